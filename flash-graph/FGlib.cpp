@@ -61,14 +61,6 @@ FG_graph::FG_graph(const std::string &graph_file,
 		exist_in_safs = safs_graph.exist() && safs_index.exist();
 	}
 
-	if (graph_conf.use_in_mem_graph() && exist_in_safs)
-		graph_data = in_mem_graph::load_safs_graph(graph_file);
-	else if (!exist_in_safs) {
-		// If we can't initialize SAFS, we assume the graph file is
-		// in the local filesystem.
-		graph_data = in_mem_graph::load_graph(graph_file);
-	}
-
 	if (graph_conf.use_in_mem_index() && exist_in_safs) {
 		index_data = vertex_index::safs_load(index_file);
 		header = index_data->get_graph_header();
@@ -76,7 +68,12 @@ FG_graph::FG_graph(const std::string &graph_file,
 	else if (!exist_in_safs) {
 		// If we can't initialize SAFS, we assume the index file is
 		// in the local filesystem.
-		index_data = vertex_index::load(index_file);
+		if (graph_conf.use_mmap_index())
+			index_data = vertex_index::mmap_load(index_file,
+					graph_conf.mmap_index_populate(),
+					graph_conf.mmap_index_huge_page());
+		else
+			index_data = vertex_index::load(index_file);
 		header = index_data->get_graph_header();
 	}
 	else {
@@ -85,6 +82,25 @@ FG_graph::FG_graph(const std::string &graph_file,
 		io_interface::ptr io = index_factory->create_io(thread::get_curr_thread());
 		io->access((char *) &header, 0, sizeof(header), READ);
 	}
+
+	// The parallel loader needs the vertex index to split the graph
+	// among NUMA nodes. If the index isn't kept in memory, we only load it
+	// while loading the graph.
+	bool load_graph = graph_conf.use_in_mem_graph() || !exist_in_safs;
+	if (load_graph && graph_conf.use_numa_load()) {
+		vertex_index::ptr load_index = index_data;
+		if (load_index == NULL)
+			load_index = vertex_index::safs_load(index_file);
+		graph_data = in_mem_graph::load_numa_graph(graph_file, load_index,
+				exist_in_safs, graph_conf.in_mem_huge_page());
+	}
+	else if (graph_conf.use_in_mem_graph() && exist_in_safs)
+		graph_data = in_mem_graph::load_safs_graph(graph_file);
+	else if (!exist_in_safs) {
+		// If we can't initialize SAFS, we assume the graph file is
+		// in the local filesystem.
+		graph_data = in_mem_graph::load_graph(graph_file);
+	}
 }
 
 FG_graph::FG_graph(std::shared_ptr<in_mem_graph> graph_data,
@@ -230,6 +230,39 @@ FG_vector<std::pair<vertex_id_t, size_t> >::ptr compute_topK_scan(
 */
 size_t estimate_diameter(FG_graph::ptr fg, int num_bfs, bool directed);
 
+/**
+  * \brief The summary of a BFS in a multi-source BFS.
+  */
+struct bfs_summary
+{
+	/** The source vertex of the BFS. */
+	vertex_id_t source;
+	/** The number of vertices reached by the BFS, including the source. */
+	size_t num_reached;
+	/** The sum of the distances from the source to the reached vertices. */
+	size_t sum_dists;
+	/** The largest distance from the source, i.e., its eccentricity. */
+	int max_dist;
+};
+
+/**
+  * \brief Run a BFS from each of the source vertices. Up to 256 BFS run
+  *       in the same traversal of the graph, and each vertex keeps a bit
+  *       for each BFS, so a vertex reads its adjacency list only once in
+  *       an iteration for all of the BFS.
+  *
+  * \param fg The FlashGraph graph object for which you want to compute.
+  * \param sources The source vertices of the BFS.
+  * \param traverse_edge The type of edges the BFS traverse.
+  *
+  * \return The summary of each BFS, which can be used to compute
+  *         closeness centrality and reachability.
+  *
+*/
+std::vector<bfs_summary> compute_msbfs(FG_graph::ptr fg,
+		const std::vector<vertex_id_t> &sources,
+		edge_type traverse_edge = edge_type::OUT_EDGE);
+
 /**
   * \brief Compute the PageRank of a graph using the pull method
   *       where vertices request the data from all their neighbors
@@ -262,6 +295,26 @@ FG_vector<float>::ptr compute_pagerank(FG_graph::ptr fg, int num_iters,
 FG_vector<float>::ptr compute_pagerank2(FG_graph::ptr, int num_iters,
 		float damping_factor);
 
+/**
+  * \brief Compute the PageRank of a graph by accumulating deltas.
+  *       A vertex only pushes the deltas it has accumulated to its
+  *       neighbors when they exceed the tolerance, so vertices that
+  *       have converged don't read their edge lists any more. The
+  *       computation ends when no vertex is activated.
+  *
+  * \param fg The FlashGraph graph object for which you want to compute.
+  * \param num_iters The maximum number of iterations for PageRank.
+  * \param damping_factor The damping factor. Originally .85.
+  * \param tolerance The smallest accumulated delta that a vertex pushes
+  *        to its neighbors.
+  *
+  * \return A vector with an entry for each vertex in the graph's
+  *         PageRank value.
+  *
+*/
+FG_vector<float>::ptr compute_pagerank_delta(FG_graph::ptr fg, int num_iters,
+		float damping_factor, float tolerance);
+
 FG_vector<float>::ptr compute_sstsg(FG_graph::ptr fg, time_t start_time,
 		time_t interval, int num_intervals);
 
@@ -0,0 +1,103 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+
+#include <boost/format.hpp>
+
+#include "log.h"
+#include "engine_stats.h"
+
+size_t engine_stats::get_num_levels() const
+{
+	size_t num_levels = 0;
+	for (size_t i = 0; i < thread_stats.size(); i++)
+		num_levels = std::max(num_levels, thread_stats[i].size());
+	return num_levels;
+}
+
+void engine_stats::print_csv(FILE *f) const
+{
+	fprintf(f, "level,thread,active,processed,stolen,sent_msgs,recv_msgs,"
+			"io_reqs,io_bytes,cache_hits,compute_time,io_wait_time,sync_time\n");
+	size_t num_levels = get_num_levels();
+	for (size_t level = 0; level < num_levels; level++) {
+		for (size_t i = 0; i < thread_stats.size(); i++) {
+			if (level >= thread_stats[i].size())
+				continue;
+			const level_thread_stat &stat = thread_stats[i][level];
+			fprintf(f, "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%f,%f,%f\n",
+					level, i, stat.num_active, stat.num_processed,
+					stat.num_stolen, stat.num_sent_msgs, stat.num_recv_msgs,
+					stat.num_io_reqs, stat.num_io_bytes, stat.num_cache_hits,
+					stat.compute_time, stat.io_wait_time, stat.sync_time);
+		}
+	}
+}
+
+void engine_stats::print_json(FILE *f) const
+{
+	fprintf(f, "{\n\t\"num_threads\": %ld,\n\t\"levels\": [", thread_stats.size());
+	size_t num_levels = get_num_levels();
+	for (size_t level = 0; level < num_levels; level++) {
+		fprintf(f, "%s\n\t\t{\"level\": %ld, \"threads\": [",
+				level == 0 ? "" : ",", level);
+		bool first = true;
+		for (size_t i = 0; i < thread_stats.size(); i++) {
+			if (level >= thread_stats[i].size())
+				continue;
+			const level_thread_stat &stat = thread_stats[i][level];
+			fprintf(f, "%s\n\t\t\t{\"thread\": %ld, \"active\": %ld, "
+					"\"processed\": %ld, \"stolen\": %ld, \"sent_msgs\": %ld, "
+					"\"recv_msgs\": %ld, \"io_reqs\": %ld, \"io_bytes\": %ld, "
+					"\"cache_hits\": %ld, \"compute_time\": %f, "
+					"\"io_wait_time\": %f, \"sync_time\": %f}",
+					first ? "" : ",", i, stat.num_active, stat.num_processed,
+					stat.num_stolen, stat.num_sent_msgs, stat.num_recv_msgs,
+					stat.num_io_reqs, stat.num_io_bytes, stat.num_cache_hits,
+					stat.compute_time, stat.io_wait_time, stat.sync_time);
+			first = false;
+		}
+		fprintf(f, "\n\t\t]}");
+	}
+	fprintf(f, "\n\t]\n}\n");
+}
+
+void engine_stats::dump(const std::string &file) const
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if (f == NULL) {
+		BOOST_LOG_TRIVIAL(error) << boost::format("can't open %1%: %2%")
+			% file % strerror(errno);
+		return;
+	}
+	const std::string csv_ext = ".csv";
+	if (file.size() >= csv_ext.size() && file.compare(
+				file.size() - csv_ext.size(), csv_ext.size(), csv_ext) == 0)
+		print_csv(f);
+	else
+		print_json(f);
+	fclose(f);
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"write the statistics of %1% iterations to %2%")
+		% get_num_levels() % file;
+}
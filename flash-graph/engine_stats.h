@@ -0,0 +1,102 @@
+#ifndef __ENGINE_STATS_H__
+#define __ENGINE_STATS_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * The statistics of a worker thread in an iteration.
+ */
+struct level_thread_stat
+{
+	// The number of vertices activated in the partition of the thread.
+	size_t num_active;
+	// The number of vertices processed by the thread, including the ones
+	// stolen from other threads.
+	size_t num_processed;
+	// The number of vertices stolen from other threads.
+	size_t num_stolen;
+	// The number of vertex messages sent by the vertex programs.
+	size_t num_sent_msgs;
+	// The number of vertex messages received from all threads.
+	size_t num_recv_msgs;
+	// The I/O requests issued to access the adjacency lists.
+	size_t num_io_reqs;
+	size_t num_io_bytes;
+	// The number of page accesses served by the page cache.
+	size_t num_cache_hits;
+	// The time (in seconds) spent on computation, on waiting for I/O and
+	// on synchronizing with other threads at the end of the iteration.
+	double compute_time;
+	double io_wait_time;
+	double sync_time;
+
+	level_thread_stat() {
+		memset(this, 0, sizeof(*this));
+	}
+};
+
+/**
+ * This collects the per-iteration statistics of all worker threads in
+ * a run of the graph engine.
+ */
+class engine_stats
+{
+	// The statistics of each thread in each iteration, indexed by
+	// the thread Id first.
+	std::vector<std::vector<level_thread_stat> > thread_stats;
+public:
+	void clear() {
+		thread_stats.clear();
+	}
+
+	void add_thread(const std::vector<level_thread_stat> &stats) {
+		thread_stats.push_back(stats);
+	}
+
+	int get_num_threads() const {
+		return thread_stats.size();
+	}
+
+	/**
+	 * Threads may run different numbers of iterations if the engine
+	 * terminates abnormally, so we take the maximum.
+	 */
+	size_t get_num_levels() const;
+
+	const level_thread_stat &get_stat(int level, int thread_id) const {
+		return thread_stats[thread_id][level];
+	}
+
+	void print_csv(FILE *f) const;
+	void print_json(FILE *f) const;
+	/**
+	 * Write the statistics to the file. The format is determined by
+	 * the file extension: CSV for ".csv" and JSON otherwise.
+	 */
+	void dump(const std::string &file) const;
+};
+
+#endif
@@ -29,43 +29,140 @@
 #include "FGlib.h"
 
 edge_type traverse_edge = edge_type::OUT_EDGE;
+// The edges that a vertex reads to look for its parent in the bottom-up
+// traversal. In a directed graph, it's the reverse of `traverse_edge'.
+edge_type pull_edge = edge_type::IN_EDGE;
+
+/*
+ * The parameters of the direction-optimizing BFS from Beamer et al.
+ * BFS switches to the bottom-up traversal when the edges of the frontier
+ * are more than 1/ALPHA of the unexplored edges, and switches back to
+ * the top-down traversal when the frontier has fewer than 1/BETA of
+ * the vertices in the graph.
+ */
+const size_t ALPHA = 14;
+const size_t BETA = 24;
+
+/*
+ * The global traversal state. It's only modified by the level callback
+ * between iterations.
+ */
+bool bottom_up = false;
+// A vertex discovered in a bottom-up iteration expands its neighbors in
+// the next iteration after BFS switches back to the top-down traversal,
+// so the depth of vertices lags behind the iteration number afterwards.
+int depth_offset = 0;
+
+static inline int get_curr_depth(vertex_program &prog)
+{
+	return prog.get_graph().get_curr_level() - depth_offset;
+}
 
 class bfs_vertex: public compute_directed_vertex
 {
-	bool visited;
+	// The depth of the vertex in the BFS tree. -1 means unvisited.
+	int depth;
+
+	void push(vertex_program &prog, const page_vertex &vertex);
+	void pull(vertex_program &prog, const page_vertex &vertex);
 public:
 	bfs_vertex(vertex_id_t id): compute_directed_vertex(id) {
-		visited = false;
+		depth = -1;
 	}
 
 	bool has_visited() const {
-		return visited;
+		return depth >= 0;
 	}
 
-	void set_visited(bool visited) {
-		this->visited = visited;
+	int get_depth() const {
+		return depth;
 	}
 
-	void run(vertex_program &prog) {
-		if (!has_visited()) {
-			directed_vertex_request req(prog.get_vertex_id(*this),
-					traverse_edge);
-			request_partial_vertices(&req, 1);
-		}
-	}
+	void run(vertex_program &prog);
 
-	void run(vertex_program &prog, const page_vertex &vertex);
+	void run(vertex_program &prog, const page_vertex &vertex) {
+		if (bottom_up)
+			pull(prog, vertex);
+		else
+			push(prog, vertex);
+	}
 
 	void run_on_message(vertex_program &prog, const vertex_message &msg) {
 	}
 };
 
-void bfs_vertex::run(vertex_program &prog, const page_vertex &vertex)
+/*
+ * The vertex program keeps track of the number of edges of the vertices
+ * visited in the current iteration, so the level callback can estimate
+ * the amount of work of the top-down traversal in the next iteration.
+ */
+class bfs_vertex_program: public vertex_program_impl<bfs_vertex>
 {
-	assert(!has_visited());
-	set_visited(true);
+	size_t num_visited;
+	size_t num_visited_edges;
+public:
+	bfs_vertex_program() {
+		num_visited = 0;
+		num_visited_edges = 0;
+	}
+
+	void visit(vsize_t num_edges) {
+		num_visited++;
+		num_visited_edges += num_edges;
+	}
+
+	size_t get_num_visited() const {
+		return num_visited;
+	}
+
+	size_t get_num_visited_edges() const {
+		return num_visited_edges;
+	}
+
+	void reset() {
+		num_visited = 0;
+		num_visited_edges = 0;
+	}
+};
+
+class bfs_vertex_program_creater: public vertex_program_creater
+{
+public:
+	vertex_program::ptr create() const {
+		return vertex_program::ptr(new bfs_vertex_program());
+	}
+};
+
+void bfs_vertex::run(vertex_program &prog)
+{
+	int curr_depth = get_curr_depth(prog);
+	if (bottom_up) {
+		// All vertices are activated in a bottom-up iteration. Only
+		// the unvisited vertices that may have a parent need to search
+		// for it.
+		vertex_id_t id = prog.get_vertex_id(*this);
+		if (!has_visited() && prog.get_graph().get_num_edges(id, pull_edge) > 0) {
+			directed_vertex_request req(id, pull_edge);
+			request_partial_vertices(&req, 1);
+		}
+		return;
+	}
 
+	if (!has_visited())
+		depth = curr_depth;
+	// The vertex is discovered in this iteration, or in the previous
+	// bottom-up iteration.
+	if (depth == curr_depth) {
+		directed_vertex_request req(prog.get_vertex_id(*this),
+				traverse_edge);
+		request_partial_vertices(&req, 1);
+	}
+}
+
+void bfs_vertex::push(vertex_program &prog, const page_vertex &vertex)
+{
 	int num_dests = vertex.get_num_edges(traverse_edge);
+	((bfs_vertex_program &) prog).visit(num_dests);
 	if (num_dests == 0)
 		return;
 
@@ -85,6 +182,114 @@ void bfs_vertex::run(vertex_program &prog, const page_vertex &vertex)
 	}
 }
 
+/*
+ * Search for a parent of the vertex among the vertices visited in
+ * the previous iterations.
+ */
+static bool has_parent(graph_engine &graph, edge_seq_iterator &it,
+		int curr_depth)
+{
+	while (it.has_next()) {
+		bfs_vertex &neigh = (bfs_vertex &) graph.get_vertex(it.next());
+		if (neigh.has_visited() && neigh.get_depth() < curr_depth)
+			return true;
+	}
+	return false;
+}
+
+void bfs_vertex::pull(vertex_program &prog, const page_vertex &vertex)
+{
+	graph_engine &graph = prog.get_graph();
+	int curr_depth = get_curr_depth(prog);
+	bool found;
+	if (pull_edge == BOTH_EDGES) {
+		edge_seq_iterator it = vertex.get_neigh_seq_it(IN_EDGE);
+		found = has_parent(graph, it, curr_depth);
+		if (!found) {
+			it = vertex.get_neigh_seq_it(OUT_EDGE);
+			found = has_parent(graph, it, curr_depth);
+		}
+	}
+	else {
+		edge_seq_iterator it = vertex.get_neigh_seq_it(pull_edge);
+		found = has_parent(graph, it, curr_depth);
+	}
+	if (!found)
+		return;
+
+	depth = curr_depth;
+	vertex_id_t id = prog.get_vertex_id(*this);
+	((bfs_vertex_program &) prog).visit(graph.get_num_edges(id,
+				traverse_edge));
+	// The vertex is in the frontier of the next iteration, which needs
+	// to expand it if BFS switches back to the top-down traversal.
+	prog.activate_vertex(id);
+}
+
+/*
+ * This decides the traversal direction of the next iteration with
+ * the heuristic of the direction-optimizing BFS.
+ */
+class bfs_level_callback: public level_callback
+{
+	size_t num_unexplored_edges;
+	size_t prev_frontier_size;
+public:
+	bfs_level_callback(graph_engine &graph) {
+		num_unexplored_edges = graph.get_graph_header().get_num_edges();
+		if (graph.is_directed() && traverse_edge == BOTH_EDGES)
+			num_unexplored_edges *= 2;
+		prev_frontier_size = 1;
+	}
+
+	bool next_level(graph_engine &graph, size_t num_activated);
+};
+
+bool bfs_level_callback::next_level(graph_engine &graph, size_t num_activated)
+{
+	std::vector<vertex_program::ptr> progs;
+	graph.get_vertex_programs(progs);
+	size_t num_visited = 0;
+	size_t num_visited_edges = 0;
+	BOOST_FOREACH(vertex_program::ptr prog, progs) {
+		bfs_vertex_program &bfs_prog = (bfs_vertex_program &) *prog;
+		num_visited += bfs_prog.get_num_visited();
+		num_visited_edges += bfs_prog.get_num_visited_edges();
+		bfs_prog.reset();
+	}
+	num_unexplored_edges -= std::min(num_unexplored_edges, num_visited_edges);
+
+	bool growing = num_activated > prev_frontier_size;
+	prev_frontier_size = num_activated;
+	if (num_activated == 0) {
+		bottom_up = false;
+		return false;
+	}
+
+	if (bottom_up) {
+		// The vertices discovered in this iteration are the frontier.
+		if (!growing && num_activated < graph.get_num_vertices() / BETA) {
+			bottom_up = false;
+			depth_offset++;
+			BOOST_LOG_TRIVIAL(info) << boost::format(
+					"BFS switches to top-down with %1% vertices in the frontier")
+				% num_activated;
+		}
+	}
+	else if (growing && num_visited > 0) {
+		// We estimate the edges of the next frontier with the average degree
+		// of the vertices in the current frontier.
+		size_t frontier_edges = num_activated * num_visited_edges / num_visited;
+		if (frontier_edges > num_unexplored_edges / ALPHA) {
+			bottom_up = true;
+			BOOST_LOG_TRIVIAL(info) << boost::format(
+					"BFS switches to bottom-up with %1% vertices in the frontier")
+				% num_activated;
+		}
+	}
+	return bottom_up;
+}
+
 class count_vertex_query: public vertex_query
 {
 	size_t num_visited;
@@ -128,6 +333,7 @@ void print_usage()
 			"bfs [options] conf_file graph_file index_file start_vertex\n");
 	fprintf(stderr, "-c confs: add more configurations to the system\n");
 	fprintf(stderr, "-b: traverse with both in-edges and out-edges\n");
+	fprintf(stderr, "-p: switch between push (top-down) and pull (bottom-up)\n");
 	graph_conf.print_help();
 	params.print_help();
 }
@@ -137,7 +343,8 @@ int main(int argc, char *argv[])
 	int opt;
 	std::string confs;
 	int num_opts = 0;
-	while ((opt = getopt(argc, argv, "c:b")) != -1) {
+	bool direction_opt = false;
+	while ((opt = getopt(argc, argv, "c:bp")) != -1) {
 		num_opts++;
 		switch (opt) {
 			case 'c':
@@ -147,6 +354,9 @@ int main(int argc, char *argv[])
 			case 'b':
 				traverse_edge = edge_type::BOTH_EDGES;
 				break;
+			case 'p':
+				direction_opt = true;
+				break;
 			default:
 				print_usage();
 		}
@@ -183,7 +393,16 @@ int main(int argc, char *argv[])
 		ProfilerStart(graph_conf.get_prof_file().c_str());
 #endif
 
-	graph->start(&start_vertex, 1);
+	if (direction_opt) {
+		if (!graph->is_directed())
+			pull_edge = traverse_edge;
+		else if (traverse_edge == edge_type::BOTH_EDGES)
+			pull_edge = edge_type::BOTH_EDGES;
+		graph->set_level_callback(level_callback::ptr(
+					new bfs_level_callback(*graph)));
+	}
+	graph->start(&start_vertex, 1, vertex_initializer::ptr(),
+			vertex_program_creater::ptr(new bfs_vertex_program_creater()));
 	graph->wait4complete();
 	gettimeofday(&end, NULL);
 
@@ -32,16 +32,24 @@ class graph_config
 	int num_threads;
 	std::string prof_file;
 	std::string trace_file;
+	std::string stat_file;
+	std::string ts_index_file;
 	int max_processing_vertices;
 	bool enable_elevator;
 	int part_range_size_log;
 	bool _preload;
 	int index_file_weight;
 	bool _in_mem_index;
+	bool _mmap_index;
+	bool mmap_populate;
+	bool mmap_huge_page;
 	bool _in_mem_graph;
+	bool numa_load;
+	bool in_mem_huge;
 	int num_vparts;
 	int min_vpart_degree;
 	bool serial_run;
+	bool stream_all;
 public:
 	/**
 	 * \brief The default constructor that set all configurations to
@@ -55,10 +63,16 @@ public:
 		_preload = false;
 		index_file_weight = 10;
 		_in_mem_index = false;
+		_mmap_index = false;
+		mmap_populate = false;
+		mmap_huge_page = false;
 		_in_mem_graph = false;
+		numa_load = false;
+		in_mem_huge = false;
 		num_vparts = 1;
 		min_vpart_degree = std::numeric_limits<int>::max();
 		serial_run = false;
+		stream_all = false;
 	}
 
 	/**
@@ -109,6 +123,25 @@ public:
 		return trace_file;
 	}
 
+	/**
+	 * \brief Get the timestamp index of a time-series graph.
+	 * \return The file name of the timestamp index. It's empty if
+	 * time-series algorithms read entire vertices.
+	 */
+	const std::string &get_ts_index_file() const {
+		return ts_index_file;
+	}
+
+	/**
+	 * \brief Get the output file containing the per-iteration statistics
+	 * of the worker threads. It's written in CSV if the file name ends
+	 * with ".csv" and in JSON otherwise.
+	 * \return the file name.
+	 */
+	const std::string &get_stat_file() const {
+		return stat_file;
+	}
+
 	/**
 	 * \brief Get the maximal number of vertices being processed by
 	 * a worker thread.
@@ -153,6 +186,32 @@ public:
 		return _in_mem_index;
 	}
 
+	/**
+	 * \brief Determine whether to map the vertex index in the Linux
+	 * filesystem to memory instead of reading it to the heap.
+	 * \return true if the vertex index is memory mapped.
+	 */
+	bool use_mmap_index() const {
+		return _mmap_index;
+	}
+
+	/**
+	 * \brief Determine whether to prefault the memory-mapped vertex index.
+	 * \return true if the mapping is created with MAP_POPULATE.
+	 */
+	bool mmap_index_populate() const {
+		return mmap_populate;
+	}
+
+	/**
+	 * \brief Determine whether to back the memory-mapped vertex index
+	 * with huge pages if the kernel supports it.
+	 * \return true if the graph engine asks for huge pages.
+	 */
+	bool mmap_index_huge_page() const {
+		return mmap_huge_page;
+	}
+
 	/**
 	 * \brief Determine whether to use in-mem graph data.
 	 * \return true if the graph engine loads the entire graph data in memory
@@ -162,6 +221,26 @@ public:
 		return _in_mem_graph;
 	}
 
+	/**
+	 * \brief Determine whether to load the in-mem graph data with a thread
+	 * per partition and place the data of a partition on the NUMA node
+	 * where the partition is processed.
+	 * \return true if the graph engine loads the graph data in parallel.
+	 */
+	bool use_numa_load() const {
+		return numa_load;
+	}
+
+	/**
+	 * \brief Determine whether to back the in-mem graph data with
+	 * huge pages. It only takes effect when the graph data is loaded
+	 * in parallel.
+	 * \return true if the graph engine asks for huge pages.
+	 */
+	bool in_mem_huge_page() const {
+		return in_mem_huge;
+	}
+
 	/**
 	 * \brief Determine whether to run the user code on a vertex in serial.
 	 * \return true if the graph engine runs the user code on a vertex in serial.
@@ -170,6 +249,16 @@ public:
 		return serial_run;
 	}
 
+	/**
+	 * \brief Determine whether to stream the adjacency lists of a partition
+	 * in large sequential reads in the iterations where all vertices
+	 * are active.
+	 * \return true if the graph engine streams the adjacency lists.
+	 */
+	bool use_stream_all() const {
+		return stream_all;
+	}
+
 	/**
 	 * \brief Get the number of vertical partitions.
 	 * \return The number of vertical partitions.
@@ -193,16 +282,24 @@ inline void graph_config::print_help()
 	printf("\tthreads: the number of threads processing the graph\n");
 	printf("\tprof_file: the output file containing CPU profiling\n");
 	printf("\ttrace_file: log IO requests\n");
+	printf("\tstat_file: the output file of the statistics in each iteration (.csv or JSON)\n");
+	printf("\tts_index: the timestamp index for reading edges in a time interval\n");
 	printf("\tmax_processing_vertices: the max number of vertices being processed\n");
 	printf("\tenable_elevator: enable the elevator algorithm for scheduling vertices\n");
 	printf("\tpart_range_size_log: the log2 of the range size in range partitioning\n");
 	printf("\tpreload: preload the graph data to the page cache\n");
 	printf("\tindex_file_weight: the weight for the graph index file\n");
 	printf("\tin_mem_index: indicate whether to use in-mem vertex index\n");
+	printf("\tmmap_index: map the vertex index in the Linux filesystem to memory\n");
+	printf("\tmmap_populate: prefault the memory-mapped vertex index\n");
+	printf("\tmmap_huge_page: use huge pages for the memory-mapped vertex index\n");
 	printf("\tin_mem_graph: indicate whether to load the entire graph to memory in advance\n");
+	printf("\tnuma_load: load the graph to memory in parallel and place it on NUMA nodes (serial loading by default)\n");
+	printf("\tin_mem_huge_page: use huge pages for the graph loaded in parallel\n");
 	printf("\tnum_vparts: the number of vertical partitions\n");
 	printf("\tmin_vpart_degree: the min degree of a vertex to perform vertical partitioning\n");
 	printf("\tserial_run: run the user code on a vertex in serial\n");
+	printf("\tstream_all: stream adjacency lists when all vertices are active (a vertex that requests in-edges and out-edges separately still runs once on each part)\n");
 }
 
 inline void graph_config::print()
@@ -211,16 +308,24 @@ inline void graph_config::print()
 	BOOST_LOG_TRIVIAL(info) << "\tthreads: " << num_threads;
 	BOOST_LOG_TRIVIAL(info) << "\tprof_file: " << prof_file;
 	BOOST_LOG_TRIVIAL(info) << "\ttrace_file: " << trace_file;
+	BOOST_LOG_TRIVIAL(info) << "\tstat_file: " << stat_file;
+	BOOST_LOG_TRIVIAL(info) << "\tts_index: " << ts_index_file;
 	BOOST_LOG_TRIVIAL(info) << "\tmax_processing_vertices: " << max_processing_vertices;
 	BOOST_LOG_TRIVIAL(info) << "\tenable_elevator: " << enable_elevator;
 	BOOST_LOG_TRIVIAL(info) << "\tpart_range_size_log: " << part_range_size_log;
 	BOOST_LOG_TRIVIAL(info) << "\tpreload: " << _preload;
 	BOOST_LOG_TRIVIAL(info) << "\tindex_file_weight: " << index_file_weight;
 	BOOST_LOG_TRIVIAL(info) << "\tin_mem_index: " << _in_mem_index;
+	BOOST_LOG_TRIVIAL(info) << "\tmmap_index: " << _mmap_index;
+	BOOST_LOG_TRIVIAL(info) << "\tmmap_populate: " << mmap_populate;
+	BOOST_LOG_TRIVIAL(info) << "\tmmap_huge_page: " << mmap_huge_page;
 	BOOST_LOG_TRIVIAL(info) << "\tin_mem_graph: " << _in_mem_graph;
+	BOOST_LOG_TRIVIAL(info) << "\tnuma_load: " << numa_load;
+	BOOST_LOG_TRIVIAL(info) << "\tin_mem_huge_page: " << in_mem_huge;
 	BOOST_LOG_TRIVIAL(info) << "\tnum_vparts: " << num_vparts;
 	BOOST_LOG_TRIVIAL(info) << "\tmin_vpart_degree: " << min_vpart_degree;
 	BOOST_LOG_TRIVIAL(info) << "\tserial_run: " << serial_run;
+	BOOST_LOG_TRIVIAL(info) << "\tstream_all: " << stream_all;
 }
 
 inline void graph_config::init(config_map::ptr map)
@@ -230,16 +335,24 @@ inline void graph_config::init(config_map::ptr map)
 		throw conf_exception("The number of worker threads has to be 2^n");
 	map->read_option("prof_file", prof_file);
 	map->read_option("trace_file", trace_file);
+	map->read_option("stat_file", stat_file);
+	map->read_option("ts_index", ts_index_file);
 	map->read_option_int("max_processing_vertices", max_processing_vertices);
 	map->read_option_bool("enable_elevator", enable_elevator);
 	map->read_option_int("part_range_size_log", part_range_size_log);
 	map->read_option_bool("preload", _preload);
 	map->read_option_int("index_file_weight", index_file_weight);
 	map->read_option_bool("in_mem_index", _in_mem_index);
+	map->read_option_bool("mmap_index", _mmap_index);
+	map->read_option_bool("mmap_populate", mmap_populate);
+	map->read_option_bool("mmap_huge_page", mmap_huge_page);
 	map->read_option_bool("in_mem_graph", _in_mem_graph);
+	map->read_option_bool("numa_load", numa_load);
+	map->read_option_bool("in_mem_huge_page", in_mem_huge);
 	map->read_option_int("num_vparts", num_vparts);
 	map->read_option_int("min_vpart_degree", min_vpart_degree);
 	map->read_option_bool("serial_run", serial_run);
+	map->read_option_bool("stream_all", stream_all);
 }
 
 extern graph_config graph_conf;
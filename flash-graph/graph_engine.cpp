@@ -31,6 +31,7 @@
 #include "vertex_index_reader.h"
 #include "in_mem_storage.h"
 #include "FGlib.h"
+#include "ts_index.h"
 
 /**
  * The size of a message buffer used to pass vertex messages to other threads.
@@ -223,11 +224,14 @@ void compute_vertex::request_vertices(vertex_id_t ids[], size_t num)
 	vertex_id_t id = curr->get_vertex_program(false).get_vertex_id(*this);
 	curr->request_on_vertex(id);
 	if (request_self(ids, num, id)) {
+		// In the streaming mode, the worker thread reads the adjacency list
+		// along with the ones of the adjacent vertices.
 		if (curr->get_graph().is_directed()) {
 			directed_vertex_request req(ids[0], BOTH_EDGES);
-			curr->get_index_reader().request_vertex(req);
+			if (!curr->stream_vertex(ids[0], BOTH_EDGES))
+				curr->get_index_reader().request_vertex(req);
 		}
-		else
+		else if (!curr->stream_vertex(ids[0], IN_EDGE))
 			curr->get_index_reader().request_vertex(ids[0]);
 	}
 	else {
@@ -259,7 +263,8 @@ void compute_directed_vertex::request_partial_vertices(
 	curr->request_on_vertex(id);
 	if (request_self(reqs, num, id)) {
 		for (size_t i = 0; i < num; i++)
-			curr->get_index_reader().request_vertex(reqs[i]);
+			if (!curr->stream_vertex(reqs[i].get_id(), reqs[i].get_type()))
+				curr->get_index_reader().request_vertex(reqs[i]);
 	}
 	else {
 		compute_vertex_pointer curr_vertex = curr->get_curr_vertex();
@@ -271,6 +276,24 @@ void compute_directed_vertex::request_partial_vertices(
 	}
 }
 
+size_t compute_directed_vertex::request_ts_vertices(ts_range_request reqs[],
+		size_t num)
+{
+	worker_thread *curr = (worker_thread *) thread::get_curr_thread();
+	vertex_id_t id = curr->get_vertex_program(false).get_vertex_id(*this);
+	compute_vertex_pointer curr_vertex = curr->get_curr_vertex();
+	assert(curr_vertex.is_valid());
+	assert(curr_vertex.get() == this);
+	directed_vertex_compute *compute
+		= (directed_vertex_compute *) curr->get_vertex_compute(curr_vertex);
+	size_t ret = compute->request_ts_vertices(reqs, num);
+	// We don't issue any requests if no vertices have edges in the time
+	// interval.
+	if (ret > 0)
+		curr->request_on_vertex(id);
+	return ret;
+}
+
 void part_compute_vertex::broadcast_vpart(const vertex_message &msg)
 {
 	worker_thread *curr = (worker_thread *) thread::get_curr_thread();
@@ -367,14 +390,24 @@ bool vpart_index_compute::run(vertex_id_t start_vid, index_iterator &it)
 {
 	vertex_id_t vid = start_vid;
 	while (it.has_next()) {
-		if (graph.is_directed()) {
-			vsize_t num_edges = graph.cal_num_edges(it.get_curr_size())
-				+ graph.cal_num_edges(it.get_curr_out_size());
+		// We can't get the number of edges from the vertex size if
+		// the adjacency lists are compressed.
+		if (graph.get_graph_header().is_edge_list_compressed()) {
+			vsize_t num_edges = graph.get_num_edges(vid, edge_type::BOTH_EDGES);
+			if (num_edges >= (vsize_t) graph_conf.get_min_vpart_degree())
+				large_degree_ids->push_back(vid);
+		}
+		else if (graph.is_directed()) {
+			vsize_t num_edges = graph.cal_num_edges(vid, edge_type::IN_EDGE,
+					it.get_curr_size())
+				+ graph.cal_num_edges(vid, edge_type::OUT_EDGE,
+						it.get_curr_out_size());
 			if (num_edges >= (vsize_t) graph_conf.get_min_vpart_degree())
 				large_degree_ids->push_back(vid);
 		}
 		else {
-			vsize_t num_edges = graph.cal_num_edges(it.get_curr_size());
+			vsize_t num_edges = graph.cal_num_edges(vid, edge_type::IN_EDGE,
+					it.get_curr_size());
 			if (num_edges >= (vsize_t) graph_conf.get_min_vpart_degree())
 				large_degree_ids->push_back(vid);
 		}
@@ -594,7 +627,8 @@ graph_engine::graph_engine(FG_graph &graph, graph_index::ptr index)
 
 	// Init graph data.
 	graph_factory = graph.get_graph_io_factory(GLOBAL_CACHE_ACCESS);
-	// Construct the in-memory compressed vertex index.
+	// Construct the in-memory compressed vertex index. A memory-mapped
+	// index isn't compressed, so it's read on demand.
 	vindex = in_mem_query_vertex_index::create(graph.get_index_data(),
 			!graph_conf.use_in_mem_index());
 
@@ -607,6 +641,17 @@ graph_engine::graph_engine(FG_graph &graph, graph_index::ptr index)
 		out_part_off = idx->get_out_part_loc();
 	}
 
+	if (!graph_conf.get_ts_index_file().empty()) {
+		if (!header.is_directed_graph() || !header.has_edge_data()
+				|| header.is_edge_list_compressed())
+			ABORT_MSG("The timestamp index only works for uncompressed time-series graphs");
+		ts_index = ts_vertex_index::load(graph_conf.get_ts_index_file());
+		if (ts_index->get_num_vertices() != header.get_num_vertices())
+			ABORT_MSG(boost::format(
+						"The timestamp index has %1% vertices, but the graph has %2%")
+					% ts_index->get_num_vertices() % header.get_num_vertices());
+	}
+
 	init(index);
 
 	gettimeofday(&init_end, NULL);
@@ -624,11 +669,6 @@ graph_engine::~graph_engine()
 	destroy_flash_graph();
 }
 
-static inline int get_node_id(int thread_idx, int num_nodes)
-{
-	return thread_idx % num_nodes;
-}
-
 void graph_engine::init_threads(vertex_program_creater::ptr creater)
 {
 	std::vector<std::shared_ptr<slab_allocator> > msg_allocs(num_nodes);
@@ -660,16 +700,16 @@ void graph_engine::init_threads(vertex_program_creater::ptr creater)
 		worker_thread *t = new worker_thread(this, graph_factory,
 				file_io_factory::shared_ptr(),
 				new_prog, vertices->create_def_part_vertex_program(),
-				get_node_id(i, num_nodes), i, num_threads, scheduler,
-				msg_allocs[get_node_id(i, num_nodes)]);
+				get_thread_node_id(i), i, num_threads, scheduler,
+				msg_allocs[get_thread_node_id(i)]);
 		assert(worker_threads[i] == NULL);
 		worker_threads[i] = t;
 		vprograms[i] = new_prog;
 	}
 	for (int i = 0; i < num_threads; i++) {
 		worker_threads[i]->init_messaging(worker_threads,
-				msg_allocs[get_node_id(i, num_nodes)],
-				flush_msg_allocs[get_node_id(i, num_nodes)]);
+				msg_allocs[get_thread_node_id(i)],
+				flush_msg_allocs[get_thread_node_id(i)]);
 	}
 }
 
@@ -748,6 +788,36 @@ bool graph_engine::progress_first_level()
 	return is_complete;
 }
 
+/*
+ * The level callback needs to know the number of vertices activated for
+ * the next level by all threads, so we need two more synchronizations here.
+ */
+void graph_engine::notify_level_end(worker_thread *curr)
+{
+	static atomic_number<long> tot_num_activates;
+	static volatile bool activate_all;
+
+	tot_num_activates.inc(curr->get_num_next_activated());
+	int rc = pthread_barrier_wait(&barrier1);
+	if (rc == PTHREAD_BARRIER_SERIAL_THREAD) {
+		activate_all = level_cb->next_level(*this, tot_num_activates.get());
+		tot_num_activates = 0;
+	}
+	else if (rc != 0) {
+		BOOST_LOG_TRIVIAL(fatal) << "Could not wait on barrier";
+		exit(-1);
+	}
+
+	rc = pthread_barrier_wait(&barrier2);
+	if(rc != 0 && rc != PTHREAD_BARRIER_SERIAL_THREAD)
+	{
+		BOOST_LOG_TRIVIAL(fatal) << "Could not wait on barrier";
+		exit(-1);
+	}
+	if (activate_all)
+		curr->activate_all_next_level();
+}
+
 bool graph_engine::progress_next_level()
 {
 	static atomic_number<long> tot_num_activates;
@@ -762,6 +832,9 @@ bool graph_engine::progress_next_level()
 		exit(-1);
 	}
 	worker_thread *curr = (worker_thread *) thread::get_curr_thread();
+	curr->complete_level();
+	if (level_cb)
+		notify_level_end(curr);
 	int num_activates = curr->enter_next_level();
 	tot_num_activates.inc(num_activates);
 	// If all threads have reached here.
@@ -796,8 +869,10 @@ bool graph_engine::progress_next_level()
 
 void graph_engine::wait4complete()
 {
+	stats.clear();
 	for (unsigned i = 0; i < worker_threads.size(); i++) {
 		worker_threads[i]->join();
+		stats.add_thread(worker_threads[i]->get_level_stats());
 		delete worker_threads[i];
 		worker_threads[i] = NULL;
 	}
@@ -806,6 +881,8 @@ void graph_engine::wait4complete()
 	BOOST_LOG_TRIVIAL(info)
 		<< boost::format("The graph engine takes %1% seconds to complete")
 		% time_diff(start_time, curr);
+	if (!graph_conf.get_stat_file().empty())
+		stats.dump(graph_conf.get_stat_file());
 }
 
 void graph_engine::set_vertex_scheduler(vertex_scheduler::ptr scheduler)
@@ -30,12 +30,14 @@
 #include "messaging.h"
 #include "partitioner.h"
 #include "graph_index.h"
+#include "engine_stats.h"
 #include "graph_config.h"
 #include "vertex_request.h"
 #include "vertex_program.h"
 
 class graph_engine;
 class vertex_request;
+class ts_vertex_index;
 
 /**
   * \brief Class from which users' vertex-centric programs should inherit.
@@ -188,6 +190,20 @@ public:
      * \param num the number of elements in `reqs`.
 	 */
 	void request_partial_vertices(directed_vertex_request reqs[], size_t num);
+
+	/**
+	 * \brief This allows a vertex to request the edges of vertices in
+	 *        a time interval in a time-series graph. Only the neighbors in
+	 *        the time interval are read from the graph file, and the vertex
+	 *        receives them in a `page_ts_range_vertex'.
+	 *        It requires a timestamp index in the graph engine and the time
+	 *        interval has to be aligned with the buckets of the index.
+	 * \param reqs The vertices and the time interval of each vertex.
+	 * \param num the number of elements in `reqs`.
+	 * \return The number of vertices that will be received. A vertex without
+	 *         edges in the time interval isn't received.
+	 */
+	size_t request_ts_vertices(ts_range_request reqs[], size_t num);
 };
 
 class part_compute_directed_vertex: public compute_directed_vertex
@@ -314,6 +330,33 @@ public:
 	virtual ptr clone() = 0;
 };
 
+/**
+ * \brief This allows users to make a global decision when all worker threads
+ *        have completed an iteration and before the engine enters the next
+ *        iteration. e.g., BFS can choose its traversal direction based on
+ *        the size of the frontier.
+ */
+class level_callback
+{
+public:
+	typedef std::shared_ptr<level_callback> ptr; /** Type provides access to the object */
+
+	virtual ~level_callback() {
+	}
+
+	/**
+	 * \brief This is invoked by a single thread at the end of an iteration.
+	 *        `graph_engine::get_curr_level' still returns the iteration
+	 *        that has just completed.
+	 * \param graph The graph engine.
+	 * \param num_activated The number of vertices activated for the next
+	 *        iteration. A vertex may be counted multiple times if it is
+	 *        activated multiple times.
+	 * \return true if all vertices should be activated in the next iteration.
+	 */
+	virtual bool next_level(graph_engine &graph, size_t num_activated) = 0;
+};
+
 class worker_thread;
 class in_mem_graph;
 class FG_graph;
@@ -333,8 +376,11 @@ class graph_engine
 
 	graph_index::ptr vertices;
 	in_mem_query_vertex_index::ptr vindex;
+	// The timestamp index of a time-series graph. It may not exist.
+	std::shared_ptr<ts_vertex_index> ts_index;
 	std::shared_ptr<in_mem_graph> graph_data;
 	vertex_scheduler::ptr scheduler;
+	level_callback::ptr level_cb;
 
 	// The number of activated vertices that haven't been processed
 	// in the current level.
@@ -353,12 +399,15 @@ class graph_engine
 
 	trace_logger::ptr logger;
 	file_io_factory::shared_ptr graph_factory;
+	// The statistics of the worker threads in the last run.
+	engine_stats stats;
 	int max_processing_vertices;
 
 	// The time when the current iteration starts.
 	struct timeval start_time, iter_start;
 
 	void init_threads(vertex_program_creater::ptr creater);
+	void notify_level_end(worker_thread *curr);
 protected:
 	graph_engine(FG_graph &graph, graph_index::ptr index);
 	void init(graph_index::ptr index);
@@ -464,6 +513,15 @@ public:
      * \param scheduler The user-defined vertex scheduler.
      */
 	void set_vertex_scheduler(vertex_scheduler::ptr scheduler);
+
+    /**
+     * \brief Set the callback invoked at the end of every iteration.
+     *        It has to be set before the graph engine starts.
+     * \param cb The user-defined level callback.
+     */
+	void set_level_callback(level_callback::ptr cb) {
+		this->level_cb = cb;
+	}
     
     /**
      * \brief Start the graph engine and begin computation on a subset of vertices.
@@ -544,6 +602,15 @@ public:
 		programs = vprograms;
 	}
 
+	/**
+	 * \brief Get the per-iteration statistics of all worker threads
+	 *        in the last run. They are available after `wait4complete'.
+	 * \return The statistics of the worker threads.
+	 */
+	const engine_stats &get_stats() const {
+		return stats;
+	}
+
 	/**
 	 * \brief This returns the current iteration number in the graph engine.
      * \return The current iteration number.
@@ -592,6 +659,13 @@ public:
 		return worker_threads.size();
 	}
     
+    /**\internal
+     * Worker threads are assigned to NUMA nodes in a round-robin fashion.
+     */
+	int get_thread_node_id(int idx) const {
+		return idx % num_nodes;
+	}
+
     /**\internal */
 	worker_thread *get_thread(int idx) const {
 		return worker_threads[idx];
@@ -623,6 +697,14 @@ public:
 		return vindex;
 	}
 
+	/**
+	 * \brief Get the timestamp index of a time-series graph.
+	 * \return The timestamp index or NULL if it isn't given by `ts_index'.
+	 */
+	std::shared_ptr<ts_vertex_index> get_ts_index() const {
+		return ts_index;
+	}
+
 	void set_max_processing_vertices(int max) {
 		max_processing_vertices = max;
 	}
@@ -639,7 +721,15 @@ public:
 		return out_part_off;
 	}
 
-	vsize_t cal_num_edges(vsize_t vertex_size) const {
+	/*
+	 * Get the number of edges in a part of a vertex from its size in
+	 * the graph file. The size of a compressed vertex doesn't tell
+	 * the number of edges, so we get it from the vertex index instead.
+	 */
+	vsize_t cal_num_edges(vertex_id_t id, edge_type type,
+			vsize_t vertex_size) const {
+		if (header.is_edge_list_compressed())
+			return vindex->get_num_edges(id, type);
 		return ext_mem_undirected_vertex::vsize2num_edges(vertex_size,
 				header.get_edge_data_size());
 	}
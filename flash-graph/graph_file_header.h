@@ -27,6 +27,12 @@
 
 const int64_t MAGIC_NUMBER = 0x123456789ABCDEFL;
 const int CURR_VERSION = 4;
+/*
+ * A graph whose adjacency lists are compressed (see
+ * ext_mem_compressed_vertex) uses a different version number, so code that
+ * doesn't understand the compressed format refuses to open the graph.
+ */
+const int COMPRESSED_EDGE_VERSION = 5;
 
 enum graph_type {
 	DIRECTED,
@@ -96,7 +102,16 @@ public:
 	}
 
 	bool is_right_version() const {
-		return h.data.version_number == CURR_VERSION;
+		return h.data.version_number == CURR_VERSION
+			|| h.data.version_number == COMPRESSED_EDGE_VERSION;
+	}
+
+	bool is_edge_list_compressed() const {
+		return h.data.version_number == COMPRESSED_EDGE_VERSION;
+	}
+
+	void set_edge_list_compressed(bool compressed) {
+		h.data.version_number = compressed ? COMPRESSED_EDGE_VERSION : CURR_VERSION;
 	}
 
 	bool is_directed_graph() const {
@@ -19,6 +19,9 @@
 
 #include <stdlib.h>
 #include <malloc.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/time.h>
 
 #include <boost/format.hpp>
 
@@ -30,6 +33,9 @@
 
 #include "in_mem_storage.h"
 #include "graph_file_header.h"
+#include "graph_config.h"
+#include "partitioner.h"
+#include "vertex_index.h"
 
 class in_mem_byte_array: public page_byte_array
 {
@@ -77,6 +83,14 @@ public:
 		return pages + pg_idx * PAGE_SIZE;
 	}
 
+	/*
+	 * The byte array references the graph data in memory directly,
+	 * so all bytes are contiguous.
+	 */
+	virtual const char *get_contiguous_data() const {
+		return pages + off % PAGE_SIZE;
+	}
+
 	virtual size_t get_size() const {
 		return size;
 	}
@@ -345,6 +359,288 @@ in_mem_graph::ptr in_mem_graph::load_safs_graph(const std::string &file_name)
 	return graph;
 }
 
+/*
+ * A contiguous piece of the graph file.
+ */
+struct graph_chunk
+{
+	off_t start;
+	off_t end;
+
+	graph_chunk(off_t start, off_t end) {
+		this->start = start;
+		this->end = end;
+	}
+};
+
+/*
+ * This finds the location of a vertex in the graph file with any type of
+ * vertex index.
+ */
+class vertex_loc_finder
+{
+	default_vertex_index::ptr undirected_index;
+	directed_vertex_index::ptr directed_index;
+	in_mem_cundirected_vertex_index::ptr cundirected_index;
+	in_mem_cdirected_vertex_index::ptr cdirected_index;
+public:
+	vertex_loc_finder(vertex_index::ptr index) {
+		bool directed = index->get_graph_header().is_directed_graph();
+		if (index->is_compressed() && directed)
+			cdirected_index = in_mem_cdirected_vertex_index::create(*index);
+		else if (index->is_compressed())
+			cundirected_index = in_mem_cundirected_vertex_index::create(*index);
+		else if (directed)
+			directed_index = directed_vertex_index::cast(index);
+		else
+			undirected_index = default_vertex_index::cast(index);
+	}
+
+	bool is_directed() const {
+		return directed_index != NULL || cdirected_index != NULL;
+	}
+
+	/*
+	 * Get the location of the out-part of a vertex if `out_part' is true.
+	 * Otherwise, get the location of the in-part of a vertex in a directed
+	 * graph or the location of a vertex in an undirected graph.
+	 */
+	off_t get_off(vertex_id_t id, bool out_part) const {
+		if (undirected_index)
+			return undirected_index->get_vertex(id).get_off();
+		else if (cundirected_index)
+			return cundirected_index->get_vertex(id).get_off();
+
+		directed_vertex_entry e;
+		if (directed_index)
+			e = directed_index->get_vertex(id);
+		else
+			e = cdirected_index->get_vertex(id);
+		return out_part ? e.get_out_off() : e.get_in_off();
+	}
+};
+
+/*
+ * Split [start, end) of the graph file with the vertex ranges of
+ * the partitioner and assign each piece to the partition that owns
+ * the vertices in it. The boundaries are rounded down to pages, so each
+ * page is placed on a single NUMA node, and the page that holds the
+ * boundary of two ranges belongs to the second range. Only the end of
+ * the last vertex of the first range is in that page, while the vertices
+ * of the second range start in it.
+ */
+static void split_graph(const vertex_loc_finder &finder, bool out_part,
+		off_t start, off_t end, const graph_partitioner &partitioner,
+		size_t num_vertices, std::vector<std::vector<graph_chunk> > &chunks)
+{
+	size_t range_size = 1UL << graph_conf.get_part_range_size_log();
+	off_t chunk_start = start;
+	for (vertex_id_t id = 0; id < num_vertices; id += range_size) {
+		off_t chunk_end = end;
+		if (id + range_size < num_vertices)
+			chunk_end = ROUND_PAGE(finder.get_off(id + range_size, out_part));
+		assert(chunk_end <= end);
+		if (chunk_end <= chunk_start)
+			continue;
+
+		// Adjacent ranges in the same partition are read together.
+		std::vector<graph_chunk> &part_chunks = chunks[partitioner.map(id)];
+		if (!part_chunks.empty() && part_chunks.back().end == chunk_start)
+			part_chunks.back().end = chunk_end;
+		else
+			part_chunks.push_back(graph_chunk(chunk_start, chunk_end));
+		chunk_start = chunk_end;
+	}
+	assert(chunk_start == end);
+}
+
+static int open_graph_file(const std::string &file_name)
+{
+	int fd = open(file_name.c_str(), O_RDONLY);
+	if (fd < 0)
+		ABORT_MSG(boost::format("can't open %1%: %2%")
+				% file_name % strerror(errno));
+	return fd;
+}
+
+static void read_graph_file(int fd, const std::string &file_name, char *buf,
+		off_t off, size_t size)
+{
+	while (size > 0) {
+		ssize_t ret = pread(fd, buf + off, size, off);
+		if (ret <= 0)
+			ABORT_MSG(boost::format("can't read from %1%: %2%")
+					% file_name % strerror(errno));
+		off += ret;
+		size -= ret;
+	}
+}
+
+/*
+ * This thread loads the chunks of the graph file that belong to
+ * a partition. It runs on the NUMA node of the worker thread that owns
+ * the partition, and it touches the pages of the chunks before reading
+ * data to them, so the pages are allocated on the node. We don't rely on
+ * the thread that reads data to the pages because I/O to SAFS is performed
+ * by its own I/O threads.
+ */
+class graph_load_thread: public thread
+{
+	const std::vector<graph_chunk> &chunks;
+	char *graph_data;
+	const std::string file_name;
+	// The I/O factory for the graph file in SAFS. It's NULL if the graph
+	// file is in the Linux filesystem.
+	file_io_factory::shared_ptr io_factory;
+	size_t num_bytes;
+
+	void read_safs(io_interface &io, off_t off, size_t size);
+public:
+	graph_load_thread(const std::vector<graph_chunk> &_chunks, char *graph_data,
+			const std::string &file_name, file_io_factory::shared_ptr io_factory,
+			int node_id): thread("graph-load-thread", node_id), chunks(
+				_chunks), file_name(file_name) {
+		this->graph_data = graph_data;
+		this->io_factory = io_factory;
+		this->num_bytes = 0;
+	}
+
+	size_t get_num_bytes() const {
+		return num_bytes;
+	}
+
+	void run();
+};
+
+void graph_load_thread::read_safs(io_interface &io, off_t off, size_t size)
+{
+	const size_t MAX_IO_SIZE = 256 * 1024 * 1024;
+	while (size > 0) {
+		data_loc_t loc(io_factory->get_file_id(), off);
+		size_t req_size = min(MAX_IO_SIZE, size);
+		io_request req(graph_data + off, loc, req_size, READ);
+		io.access(&req, 1);
+		io.wait4complete(1);
+		off += req_size;
+		size -= req_size;
+	}
+}
+
+void graph_load_thread::run()
+{
+	int fd = -1;
+	io_interface::ptr io;
+	if (io_factory)
+		io = io_factory->create_io(this);
+	else
+		fd = open_graph_file(file_name);
+
+	for (size_t i = 0; i < chunks.size(); i++) {
+		off_t start = chunks[i].start;
+		size_t size = chunks[i].end - start;
+		for (off_t off = start; off < chunks[i].end; off += PAGE_SIZE)
+			graph_data[off] = 0;
+		if (io)
+			read_safs(*io, start, size);
+		else
+			read_graph_file(fd, file_name, graph_data, start, size);
+		num_bytes += size;
+	}
+
+	if (fd >= 0)
+		close(fd);
+	this->stop();
+}
+
+in_mem_graph::ptr in_mem_graph::load_numa_graph(const std::string &file_name,
+		vertex_index::ptr index, bool in_safs, bool huge_page)
+{
+	file_io_factory::shared_ptr io_factory;
+	size_t graph_size;
+	if (in_safs) {
+		io_factory = ::create_io_factory(file_name, REMOTE_ACCESS);
+		graph_size = io_factory->get_file_size();
+	}
+	else {
+		native_file local_f(file_name);
+		graph_size = local_f.get_size();
+	}
+	assert(graph_size > 0);
+
+	in_mem_graph::ptr graph = in_mem_graph::ptr(new in_mem_graph());
+	graph->graph_size = graph_size;
+	graph->graph_file_name = file_name;
+	// We allocate the memory with mmap, so physical pages aren't allocated
+	// until the loading threads touch them.
+	const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+	graph->map_size = ROUNDUP(graph_size, huge_page ? HUGE_PAGE_SIZE : PAGE_SIZE);
+	void *addr = mmap(NULL, graph->map_size, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (addr == MAP_FAILED) {
+		graph->map_size = 0;
+		throw io_exception(std::string("can't allocate memory for ")
+				+ file_name + ": " + strerror(errno));
+	}
+	graph->graph_data = (char *) addr;
+#ifdef MADV_HUGEPAGE
+	if (huge_page && madvise(addr, graph->map_size, MADV_HUGEPAGE) < 0)
+		BOOST_LOG_TRIVIAL(warning)
+			<< boost::format("can't use huge pages for %1%: %2%")
+			% file_name % strerror(errno);
+#endif
+
+	// The graph engine assigns a partition to each worker thread and
+	// the worker threads are assigned to NUMA nodes in a round-robin fashion.
+	int num_parts = graph_conf.get_num_threads();
+	int num_nodes = params.get_num_nodes();
+	range_graph_partitioner partitioner(num_parts);
+	vertex_loc_finder finder(index);
+	size_t num_vertices = index->get_num_vertices();
+	std::vector<std::vector<graph_chunk> > chunks(num_parts);
+	if (finder.is_directed()) {
+		off_t out_start = ROUND_PAGE(finder.get_off(0, true));
+		split_graph(finder, false, 0, out_start, partitioner, num_vertices,
+				chunks);
+		split_graph(finder, true, out_start, graph_size, partitioner,
+				num_vertices, chunks);
+	}
+	else
+		split_graph(finder, false, 0, graph_size, partitioner, num_vertices,
+				chunks);
+
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("load a graph of %1% bytes with %2% threads on %3% nodes")
+		% graph_size % num_parts % num_nodes;
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	std::vector<graph_load_thread *> threads(num_parts);
+	for (int i = 0; i < num_parts; i++) {
+		threads[i] = new graph_load_thread(chunks[i], graph->graph_data,
+				file_name, io_factory, i % num_nodes);
+		threads[i]->start();
+	}
+	std::vector<size_t> node_bytes(num_nodes);
+	for (int i = 0; i < num_parts; i++) {
+		threads[i]->join();
+		node_bytes[i % num_nodes] += threads[i]->get_num_bytes();
+		delete threads[i];
+	}
+	gettimeofday(&end, NULL);
+
+	float secs = time_diff(start, end);
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("load %1% bytes in %2% seconds (%3% MB/s)")
+		% graph_size % secs % (graph_size / 1024.0 / 1024.0 / secs);
+	for (int i = 0; i < num_nodes; i++)
+		BOOST_LOG_TRIVIAL(info) << boost::format("node %1% gets %2% bytes")
+			% i % node_bytes[i];
+
+	graph_header *header = (graph_header *) graph->graph_data;
+	header->verify();
+
+	return graph;
+}
+
 file_io_factory::shared_ptr in_mem_graph::create_io_factory() const
 {
 	return file_io_factory::shared_ptr(new in_mem_io_factory(*this,
@@ -20,21 +20,28 @@
  * limitations under the License.
  */
 
+#include <sys/mman.h>
+
 #include "io_interface.h"
 
 class in_mem_io;
 class thread_safe_page;
+class vertex_index;
 
 class in_mem_graph
 {
 	size_t graph_size;
 	char *graph_data;
+	// The size of the memory mapping if the graph data is allocated by
+	// mmap. It's 0 if the graph data is allocated by malloc.
+	size_t map_size;
 	int graph_file_id;
 	std::string graph_file_name;
 
 	in_mem_graph() {
 		graph_data = NULL;
 		graph_size = 0;
+		map_size = 0;
 		graph_file_id = -1;
 	}
 public:
@@ -55,9 +62,23 @@ public:
 
 	static ptr load_graph(const std::string &graph_file);
 	static ptr load_safs_graph(const std::string &graph_file);
+	/*
+	 * Load the graph with a thread for each partition of the graph engine.
+	 * The graph file is split with the vertex ranges of
+	 * range_graph_partitioner, and the adjacency lists in a range are
+	 * placed on the NUMA node of the worker thread that owns the range.
+	 * The graph is read from SAFS if `in_safs' is true, or from the Linux
+	 * filesystem otherwise. `huge_page' asks the kernel to back the graph
+	 * data with huge pages.
+	 */
+	static ptr load_numa_graph(const std::string &graph_file,
+			std::shared_ptr<vertex_index> index, bool in_safs, bool huge_page);
 
 	~in_mem_graph() {
-		free(graph_data);
+		if (map_size > 0)
+			munmap(graph_data, map_size);
+		else
+			free(graph_data);
 	}
 
 	file_io_factory::shared_ptr create_io_factory() const;
@@ -199,34 +199,9 @@ size_t directed_runtime_data_t::count_triangles(vertex_program &prog,
 			}
 		}
 	}
-	else {
-		std::vector<vertex_id_t>::const_iterator this_it = this->edges.begin();
-		std::vector<int>::iterator count_it = this->triangles.begin();
-		std::vector<vertex_id_t>::const_iterator this_end = this->edges.end();
-		page_byte_array::seq_const_iterator<vertex_id_t> other_it
-			= v.get_neigh_seq_it(edge_type::OUT_EDGE, 0,
-					v.get_num_edges(edge_type::OUT_EDGE));
-		while (this_it != this_end && other_it.has_next()) {
-			vertex_id_t this_neighbor = *this_it;
-			vertex_id_t neigh_neighbor = other_it.curr();
-			if (this_neighbor == neigh_neighbor) {
-				// skip loop
-				if (neigh_neighbor != v.get_id() && neigh_neighbor != id) {
-					num_local_triangles++;
-					(*count_it)++;
-				}
-				++this_it;
-				other_it.next();
-				++count_it;
-			}
-			else if (this_neighbor < neigh_neighbor) {
-				++this_it;
-				++count_it;
-			}
-			else
-				other_it.next();
-		}
-	}
+	else
+		num_local_triangles = count_triangles_scan(this, this->edges.size(),
+				v, edge_type::OUT_EDGE, id);
 	return num_local_triangles;
 }
 
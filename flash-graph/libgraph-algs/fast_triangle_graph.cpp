@@ -200,35 +200,9 @@ size_t count_triangles(runtime_data_t *data, const page_vertex &v,
 			}
 		}
 	}
-	else {
-		std::vector<vertex_id_t>::const_iterator this_it = data->edges.begin();
-		std::vector<int>::iterator count_it = data->triangles.begin();
-		std::vector<vertex_id_t>::const_iterator this_end = data->edges.end();
-		page_byte_array::seq_const_iterator<vertex_id_t> other_it
-			= v.get_neigh_seq_it(neigh_edge_type, 0,
-					v.get_num_edges(neigh_edge_type));
-		while (this_it != this_end && other_it.has_next()) {
-			vertex_id_t this_neighbor = *this_it;
-			vertex_id_t neigh_neighbor = other_it.curr();
-			if (this_neighbor == neigh_neighbor) {
-				// skip loop
-				if (neigh_neighbor != v.get_id()
-						&& neigh_neighbor != this_id) {
-					num_local_triangles++;
-					(*count_it)++;
-				}
-				++this_it;
-				other_it.next();
-				++count_it;
-			}
-			else if (this_neighbor < neigh_neighbor) {
-				++this_it;
-				++count_it;
-			}
-			else
-				other_it.next();
-		}
-	}
+	else
+		num_local_triangles = count_triangles_scan(data, data->edges.size(),
+				v, neigh_edge_type, this_id);
 	return num_local_triangles;
 }
 
@@ -0,0 +1,413 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifdef PROFILER
+#include <gperftools/profiler.h>
+#endif
+
+#include <vector>
+#include <unordered_map>
+
+#include "graph_engine.h"
+#include "graph_config.h"
+#include "FGlib.h"
+
+/*
+ * This runs many BFS in the same traversal of the graph. Each BFS is
+ * represented by a bit in a bitmap of a vertex, so a vertex reads its
+ * adjacency list once in an iteration and sends the bits of all BFS that
+ * reach it in the previous iteration to its neighbors.
+ */
+
+namespace {
+
+edge_type traverse_edge = edge_type::OUT_EDGE;
+int start_level;
+
+template<int NUM_WORDS>
+class bfs_bitmap
+{
+	uint64_t words[NUM_WORDS];
+public:
+	static const int NUM_BITS = NUM_WORDS * 64;
+
+	bfs_bitmap() {
+		clear();
+	}
+
+	void clear() {
+		for (int i = 0; i < NUM_WORDS; i++)
+			words[i] = 0;
+	}
+
+	void set(int idx) {
+		assert(idx < NUM_BITS);
+		words[idx / 64] |= ((uint64_t) 1) << (idx % 64);
+	}
+
+	bool is_empty() const {
+		for (int i = 0; i < NUM_WORDS; i++)
+			if (words[i])
+				return false;
+		return true;
+	}
+
+	void merge(const bfs_bitmap<NUM_WORDS> &map) {
+		for (int i = 0; i < NUM_WORDS; i++)
+			words[i] |= map.words[i];
+	}
+
+	/*
+	 * Get the bits that are in this bitmap but not in `map'.
+	 */
+	bfs_bitmap<NUM_WORDS> get_diff(const bfs_bitmap<NUM_WORDS> &map) const {
+		bfs_bitmap<NUM_WORDS> ret;
+		for (int i = 0; i < NUM_WORDS; i++)
+			ret.words[i] = words[i] & ~map.words[i];
+		return ret;
+	}
+
+	template<class Func>
+	void foreach_set(Func &func) const {
+		for (int i = 0; i < NUM_WORDS; i++) {
+			uint64_t word = words[i];
+			while (word) {
+				int idx = __builtin_ctzll(word);
+				word &= word - 1;
+				func(i * 64 + idx);
+			}
+		}
+	}
+};
+
+template<int NUM_WORDS>
+class msbfs_message: public vertex_message
+{
+	bfs_bitmap<NUM_WORDS> bfs_ids;
+public:
+	msbfs_message(const bfs_bitmap<NUM_WORDS> &bfs_ids): vertex_message(
+			sizeof(msbfs_message<NUM_WORDS>), true) {
+		this->bfs_ids = bfs_ids;
+	}
+
+	const bfs_bitmap<NUM_WORDS> &get_bfs_ids() const {
+		return bfs_ids;
+	}
+
+	void merge(const msbfs_message<NUM_WORDS> &msg) {
+		bfs_ids.merge(msg.bfs_ids);
+	}
+};
+
+/*
+ * A vertex only needs the union of the BFS that reach it.
+ */
+template<int NUM_WORDS>
+class msbfs_msg_combiner: public message_combiner
+{
+public:
+	void combine(vertex_message &combined, const vertex_message &msg) const {
+		((msbfs_message<NUM_WORDS> &) combined).merge(
+				(const msbfs_message<NUM_WORDS> &) msg);
+	}
+};
+
+template<int NUM_WORDS>
+class msbfs_vertex: public compute_directed_vertex
+{
+	// The BFS that have visited the vertex.
+	bfs_bitmap<NUM_WORDS> seen;
+	// The BFS that visit the vertex for the first time in the previous
+	// iteration. The vertex sends them to its neighbors.
+	bfs_bitmap<NUM_WORDS> frontier;
+	// The BFS that reach the vertex in the current iteration.
+	bfs_bitmap<NUM_WORDS> next;
+	bool notify_requested;
+public:
+	msbfs_vertex(vertex_id_t id): compute_directed_vertex(id) {
+		notify_requested = false;
+	}
+
+	void init(const bfs_bitmap<NUM_WORDS> &bfs_ids) {
+		reset();
+		seen = bfs_ids;
+		frontier = bfs_ids;
+	}
+
+	void reset() {
+		seen.clear();
+		frontier.clear();
+		next.clear();
+		notify_requested = false;
+	}
+
+	void run(vertex_program &prog) {
+		if (!frontier.is_empty()) {
+			directed_vertex_request req(prog.get_vertex_id(*this),
+					traverse_edge);
+			request_partial_vertices(&req, 1);
+		}
+	}
+
+	void run(vertex_program &prog, const page_vertex &vertex);
+
+	void run_on_message(vertex_program &prog, const vertex_message &msg) {
+		const msbfs_message<NUM_WORDS> &bmsg
+			= (const msbfs_message<NUM_WORDS> &) msg;
+		next.merge(bmsg.get_bfs_ids());
+		if (!notify_requested) {
+			notify_requested = true;
+			prog.request_notify_iter_end(*this);
+		}
+	}
+
+	void notify_iteration_end(vertex_program &prog);
+};
+
+/*
+ * This collects the number of vertices each BFS reaches and the distances
+ * of the vertices in the partition of a thread.
+ */
+template<int NUM_WORDS>
+class msbfs_vertex_program: public vertex_program_impl<msbfs_vertex<NUM_WORDS> >
+{
+	std::vector<size_t> num_reached;
+	std::vector<size_t> sum_dists;
+	std::vector<int> max_dists;
+public:
+	typedef std::shared_ptr<msbfs_vertex_program<NUM_WORDS> > ptr;
+
+	static ptr cast2(vertex_program::ptr prog) {
+		return std::static_pointer_cast<msbfs_vertex_program<NUM_WORDS>,
+			   vertex_program>(prog);
+	}
+
+	msbfs_vertex_program(): num_reached(bfs_bitmap<NUM_WORDS>::NUM_BITS),
+			sum_dists(bfs_bitmap<NUM_WORDS>::NUM_BITS),
+			max_dists(bfs_bitmap<NUM_WORDS>::NUM_BITS) {
+		this->set_msg_combiner(message_combiner::ptr(
+					new msbfs_msg_combiner<NUM_WORDS>()));
+	}
+
+	// It's invoked on each BFS that visits a vertex for the first time.
+	void add_visit(int bfs_id, int dist) {
+		num_reached[bfs_id]++;
+		sum_dists[bfs_id] += dist;
+		max_dists[bfs_id] = std::max(max_dists[bfs_id], dist);
+	}
+
+	void add_summaries(std::vector<bfs_summary> &summaries) const {
+		for (size_t i = 0; i < summaries.size(); i++) {
+			summaries[i].num_reached += num_reached[i];
+			summaries[i].sum_dists += sum_dists[i];
+			summaries[i].max_dist = std::max(summaries[i].max_dist,
+					max_dists[i]);
+		}
+	}
+};
+
+template<int NUM_WORDS>
+class visit_recorder
+{
+	msbfs_vertex_program<NUM_WORDS> &prog;
+	int dist;
+public:
+	visit_recorder(msbfs_vertex_program<NUM_WORDS> &_prog,
+			int dist): prog(_prog) {
+		this->dist = dist;
+	}
+
+	void operator()(int bfs_id) {
+		prog.add_visit(bfs_id, dist);
+	}
+};
+
+template<int NUM_WORDS>
+void msbfs_vertex<NUM_WORDS>::run(vertex_program &prog,
+		const page_vertex &vertex)
+{
+	msbfs_message<NUM_WORDS> msg(frontier);
+	frontier.clear();
+	if (traverse_edge == BOTH_EDGES) {
+		edge_seq_iterator it = vertex.get_neigh_seq_it(IN_EDGE);
+		prog.multicast_msg(it, msg);
+		it = vertex.get_neigh_seq_it(OUT_EDGE);
+		prog.multicast_msg(it, msg);
+	}
+	else {
+		edge_seq_iterator it = vertex.get_neigh_seq_it(traverse_edge);
+		prog.multicast_msg(it, msg);
+	}
+}
+
+template<int NUM_WORDS>
+void msbfs_vertex<NUM_WORDS>::notify_iteration_end(vertex_program &prog)
+{
+	notify_requested = false;
+	bfs_bitmap<NUM_WORDS> new_ids = next.get_diff(seen);
+	next.clear();
+	if (new_ids.is_empty())
+		return;
+
+	// The vertex is activated by the messages, so it sends the new BFS
+	// to its neighbors in the next iteration.
+	seen.merge(new_ids);
+	frontier = new_ids;
+	visit_recorder<NUM_WORDS> recorder((msbfs_vertex_program<NUM_WORDS> &) prog,
+			prog.get_graph().get_curr_level() + 1 - start_level);
+	new_ids.foreach_set(recorder);
+}
+
+template<int NUM_WORDS>
+class msbfs_vertex_program_creater: public vertex_program_creater
+{
+public:
+	vertex_program::ptr create() const {
+		return vertex_program::ptr(new msbfs_vertex_program<NUM_WORDS>());
+	}
+};
+
+template<int NUM_WORDS>
+class msbfs_reset: public vertex_initializer
+{
+public:
+	void init(compute_vertex &v) {
+		((msbfs_vertex<NUM_WORDS> &) v).reset();
+	}
+};
+
+template<int NUM_WORDS>
+class msbfs_initializer: public vertex_initializer
+{
+	typedef std::unordered_map<vertex_id_t, bfs_bitmap<NUM_WORDS> > source_map_t;
+	// A vertex may be the source of multiple BFS.
+	const source_map_t &sources;
+	graph_engine &graph;
+public:
+	msbfs_initializer(const source_map_t &_sources,
+			graph_engine &_graph): sources(_sources), graph(_graph) {
+	}
+
+	void init(compute_vertex &v) {
+		typename source_map_t::const_iterator it = sources.find(
+				graph.get_graph_index().get_vertex_id(v));
+		assert(it != sources.end());
+		((msbfs_vertex<NUM_WORDS> &) v).init(it->second);
+	}
+};
+
+/*
+ * Run a batch of BFS, one for each bit in the bitmap, and add
+ * the results to `summaries'.
+ */
+template<int NUM_WORDS>
+void run_msbfs_batch(graph_engine::ptr graph,
+		const std::vector<vertex_id_t> &sources, size_t batch_start,
+		std::vector<bfs_summary> &summaries)
+{
+	typedef std::unordered_map<vertex_id_t, bfs_bitmap<NUM_WORDS> > source_map_t;
+	size_t batch_size = std::min((size_t) bfs_bitmap<NUM_WORDS>::NUM_BITS,
+			sources.size() - batch_start);
+	source_map_t source_map;
+	for (size_t i = 0; i < batch_size; i++)
+		source_map[sources[batch_start + i]].set(i);
+	std::vector<vertex_id_t> start_vertices;
+	for (typename source_map_t::const_iterator it = source_map.begin();
+			it != source_map.end(); it++)
+		start_vertices.push_back(it->first);
+
+	start_level = graph->get_curr_level();
+	graph->init_all_vertices(vertex_initializer::ptr(
+				new msbfs_reset<NUM_WORDS>()));
+	graph->start(start_vertices.data(), start_vertices.size(),
+			vertex_initializer::ptr(new msbfs_initializer<NUM_WORDS>(
+					source_map, *graph)),
+			vertex_program_creater::ptr(
+				new msbfs_vertex_program_creater<NUM_WORDS>()));
+	graph->wait4complete();
+
+	std::vector<bfs_summary> batch_summaries(bfs_bitmap<NUM_WORDS>::NUM_BITS);
+	std::vector<vertex_program::ptr> vprogs;
+	graph->get_vertex_programs(vprogs);
+	BOOST_FOREACH(vertex_program::ptr vprog, vprogs) {
+		msbfs_vertex_program<NUM_WORDS>::cast2(vprog)->add_summaries(
+				batch_summaries);
+	}
+	for (size_t i = 0; i < batch_size; i++) {
+		bfs_summary &summary = summaries[batch_start + i];
+		summary.source = sources[batch_start + i];
+		// The source is at distance 0.
+		summary.num_reached = batch_summaries[i].num_reached + 1;
+		summary.sum_dists = batch_summaries[i].sum_dists;
+		summary.max_dist = batch_summaries[i].max_dist;
+	}
+}
+
+template<int NUM_WORDS>
+void run_msbfs(FG_graph::ptr fg, const std::vector<vertex_id_t> &sources,
+		std::vector<bfs_summary> &summaries)
+{
+	graph_index::ptr index = NUMA_graph_index<msbfs_vertex<NUM_WORDS> >::create(
+			fg->get_graph_header());
+	graph_engine::ptr graph = fg->create_engine(index);
+	for (size_t i = 0; i < sources.size();
+			i += bfs_bitmap<NUM_WORDS>::NUM_BITS) {
+		BOOST_LOG_TRIVIAL(info)
+			<< boost::format("BFS from sources %1% to %2%") % i
+			% std::min(sources.size(), i + bfs_bitmap<NUM_WORDS>::NUM_BITS);
+		run_msbfs_batch<NUM_WORDS>(graph, sources, i, summaries);
+	}
+}
+
+}
+
+std::vector<bfs_summary> compute_msbfs(FG_graph::ptr fg,
+		const std::vector<vertex_id_t> &sources, edge_type edge)
+{
+	traverse_edge = edge;
+	std::vector<bfs_summary> summaries(sources.size());
+	if (sources.empty())
+		return summaries;
+
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("multi-source BFS on %1% sources starts")
+		% sources.size();
+	BOOST_LOG_TRIVIAL(info) << "prof_file: " << graph_conf.get_prof_file();
+#ifdef PROFILER
+	if (!graph_conf.get_prof_file().empty())
+		ProfilerStart(graph_conf.get_prof_file().c_str());
+#endif
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	// A small batch uses a smaller bitmap to reduce the size of vertex
+	// state and messages.
+	if (sources.size() <= 64)
+		run_msbfs<1>(fg, sources, summaries);
+	else
+		run_msbfs<4>(fg, sources, summaries);
+	gettimeofday(&end, NULL);
+
+#ifdef PROFILER
+	if (!graph_conf.get_prof_file().empty())
+		ProfilerStop();
+#endif
+	BOOST_LOG_TRIVIAL(info) << boost::format("It takes %1% seconds in total")
+		% time_diff(start, end);
+	return summaries;
+}
@@ -139,8 +139,24 @@ public:
 	float get_delta() const {
 		return delta;
 	}
+
+	void add_delta(float delta) {
+		this->delta += delta;
+	}
 };
 
+/*
+ * A vertex only needs the sum of the deltas it receives in an iteration.
+ */
+class pr_msg_combiner: public message_combiner
+{
+public:
+	void combine(vertex_message &combined, const vertex_message &msg) const {
+		((pr_message &) combined).add_delta(((const pr_message &) msg).get_delta());
+	}
+};
+
+
 class pgrank_vertex2: public compute_directed_vertex
 {
 	float new_pr;
@@ -189,6 +205,111 @@ void pgrank_vertex2::run(vertex_program &prog, const page_vertex &vertex)
 	}
 }
 
+class pgrank2_vertex_program_creater: public vertex_program_creater
+{
+public:
+	vertex_program::ptr create() const {
+		vertex_program::ptr prog(new vertex_program_impl<pgrank_vertex2>());
+		prog->set_msg_combiner(message_combiner::ptr(new pr_msg_combiner()));
+		return prog;
+	}
+};
+
+/*
+ * This implements PageRank by accumulating deltas. A vertex accumulates
+ * the deltas it receives in its residual, and only adds the residual to
+ * its PageRank and pushes it to its out-neighbors when the residual is
+ * larger than the tolerance. Incoming deltas activate the vertex again.
+ * Vertices whose residuals are small don't read their edge lists, and
+ * the algorithm stops when no vertex is activated.
+ */
+class pgrank_delta_vertex: public compute_directed_vertex
+{
+	float curr_pr;
+	float residual;
+public:
+	pgrank_delta_vertex(vertex_id_t id): compute_directed_vertex(id) {
+		this->curr_pr = 0;
+		this->residual = 1 - DAMPING_FACTOR;
+	}
+
+	float get_result() const {
+		return curr_pr;
+	}
+
+	void run(vertex_program &prog) {
+		if (prog.get_graph().get_curr_level() >= max_num_iters)
+			return;
+		if (residual <= get_tolerance(prog))
+			return;
+		directed_vertex_request req(prog.get_vertex_id(*this),
+				edge_type::OUT_EDGE);
+		request_partial_vertices(&req, 1);
+	}
+
+	void run(vertex_program &prog, const page_vertex &vertex);
+
+	void run_on_message(vertex_program &, const vertex_message &msg1) {
+		const pr_message &msg = (const pr_message &) msg1;
+		residual += msg.get_delta();
+	}
+
+	static float get_tolerance(vertex_program &prog);
+};
+
+/*
+ * The tolerance is kept in the vertex program, so it doesn't affect
+ * the other PageRank implementations in the same process.
+ */
+class pgrank_delta_vertex_program: public vertex_program_impl<pgrank_delta_vertex>
+{
+	float tolerance;
+public:
+	pgrank_delta_vertex_program(float tolerance) {
+		this->tolerance = tolerance;
+	}
+
+	float get_tolerance() const {
+		return tolerance;
+	}
+};
+
+float pgrank_delta_vertex::get_tolerance(vertex_program &prog)
+{
+	return ((pgrank_delta_vertex_program &) prog).get_tolerance();
+}
+
+void pgrank_delta_vertex::run(vertex_program &prog, const page_vertex &vertex)
+{
+	// The vertex may have received more deltas since it requested
+	// its edge list.
+	float delta = residual;
+	residual = 0;
+	curr_pr += delta;
+
+	int num_dests = vertex.get_num_edges(OUT_EDGE);
+	if (num_dests == 0)
+		return;
+	edge_seq_iterator it = vertex.get_neigh_seq_it(OUT_EDGE, 0, num_dests);
+	pr_message msg(delta / num_dests * DAMPING_FACTOR);
+	prog.multicast_msg(it, msg);
+}
+
+class pgrank_delta_vertex_program_creater: public vertex_program_creater
+{
+	float tolerance;
+public:
+	pgrank_delta_vertex_program_creater(float tolerance) {
+		this->tolerance = tolerance;
+	}
+
+	vertex_program::ptr create() const {
+		vertex_program::ptr prog(new pgrank_delta_vertex_program(tolerance));
+		prog->set_msg_combiner(message_combiner::ptr(new pr_msg_combiner()));
+		return prog;
+	}
+};
+
 }
 
 #include "save_result.h"
@@ -266,7 +387,8 @@ FG_vector<float>::ptr compute_pagerank2(FG_graph::ptr fg, int num_iters,
 		ProfilerStart(graph_conf.get_prof_file().c_str());
 #endif
 
-	graph->start_all(); 
+	graph->start_all(vertex_initializer::ptr(),
+			vertex_program_creater::ptr(new pgrank2_vertex_program_creater()));
 	graph->wait4complete();
 	gettimeofday(&end, NULL);
 
@@ -285,3 +407,53 @@ FG_vector<float>::ptr compute_pagerank2(FG_graph::ptr fg, int num_iters,
 		% time_diff(start, end);
 	return ret;
 }
+
+FG_vector<float>::ptr compute_pagerank_delta(FG_graph::ptr fg, int num_iters,
+		float damping_factor, float tolerance)
+{
+	DAMPING_FACTOR = damping_factor;
+	if (DAMPING_FACTOR < 0 || DAMPING_FACTOR > 1) {
+		BOOST_LOG_TRIVIAL(fatal)
+			<< "Damping factor must be between 0 and 1 inclusive";
+		exit(-1);
+	}
+	if (tolerance <= 0) {
+		BOOST_LOG_TRIVIAL(fatal) << "Tolerance must be positive";
+		exit(-1);
+	}
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	graph_index::ptr index = NUMA_graph_index<pgrank_delta_vertex>::create(
+			fg->get_graph_header());
+	graph_engine::ptr graph = fg->create_engine(index);
+	max_num_iters = num_iters;
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("Delta-based pagerank (tolerance: %1%) starting")
+		% tolerance;
+	BOOST_LOG_TRIVIAL(info) << "prof_file: " << graph_conf.get_prof_file();
+#ifdef PROFILER
+	if (!graph_conf.get_prof_file().empty())
+		ProfilerStart(graph_conf.get_prof_file().c_str());
+#endif
+
+	graph->start_all(vertex_initializer::ptr(), vertex_program_creater::ptr(
+				new pgrank_delta_vertex_program_creater(tolerance)));
+	graph->wait4complete();
+	gettimeofday(&end, NULL);
+
+	FG_vector<float>::ptr ret = FG_vector<float>::create(
+			graph->get_num_vertices());
+	graph->query_on_all(vertex_query::ptr(
+				new save_query<float, pgrank_delta_vertex>(ret)));
+
+#ifdef PROFILER
+	if (!graph_conf.get_prof_file().empty())
+		ProfilerStop();
+#endif
+
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("It takes %1% seconds and %2% iterations in total")
+		% time_diff(start, end) % graph->get_curr_level();
+	return ret;
+}
@@ -25,6 +25,7 @@
 
 #include "graphlab/cuckoo_set_pow2.hpp"
 #include "scan_graph.h"
+#include "sorted_intersect.h"
 
 const double BIN_SEARCH_RATIO = 100;
 
@@ -134,51 +135,64 @@ size_t neighbor_list::count_edges_bin_search_other(const page_vertex *v,
 	return num_local_edges;
 }
 
-size_t neighbor_list::count_edges_scan(const page_vertex *v,
+namespace {
+
+/*
+ * This counts the edges between the neighbors of a vertex when we intersect
+ * the neighbor list with the edge list of a neighbor.
+ */
+class scan_counter
+{
+	const vertex_id_t *this_ids;
+	vertex_id_t neigh_id;
+	vertex_id_t this_id;
+	std::vector<vertex_id_t> *common_neighs;
+	size_t num_local_edges;
+	size_t last_idx;
+public:
+	scan_counter(const vertex_id_t *this_ids, vertex_id_t neigh_id,
+			vertex_id_t this_id, std::vector<vertex_id_t> *common_neighs) {
+		this->this_ids = this_ids;
+		this->neigh_id = neigh_id;
+		this->this_id = this_id;
+		this->common_neighs = common_neighs;
+		this->num_local_edges = 0;
+		this->last_idx = -1;
+	}
+
+	void operator()(size_t this_idx, size_t neigh_idx) {
+		vertex_id_t id = this_ids[this_idx];
+		if (id == neigh_id || id == this_id)
+			return;
+		// Edges in the v's neighbor lists may duplicated.
+		// The duplicated neighbors need to be counted multiple times.
+		num_local_edges++;
+		if (common_neighs && this_idx != last_idx)
+			common_neighs->push_back(id);
+		last_idx = this_idx;
+	}
+
+	size_t get_num_edges() const {
+		return num_local_edges;
+	}
+};
+
+}
+
+size_t neighbor_list::count_edges_scan(const page_vertex *v, edge_type type,
 		neighbor_list::id_iterator this_it,
-		neighbor_list::id_iterator this_end,
-		page_byte_array::seq_const_iterator<vertex_id_t> other_it,
+		neighbor_list::id_iterator this_end, size_t num_v_edges,
 		std::vector<vertex_id_t> *common_neighs) const
 {
-	size_t num_local_edges = 0;
-	while (other_it.has_next() && this_it != this_end) {
-		vertex_id_t this_neighbor = *this_it;
-		vertex_id_t neigh_neighbor = other_it.curr();
-		if (neigh_neighbor == v->get_id()
-				|| neigh_neighbor == this->get_id()) {
-			other_it.next();
-#if 0
-			++other_data_it;
-#endif
-			continue;
-		}
-		if (this_neighbor == neigh_neighbor) {
-			if (common_neighs)
-				common_neighs->push_back(*this_it);
-			do {
-				// Edges in the v's neighbor lists may duplicated.
-				// The duplicated neighbors need to be counted
-				// multiple times.
-#if 0
-				num_local_edges += (*other_data_it).get_count();
-				++other_data_it;
-#endif
-				num_local_edges++;
-				other_it.next();
-			} while (other_it.has_next() && this_neighbor == other_it.curr());
-			++this_it;
-		}
-		else if (this_neighbor < neigh_neighbor) {
-			++this_it;
-		}
-		else {
-			other_it.next();
-#if 0
-			++other_data_it;
-#endif
-		}
-	}
-	return num_local_edges;
+	// We have to read all edges of v, but only need the first `num_v_edges'.
+	size_t num_all_edges = v->get_num_edges(type);
+	stack_array<vertex_id_t, 1024> v_edges(num_all_edges);
+	v->read_edges(type, v_edges.data(), num_all_edges);
+	const vertex_id_t *this_ids = id_list.data() + (this_it - get_id_begin());
+	scan_counter counter(this_ids, v->get_id(), this->get_id(), common_neighs);
+	sorted_intersect(this_ids, this_end - this_it, v_edges.data(), num_v_edges,
+			counter);
+	return counter.get_num_edges();
 }
 
 size_t neighbor_list::count_edges(const page_vertex *v, edge_type type,
@@ -230,8 +244,8 @@ size_t neighbor_list::count_edges(const page_vertex *v, edge_type type,
 		scan_bytes += num_v_edges * sizeof(vertex_id_t);
 		scan_bytes += this->size() * sizeof(vertex_id_t);
 #endif
-		return count_edges_scan(v, this_it, this_end,
-				v->get_neigh_seq_it(type, 0, num_v_edges), common_neighs);
+		return count_edges_scan(v, type, this_it, this_end, num_v_edges,
+				common_neighs);
 	}
 }
 
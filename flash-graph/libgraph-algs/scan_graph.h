@@ -326,10 +326,9 @@ public:
 			page_byte_array::const_iterator<vertex_id_t> other_it,
 			page_byte_array::const_iterator<vertex_id_t> other_end,
 			std::vector<vertex_id_t> *common_neighs) const;
-	virtual size_t count_edges_scan(const page_vertex *v,
+	virtual size_t count_edges_scan(const page_vertex *v, edge_type type,
 			neighbor_list::id_iterator this_it,
-			neighbor_list::id_iterator this_end,
-			page_byte_array::seq_const_iterator<vertex_id_t> other_it,
+			neighbor_list::id_iterator this_end, size_t num_v_edges,
 			std::vector<vertex_id_t> *common_neighs) const;
 };
 
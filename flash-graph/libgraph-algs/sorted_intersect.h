@@ -0,0 +1,179 @@
+#ifndef __SORTED_INTERSECT_H__
+#define __SORTED_INTERSECT_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdlib.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "FG_basic_types.h"
+
+/**
+ * This file implements the intersection of two sorted vertex Id lists,
+ * which dominates the computation of triangle counting and scan statistics.
+ *
+ * For each element in `arr2' that also exists in `arr1', the handler is
+ * invoked with the locations of the element in both lists. The matches are
+ * reported in the ascending order of the elements. `arr1' is expected to
+ * have no duplicates, while duplicated elements in `arr2' are reported
+ * individually.
+ *
+ * On x86 CPUs, we compare a block of elements in one list with a block of
+ * elements in the other list with SIMD instructions. AVX2 is used if CPUID
+ * shows the CPU supports it, and SSE otherwise. The remaining elements
+ * that can't fill a block are intersected with a scalar merge.
+ */
+
+template<class Handler>
+void sorted_intersect_scalar(const vertex_id_t *arr1, size_t len1, size_t i,
+		const vertex_id_t *arr2, size_t len2, size_t j, Handler &handler)
+{
+	while (i < len1 && j < len2) {
+		if (arr1[i] == arr2[j]) {
+			handler(i, j);
+			// We don't move to the next element in arr1 because
+			// the next element in arr2 may be the same.
+			j++;
+		}
+		else if (arr1[i] < arr2[j])
+			i++;
+		else
+			j++;
+	}
+}
+
+#if defined(__x86_64__)
+
+/*
+ * Report the matches in a block in the order of the elements in arr2.
+ * masks[r] indicates the elements in the block of arr2 that match
+ * the elements in the block of arr1 rotated by r.
+ */
+template<int BLOCK_SIZE, class Handler>
+static inline void report_block_matches(const int masks[], int matched,
+		size_t i, size_t j, Handler &handler)
+{
+	while (matched) {
+		int l = __builtin_ctz(matched);
+		matched &= matched - 1;
+		for (int r = 0; r < BLOCK_SIZE; r++) {
+			if (masks[r] & (1 << l)) {
+				handler(i + (l + r) % BLOCK_SIZE, j + l);
+				break;
+			}
+		}
+	}
+}
+
+template<class Handler>
+void sorted_intersect_sse(const vertex_id_t *arr1, size_t len1,
+		const vertex_id_t *arr2, size_t len2, Handler &handler)
+{
+	const int BLOCK_SIZE = 4;
+	size_t i = 0;
+	size_t j = 0;
+	while (i + BLOCK_SIZE <= len1 && j + BLOCK_SIZE <= len2) {
+		__m128i a = _mm_loadu_si128((const __m128i *) (arr1 + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (arr2 + j));
+		int masks[BLOCK_SIZE];
+		// Lane l of the rotated block r contains a[(l + r) % 4].
+		masks[0] = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, a)));
+		masks[1] = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b,
+						_mm_shuffle_epi32(a, _MM_SHUFFLE(0, 3, 2, 1)))));
+		masks[2] = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b,
+						_mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)))));
+		masks[3] = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b,
+						_mm_shuffle_epi32(a, _MM_SHUFFLE(2, 1, 0, 3)))));
+		int matched = masks[0] | masks[1] | masks[2] | masks[3];
+		if (matched)
+			report_block_matches<BLOCK_SIZE>(masks, matched, i, j, handler);
+
+		// If the largest elements are the same, we only move to the next
+		// block in arr2, which may contain the same element.
+		vertex_id_t a_max = arr1[i + BLOCK_SIZE - 1];
+		vertex_id_t b_max = arr2[j + BLOCK_SIZE - 1];
+		if (a_max < b_max)
+			i += BLOCK_SIZE;
+		else
+			j += BLOCK_SIZE;
+	}
+	sorted_intersect_scalar(arr1, len1, i, arr2, len2, j, handler);
+}
+
+template<class Handler>
+__attribute__((target("avx2")))
+void sorted_intersect_avx2(const vertex_id_t *arr1, size_t len1,
+		const vertex_id_t *arr2, size_t len2, Handler &handler)
+{
+	const int BLOCK_SIZE = 8;
+	const __m256i rot = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+	size_t i = 0;
+	size_t j = 0;
+	while (i + BLOCK_SIZE <= len1 && j + BLOCK_SIZE <= len2) {
+		__m256i a = _mm256_loadu_si256((const __m256i *) (arr1 + i));
+		__m256i b = _mm256_loadu_si256((const __m256i *) (arr2 + j));
+		int masks[BLOCK_SIZE];
+		int matched = 0;
+		// Lane l of the rotated block r contains a[(l + r) % 8].
+		for (int r = 0; r < BLOCK_SIZE; r++) {
+			masks[r] = _mm256_movemask_ps(_mm256_castsi256_ps(
+						_mm256_cmpeq_epi32(b, a)));
+			matched |= masks[r];
+			a = _mm256_permutevar8x32_epi32(a, rot);
+		}
+		if (matched)
+			report_block_matches<BLOCK_SIZE>(masks, matched, i, j, handler);
+
+		vertex_id_t a_max = arr1[i + BLOCK_SIZE - 1];
+		vertex_id_t b_max = arr2[j + BLOCK_SIZE - 1];
+		if (a_max < b_max)
+			i += BLOCK_SIZE;
+		else
+			j += BLOCK_SIZE;
+	}
+	sorted_intersect_scalar(arr1, len1, i, arr2, len2, j, handler);
+}
+
+static inline bool cpu_support_avx2()
+{
+	static bool support = __builtin_cpu_supports("avx2");
+	return support;
+}
+
+#endif
+
+template<class Handler>
+void sorted_intersect(const vertex_id_t *arr1, size_t len1,
+		const vertex_id_t *arr2, size_t len2, Handler &handler)
+{
+#if defined(__x86_64__)
+	if (cpu_support_avx2())
+		sorted_intersect_avx2(arr1, len1, arr2, len2, handler);
+	else
+		sorted_intersect_sse(arr1, len1, arr2, len2, handler);
+#else
+	sorted_intersect_scalar(arr1, len1, 0, arr2, len2, 0, handler);
+#endif
+}
+
+#endif
@@ -36,8 +36,29 @@ namespace {
 time_t timestamp;
 time_t time_interval = 1;
 int num_time_intervals = 1;
+// If the timestamp index exists, a vertex only reads the edges in
+// the time intervals.
+ts_vertex_index::ptr ts_index;
+// The time range that covers all time intervals.
+time_t range_start;
+time_t range_interval;
+
+/*
+ * Get the edges of a vertex in a time interval. The vertex is
+ * a page_ts_range_vertex if it's read with the timestamp index.
+ */
+edge_seq_iterator get_edges(const page_vertex &v, edge_type type,
+		time_t time_start, time_t time_interval)
+{
+	if (ts_index)
+		return get_ts_iterator((const page_ts_range_vertex &) v, *ts_index,
+				type, time_start, time_interval);
+	else
+		return get_ts_iterator((const page_directed_vertex &) v, type,
+				time_start, time_interval);
+}
 
-class scan_vertex: public compute_vertex
+class scan_vertex: public compute_directed_vertex
 {
 	// The number of vertices that have joined with the vertex.
 	int num_joined;
@@ -50,7 +71,7 @@ class scan_vertex: public compute_vertex
 	// The final result.
 	double result;
 public:
-	scan_vertex(vertex_id_t id): compute_vertex(id) {
+	scan_vertex(vertex_id_t id): compute_directed_vertex(id) {
 		num_joined = 0;
 		local_scans = NULL;
 		neighbors = NULL;
@@ -60,38 +81,44 @@ public:
 		return result;
 	}
 
-	size_t count_edges(vertex_program &prog, const page_directed_vertex &v,
+	size_t count_edges(vertex_program &prog, const page_vertex &v,
 			const std::vector<vertex_id_t> *neighbors, time_t timestamp,
 			time_t time_interval);
-	size_t count_edges(vertex_program &prog, const page_directed_vertex &v,
+	size_t count_edges(vertex_program &prog, const page_vertex &v,
 			const std::vector<vertex_id_t> *neighbors, time_t timestamp,
 			time_t time_interval, edge_type type);
 
 	void run(vertex_program &prog) {
 		vertex_id_t id = prog.get_vertex_id(*this);
-		request_vertices(&id, 1);
+		if (ts_index) {
+			ts_range_request req(id, edge_type::BOTH_EDGES, range_start,
+					range_interval);
+			request_ts_vertices(&req, 1);
+		}
+		else
+			request_vertices(&id, 1);
 	}
 
 	void run(vertex_program &prog, const page_vertex &vertex) {
 		if (vertex.get_id() == prog.get_vertex_id(*this))
-			run_on_itself(prog, (const page_directed_vertex &) vertex);
+			run_on_itself(prog, vertex);
 		else
-			run_on_neighbor(prog, (const page_directed_vertex &) vertex);
+			run_on_neighbor(prog, vertex);
 	}
 
-	void run_on_itself(vertex_program &prog, const page_directed_vertex &vertex);
-	void run_on_neighbor(vertex_program &prog, const page_directed_vertex &vertex);
+	void run_on_itself(vertex_program &prog, const page_vertex &vertex);
+	void run_on_neighbor(vertex_program &prog, const page_vertex &vertex);
 
 	void run_on_message(vertex_program &prog, const vertex_message &msg) {
 	}
 };
 
-size_t scan_vertex::count_edges(vertex_program &prog, const page_directed_vertex &v,
+size_t scan_vertex::count_edges(vertex_program &prog, const page_vertex &v,
 		const std::vector<vertex_id_t> *neighbors, time_t timestamp,
 		time_t time_interval, edge_type type)
 {
 	size_t num_local_edges = 0;
-	page_byte_array::seq_const_iterator<vertex_id_t> it = get_ts_iterator(
+	page_byte_array::seq_const_iterator<vertex_id_t> it = get_edges(
 			v, type, timestamp, time_interval);
 	// If there are no edges in the time interval.
 	if (it.get_num_tot_entries() == 0)
@@ -113,7 +140,7 @@ size_t scan_vertex::count_edges(vertex_program &prog, const page_directed_vertex
 	return num_local_edges;
 }
 
-size_t scan_vertex::count_edges(vertex_program &prog, const page_directed_vertex &v,
+size_t scan_vertex::count_edges(vertex_program &prog, const page_vertex &v,
 		const std::vector<vertex_id_t> *neighbors, time_t timestamp,
 		time_t time_interval)
 {
@@ -175,10 +202,10 @@ int unique_merge(InputIterator1 it1, InputIterator1 last1,
 	return result - result_begin;
 }
 
-size_t get_neighbors(const page_directed_vertex &v, edge_type type, time_t time_start,
+size_t get_neighbors(const page_vertex &v, edge_type type, time_t time_start,
 		time_t time_interval, std::vector<vertex_id_t> &neighbors)
 {
-	page_byte_array::seq_const_iterator<vertex_id_t> it = get_ts_iterator(
+	page_byte_array::seq_const_iterator<vertex_id_t> it = get_edges(
 			v, type, time_start, time_interval);
 	size_t ret = it.get_num_tot_entries();
 	PAGE_FOREACH(vertex_id_t, id, it) {
@@ -188,7 +215,7 @@ size_t get_neighbors(const page_directed_vertex &v, edge_type type, time_t time_
 }
 
 void scan_vertex::run_on_itself(vertex_program &prog,
-		const page_directed_vertex &vertex)
+		const page_vertex &vertex)
 {
 	assert(neighbors == NULL);
 	assert(num_joined == 0);
@@ -254,7 +281,7 @@ void scan_vertex::run_on_itself(vertex_program &prog,
 
 		// For in-edges.
 		page_byte_array::seq_const_iterator<vertex_id_t> it
-			= get_ts_iterator(vertex, edge_type::IN_EDGE, timestamp2,
+			= get_edges(vertex, edge_type::IN_EDGE, timestamp2,
 					time_interval);
 		PAGE_FOREACH(vertex_id_t, id, it) {
 			// Ignore loop
@@ -267,7 +294,7 @@ void scan_vertex::run_on_itself(vertex_program &prog,
 		} PAGE_FOREACH_END
 
 		// For out-edges.
-		it = get_ts_iterator(vertex, edge_type::OUT_EDGE, timestamp2,
+		it = get_edges(vertex, edge_type::OUT_EDGE, timestamp2,
 					time_interval);
 		PAGE_FOREACH(vertex_id_t, id, it) {
 			// Ignore loop
@@ -280,11 +307,22 @@ void scan_vertex::run_on_itself(vertex_program &prog,
 		} PAGE_FOREACH_END
 	}
 
-	request_vertices(neighbors->data(), neighbors->size());
+	if (ts_index) {
+		std::vector<ts_range_request> reqs(neighbors->size());
+		for (size_t i = 0; i < neighbors->size(); i++)
+			reqs[i] = ts_range_request(neighbors->at(i), edge_type::BOTH_EDGES,
+					range_start, range_interval);
+		// A neighbor always has the edge to this vertex in the time range,
+		// so all neighbors are read.
+		BOOST_VERIFY(request_ts_vertices(reqs.data(), reqs.size())
+				== neighbors->size());
+	}
+	else
+		request_vertices(neighbors->data(), neighbors->size());
 }
 
 void scan_vertex::run_on_neighbor(vertex_program &prog,
-		const page_directed_vertex &vertex)
+		const page_vertex &vertex)
 {
 	num_joined++;
 	assert(neighbors);
@@ -339,12 +377,23 @@ FG_vector<float>::ptr compute_sstsg(FG_graph::ptr fg, time_t start_time,
 	timestamp = start_time;
 	time_interval = interval;
 	num_time_intervals = num_intervals;
+	range_start = timestamp;
+	for (int j = 1; j < num_time_intervals && timestamp >= j * time_interval; j++)
+		range_start = timestamp - j * time_interval;
+	range_interval = timestamp + time_interval - range_start;
 
 	graph_index::ptr index = NUMA_graph_index<scan_vertex>::create(
 			fg->get_graph_header());
 	graph_engine::ptr graph = fg->create_engine(index);
 	assert(graph->get_graph_header().get_graph_type() == graph_type::DIRECTED);
 	assert(graph->get_graph_header().has_edge_data());
+	ts_index = graph->get_ts_index();
+	if (ts_index && !ts_index->is_aligned(timestamp, time_interval)) {
+		BOOST_LOG_TRIVIAL(warning) << boost::format(
+				"The time interval isn't aligned with the timestamp index of %1% seconds. Read entire vertices.")
+			% ts_index->get_granularity();
+		ts_index = ts_vertex_index::ptr();
+	}
 	BOOST_LOG_TRIVIAL(info)
 		<< boost::format("scan statistics starts, start: %1%, interval: %2%, #interval: %3%")
 		% timestamp % time_interval % num_time_intervals;
@@ -368,5 +417,6 @@ FG_vector<float>::ptr compute_sstsg(FG_graph::ptr fg, time_t start_time,
 
 	FG_vector<float>::ptr vec = FG_vector<float>::create(graph);
 	graph->query_on_all(vertex_query::ptr(new save_query<float, scan_vertex>(vec)));
+	ts_index = ts_vertex_index::ptr();
 	return vec;
 }
@@ -25,6 +25,7 @@
 #include "graphlab/cuckoo_set_pow2.hpp"
 #include "FG_vector.h"
 #include "FGlib.h"
+#include "sorted_intersect.h"
 
 /**
  * This contains the data structures shared directed triangle counting
@@ -190,3 +191,61 @@ public:
 		return (runtime_data_t *) (value & FLAGS_MASK);
 	}
 };
+
+/*
+ * This counts the triangles when we intersect the edge list of a vertex
+ * with the edge list of its neighbor.
+ */
+class triangle_counter
+{
+	const vertex_id_t *edges;
+	int *triangles;
+	vertex_id_t neigh_id;
+	vertex_id_t this_id;
+	size_t num_triangles;
+	size_t last_idx;
+public:
+	triangle_counter(runtime_data_t *data, vertex_id_t neigh_id,
+			vertex_id_t this_id) {
+		this->edges = data->edges.data();
+		this->triangles = data->triangles.data();
+		this->neigh_id = neigh_id;
+		this->this_id = this_id;
+		this->num_triangles = 0;
+		this->last_idx = -1;
+	}
+
+	void operator()(size_t idx, size_t neigh_idx) {
+		// The neighbor may have duplicated edges. We only count an edge of
+		// this vertex once.
+		if (idx == last_idx)
+			return;
+		last_idx = idx;
+		// skip loop
+		if (edges[idx] != neigh_id && edges[idx] != this_id) {
+			num_triangles++;
+			triangles[idx]++;
+		}
+	}
+
+	size_t get_num_triangles() const {
+		return num_triangles;
+	}
+};
+
+/*
+ * Count the triangles by intersecting the first `num_this_edges' edges
+ * in the runtime data with the edges of the neighbor vertex.
+ */
+static inline size_t count_triangles_scan(runtime_data_t *data,
+		size_t num_this_edges, const page_vertex &v, edge_type type,
+		vertex_id_t this_id)
+{
+	size_t num_neigh_edges = v.get_num_edges(type);
+	stack_array<vertex_id_t, 1024> neigh_edges(num_neigh_edges);
+	v.read_edges(type, neigh_edges.data(), num_neigh_edges);
+	triangle_counter counter(data, v.get_id(), this_id);
+	sorted_intersect(data->edges.data(), num_this_edges, neigh_edges.data(),
+			num_neigh_edges, counter);
+	return counter.get_num_triangles();
+}
@@ -239,35 +239,11 @@ int undirected_triangle_vertex::count_triangles(vertex_program &prog,
 		}
 	}
 	else {
-		std::vector<vertex_id_t>::const_iterator this_it = data->edges.cbegin();
-		std::vector<vertex_id_t>::const_iterator this_end
-			= std::lower_bound(this_it, data->edges.cend(), v->get_id());
-		std::vector<int>::iterator count_it = data->triangles.begin();
-
-		page_byte_array::seq_const_iterator<vertex_id_t> other_it
-			= v->get_neigh_seq_it(edge_type::OUT_EDGE, 0,
-					v->get_num_edges(edge_type::OUT_EDGE));
-		while (this_it != this_end && other_it.has_next()) {
-			vertex_id_t this_neighbor = *this_it;
-			vertex_id_t neigh_neighbor = other_it.curr();
-			if (this_neighbor == neigh_neighbor) {
-				// skip loop
-				if (neigh_neighbor != v->get_id()
-						&& neigh_neighbor != this_id) {
-					num_local_triangles++;
-					(*count_it)++;
-				}
-				++this_it;
-				other_it.next();
-				++count_it;
-			}
-			else if (this_neighbor < neigh_neighbor) {
-				++this_it;
-				++count_it;
-			}
-			else
-				other_it.next();
-		}
+		// We only need the edges of this vertex smaller than the neighbor.
+		size_t num_this_edges = std::lower_bound(data->edges.cbegin(),
+				data->edges.cend(), v->get_id()) - data->edges.cbegin();
+		num_local_triangles = count_triangles_scan(data, num_this_edges,
+				*v, edge_type::OUT_EDGE, this_id);
 	}
 	return num_local_triangles;
 }
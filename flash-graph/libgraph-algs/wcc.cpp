@@ -43,14 +43,18 @@ public:
 	vertex_id_t get_id() const {
 		return id;
 	}
+
+	void set_id(vertex_id_t id) {
+		this->id = id;
+	}
 };
 
 class wcc_vertex: public compute_directed_vertex
 {
 protected:
 	bool empty;
-private:
 	bool updated;
+private:
 	vertex_id_t component_id;
 public:
 	wcc_vertex(vertex_id_t id): compute_directed_vertex(id) {
@@ -93,6 +97,20 @@ public:
 	}
 };
 
+/*
+ * A vertex only needs the smallest component Id it receives.
+ */
+class component_msg_combiner: public message_combiner
+{
+public:
+	void combine(vertex_message &combined, const vertex_message &msg) const {
+		component_message &cmsg = (component_message &) combined;
+		const component_message &new_msg = (const component_message &) msg;
+		if (new_msg.get_id() < cmsg.get_id())
+			cmsg.set_id(new_msg.get_id());
+	}
+};
+
 template<class vertex_type>
 class wcc_vertex_program: public vertex_program_impl<vertex_type>
 {
@@ -100,6 +118,11 @@ class wcc_vertex_program: public vertex_program_impl<vertex_type>
 public:
 	typedef std::shared_ptr<wcc_vertex_program<vertex_type> > ptr;
 
+	wcc_vertex_program() {
+		this->set_msg_combiner(message_combiner::ptr(
+					new component_msg_combiner()));
+	}
+
 	static ptr cast2(vertex_program::ptr prog) {
 		return std::static_pointer_cast<wcc_vertex_program<vertex_type>,
 			   vertex_program>(prog);
@@ -257,9 +280,7 @@ public:
 	ts_wcc_vertex(vertex_id_t id): wcc_vertex(id) {
 	}
 
-	void run(vertex_program &prog) {
-		wcc_vertex::run(prog);
-	}
+	void run(vertex_program &prog);
 
 	void run(vertex_program &prog, const page_vertex &vertex);
 };
@@ -268,10 +289,19 @@ class ts_wcc_vertex_program: public vertex_program_impl<ts_wcc_vertex>
 {
 	time_t start_time;
 	time_t time_interval;
+	// If the timestamp index exists, vertices only read the edges
+	// in the time interval.
+	ts_vertex_index::ptr ts_index;
 public:
-	ts_wcc_vertex_program(time_t start_time, time_t time_interval) {
+	ts_wcc_vertex_program(time_t start_time, time_t time_interval,
+			ts_vertex_index::ptr ts_index) {
 		this->start_time = start_time;
 		this->time_interval = time_interval;
+		this->ts_index = ts_index;
+	}
+
+	ts_vertex_index::ptr get_ts_index() const {
+		return ts_index;
 	}
 
 	time_t get_start_time() const {
@@ -287,22 +317,54 @@ class ts_wcc_vertex_program_creater: public vertex_program_creater
 {
 	time_t start_time;
 	time_t time_interval;
+	ts_vertex_index::ptr ts_index;
 public:
-	ts_wcc_vertex_program_creater(time_t start_time, time_t time_interval) {
+	ts_wcc_vertex_program_creater(time_t start_time, time_t time_interval,
+			ts_vertex_index::ptr ts_index) {
 		this->start_time = start_time;
 		this->time_interval = time_interval;
+		this->ts_index = ts_index;
 	}
 
 	vertex_program::ptr create() const {
 		return vertex_program::ptr(new ts_wcc_vertex_program(
-					start_time, time_interval));
+					start_time, time_interval, ts_index));
 	}
 };
 
+void ts_wcc_vertex::run(vertex_program &prog)
+{
+	ts_wcc_vertex_program &wcc_vprog = (ts_wcc_vertex_program &) prog;
+	if (wcc_vprog.get_ts_index() == NULL) {
+		wcc_vertex::run(prog);
+		return;
+	}
+
+	if (updated) {
+		ts_range_request req(prog.get_vertex_id(*this), edge_type::BOTH_EDGES,
+				wcc_vprog.get_start_time(), wcc_vprog.get_time_interval());
+		// The vertex doesn't have edges in the time interval if
+		// it isn't requested.
+		request_ts_vertices(&req, 1);
+		updated = false;
+	}
+}
+
 void ts_wcc_vertex::run(vertex_program &prog, const page_vertex &vertex)
 {
 	assert(prog.get_graph().is_directed());
 	ts_wcc_vertex_program &wcc_vprog = (ts_wcc_vertex_program &) prog;
+	// The vertex only has the edges in the time interval.
+	if (wcc_vprog.get_ts_index()) {
+		empty = false;
+		component_message msg(get_component_id());
+		edge_seq_iterator in_it = vertex.get_neigh_seq_it(edge_type::IN_EDGE);
+		prog.multicast_msg(in_it, msg);
+		edge_seq_iterator out_it = vertex.get_neigh_seq_it(edge_type::OUT_EDGE);
+		prog.multicast_msg(out_it, msg);
+		return;
+	}
+
 	const page_directed_vertex &dvertex = (const page_directed_vertex &) vertex;
 	edge_seq_iterator in_it = get_ts_iterator(dvertex, edge_type::IN_EDGE,
 			wcc_vprog.get_start_time(), wcc_vprog.get_time_interval());
@@ -392,13 +454,21 @@ FG_vector<vertex_id_t>::ptr compute_ts_wcc(FG_graph::ptr fg,
 	graph_engine::ptr graph = fg->create_engine(index);
 	assert(graph->get_graph_header().has_edge_data());
 	BOOST_LOG_TRIVIAL(info) << "TS weakly connected components starts";
+	ts_vertex_index::ptr ts_index = graph->get_ts_index();
+	if (ts_index && !ts_index->is_aligned(start_time, time_interval)) {
+		BOOST_LOG_TRIVIAL(warning) << boost::format(
+				"The time interval isn't aligned with the timestamp index of %1% seconds. Read entire vertices.")
+			% ts_index->get_granularity();
+		ts_index = ts_vertex_index::ptr();
+	}
 #ifdef PROFILER
 	if (!graph_conf.get_prof_file().empty())
 		ProfilerStart(graph_conf.get_prof_file().c_str());
 #endif
 
 	graph->start_all(vertex_initializer::ptr(), vertex_program_creater::ptr(
-				new ts_wcc_vertex_program_creater(start_time, time_interval)));
+				new ts_wcc_vertex_program_creater(start_time, time_interval,
+					ts_index)));
 	graph->wait4complete();
 	gettimeofday(&end, NULL);
 	BOOST_LOG_TRIVIAL(info)
@@ -17,6 +17,10 @@
  * limitations under the License.
  */
 
+#include <stdlib.h>
+
+#include <algorithm>
+
 #include "load_balancer.h"
 #include "worker_thread.h"
 #include "graph_engine.h"
@@ -24,7 +28,16 @@
 load_balancer::load_balancer(graph_engine &_graph,
 		worker_thread &_owner): owner(_owner), graph(_graph)
 {
-	steal_thread_id = (owner.get_worker_id() + 1) % graph.get_num_threads();
+	local_chunk_idx = 0;
+	rand_seed = owner.get_worker_id();
+	for (int i = 0; i < graph.get_num_threads(); i++) {
+		if (i == owner.get_worker_id())
+			continue;
+		if (graph.get_thread_node_id(i) == owner.get_node_id())
+			local_victims.push_back(i);
+		else
+			remote_victims.push_back(i);
+	}
 	// TODO can I have a better way to do it?
 	completed_stolen_vertices = (fifo_queue<vertex_id_t> *) malloc(
 			graph.get_num_threads() * sizeof(fifo_queue<vertex_id_t>));
@@ -33,6 +46,7 @@ load_balancer::load_balancer(graph_engine &_graph,
 				_owner.get_node_id(), PAGE_SIZE, true);
 	}
 	num_completed_stolen_vertices = 0;
+	num_stolen = 0;
 }
 
 load_balancer::~load_balancer()
@@ -43,34 +57,142 @@ load_balancer::~load_balancer()
 }
 
 /**
- * This steals vertices from other threads. It tries to steal more vertices
- * than it can process, and the remaining vertices will be placed in its
- * own activated vertex queue.
+ * This moves activated vertices from the queue of the owner thread to
+ * the deque. The chunks are pushed in the reverse order, so the owner
+ * thread processes vertices in the order of the queue, while thieves
+ * steal the vertices that the owner thread would process last.
+ */
+bool load_balancer::refill_deque()
+{
+	assert(deque.is_empty());
+	int max_num = NUM_REFILL_CHUNKS * vertex_chunk::CHUNK_SIZE;
+	stack_array<compute_vertex_pointer> buf(max_num);
+	int num = owner.curr_activated_vertices->fetch(buf.data(), max_num);
+	if (num == 0)
+		return false;
+
+	int num_chunks = ROUNDUP(num, vertex_chunk::CHUNK_SIZE)
+		/ vertex_chunk::CHUNK_SIZE;
+	for (int i = num_chunks - 1; i >= 0; i--) {
+		vertex_chunk chunk;
+		int off = i * vertex_chunk::CHUNK_SIZE;
+		chunk.num = std::min(num - off, vertex_chunk::CHUNK_SIZE);
+		memcpy(chunk.vertices, buf.data() + off,
+				chunk.num * sizeof(chunk.vertices[0]));
+		BOOST_VERIFY(deque.push(chunk));
+	}
+	return true;
+}
+
+int load_balancer::fetch_local_chunk(compute_vertex_pointer vertices[],
+		int num)
+{
+	int num_fetches = std::min(num, local_chunk.num - local_chunk_idx);
+	memcpy(vertices, local_chunk.vertices + local_chunk_idx,
+			num_fetches * sizeof(vertices[0]));
+	local_chunk_idx += num_fetches;
+	return num_fetches;
+}
+
+int load_balancer::fetch_activated_vertices(compute_vertex_pointer vertices[],
+		int num)
+{
+	int num_fetches = 0;
+	while (num_fetches < num) {
+		if (local_chunk_idx < local_chunk.num) {
+			num_fetches += fetch_local_chunk(vertices + num_fetches,
+					num - num_fetches);
+			continue;
+		}
+
+		// The owner thread may lose the last chunk in the deque to
+		// a thief, so we need to check whether the deque is empty.
+		// We can't pop to `local_chunk' directly because a failed pop
+		// may overwrite it.
+		vertex_chunk chunk;
+		if (deque.pop(chunk)) {
+			local_chunk = chunk;
+			local_chunk_idx = 0;
+		}
+		else if (!deque.is_empty())
+			continue;
+		else if (!refill_deque())
+			break;
+	}
+	return num_fetches;
+}
+
+void load_balancer::add_stolen_part(int part_id)
+{
+	if (std::find(stolen_parts.begin(), stolen_parts.end(),
+				part_id) == stolen_parts.end())
+		stolen_parts.push_back(part_id);
+}
+
+int load_balancer::steal_chunk(const std::vector<int> &victims,
+		compute_vertex_pointer vertices[], int num)
+{
+	if (victims.empty())
+		return 0;
+
+	int start = rand_r(&rand_seed) % victims.size();
+	for (size_t i = 0; i < victims.size(); i++) {
+		int victim = victims[(start + i) % victims.size()];
+		worker_thread *t = graph.get_thread(victim);
+		vertex_chunk chunk;
+		if (t->get_balancer().steal_chunk(chunk)) {
+			// The stolen chunk becomes the local chunk of this thread, so
+			// the vertices that can't be returned now are fetched next time.
+			local_chunk = chunk;
+			local_chunk_idx = 0;
+			// If the thread steals vertices from another thread successfully,
+			// it needs to notify the thread of the stolen vertices.
+			t->notify_stolen_vertices(local_chunk.vertices, local_chunk.num);
+			add_stolen_part(victim);
+			num_stolen += local_chunk.num;
+			return fetch_local_chunk(vertices, num);
+		}
+	}
+	return 0;
+}
+
+int load_balancer::steal_queue(const std::vector<int> &victims,
+		compute_vertex_pointer vertices[], int num)
+{
+	if (victims.empty())
+		return 0;
+
+	int start = rand_r(&rand_seed) % victims.size();
+	for (size_t i = 0; i < victims.size(); i++) {
+		int victim = victims[(start + i) % victims.size()];
+		int ret = graph.get_thread(victim)->steal_activated_vertices(
+				vertices, num);
+		if (ret > 0) {
+			add_stolen_part(victim);
+			num_stolen += ret;
+			return ret;
+		}
+	}
+	return 0;
+}
+
+/**
+ * This steals vertices from other threads. It steals a chunk from
+ * the deques of other threads first. If all deques are empty, it steals
+ * the vertices that haven't been moved to the deques from the queues of
+ * other threads directly.
  */
 int load_balancer::steal_activated_vertices(compute_vertex_pointer vertex_buf[],
 		int buf_size)
 {
-	if (steal_thread_id == owner.get_worker_id())
-		steal_thread_id = (steal_thread_id + 1) % graph.get_num_threads();
-	int num_tries = 0;
-	int num;
-	do {
-		worker_thread *t = graph.get_thread(steal_thread_id);
-		num_tries++;
-
-		num = t->steal_activated_vertices(vertex_buf, buf_size);
-		// If we can't steal vertices from the thread, we should move
-		// to the next thread.
-		if (num == 0)
-			steal_thread_id = (steal_thread_id + 1) % graph.get_num_threads();
-		// If we have tried to steal vertices from all threads.
-	} while (num == 0 && num_tries < graph.get_num_threads());
-
-	// Record the owner thread of the stolen vertices.
-	for (int i = 0; i < num; i++)
-		stolen_vertex_map.insert(vertex_map_t::value_type(
-					vertex_buf[i].get(), steal_thread_id));
-
+	assert(local_chunk_idx == local_chunk.num);
+	int num = steal_chunk(local_victims, vertex_buf, buf_size);
+	if (num == 0)
+		num = steal_chunk(remote_victims, vertex_buf, buf_size);
+	if (num == 0)
+		num = steal_queue(local_victims, vertex_buf, buf_size);
+	if (num == 0)
+		num = steal_queue(remote_victims, vertex_buf, buf_size);
 	return num;
 }
 
@@ -100,9 +222,8 @@ void load_balancer::return_vertices(const compute_vertex_pointer vs[], int num)
 {
 	for (int i = 0; i < num; i++) {
 		compute_vertex_pointer v = vs[i];
-		vertex_map_t::iterator it = stolen_vertex_map.find(v.get());
-		assert(it != stolen_vertex_map.end());
-		int part_id = it->second;
+		int part_id = get_stolen_vertex_part(*v);
+		assert(part_id >= 0);
 		// We don't need to return verticalled partitioned vertices to their
 		// owner because messages are processed in the main vertices and the
 		// main vertices cannot be stolen by other threads.
@@ -118,7 +239,6 @@ void load_balancer::return_vertices(const compute_vertex_pointer vs[], int num)
 			completed_stolen_vertices[part_id].push_back(id);
 			num_completed_stolen_vertices++;
 		}
-		stolen_vertex_map.erase(it);
 	}
 }
 
@@ -127,13 +247,17 @@ void load_balancer::reset()
 	for (int i = 0; i < graph.get_num_threads(); i++)
 		assert(completed_stolen_vertices[i].is_empty());
 	assert(num_completed_stolen_vertices == 0);
+	assert(deque.is_empty());
+	assert(local_chunk_idx == local_chunk.num);
+	stolen_parts.clear();
 }
 
 int load_balancer::get_stolen_vertex_part(const compute_vertex &v) const
 {
-	vertex_map_t::const_iterator it = stolen_vertex_map.find(&v);
-	if (it != stolen_vertex_map.end())
-		return it->second;
-	else
-		return -1;
+	const graph_index &index = graph.get_graph_index();
+	for (size_t i = 0; i < stolen_parts.size(); i++) {
+		if (index.belong2part(v, stolen_parts[i]))
+			return stolen_parts[i];
+	}
+	return -1;
 }
@@ -20,38 +20,163 @@
  * limitations under the License.
  */
 
-#include <unordered_map>
+#include <atomic>
+#include <vector>
 
 #include "container.h"
 #include "vertex.h"
+#include "vertex_pointer.h"
 
 class worker_thread;
 class graph_engine;
 class compute_vertex;
-class compute_vertex_pointer;
+
+/**
+ * A chunk of activated vertices. It is the unit of work stealing.
+ */
+struct vertex_chunk
+{
+	static const int CHUNK_SIZE = 64;
+
+	int num;
+	compute_vertex_pointer vertices[CHUNK_SIZE];
+
+	vertex_chunk() {
+		num = 0;
+	}
+};
+
+/**
+ * This is a bounded Chase-Lev work-stealing deque of vertex chunks.
+ * The owner thread pushes and pops chunks at the bottom, and other threads
+ * steal chunks from the top without locking.
+ *
+ * The chunks are stored in the deque by value. A thief may read a chunk
+ * while the owner thread is overwriting it, but the thief can't win
+ * the race on `top' in this case, so it always discards the chunk.
+ */
+class vertex_chunk_deque
+{
+	static const long CAPACITY = 32;
+
+	std::atomic_long top;
+	std::atomic_long bottom;
+	vertex_chunk chunks[CAPACITY];
+public:
+	vertex_chunk_deque() {
+		top = 0;
+		bottom = 0;
+	}
+
+	static long get_capacity() {
+		return CAPACITY;
+	}
+
+	long get_size() const {
+		long b = bottom.load(std::memory_order_relaxed);
+		long t = top.load(std::memory_order_relaxed);
+		return b > t ? b - t : 0;
+	}
+
+	bool is_empty() const {
+		return get_size() == 0;
+	}
+
+	/*
+	 * These two methods can only be invoked by the owner thread.
+	 */
+
+	bool push(const vertex_chunk &chunk) {
+		long b = bottom.load(std::memory_order_relaxed);
+		long t = top.load(std::memory_order_acquire);
+		if (b - t >= CAPACITY)
+			return false;
+		chunks[b % CAPACITY] = chunk;
+		bottom.store(b + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(vertex_chunk &chunk) {
+		long b = bottom.load(std::memory_order_relaxed) - 1;
+		bottom.store(b, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long t = top.load(std::memory_order_relaxed);
+		if (t > b) {
+			// The deque is empty.
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return false;
+		}
+		chunk = chunks[b % CAPACITY];
+		if (t == b) {
+			// This is the last chunk. We have to compete with the thieves.
+			bool success = top.compare_exchange_strong(t, t + 1,
+					std::memory_order_seq_cst, std::memory_order_relaxed);
+			bottom.store(b + 1, std::memory_order_relaxed);
+			return success;
+		}
+		return true;
+	}
+
+	/*
+	 * This can be invoked by any thread.
+	 */
+	bool steal(vertex_chunk &chunk) {
+		long t = top.load(std::memory_order_acquire);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		long b = bottom.load(std::memory_order_acquire);
+		if (t >= b)
+			return false;
+		chunk = chunks[t % CAPACITY];
+		return top.compare_exchange_strong(t, t + 1,
+				std::memory_order_seq_cst, std::memory_order_relaxed);
+	}
+};
 
 /**
  * This class is to help balance the load.
- * If the owner thread has finished the work originally assigned to it,
- * it can steal work from other threads through this class.
+ * The owner thread moves its activated vertices to a work-stealing deque
+ * in chunks. If a thread has finished the work originally assigned to it,
+ * it steals chunks from the deques of other threads, first from the threads
+ * in the same NUMA node and then from the ones in other NUMA nodes.
+ * The victims are tried in a random order.
  */
 class load_balancer
 {
-	typedef std::unordered_map<const compute_vertex *, int> vertex_map_t;
+	// The number of chunks moved to the deque each time.
+	static const int NUM_REFILL_CHUNKS = 16;
 
 	worker_thread &owner;
 	graph_engine &graph;
 
-	// This map records the owner threads of vertices stolen from another
-	// partition.
-	vertex_map_t stolen_vertex_map;
+	vertex_chunk_deque deque;
+	// The chunk being processed by the thread.
+	vertex_chunk local_chunk;
+	int local_chunk_idx;
+
+	// The threads in the same NUMA node and the ones in other NUMA nodes.
+	std::vector<int> local_victims;
+	std::vector<int> remote_victims;
+	unsigned int rand_seed;
+
+	// The partitions where we have stolen vertices from in the current
+	// level. A stolen vertex always belongs to one of them, so we can find
+	// the owner of a stolen vertex with a few range checks.
+	std::vector<int> stolen_parts;
 
 	// This is a local buffer that contains the completed stolen vertices.
 	// All vertices here need to be returned to their owner threads.
 	fifo_queue<vertex_id_t> *completed_stolen_vertices;
 	int num_completed_stolen_vertices;
-	// The thread where we should steal activated vertices from.
-	int steal_thread_id;
+	// The number of vertices stolen from other threads.
+	size_t num_stolen;
+
+	bool refill_deque();
+	int fetch_local_chunk(compute_vertex_pointer vertices[], int num);
+	int steal_chunk(const std::vector<int> &victims,
+			compute_vertex_pointer vertices[], int num);
+	int steal_queue(const std::vector<int> &victims,
+			compute_vertex_pointer vertices[], int num);
+	void add_stolen_part(int part_id);
 public:
 	load_balancer(graph_engine &_graph, worker_thread &_owner);
 
@@ -59,7 +184,20 @@ public:
 
 	int get_stolen_vertex_part(const compute_vertex &v) const;
 
+	/**
+	 * The owner thread fetches its own activated vertices.
+	 */
+	int fetch_activated_vertices(compute_vertex_pointer vertices[], int num);
+
 	int steal_activated_vertices(compute_vertex_pointer vertices[], int num);
+
+	/**
+	 * Other threads steal a chunk of activated vertices from the deque.
+	 */
+	bool steal_chunk(vertex_chunk &chunk) {
+		return deque.steal(chunk);
+	}
+
 	/**
 	 * After the thread finishes processing the stolen vertices, it needs to
 	 * return all the vertices to their owner threads.
@@ -71,6 +209,10 @@ public:
 	void process_completed_stolen_vertices();
 
 	void reset();
+
+	size_t get_num_stolen() const {
+		return num_stolen;
+	}
 };
 
 #endif
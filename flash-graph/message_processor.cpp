@@ -23,14 +23,22 @@
 #include "worker_thread.h"
 #include "steal_state.h"
 
+/*
+ * The number of messages that can be buffered in the lock-free part of
+ * the inbox. When it's full, messages are added to the inbox with a lock.
+ */
+static const int MSG_QUEUE_CAPACITY = 4096;
+
 message_processor::message_processor(graph_engine &_graph,
 		worker_thread &_owner, std::shared_ptr<slab_allocator> msg_alloc): graph(_graph),
-	owner(_owner), msg_q(_owner.get_node_id(), "graph_msg_queue", 16, INT_MAX),
+	owner(_owner), msg_q(_owner.get_node_id(), "graph_msg_queue",
+			MSG_QUEUE_CAPACITY),
 	stolenv_msgs(_owner.get_node_id(), PAGE_SIZE, true)
 {
 	if (graph_conf.use_serial_run())
 		steal_state = std::unique_ptr<steal_state_t>(new steal_state_t(graph, owner));
 	this->msg_alloc = msg_alloc;
+	num_recv_msgs = 0;
 }
 
 void message_processor::buf_msg(vertex_message &vmsg)
@@ -85,7 +93,72 @@ void message_processor::buf_mmsg(local_vid_t id, multicast_message &mmsg)
 	}
 }
 
-void message_processor::process_multicast_msg(multicast_message &mmsg,
+/*
+ * Combine the message with the message received earlier by the same
+ * vertex. `size' is the size of the message without the destination list
+ * of a multicast message. Only the messages of the same size and the same
+ * activation flag can be combined. Otherwise, the message is delivered
+ * to the vertex immediately.
+ */
+void message_processor::combine_msg(vertex_program &vprog,
+		const message_combiner &combiner, local_vid_t dest,
+		const vertex_message &msg, int size)
+{
+	std::unordered_map<vertex_id_t, size_t>::const_iterator it
+		= combined_locs.find(dest.id);
+	if (it == combined_locs.end()) {
+		size_t loc = combined_msgs.size();
+		combined_msgs.resize(loc + size);
+		char *buf = combined_msgs.data() + loc;
+		memcpy(buf, &msg, size);
+		// A multicast message becomes a point-to-point message.
+		vertex_message *copy = (vertex_message *) buf;
+		*copy = vertex_message(size, msg.is_activate());
+		copy->set_dest(dest);
+		combined_locs.insert(std::pair<vertex_id_t, size_t>(dest.id, loc));
+		return;
+	}
+
+	vertex_message *combined
+		= (vertex_message *) (combined_msgs.data() + it->second);
+	if (combined->get_serialized_size() == size
+			&& combined->is_activate() == msg.is_activate())
+		combiner.combine(*combined, msg);
+	else {
+		compute_vertex &info = graph.get_vertex(owner.get_worker_id(), dest);
+		vprog.run_on_message(info, msg);
+		if (msg.is_activate())
+			owner.activate_vertex(dest);
+	}
+}
+
+void message_processor::deliver_combined_msgs(vertex_program &vprog)
+{
+	if (combined_locs.empty())
+		return;
+
+	std::vector<const vertex_message *> v_msgs;
+	v_msgs.reserve(combined_locs.size());
+	size_t loc = 0;
+	while (loc < combined_msgs.size()) {
+		const vertex_message *msg
+			= (const vertex_message *) (combined_msgs.data() + loc);
+		v_msgs.push_back(msg);
+		loc += msg->get_serialized_size();
+	}
+	vprog.run_on_messages(v_msgs.data(), v_msgs.size());
+	for (size_t i = 0; i < v_msgs.size(); i++) {
+		if (v_msgs[i]->is_activate())
+			owner.activate_vertex(v_msgs[i]->get_dest());
+	}
+	combined_msgs.clear();
+	combined_locs.clear();
+}
+
+/*
+ * It returns the number of vertex messages delivered by the multicast message.
+ */
+size_t message_processor::process_multicast_msg(multicast_message &mmsg,
 		bool check_steal)
 {
 	worker_thread *t = (worker_thread *) thread::get_curr_thread();
@@ -97,14 +170,22 @@ void message_processor::process_multicast_msg(multicast_message &mmsg,
 
 	if (mmsg.is_activation_msg()) {
 		owner.activate_vertices(dest_list.get_dests(), num_dests);
-		return;
+		return 0;
+	}
+
+	const message_combiner *combiner = curr_vprog.get_msg_combiner().get();
+	if (!check_steal && combiner) {
+		for (int i = 0; i < num_dests; i++)
+			combine_msg(curr_vprog, *combiner, dest_list.get_dest(i), mmsg,
+					mmsg.get_body_size());
+		return num_dests;
 	}
 
 	if (!check_steal) {
 		curr_vprog.run_on_multicast_message(mmsg);
 		if (mmsg.is_activate())
 			owner.activate_vertices(dest_list.get_dests(), num_dests);
-		return;
+		return num_dests;
 	}
 
 	for (int i = 0; i < num_dests; i++) {
@@ -119,9 +200,13 @@ void message_processor::process_multicast_msg(multicast_message &mmsg,
 		if (mmsg.is_activate())
 			owner.activate_vertex(id);
 	}
+	return num_dests;
 }
 
-void message_processor::process_msg(message &msg, bool check_steal)
+/*
+ * It returns the number of vertex messages in the message.
+ */
+size_t message_processor::process_msg(message &msg, bool check_steal)
 {
 	worker_thread *t = (worker_thread *) thread::get_curr_thread();
 	// Messages are always processed in the main vertex.
@@ -129,6 +214,7 @@ void message_processor::process_msg(message &msg, bool check_steal)
 
 	const int VMSG_BUF_SIZE = 128;
 	vertex_message *v_msgs[VMSG_BUF_SIZE];
+	size_t num_vmsgs = 0;
 	while (!msg.is_empty()) {
 		int num = msg.get_next(v_msgs, VMSG_BUF_SIZE);
 		assert(num > 0);
@@ -136,8 +222,18 @@ void message_processor::process_msg(message &msg, bool check_steal)
 		// multicast messages, we can use the fast path.
 		// We only need to check the first message. All messages are
 		// of the same type.
+		if (!check_steal && !v_msgs[0]->is_multicast()
+				&& curr_vprog.get_msg_combiner()) {
+			const message_combiner &combiner = *curr_vprog.get_msg_combiner();
+			for (int i = 0; i < num; i++)
+				combine_msg(curr_vprog, combiner, v_msgs[i]->get_dest(),
+						*v_msgs[i], v_msgs[i]->get_serialized_size());
+			num_vmsgs += num;
+			continue;
+		}
 		if (!check_steal && !v_msgs[0]->is_multicast()) {
 			curr_vprog.run_on_messages((const vertex_message **) v_msgs, num);
+			num_vmsgs += num;
 			for (int i = 0; i < num; i++) {
 				local_vid_t id = v_msgs[i]->get_dest();
 				if (v_msgs[i]->is_activate())
@@ -148,8 +244,9 @@ void message_processor::process_msg(message &msg, bool check_steal)
 
 		if (v_msgs[0]->is_multicast()) {
 			for (int i = 0; i < num; i++)
-				process_multicast_msg(*multicast_message::cast2multicast(
-							v_msgs[i]), check_steal);
+				num_vmsgs += process_multicast_msg(
+						*multicast_message::cast2multicast(v_msgs[i]),
+						check_steal);
 			continue;
 		}
 
@@ -167,7 +264,9 @@ void message_processor::process_msg(message &msg, bool check_steal)
 			if (v_msgs[i]->is_activate())
 				owner.activate_vertex(id);
 		}
+		num_vmsgs += num;
 	}
+	return num_vmsgs;
 }
 
 void message_processor::process_msgs()
@@ -195,9 +294,12 @@ void message_processor::process_msgs()
 	}
 	while (!msg_q.is_empty()) {
 		int num_fetched = msg_q.fetch(msgs, MSG_BUF_SIZE);
-		for (int i = 0; i < num_fetched; i++)
-			process_msg(msgs[i], check_steal);
+		for (int i = 0; i < num_fetched; i++) {
+			num_recv_msgs += process_msg(msgs[i], check_steal);
+		}
 	}
+	worker_thread *t = (worker_thread *) thread::get_curr_thread();
+	deliver_combined_msgs(t->get_vertex_program(false));
 	if (steal_state)
 		steal_state->unguard_msg_processing();
 }
@@ -21,6 +21,8 @@
  */
 
 #include <memory>
+#include <vector>
+#include <unordered_map>
 
 #include "container.h"
 
@@ -32,6 +34,8 @@ class worker_thread;
 class steal_state_t;
 class compute_vertex;
 class compute_vertex_pointer;
+class vertex_program;
+class message_combiner;
 
 /**
  * This class is to process the messages sent to the owner thread.
@@ -56,11 +60,28 @@ class message_processor
 	// have been stolen by other threads.
 	fifo_queue<message> stolenv_msgs;
 
+	// The number of vertex messages received from the message queue.
+	// A multicast message counts once per destination and activation
+	// messages aren't counted, the same as vertex_program::num_sent_msgs.
+	size_t num_recv_msgs;
+
+	// If the vertex program has a message combiner, the messages received
+	// from the queue are combined by their destinations before they are
+	// delivered to the vertices. The combined messages are stored in
+	// `combined_msgs', and `combined_locs' maps a destination vertex to
+	// the location of its message.
+	std::vector<char> combined_msgs;
+	std::unordered_map<vertex_id_t, size_t> combined_locs;
+
+	void combine_msg(vertex_program &vprog, const message_combiner &combiner,
+			local_vid_t dest, const vertex_message &msg, int size);
+	void deliver_combined_msgs(vertex_program &vprog);
+
 	void buf_msg(vertex_message &msg);
 	void buf_mmsg(local_vid_t id, multicast_message &mmsg);
 
-	void process_msg(message &msg, bool check_steal);
-	void process_multicast_msg(multicast_message &mmsg, bool check_steal);
+	size_t process_msg(message &msg, bool check_steal);
+	size_t process_multicast_msg(multicast_message &mmsg, bool check_steal);
 
 public:
 	message_processor(graph_engine &_graph, worker_thread &_owner,
@@ -71,6 +92,10 @@ public:
 	void steal_vertices(compute_vertex_pointer vertices[], int num);
 	void return_vertices(vertex_id_t ids[], int num);
 
+	size_t get_num_recv_msgs() const {
+		return num_recv_msgs;
+	}
+
 	msg_queue &get_msg_queue() {
 		return msg_q;
 	}
@@ -20,6 +20,8 @@
  * limitations under the License.
  */
 
+#include <vector>
+
 #include "slab_allocator.h"
 
 #include "vertex.h"
@@ -128,6 +130,19 @@ public:
 		return obj_p;
 	}
 
+	/**
+	 * The offset where the next object will be added.
+	 */
+	int get_add_offset() const {
+		return curr_add_off;
+	}
+
+	template<class T>
+	T *get_obj(int off) {
+		assert(off < curr_add_off);
+		return (T *) &buf[off];
+	}
+
 	int inc_msg_size(int msg_size) {
 		int remaining = size() - curr_add_off;
 		if (remaining < msg_size)
@@ -177,42 +192,27 @@ public:
 	}
 };
 
-class msg_queue: public thread_safe_FIFO_queue<message>
+/**
+ * The inbox of a worker thread. Any thread can add messages to it, but
+ * only the owner thread fetches messages from it, so we use a lock-free
+ * MPSC queue to avoid contention among the threads sending messages.
+ */
+class msg_queue: public lockfree_mpsc_queue<message>
 {
 public:
-	msg_queue(int node_id, const std::string _name, int init_size,
-			int max_size): thread_safe_FIFO_queue<message>(_name,
-				node_id, init_size, max_size) {
+	msg_queue(int node_id, const std::string _name,
+			int capacity): lockfree_mpsc_queue<message>(_name, node_id,
+				capacity) {
 	}
 
 	static msg_queue *create(int node_id, const std::string name,
-			int init_size, int max_size) {
-		return new msg_queue(node_id, name, init_size, max_size);
+			int capacity) {
+		return new msg_queue(node_id, name, capacity);
 	}
 
 	static void destroy(msg_queue *q) {
 		delete q;
 	}
-
-	/**
-	 * This method needs to be used with caution.
-	 * It may change the behavior of other threads if they also access
-	 * the queue, so it's better to use it when no other threads are
-	 * using it.
-	 * It is also a heavy operation.
-	 */
-	int get_num_objs() {
-		int num = thread_safe_FIFO_queue<message>::get_num_entries();
-		stack_array<message> msgs(num);
-		int ret = thread_safe_FIFO_queue<message>::fetch(msgs.data(), num);
-		int num_objs = 0;
-		for (int i = 0; i < ret; i++) {
-			num_objs += msgs[i].get_num_objs();
-		}
-		BOOST_VERIFY(ret == thread_safe_FIFO_queue<message>::add(
-					msgs.data(), ret));
-		return num_objs;
-	}
 };
 
 class simple_msg_sender
@@ -222,6 +222,34 @@ class simple_msg_sender
 	msg_queue *queue;
 	int num_objs;
 
+	/*
+	 * The location of the messages in the buffer, indexed by their
+	 * destinations. It's used to merge the messages sent to the same vertex.
+	 * An entry is only valid if its generation is the same as the current
+	 * one, so we only need to change the generation after the buffer is
+	 * flushed.
+	 */
+	struct combine_entry
+	{
+		unsigned gen;
+		int off;
+	};
+	std::vector<combine_entry> combine_table;
+	unsigned combine_gen;
+	int num_combine_entries;
+
+	void init_combine_table(int msg_size) {
+		int num_entries = 1;
+		while (num_entries < buf.size() / msg_size * 2)
+			num_entries *= 2;
+		combine_entry entry;
+		entry.gen = 0;
+		entry.off = 0;
+		combine_table.resize(num_entries, entry);
+		combine_gen = 1;
+		num_combine_entries = 0;
+	}
+
 protected:
 	/**
 	 * buf_size: the number of messages that can be buffered in the sender.
@@ -231,6 +259,8 @@ protected:
 		this->alloc = alloc;
 		this->queue = queue;
 		num_objs = 0;
+		combine_gen = 0;
+		num_combine_entries = 0;
 	}
 
 public:
@@ -246,6 +276,17 @@ public:
 
 	int flush() {
 		num_objs = 0;
+		if (!combine_table.empty() && num_combine_entries > 0) {
+			num_combine_entries = 0;
+			combine_gen++;
+			// All entries would look valid again when the generation
+			// wraps around.
+			if (combine_gen == 0) {
+				for (size_t i = 0; i < combine_table.size(); i++)
+					combine_table[i].gen = 0;
+				combine_gen = 1;
+			}
+		}
 		if (buf.is_empty()) {
 			return 0;
 		}
@@ -277,6 +318,54 @@ public:
 		return 1;
 	}
 
+	/**
+	 * Send a vertex message, but merge it with the message in the buffer
+	 * that is sent to the same vertex if there is one. The messages can
+	 * only be merged if they have the same size and activation flag.
+	 * It returns the number of messages added to the buffer.
+	 */
+	template<class T, class Combiner>
+	int send_combined(T &msg, const Combiner &combiner) {
+		if (combine_table.empty())
+			init_combine_table(msg.get_serialized_size());
+
+		size_t mask = combine_table.size() - 1;
+		size_t idx = msg.get_dest().id & mask;
+		while (combine_table[idx].gen == combine_gen) {
+			T *buffered = buf.get_obj<T>(combine_table[idx].off);
+			if (buffered->get_dest().id == msg.get_dest().id) {
+				if (buffered->get_serialized_size() == msg.get_serialized_size()
+						&& buffered->is_activate() == msg.is_activate()) {
+					combiner.combine(*buffered, msg);
+					return 0;
+				}
+				break;
+			}
+			idx = (idx + 1) & mask;
+		}
+
+		num_objs++;
+		int off = buf.get_add_offset();
+		T *ret = buf.add(msg);
+		if (ret == NULL) {
+			// The table is invalidated after the buffer is flushed,
+			// so we have to search for an empty entry again.
+			flush();
+			off = buf.get_add_offset();
+			ret = buf.add(msg);
+			assert(ret != NULL);
+			idx = msg.get_dest().id & mask;
+		}
+		// We keep the table at most half full, so the search stops quickly.
+		if (combine_table[idx].gen != combine_gen
+				&& (size_t) num_combine_entries < combine_table.size() / 2) {
+			combine_table[idx].gen = combine_gen;
+			combine_table[idx].off = off;
+			num_combine_entries++;
+		}
+		return 1;
+	}
+
 	msg_queue *get_queue() const {
 		return queue;
 	}
@@ -0,0 +1,33 @@
+#!/bin/sh
+
+# Run graph algorithms on virtual SSDs that follow an SSD performance model,
+# so the runtime doesn't depend on the SSDs of the machine.
+# The graph has to be loaded to SAFS first, and the profile of the SSD model
+# is generated by "SAFS-util conf_file calibrate file_name profile".
+
+if [ $# -lt 3 ]; then
+	echo "run_model_bench.sh graph_file index_file profile [conf_file]"
+	exit 1
+fi
+
+GRAPH=$1
+INDEX=$2
+PROFILE=$3
+CONF=${4:-run_test.txt}
+
+# Data is served from the Linux page cache and the model decides the delay.
+# The graph has to be read from the virtual SSDs, so we can't keep it
+# in memory.
+MODEL_CONF=`mktemp`
+sed -e '/^in_mem_graph/d' -e '/^in_mem_index/d' -e '/^preload/d' $CONF > $MODEL_CONF
+echo "virt_aio=" >> $MODEL_CONF
+echo "ssd_model=$PROFILE" >> $MODEL_CONF
+echo "print_io_stat=" >> $MODEL_CONF
+
+for alg in wcc pagerank diameter; do
+	echo "run $alg"
+	/usr/bin/time -f "$alg takes %e seconds" \
+		../test-algs/test_algs $MODEL_CONF $GRAPH $INDEX $alg
+done
+
+rm $MODEL_CONF
@@ -51,6 +51,20 @@ public:
 	}
 };
 
+/*
+ * A vertex only needs the shortest distance it receives and its parent.
+ */
+class dist_msg_combiner: public message_combiner
+{
+public:
+	void combine(vertex_message &combined, const vertex_message &msg) const {
+		dist_message &dmsg = (dist_message &) combined;
+		const dist_message &new_msg = (const dist_message &) msg;
+		if (new_msg.get_parent_dist() < dmsg.get_parent_dist())
+			dmsg = new_msg;
+	}
+};
+
 class sssp_vertex: public compute_directed_vertex
 {
 	int parent_dist;
@@ -118,6 +132,16 @@ void sssp_vertex::run(vertex_program &prog, const page_vertex &vertex)
 	}
 }
 
+class sssp_vertex_program_creater: public vertex_program_creater
+{
+public:
+	vertex_program::ptr create() const {
+		vertex_program::ptr prog(new vertex_program_impl<sssp_vertex>());
+		prog->set_msg_combiner(message_combiner::ptr(new dist_msg_combiner()));
+		return prog;
+	}
+};
+
 class sssp_initializer: public vertex_initializer
 {
 public:
@@ -198,7 +222,8 @@ int main(int argc, char *argv[])
 	struct timeval start, end;
 	gettimeofday(&start, NULL);
 	graph->start(&start_vertex, 1, vertex_initializer::ptr(
-				new sssp_initializer()));
+				new sssp_initializer()), vertex_program_creater::ptr(
+				new sssp_vertex_program_creater()));
 	graph->wait4complete();
 	gettimeofday(&end, NULL);
 
@@ -189,6 +189,44 @@ void run_diameter(FG_graph::ptr graph, int argc, char *argv[])
 	printf("The estimated diameter is %ld\n", diameter);
 }
 
+void run_msbfs(FG_graph::ptr graph, int argc, char *argv[])
+{
+	int opt;
+	int num_opts = 0;
+
+	int num_sources = 64;
+	edge_type traverse_edge = edge_type::BOTH_EDGES;
+
+	while ((opt = getopt(argc, argv, "n:d")) != -1) {
+		num_opts++;
+		switch (opt) {
+			case 'n':
+				num_sources = atoi(optarg);
+				num_opts++;
+				break;
+			case 'd':
+				traverse_edge = edge_type::OUT_EDGE;
+				break;
+			default:
+				print_usage();
+				abort();
+		}
+	}
+
+	std::vector<vertex_id_t> sources;
+	while (sources.size() < (size_t) num_sources)
+		sources.push_back(random() % graph->get_graph_header().get_num_vertices());
+	std::vector<bfs_summary> summaries = compute_msbfs(graph, sources,
+			traverse_edge);
+	for (size_t i = 0; i < summaries.size(); i++) {
+		double closeness = summaries[i].sum_dists > 0
+			? ((double) summaries[i].num_reached - 1) / summaries[i].sum_dists : 0;
+		printf("v%ld: reach %ld vertices, eccentricity: %d, closeness: %f\n",
+				(long) summaries[i].source, summaries[i].num_reached,
+				summaries[i].max_dist, closeness);
+	}
+}
+
 void run_pagerank(FG_graph::ptr graph, int argc, char *argv[], int version)
 {
 	int opt;
@@ -196,8 +234,9 @@ void run_pagerank(FG_graph::ptr graph, int argc, char *argv[], int version)
 
 	int num_iters = 30;
 	float damping_factor = 0.85;
+	float tolerance = 1.0E-3;
 
-	while ((opt = getopt(argc, argv, "i:D:")) != -1) {
+	while ((opt = getopt(argc, argv, "i:D:T:")) != -1) {
 		num_opts++;
 		switch (opt) {
 			case 'i':
@@ -208,6 +247,10 @@ void run_pagerank(FG_graph::ptr graph, int argc, char *argv[], int version)
 				damping_factor = atof(optarg);
 				num_opts++;
 				break;
+			case 'T':
+				tolerance = atof(optarg);
+				num_opts++;
+				break;
 			default:
 				print_usage();
 				abort();
@@ -222,6 +265,10 @@ void run_pagerank(FG_graph::ptr graph, int argc, char *argv[], int version)
 		case 2:
 			pr = compute_pagerank2(graph, num_iters, damping_factor);
 			break;
+		case 3:
+			pr = compute_pagerank_delta(graph, num_iters, damping_factor,
+					tolerance);
+			break;
 		default:
 			abort();
 	}
@@ -507,8 +554,10 @@ std::string supported_algs[] = {
 	"wcc",
 	"scc",
 	"diameter",
+	"msbfs",
 	"pagerank",
 	"pagerank2",
+	"pagerank_delta",
 	"sstsg",
 	"ts_wcc",
 	"kcore",
@@ -528,9 +577,14 @@ void print_usage()
 	fprintf(stderr, "-d: whether we respect the direction of edges\n");
 	fprintf(stderr, "-s num: the number of sweeps performed in diameter estimation\n");
 	fprintf(stderr, "\n");
+	fprintf(stderr, "msbfs\n");
+	fprintf(stderr, "-n num: the number of random source vertices\n");
+	fprintf(stderr, "-d: whether we respect the direction of edges\n");
+	fprintf(stderr, "\n");
 	fprintf(stderr, "pagerank\n");
 	fprintf(stderr, "-i num: the maximum number of iterations\n");
 	fprintf(stderr, "-D v: damping factor\n");
+	fprintf(stderr, "-T v: the tolerance of pagerank_delta\n");
 	fprintf(stderr, "\n");
 	fprintf(stderr, "sstsg\n");
 	fprintf(stderr, "-n num: the number of time intervals\n");
@@ -603,12 +657,18 @@ int main(int argc, char *argv[])
 	else if (alg == "diameter") {
 		run_diameter(graph, argc, argv);
 	}
+	else if (alg == "msbfs") {
+		run_msbfs(graph, argc, argv);
+	}
 	else if (alg == "pagerank") {
 		run_pagerank(graph, argc, argv, 1);
 	}
 	else if (alg == "pagerank2") {
 		run_pagerank(graph, argc, argv, 2);
 	}
+	else if (alg == "pagerank_delta") {
+		run_pagerank(graph, argc, argv, 3);
+	}
 	else if (alg == "wcc") {
 		run_wcc(graph, argc, argv);
 	}
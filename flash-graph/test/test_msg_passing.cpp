@@ -87,6 +87,76 @@ void test_vertex::run(vertex_program &prog, const page_vertex &vertex)
 	prog.multicast_msg(it, msg);
 }
 
+/**
+ * Measure the throughput of the queue used as the inbox of a worker thread.
+ * Multiple producers add messages to the queue one at a time, as vertex
+ * programs flush their message buffers, and a single consumer fetches
+ * messages in batches.
+ */
+
+const long NUM_QUEUE_MSGS = 10 * 1000 * 1000;
+
+template<class QueueType>
+struct queue_bench_arg
+{
+	QueueType *q;
+	long num_msgs;
+	std::atomic_bool *start;
+};
+
+template<class QueueType>
+void *produce_msgs(void *arg)
+{
+	queue_bench_arg<QueueType> *bench_arg = (queue_bench_arg<QueueType> *) arg;
+	while (!bench_arg->start->load());
+	for (long i = 0; i < bench_arg->num_msgs; i++) {
+		message msg;
+		BOOST_VERIFY(bench_arg->q->add(&msg, 1) == 1);
+	}
+	return NULL;
+}
+
+template<class QueueType>
+double bench_queue(QueueType &q, int num_producers)
+{
+	std::atomic_bool start;
+	start = false;
+	std::vector<pthread_t> producers(num_producers);
+	std::vector<queue_bench_arg<QueueType> > args(num_producers);
+	for (int i = 0; i < num_producers; i++) {
+		args[i].q = &q;
+		args[i].num_msgs = NUM_QUEUE_MSGS / num_producers;
+		args[i].start = &start;
+		pthread_create(&producers[i], NULL, produce_msgs<QueueType>, &args[i]);
+	}
+
+	const int MSG_BUF_SIZE = 16;
+	message msgs[MSG_BUF_SIZE];
+	long num_expected = NUM_QUEUE_MSGS / num_producers * num_producers;
+	long num_fetched = 0;
+	struct timeval start_time, end_time;
+	gettimeofday(&start_time, NULL);
+	start = true;
+	while (num_fetched < num_expected)
+		num_fetched += q.fetch(msgs, MSG_BUF_SIZE);
+	gettimeofday(&end_time, NULL);
+
+	for (int i = 0; i < num_producers; i++)
+		pthread_join(producers[i], NULL);
+	assert(q.is_empty());
+	return num_expected / time_diff(start_time, end_time);
+}
+
+void run_queue_bench(int num_producers)
+{
+	thread_safe_FIFO_queue<message> locked_q("locked_queue", 0, 16, INT_MAX);
+	printf("thread_safe_FIFO_queue with %d producers: %.0f msgs/s\n",
+			num_producers, bench_queue(locked_q, num_producers));
+	lockfree_mpsc_queue<message> lockfree_q("lockfree_queue", 0, 4096);
+	printf("lockfree_mpsc_queue with %d producers: %.0f msgs/s\n",
+			num_producers, bench_queue(lockfree_q, num_producers));
+}
+
 void int_handler(int sig_num)
 {
 #ifdef PROFILER
@@ -101,6 +171,7 @@ void print_usage()
 	fprintf(stderr,
 			"test [options] conf_file graph_file index_file\n");
 	fprintf(stderr, "-c confs: add more configurations to the system\n");
+	fprintf(stderr, "-q num_producers: only measure the throughput of the message queues\n");
 	graph_conf.print_help();
 	params.print_help();
 }
@@ -110,13 +181,18 @@ int main(int argc, char *argv[])
 	int opt;
 	std::string confs;
 	int num_opts = 0;
-	while ((opt = getopt(argc, argv, "c:")) != -1) {
+	int num_producers = 0;
+	while ((opt = getopt(argc, argv, "c:q:")) != -1) {
 		num_opts++;
 		switch (opt) {
 			case 'c':
 				confs = optarg;
 				num_opts++;
 				break;
+			case 'q':
+				num_producers = atoi(optarg);
+				num_opts++;
+				break;
 			default:
 				print_usage();
 		}
@@ -124,6 +200,11 @@ int main(int argc, char *argv[])
 	argv += 1 + num_opts;
 	argc -= 1 + num_opts;
 
+	if (num_producers > 0) {
+		run_queue_bench(num_producers);
+		return 0;
+	}
+
 	if (argc < 3) {
 		print_usage();
 		exit(-1);
@@ -34,6 +34,24 @@ static struct str2int_pair edge_type_map[] = {
 };
 static int type_map_size = sizeof(edge_type_map) / sizeof(edge_type_map[0]);
 
+static struct str2int_pair vertex_order_map[] = {
+	{"orig", ORIG_ORDER},
+	{"degree", DEGREE_ORDER},
+	{"rcm", RCM_ORDER},
+};
+static int order_map_size = sizeof(vertex_order_map) / sizeof(vertex_order_map[0]);
+
+static inline vertex_order conv_vertex_order_str2int(const std::string &order_str)
+{
+	for (int i = 0; i < order_map_size; i++) {
+		if (vertex_order_map[i].str == order_str) {
+			return (vertex_order) vertex_order_map[i].number;
+		}
+	}
+	fprintf(stderr, "unknown vertex order: %s\n", order_str.c_str());
+	exit(-1);
+}
+
 static inline int conv_edge_type_str2int(const std::string &type_str)
 {
 	for (int i = 0; i < type_map_size; i++) {
@@ -62,6 +80,31 @@ void print_usage()
 	fprintf(stderr, "-w: write the graph to a file\n");
 	fprintf(stderr, "-T: the number of threads to process in parallel\n");
 	fprintf(stderr, "-d: store intermediate data on disks\n");
+	fprintf(stderr, "-c: compress the adjacency lists\n");
+	fprintf(stderr, "-r order: relabel vertices in the order. Supported order: ");
+	for (int i = 0; i < order_map_size; i++) {
+		fprintf(stderr, "%s, ", vertex_order_map[i].str.c_str());
+	}
+	fprintf(stderr, "\n");
+	fprintf(stderr, "   The original ID of each vertex is written to adj_list_file-vmap\n");
+	fprintf(stderr, "   It builds the whole graph in memory and can't be used with -d\n");
+}
+
+/*
+ * Relabel the vertices in the edge graph and write the map from the new IDs
+ * to the original IDs next to the adjacency list file.
+ */
+static void reorder_graph(edge_graph &edge_g, vertex_order order,
+		const std::string &adj_file, bool write_graph)
+{
+	if (order == ORIG_ORDER)
+		return;
+	std::vector<vertex_id_t> new_ids = reorder_vertices(edge_g, order);
+	if (write_graph) {
+		std::string map_file = adj_file + "-vmap";
+		assert(!file_exist(map_file));
+		dump_vertex_map(map_file, new_ids);
+	}
 }
 
 int main(int argc, char *argv[])
@@ -74,7 +117,9 @@ int main(int argc, char *argv[])
 	bool merge_graph = false;
 	bool write_graph = false;
 	bool on_disk = false;
-	while ((opt = getopt(argc, argv, "uvt:mwT:d")) != -1) {
+	bool compress_edges = false;
+	vertex_order order = ORIG_ORDER;
+	while ((opt = getopt(argc, argv, "uvt:mwT:dcr:")) != -1) {
 		num_opts++;
 		switch (opt) {
 			case 'u':
@@ -100,6 +145,13 @@ int main(int argc, char *argv[])
 			case 'd':
 				on_disk = true;
 				break;
+			case 'c':
+				compress_edges = true;
+				break;
+			case 'r':
+				order = conv_vertex_order_str2int(optarg);
+				num_opts++;
+				break;
 			default:
 				print_usage();
 		}
@@ -110,19 +162,27 @@ int main(int argc, char *argv[])
 		print_usage();
 		exit(-1);
 	}
+	// Computing the vertex order needs the undirected adjacency lists of
+	// the whole graph in memory, which defeats storing data on disks.
+	if (on_disk && order != ORIG_ORDER) {
+		fprintf(stderr,
+				"vertex reordering (-r) builds the graph in memory and can't be used with -d\n");
+		exit(-1);
+	}
 
 	int edge_attr_type = DEFAULT_TYPE;
 	if (type_str) {
 		edge_attr_type = conv_edge_type_str2int(type_str);
 	}
 
+	int version = compress_edges ? COMPRESSED_EDGE_VERSION : CURR_VERSION;
 	std::string adjacency_list_file = argv[0];
-	adjacency_list_file += std::string("-v") + itoa(CURR_VERSION);
+	adjacency_list_file += std::string("-v") + itoa(version);
 	std::string work_dir = dirname(argv[0]);
 	printf("work dir: %s\n", work_dir.c_str());
 
 	std::string index_file = argv[1];
-	index_file += std::string("-v") + itoa(CURR_VERSION);
+	index_file += std::string("-v") + itoa(version);
 	std::vector<std::string> edge_list_files;
 	for (int i = 2; i < argc; i++) {
 		native_dir dir(argv[i]);
@@ -143,6 +203,7 @@ int main(int argc, char *argv[])
 	if (merge_graph) {
 		edge_graph::ptr edge_g = parse_edge_lists(edge_list_files, edge_attr_type,
 				directed, num_threads, !on_disk);
+		reorder_graph(*edge_g, order, adjacency_list_file, write_graph);
 		disk_serial_graph::ptr g
 			= std::static_pointer_cast<disk_serial_graph, serial_graph>(
 					construct_graph(edge_g, work_dir, num_threads));
@@ -163,6 +224,9 @@ int main(int argc, char *argv[])
 			printf("verifying a graph takes %.2f seconds\n",
 					time_diff(start, end));
 		}
+		// The graph is verified in the original format.
+		if (write_graph && compress_edges)
+			compress_adj_lists(index_file, adjacency_list_file);
 	}
 	else {
 		std::vector<std::string> graph_files;
@@ -185,6 +249,7 @@ int main(int argc, char *argv[])
 
 			edge_graph::ptr edge_g = parse_edge_lists(files, edge_attr_type,
 					directed, num_threads, !on_disk);
+			reorder_graph(*edge_g, order, graph_files[i], write_graph);
 			disk_serial_graph::ptr g
 				= std::static_pointer_cast<disk_serial_graph, serial_graph>(
 						construct_graph(edge_g, work_dir, num_threads));
@@ -205,6 +270,8 @@ int main(int argc, char *argv[])
 				printf("verifying a graph takes %.2f seconds\n",
 						time_diff(start, end));
 			}
+			if (write_graph && compress_edges)
+				compress_adj_lists(index_files[i], graph_files[i]);
 		}
 	}
 }
@@ -0,0 +1,155 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * This builds the timestamp index of a time-series graph, so algorithms
+ * can read only the edges in a time interval.
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "native_file.h"
+
+#include "vertex_index.h"
+#include "ts_graph.h"
+
+void print_usage()
+{
+	fprintf(stderr,
+			"ts-index [options] adj_list_file index_file ts_index_file\n");
+	fprintf(stderr, "-g granularity: the size of a time bucket\n");
+	fprintf(stderr, "-u unit: the unit of the granularity (hour, day, month)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	int opt;
+	int num_opts = 0;
+	time_t granularity = 1;
+	std::string time_unit_str = "hour";
+	while ((opt = getopt(argc, argv, "g:u:")) != -1) {
+		num_opts++;
+		switch (opt) {
+			case 'g':
+				granularity = atol(optarg);
+				num_opts++;
+				break;
+			case 'u':
+				time_unit_str = optarg;
+				num_opts++;
+				break;
+			default:
+				print_usage();
+				exit(-1);
+		}
+	}
+	argv += 1 + num_opts;
+	argc -= 1 + num_opts;
+
+	if (argc < 3) {
+		print_usage();
+		exit(-1);
+	}
+
+	if (time_unit_str == "hour")
+		granularity *= HOUR_SECS;
+	else if (time_unit_str == "day")
+		granularity *= DAY_SECS;
+	else if (time_unit_str == "month")
+		granularity *= MONTH_SECS;
+	else {
+		fprintf(stderr, "a wrong time unit: %s\n", time_unit_str.c_str());
+		exit(-1);
+	}
+	if (granularity <= 0) {
+		fprintf(stderr, "a wrong granularity: %ld\n", granularity);
+		exit(-1);
+	}
+
+	const std::string adj_file_name = argv[0];
+	const std::string index_file_name = argv[1];
+	const std::string ts_index_file_name = argv[2];
+
+	vertex_index::ptr index = vertex_index::load(index_file_name);
+	const graph_header &header = index->get_graph_header();
+	if (!header.is_directed_graph() || header.is_edge_list_compressed()
+			|| !header.has_edge_data()) {
+		fprintf(stderr, "%s isn't an uncompressed time-series graph\n",
+				adj_file_name.c_str());
+		exit(-1);
+	}
+	// The vertex index may be compressed.
+	directed_vertex_index::ptr dindex;
+	in_mem_cdirected_vertex_index::ptr cindex;
+	if (index->is_compressed())
+		cindex = in_mem_cdirected_vertex_index::create(*index);
+	else
+		dindex = directed_vertex_index::cast(index);
+
+	native_file adj_file(adj_file_name);
+	size_t adj_file_size = adj_file.get_size();
+	int fd = open(adj_file_name.c_str(), O_RDONLY);
+	if (fd < 0) {
+		perror("open");
+		exit(-1);
+	}
+	char *adj_list = (char *) mmap(NULL, adj_file_size, PROT_READ,
+			MAP_PRIVATE, fd, 0);
+	if (adj_list == MAP_FAILED) {
+		perror("mmap");
+		exit(-1);
+	}
+	madvise(adj_list, adj_file_size, MADV_SEQUENTIAL);
+
+	ts_vertex_index::ptr ts_index = ts_vertex_index::create(granularity);
+	size_t num_edges = 0;
+	for (size_t i = 0; i < header.get_num_vertices(); i++) {
+		directed_vertex_entry e = dindex ? dindex->get_vertex(i)
+			: cindex->get_vertex(i);
+		off_t offs[2] = {e.get_in_off(), e.get_out_off()};
+		for (int j = 0; j < 2; j++) {
+			assert((size_t) offs[j] < adj_file_size);
+			const ext_mem_undirected_vertex *v
+				= (const ext_mem_undirected_vertex *) (adj_list + offs[j]);
+			assert(v->get_id() == i);
+			ts_edge_data *data = NULL;
+			if (v->get_num_edges() > 0) {
+				if (v->get_edge_data_size() != sizeof(ts_edge_data)) {
+					fprintf(stderr, "vertex %ld doesn't have timestamps\n", i);
+					exit(-1);
+				}
+				data = (ts_edge_data *) &v->get_edge_data<ts_edge_data>(0);
+			}
+			ts_index->add_part(offs[j], data, v->get_num_edges());
+			num_edges += v->get_num_edges();
+		}
+	}
+	munmap(adj_list, adj_file_size);
+	close(fd);
+
+	ts_index->dump(ts_index_file_name);
+	printf("There are %ld vertices, %ld edges and %ld time buckets of %ld seconds\n",
+			ts_index->get_num_vertices(), num_edges / 2,
+			ts_index->get_num_buckets(), granularity);
+}
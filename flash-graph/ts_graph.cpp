@@ -17,6 +17,10 @@
  * limitations under the License.
  */
 
+#include <stdio.h>
+
+#include <boost/format.hpp>
+
 #include "ts_graph.h"
 
 page_byte_array::seq_const_iterator<vertex_id_t> get_ts_iterator(
@@ -40,3 +44,114 @@ page_byte_array::seq_const_iterator<vertex_id_t> get_ts_iterator(
 
 	return v.get_neigh_seq_it(type, start, end);
 }
+
+void ts_vertex_index::add_part(off_t off, const ts_edge_data data[],
+		size_t num_edges)
+{
+	part_entry &part = parts.back();
+	part.off = off;
+	part.bucket_start = buckets.size();
+	part.num_edges = num_edges;
+	for (size_t i = 0; i < num_edges; i++) {
+		time_t bucket = get_bucket(data[i].get_timestamp());
+		if (i > 0)
+			assert(data[i - 1].get_timestamp() <= data[i].get_timestamp());
+		if (buckets.size() == part.bucket_start
+				|| buckets.back().time != bucket)
+			buckets.push_back(bucket_entry(bucket, i));
+	}
+	parts.push_back(part_entry(0, buckets.size(), 0));
+}
+
+size_t ts_vertex_index::get_edge_idx(const part_entry &part,
+		const part_entry &next, time_t time) const
+{
+	std::vector<bucket_entry>::const_iterator begin
+		= buckets.begin() + part.bucket_start;
+	std::vector<bucket_entry>::const_iterator end
+		= buckets.begin() + next.bucket_start;
+	std::vector<bucket_entry>::const_iterator it = std::lower_bound(begin,
+			end, bucket_entry(time, 0));
+	if (it == end)
+		return part.num_edges;
+	else
+		return it->edge_idx;
+}
+
+ts_edge_range ts_vertex_index::get_edge_range(vertex_id_t id, edge_type type,
+		time_t time_start, time_t time_interval) const
+{
+	assert(type == IN_EDGE || type == OUT_EDGE);
+	size_t idx = ((size_t) id) * 2 + (type == OUT_EDGE);
+	assert(idx + 1 < parts.size());
+	const part_entry &part = parts[idx];
+	const part_entry &next = parts[idx + 1];
+	size_t start = get_edge_idx(part, next, time_start);
+	size_t end = get_edge_idx(part, next, time_start + time_interval);
+	return ts_edge_range(part.off, start, end);
+}
+
+void ts_vertex_index::dump(const std::string &file) const
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if (f == NULL)
+		ABORT_MSG(boost::format("can't open %1%: %2%") % file
+				% strerror(errno));
+
+	header_t header;
+	header.magic = MAGIC_NUMBER;
+	header.granularity = granularity;
+	header.num_vertices = get_num_vertices();
+	header.num_buckets = buckets.size();
+	BOOST_VERIFY(fwrite(&header, sizeof(header), 1, f) == 1);
+	BOOST_VERIFY(fwrite(parts.data(), sizeof(parts[0]) * parts.size(), 1,
+				f) == 1);
+	if (!buckets.empty())
+		BOOST_VERIFY(fwrite(buckets.data(),
+					sizeof(buckets[0]) * buckets.size(), 1, f) == 1);
+	fclose(f);
+}
+
+ts_vertex_index::ptr ts_vertex_index::load(const std::string &file)
+{
+	FILE *f = fopen(file.c_str(), "r");
+	if (f == NULL)
+		ABORT_MSG(boost::format("can't open %1%: %2%") % file
+				% strerror(errno));
+
+	header_t header;
+	if (fread(&header, sizeof(header), 1, f) != 1
+			|| header.magic != MAGIC_NUMBER || header.granularity <= 0)
+		ABORT_MSG(boost::format("%1% isn't a timestamp index") % file);
+
+	ptr index(new ts_vertex_index(header.granularity));
+	index->parts.resize(header.num_vertices * 2 + 1, part_entry(0, 0, 0));
+	index->buckets.resize(header.num_buckets, bucket_entry(0, 0));
+	BOOST_VERIFY(fread(index->parts.data(),
+				sizeof(index->parts[0]) * index->parts.size(), 1, f) == 1);
+	if (header.num_buckets > 0)
+		BOOST_VERIFY(fread(index->buckets.data(),
+					sizeof(index->buckets[0]) * index->buckets.size(),
+					1, f) == 1);
+	fclose(f);
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"load a timestamp index of %1% vertices and %2% buckets from %3%")
+		% index->get_num_vertices() % index->get_num_buckets() % file;
+	return index;
+}
+
+page_byte_array::seq_const_iterator<vertex_id_t> get_ts_iterator(
+		const page_ts_range_vertex &v, const ts_vertex_index &index,
+		edge_type type, time_t time_start, time_t time_interval)
+{
+	assert(index.is_aligned(time_start, time_interval));
+	ts_edge_range range = index.get_edge_range(v.get_id(), type, time_start,
+			time_interval);
+	// The range that has been read from the graph file.
+	size_t read_start = v.get_edge_start(type);
+	size_t read_end = read_start + v.get_num_edges(type);
+	size_t start = std::min(std::max(range.get_start(), read_start), read_end);
+	size_t end = std::max(std::min(range.get_start() + range.get_num_edges(),
+				read_end), start);
+	return v.get_neigh_seq_it(type, start - read_start, end - read_start);
+}
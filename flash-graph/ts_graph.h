@@ -23,6 +23,7 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include "vertex.h"
+#include "ts_index.h"
 
 const int HOUR_SECS = 3600;
 const int DAY_SECS = HOUR_SECS * 24;
@@ -32,6 +33,14 @@ page_byte_array::seq_const_iterator<vertex_id_t> get_ts_iterator(
 		const page_directed_vertex &v, edge_type type, time_t time_start,
 		time_t time_interval);
 
+/*
+ * Get the edges of a vertex read with a timestamp index in a time interval.
+ * The time interval has to be aligned with the buckets of the index.
+ */
+page_byte_array::seq_const_iterator<vertex_id_t> get_ts_iterator(
+		const page_ts_range_vertex &v, const ts_vertex_index &index,
+		edge_type type, time_t time_start, time_t time_interval);
+
 static inline bool is_time_str(const std::string &str)
 {
 	struct tm tm;
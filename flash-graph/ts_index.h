@@ -0,0 +1,285 @@
+#ifndef __TS_INDEX_H__
+#define __TS_INDEX_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of FlashGraph.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vertex.h"
+
+/*
+ * The range of edges of a vertex part in a time interval.
+ * The edges are in [start, end) of the edge list of the part stored
+ * at `off' of the graph file.
+ */
+class ts_edge_range
+{
+	off_t off;
+	size_t start;
+	size_t end;
+public:
+	ts_edge_range() {
+		off = 0;
+		start = 0;
+		end = 0;
+	}
+
+	ts_edge_range(off_t off, size_t start, size_t end) {
+		this->off = off;
+		this->start = start;
+		this->end = end;
+	}
+
+	size_t get_start() const {
+		return start;
+	}
+
+	size_t get_num_edges() const {
+		return end - start;
+	}
+
+	/*
+	 * The location of the neighbors in the range in the graph file.
+	 */
+	off_t get_neigh_off() const {
+		return off + ext_mem_undirected_vertex::get_header_size()
+			+ start * sizeof(vertex_id_t);
+	}
+};
+
+/*
+ * This index stores the location of the edges of every vertex in time
+ * buckets, so we can read only the edges in a time interval from
+ * a time-series graph.
+ *
+ * The edges of a vertex part are sorted by timestamps. The time is split
+ * into buckets of `granularity' seconds, and for each part the index keeps
+ * the location of the first edge of every non-empty bucket. The location
+ * of the edges in a time interval is exact only if the interval is aligned
+ * with the buckets.
+ *
+ * On disk, the index has a header, followed by an entry for each part
+ * (the in-part and the out-part of every vertex and a sentinel), followed
+ * by all bucket entries.
+ */
+class ts_vertex_index
+{
+	static const int64_t MAGIC_NUMBER = 0x7473696478;
+
+	struct header_t {
+		int64_t magic;
+		int64_t granularity;
+		size_t num_vertices;
+		size_t num_buckets;
+	};
+
+	struct part_entry {
+		// The location of the part in the graph file.
+		off_t off;
+		// The location of the first bucket of the part.
+		size_t bucket_start;
+		size_t num_edges;
+
+		part_entry(off_t off, size_t bucket_start, size_t num_edges) {
+			this->off = off;
+			this->bucket_start = bucket_start;
+			this->num_edges = num_edges;
+		}
+	};
+
+	struct bucket_entry {
+		// The start time of the bucket.
+		time_t time;
+		// The location of the first edge in the bucket.
+		size_t edge_idx;
+
+		bucket_entry(time_t time, size_t edge_idx) {
+			this->time = time;
+			this->edge_idx = edge_idx;
+		}
+
+		bool operator<(const bucket_entry &e) const {
+			return time < e.time;
+		}
+	};
+
+	time_t granularity;
+	// The last entry is a sentinel.
+	std::vector<part_entry> parts;
+	std::vector<bucket_entry> buckets;
+
+	ts_vertex_index(time_t granularity) {
+		this->granularity = granularity;
+		parts.push_back(part_entry(0, 0, 0));
+	}
+
+	time_t get_bucket(time_t timestamp) const {
+		if (timestamp >= 0)
+			return timestamp / granularity * granularity;
+		else
+			return -((-timestamp + granularity - 1) / granularity) * granularity;
+	}
+
+	size_t get_edge_idx(const part_entry &part, const part_entry &next,
+			time_t time) const;
+public:
+	typedef std::shared_ptr<ts_vertex_index> ptr;
+
+	static ptr create(time_t granularity) {
+		assert(granularity > 0);
+		return ptr(new ts_vertex_index(granularity));
+	}
+
+	static ptr load(const std::string &file);
+	void dump(const std::string &file) const;
+
+	/*
+	 * Add the part of the next vertex to the index. The in-part and
+	 * the out-part of a vertex are added in order.
+	 */
+	void add_part(off_t off, const ts_edge_data data[], size_t num_edges);
+
+	time_t get_granularity() const {
+		return granularity;
+	}
+
+	size_t get_num_vertices() const {
+		return (parts.size() - 1) / 2;
+	}
+
+	size_t get_num_buckets() const {
+		return buckets.size();
+	}
+
+	/*
+	 * Test if the time interval is aligned with the buckets.
+	 * Only then, the index can locate the edges in the time interval exactly.
+	 */
+	bool is_aligned(time_t time_start, time_t time_interval) const {
+		return get_bucket(time_start) == time_start
+			&& time_interval % granularity == 0;
+	}
+
+	ts_edge_range get_edge_range(vertex_id_t id, edge_type type,
+			time_t time_start, time_t time_interval) const;
+};
+
+/*
+ * This vertex contains the edges of a directed vertex in a time interval.
+ * Each part of the vertex is a range of its edge list read from the graph
+ * file without the vertex header and the edge data, so only the neighbors
+ * are accessible. A part that isn't read has no edges.
+ */
+class page_ts_range_vertex: public page_vertex
+{
+	vertex_id_t id;
+	const page_byte_array *in_array;
+	const page_byte_array *out_array;
+	// The location of the first edge of the range in the edge list
+	// of the part.
+	size_t in_start;
+	size_t out_start;
+
+	const page_byte_array *get_array(edge_type type) const {
+		switch(type) {
+			case IN_EDGE:
+				return in_array;
+			case OUT_EDGE:
+				return out_array;
+			default:
+				abort();
+		}
+	}
+public:
+	page_ts_range_vertex(vertex_id_t id): page_vertex(true) {
+		this->id = id;
+		in_array = NULL;
+		out_array = NULL;
+		in_start = 0;
+		out_start = 0;
+	}
+
+	void set_part(edge_type type, const page_byte_array &arr, size_t start) {
+		switch(type) {
+			case IN_EDGE:
+				in_array = &arr;
+				in_start = start;
+				break;
+			case OUT_EDGE:
+				out_array = &arr;
+				out_start = start;
+				break;
+			default:
+				abort();
+		}
+	}
+
+	/*
+	 * The location of the first edge of the range in the edge list.
+	 */
+	size_t get_edge_start(edge_type type) const {
+		return type == IN_EDGE ? in_start : out_start;
+	}
+
+	size_t get_num_edges(edge_type type) const {
+		if (type == BOTH_EDGES)
+			return get_num_edges(IN_EDGE) + get_num_edges(OUT_EDGE);
+		const page_byte_array *arr = get_array(type);
+		return arr ? arr->get_size() / sizeof(vertex_id_t) : 0;
+	}
+
+	page_byte_array::const_iterator<vertex_id_t> get_neigh_begin(
+			edge_type type) const {
+		const page_byte_array *arr = get_array(type);
+		assert(arr);
+		return arr->begin<vertex_id_t>(0);
+	}
+
+	page_byte_array::const_iterator<vertex_id_t> get_neigh_end(
+			edge_type type) const {
+		const page_byte_array *arr = get_array(type);
+		assert(arr);
+		return arr->end<vertex_id_t>();
+	}
+
+	page_byte_array::seq_const_iterator<vertex_id_t> get_neigh_seq_it(
+			edge_type type, size_t start = 0, size_t end = -1) const {
+		end = std::min(end, get_num_edges(type));
+		assert(start <= end);
+		const page_byte_array *arr = get_array(type);
+		// The part isn't read, so we return an empty iterator on
+		// the other part.
+		if (arr == NULL) {
+			arr = in_array ? in_array : out_array;
+			assert(arr);
+			return arr->get_seq_iterator<vertex_id_t>(0, 0);
+		}
+		return arr->get_seq_iterator<vertex_id_t>(start * sizeof(vertex_id_t),
+				end * sizeof(vertex_id_t));
+	}
+
+	vertex_id_t get_id() const {
+		return id;
+	}
+};
+
+#endif
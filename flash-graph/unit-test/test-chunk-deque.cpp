@@ -0,0 +1,102 @@
+#include <pthread.h>
+
+#include <atomic>
+#include <vector>
+
+#define BOOST_TEST_MODULE chunk_deque
+#include <boost/test/included/unit_test.hpp>
+
+#include "load_balancer.h"
+
+const int num_thieves = 4;
+const int num_chunks = 1024 * 64;
+
+vertex_chunk_deque deque;
+// The number of times each chunk has been fetched.
+std::vector<std::atomic_int> fetched(num_chunks);
+std::atomic_int num_fetched;
+
+static compute_vertex *get_fake_vertex(int chunk_id, int idx)
+{
+	// compute_vertex_pointer requires an address that looks valid.
+	return (compute_vertex *) (((uintptr_t) chunk_id + 1) << 20 | idx << 4);
+}
+
+static vertex_chunk create_chunk(int chunk_id)
+{
+	vertex_chunk chunk;
+	chunk.num = chunk_id % vertex_chunk::CHUNK_SIZE + 1;
+	for (int i = 0; i < chunk.num; i++)
+		chunk.vertices[i] = compute_vertex_pointer(get_fake_vertex(chunk_id, i));
+	return chunk;
+}
+
+static void verify_chunk(const vertex_chunk &chunk)
+{
+	int chunk_id = (((uintptr_t) chunk.vertices[0].get()) >> 20) - 1;
+	BOOST_REQUIRE(chunk_id >= 0 && chunk_id < num_chunks);
+	BOOST_REQUIRE_EQUAL(chunk.num, chunk_id % vertex_chunk::CHUNK_SIZE + 1);
+	for (int i = 0; i < chunk.num; i++)
+		BOOST_REQUIRE(chunk.vertices[i].get() == get_fake_vertex(chunk_id, i));
+	fetched[chunk_id]++;
+	num_fetched++;
+}
+
+static void *steal_chunks(void *arg)
+{
+	vertex_chunk chunk;
+	while (num_fetched.load() < num_chunks) {
+		if (deque.steal(chunk))
+			verify_chunk(chunk);
+	}
+	return NULL;
+}
+
+BOOST_AUTO_TEST_SUITE (chunk_deque_test)
+
+BOOST_AUTO_TEST_CASE (test_owner)
+{
+	vertex_chunk chunk;
+	BOOST_CHECK(!deque.pop(chunk));
+	BOOST_CHECK(!deque.steal(chunk));
+	for (int i = 0; i < vertex_chunk_deque::get_capacity(); i++)
+		BOOST_CHECK(deque.push(create_chunk(i)));
+	BOOST_CHECK(!deque.push(create_chunk(0)));
+	BOOST_CHECK_EQUAL(deque.get_size(), vertex_chunk_deque::get_capacity());
+
+	// The owner gets the last chunk and a thief gets the first chunk.
+	BOOST_CHECK(deque.pop(chunk));
+	BOOST_CHECK_EQUAL(chunk.num, vertex_chunk_deque::get_capacity());
+	BOOST_CHECK(deque.steal(chunk));
+	BOOST_CHECK_EQUAL(chunk.num, 1);
+	while (deque.pop(chunk));
+	BOOST_CHECK(deque.is_empty());
+}
+
+BOOST_AUTO_TEST_CASE (test_steal)
+{
+	pthread_t threads[num_thieves];
+	for (int i = 0; i < num_thieves; i++)
+		pthread_create(&threads[i], NULL, steal_chunks, NULL);
+
+	int num_pushed = 0;
+	vertex_chunk chunk;
+	while (num_pushed < num_chunks) {
+		if (deque.push(create_chunk(num_pushed)))
+			num_pushed++;
+		// The owner pops some of the chunks itself.
+		if (num_pushed % 3 == 0 && deque.pop(chunk))
+			verify_chunk(chunk);
+	}
+	while (deque.pop(chunk))
+		verify_chunk(chunk);
+
+	for (int i = 0; i < num_thieves; i++)
+		pthread_join(threads[i], NULL);
+	BOOST_CHECK(deque.is_empty());
+	BOOST_CHECK_EQUAL(num_fetched.load(), num_chunks);
+	for (int i = 0; i < num_chunks; i++)
+		BOOST_REQUIRE_EQUAL(fetched[i].load(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE compressed_graph
+#include <boost/test/included/unit_test.hpp>
+
+#include "FGlib.h"
+#include "graph_engine.h"
+#include "utils.h"
+
+/*
+ * Run the vertex program on a graph whose adjacency lists are compressed,
+ * and check that the number of edges the engine gets for a vertex without
+ * reading its adjacency list is the same as the one in the adjacency list.
+ */
+
+enum test_stage_t
+{
+	HEADER,
+	ADJ_LIST,
+};
+static test_stage_t test_stage;
+
+class count_vertex: public compute_directed_vertex
+{
+public:
+	vsize_t header_in;
+	vsize_t header_out;
+	vsize_t list_in;
+	vsize_t list_out;
+
+	count_vertex(vertex_id_t id): compute_directed_vertex(id) {
+		header_in = -1;
+		header_out = -1;
+		list_in = -1;
+		list_out = -1;
+	}
+
+	void run(vertex_program &prog) {
+		vertex_id_t id = prog.get_vertex_id(*this);
+		if (test_stage == HEADER)
+			request_vertex_headers(&id, 1);
+		else
+			request_vertices(&id, 1);
+	}
+
+	void run(vertex_program &prog, const page_vertex &vertex) {
+		list_in = 0;
+		edge_seq_iterator in_it = vertex.get_neigh_seq_it(IN_EDGE);
+		while (in_it.has_next()) {
+			in_it.next();
+			list_in++;
+		}
+		list_out = 0;
+		edge_seq_iterator out_it = vertex.get_neigh_seq_it(OUT_EDGE);
+		while (out_it.has_next()) {
+			out_it.next();
+			list_out++;
+		}
+	}
+
+	void run_on_message(vertex_program &, const vertex_message &msg) {
+	}
+
+	void run_on_vertex_header(vertex_program &prog,
+			const vertex_header &header) {
+		const directed_vertex_header &dheader
+			= (const directed_vertex_header &) header;
+		header_in = dheader.get_num_in_edges();
+		header_out = dheader.get_num_out_edges();
+	}
+};
+
+static std::string build_graph(const std::string &dir, bool compress)
+{
+	std::string edge_file = dir + "/edges.txt";
+	FILE *f = fopen(edge_file.c_str(), "w");
+	assert(f);
+	// Some vertices have many edges, so their adjacency lists span
+	// multiple pages.
+	for (int i = 0; i < 20000; i++) {
+		vertex_id_t from = random() % 1000;
+		vertex_id_t to = i % 10 == 0 ? random() % 10 : random() % 1000;
+		fprintf(f, "%u\t%u\n", from, to);
+	}
+	fclose(f);
+
+	std::string name = dir + (compress ? "/comp" : "/orig");
+	std::vector<std::string> edge_files(1, edge_file);
+	edge_graph::ptr edge_g = parse_edge_lists(edge_files, DEFAULT_TYPE,
+			true, 1, true);
+	disk_serial_graph::ptr g
+		= std::static_pointer_cast<disk_serial_graph, serial_graph>(
+				construct_graph(edge_g, dir, 1));
+	g->dump(name + ".index", name + ".adj", true);
+	if (compress)
+		compress_adj_lists(name + ".index", name + ".adj");
+	return name;
+}
+
+static std::vector<vsize_t> count_edges(const std::string &name)
+{
+	config_map::ptr configs = config_map::create();
+	// Each thread gets a part of the small graph.
+	configs->add_options("threads=2 part_range_size_log=6");
+	FG_graph::ptr fg = FG_graph::create(name + ".adj", name + ".index",
+			configs);
+	graph_index::ptr index = NUMA_graph_index<count_vertex>::create(
+			fg->get_graph_header());
+	graph_engine::ptr graph = fg->create_engine(index);
+	test_stage = HEADER;
+	graph->start_all();
+	graph->wait4complete();
+	test_stage = ADJ_LIST;
+	graph->start_all();
+	graph->wait4complete();
+
+	std::vector<vsize_t> num_edges;
+	for (size_t i = 0; i < graph->get_num_vertices(); i++) {
+		count_vertex &v = (count_vertex &) graph->get_vertex(i);
+		BOOST_CHECK_EQUAL(v.header_in, v.list_in);
+		BOOST_CHECK_EQUAL(v.header_out, v.list_out);
+		BOOST_CHECK_EQUAL(graph->get_num_edges(i, IN_EDGE), v.list_in);
+		BOOST_CHECK_EQUAL(graph->get_num_edges(i, OUT_EDGE), v.list_out);
+		num_edges.push_back(v.list_in);
+		num_edges.push_back(v.list_out);
+	}
+	return num_edges;
+}
+
+BOOST_AUTO_TEST_SUITE (compressed_graph_test)
+
+BOOST_AUTO_TEST_CASE (test_num_edges)
+{
+	char dir_buf[] = "/tmp/test-compressed-graphXXXXXX";
+	BOOST_REQUIRE(mkdtemp(dir_buf));
+	std::string dir = dir_buf;
+
+	srandom(1);
+	std::vector<vsize_t> orig = count_edges(build_graph(dir, false));
+	srandom(1);
+	std::vector<vsize_t> comp = count_edges(build_graph(dir, true));
+	BOOST_CHECK(orig == comp);
+	graph_engine::destroy_flash_graph();
+
+	std::string cmd = "rm -rf " + dir;
+	BOOST_VERIFY(system(cmd.c_str()) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END( )
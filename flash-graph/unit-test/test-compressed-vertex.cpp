@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <vector>
+
+#define BOOST_TEST_MODULE compressed_vertex
+#include <boost/test/included/unit_test.hpp>
+
+#include "vertex.h"
+
+/*
+ * The byte array that contains data in contiguous pages in memory.
+ */
+class test_byte_array: public page_byte_array
+{
+	const char *pages;
+	off_t off;
+	size_t size;
+public:
+	test_byte_array(const char *pages, off_t off, size_t size) {
+		this->pages = pages;
+		this->off = off;
+		this->size = size;
+	}
+
+	virtual void lock() {
+	}
+
+	virtual void unlock() {
+	}
+
+	virtual size_t get_size() const {
+		return size;
+	}
+
+	virtual page_byte_array *clone() {
+		return NULL;
+	}
+
+	virtual off_t get_offset() const {
+		return off;
+	}
+
+	virtual off_t get_offset_in_first_page() const {
+		return off % PAGE_SIZE;
+	}
+
+	virtual const char *get_page(int idx) const {
+		return pages + (off / PAGE_SIZE + idx) * PAGE_SIZE;
+	}
+};
+
+void test_vertex(vsize_t num_edges, uint32_t edge_data_size, bool sparse)
+{
+	vertex_id_t id = random() % (1 << 30);
+	std::vector<vertex_id_t> neighs(num_edges);
+	for (size_t i = 0; i < num_edges; i++) {
+		if (sparse)
+			neighs[i] = random();
+		else
+			neighs[i] = id + i * 3 - 100;
+	}
+	std::sort(neighs.begin(), neighs.end());
+
+	size_t raw_size = ext_mem_undirected_vertex::num_edges2vsize(num_edges,
+			edge_data_size);
+	std::vector<char> raw_buf(raw_size);
+	new (raw_buf.data()) ext_mem_undirected_vertex(id, num_edges,
+			edge_data_size);
+	memcpy(raw_buf.data() + ext_mem_undirected_vertex::get_header_size(),
+			neighs.data(), num_edges * sizeof(vertex_id_t));
+	size_t edge_data_off = ext_mem_undirected_vertex::get_edge_data_offset(
+			num_edges, edge_data_size);
+	for (size_t i = 0; i < num_edges * edge_data_size; i++)
+		raw_buf[edge_data_off + i] = random();
+
+	std::vector<char> comp_buf(ext_mem_compressed_vertex::get_max_size(
+				num_edges, edge_data_size));
+	size_t comp_size = ext_mem_compressed_vertex::compress(
+			*(ext_mem_undirected_vertex *) raw_buf.data(), comp_buf.data(),
+			comp_buf.size());
+	if (!sparse)
+		BOOST_CHECK(comp_size <= raw_size);
+
+	// Put the compressed vertex in a random location in the pages,
+	// so it may cross page boundaries.
+	off_t off = random() % (PAGE_SIZE / sizeof(vertex_id_t))
+		* sizeof(vertex_id_t);
+	std::vector<char> pages(ROUNDUP_PAGE(off + comp_size));
+	memcpy(pages.data() + off, comp_buf.data(), comp_size);
+	test_byte_array arr(pages.data(), off, comp_size);
+
+	decompressed_byte_array dec_arr;
+	dec_arr.init(arr);
+	BOOST_CHECK_EQUAL(dec_arr.get_compressed_size(), comp_size);
+	BOOST_CHECK_EQUAL(dec_arr.get_size(), raw_size);
+	BOOST_CHECK(memcmp(dec_arr.get_page(0), raw_buf.data(),
+				ext_mem_undirected_vertex::get_header_size()
+				+ num_edges * sizeof(vertex_id_t)) == 0);
+	BOOST_CHECK(memcmp(dec_arr.get_page(0) + edge_data_off,
+				raw_buf.data() + edge_data_off,
+				num_edges * edge_data_size) == 0);
+
+	page_undirected_vertex pg_v(dec_arr);
+	BOOST_CHECK_EQUAL(pg_v.get_id(), id);
+	BOOST_CHECK_EQUAL(pg_v.get_num_edges(), num_edges);
+	edge_seq_iterator it = pg_v.get_neigh_seq_it(edge_type::OUT_EDGE);
+	size_t num_neighs = 0;
+	while (it.has_next())
+		BOOST_CHECK_EQUAL(it.next(), neighs[num_neighs++]);
+	BOOST_CHECK_EQUAL(num_neighs, num_edges);
+
+	page_byte_array *copy = dec_arr.clone();
+	BOOST_CHECK(copy != NULL);
+	BOOST_CHECK_EQUAL(copy->get_offset(), dec_arr.get_offset());
+	BOOST_CHECK_EQUAL(copy->get_size(), raw_size);
+	BOOST_CHECK(memcmp(copy->get_page(0), dec_arr.get_page(0), raw_size) == 0);
+	page_byte_array::destroy(copy);
+}
+
+BOOST_AUTO_TEST_SUITE (compressed_vertex_test)
+
+BOOST_AUTO_TEST_CASE (test_no_edge_data)
+{
+	for (int i = 0; i < 500; i++)
+		test_vertex(random() % 5000, 0, i % 2);
+}
+
+BOOST_AUTO_TEST_CASE (test_edge_data)
+{
+	for (int i = 0; i < 500; i++)
+		test_vertex(random() % 5000, i % 2 ? 4 : 8, i % 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END( )
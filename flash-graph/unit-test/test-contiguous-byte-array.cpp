@@ -0,0 +1,130 @@
+#include <vector>
+
+#define BOOST_TEST_MODULE contiguous_byte_array
+#include <boost/test/included/unit_test.hpp>
+
+#include "vertex.h"
+
+/*
+ * The byte array that contains data in pages in memory. If it's
+ * contiguous, the iterators access the data without going through
+ * the pages.
+ */
+class test_byte_array: public page_byte_array
+{
+	const char *pages;
+	off_t off;
+	size_t size;
+	bool contiguous;
+public:
+	test_byte_array(const char *pages, off_t off, size_t size,
+			bool contiguous) {
+		this->pages = pages;
+		this->off = off;
+		this->size = size;
+		this->contiguous = contiguous;
+	}
+
+	virtual void lock() {
+	}
+
+	virtual void unlock() {
+	}
+
+	virtual size_t get_size() const {
+		return size;
+	}
+
+	virtual page_byte_array *clone() {
+		return NULL;
+	}
+
+	virtual off_t get_offset() const {
+		return off;
+	}
+
+	virtual off_t get_offset_in_first_page() const {
+		return off % PAGE_SIZE;
+	}
+
+	virtual const char *get_page(int idx) const {
+		return pages + (off / PAGE_SIZE + idx) * PAGE_SIZE;
+	}
+
+	virtual const char *get_contiguous_data() const {
+		return contiguous ? pages + off : NULL;
+	}
+};
+
+std::vector<vertex_id_t> get_neighs(const page_vertex &v)
+{
+	std::vector<vertex_id_t> neighs;
+	edge_seq_iterator it = v.get_neigh_seq_it(edge_type::OUT_EDGE);
+	PAGE_FOREACH(vertex_id_t, id, it) {
+		neighs.push_back(id);
+	} PAGE_FOREACH_END
+	return neighs;
+}
+
+void test_vertex(vsize_t num_edges)
+{
+	vertex_id_t id = random() % (1 << 30);
+	std::vector<vertex_id_t> neighs(num_edges);
+	for (size_t i = 0; i < num_edges; i++)
+		neighs[i] = random();
+
+	size_t size = ext_mem_undirected_vertex::num_edges2vsize(num_edges, 0);
+	// Put the vertex in a random location in the pages, so it may cross
+	// page boundaries.
+	off_t off = random() % (PAGE_SIZE / sizeof(vertex_id_t))
+		* sizeof(vertex_id_t);
+	std::vector<char> pages(ROUNDUP_PAGE(off + size));
+	new (pages.data() + off) ext_mem_undirected_vertex(id, num_edges, 0);
+	memcpy(pages.data() + off + ext_mem_undirected_vertex::get_header_size(),
+			neighs.data(), num_edges * sizeof(vertex_id_t));
+
+	test_byte_array paged_arr(pages.data(), off, size, false);
+	test_byte_array arr(pages.data(), off, size, true);
+	page_undirected_vertex paged_v(paged_arr);
+	page_undirected_vertex v(arr);
+	BOOST_CHECK_EQUAL(v.get_id(), id);
+	BOOST_CHECK_EQUAL(v.get_num_edges(), num_edges);
+
+	BOOST_CHECK(get_neighs(v) == neighs);
+	BOOST_CHECK(get_neighs(paged_v) == neighs);
+
+	size_t i = 0;
+	for (edge_iterator it = v.get_neigh_begin(edge_type::OUT_EDGE);
+			it != v.get_neigh_end(edge_type::OUT_EDGE); ++it)
+		BOOST_CHECK_EQUAL(*it, neighs[i++]);
+	BOOST_CHECK_EQUAL(i, num_edges);
+
+	std::vector<vertex_id_t> edges(num_edges);
+	v.read_edges(edge_type::OUT_EDGE, edges.data(), num_edges);
+	BOOST_CHECK(edges == neighs);
+
+	if (num_edges > 0) {
+		size_t idx = random() % num_edges;
+		edge_seq_iterator it = v.get_neigh_seq_it(edge_type::OUT_EDGE);
+		BOOST_CHECK(it.move_to(idx));
+		BOOST_CHECK_EQUAL(it.curr(), neighs[idx]);
+		BOOST_CHECK_EQUAL(it.get_num_tot_entries(), num_edges - idx);
+	}
+
+	// A sub array of a contiguous array is also contiguous.
+	off_t sub_off = ext_mem_undirected_vertex::get_header_size();
+	sub_page_byte_array sub_arr(arr, sub_off);
+	BOOST_CHECK(sub_arr.get_contiguous_data() == pages.data() + off + sub_off);
+	sub_page_byte_array paged_sub_arr(paged_arr, sub_off);
+	BOOST_CHECK(paged_sub_arr.get_contiguous_data() == NULL);
+}
+
+BOOST_AUTO_TEST_SUITE (contiguous_byte_array_test)
+
+BOOST_AUTO_TEST_CASE (test_vertices)
+{
+	for (int i = 0; i < 500; i++)
+		test_vertex(random() % 5000);
+}
+
+BOOST_AUTO_TEST_SUITE_END( )
@@ -0,0 +1,158 @@
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE msg_combiner
+#include <boost/test/included/unit_test.hpp>
+
+#include "FGlib.h"
+#include "graph_engine.h"
+#include "utils.h"
+
+/*
+ * Every vertex multicasts a message to its out-neighbors. The messages
+ * received by a vertex are counted with and without a message combiner.
+ */
+
+class count_message: public vertex_message
+{
+	int count;
+public:
+	count_message(int count): vertex_message(sizeof(count_message), false) {
+		this->count = count;
+	}
+
+	int get_count() const {
+		return count;
+	}
+
+	void add_count(int count) {
+		this->count += count;
+	}
+};
+
+class count_msg_combiner: public message_combiner
+{
+public:
+	void combine(vertex_message &combined, const vertex_message &msg) const {
+		((count_message &) combined).add_count(
+				((const count_message &) msg).get_count());
+	}
+};
+
+class msg_vertex: public compute_directed_vertex
+{
+public:
+	// The number of times run_on_message is invoked.
+	size_t num_calls;
+	// The number of messages sent to the vertex.
+	size_t num_msgs;
+
+	msg_vertex(vertex_id_t id): compute_directed_vertex(id) {
+		num_calls = 0;
+		num_msgs = 0;
+	}
+
+	void run(vertex_program &prog) {
+		directed_vertex_request req(prog.get_vertex_id(*this),
+				edge_type::OUT_EDGE);
+		request_partial_vertices(&req, 1);
+	}
+
+	void run(vertex_program &prog, const page_vertex &vertex) {
+		edge_seq_iterator it = vertex.get_neigh_seq_it(OUT_EDGE);
+		count_message msg(1);
+		prog.multicast_msg(it, msg);
+	}
+
+	void run_on_message(vertex_program &, const vertex_message &msg) {
+		num_calls++;
+		num_msgs += ((const count_message &) msg).get_count();
+	}
+};
+
+class combiner_program_creater: public vertex_program_creater
+{
+public:
+	vertex_program::ptr create() const {
+		vertex_program::ptr prog(new vertex_program_impl<msg_vertex>());
+		prog->set_msg_combiner(message_combiner::ptr(new count_msg_combiner()));
+		return prog;
+	}
+};
+
+static std::string build_graph(const std::string &dir)
+{
+	std::string edge_file = dir + "/edges.txt";
+	FILE *f = fopen(edge_file.c_str(), "w");
+	assert(f);
+	// Vertices have many in-edges, so the messages to a vertex
+	// can be combined.
+	for (int i = 0; i < 20000; i++)
+		fprintf(f, "%ld\t%ld\n", random() % 1000, random() % 100);
+	fclose(f);
+
+	std::string name = dir + "/graph";
+	std::vector<std::string> edge_files(1, edge_file);
+	edge_graph::ptr edge_g = parse_edge_lists(edge_files, DEFAULT_TYPE,
+			true, 1, true);
+	disk_serial_graph::ptr g
+		= std::static_pointer_cast<disk_serial_graph, serial_graph>(
+				construct_graph(edge_g, dir, 1));
+	g->dump(name + ".index", name + ".adj", true);
+	return name;
+}
+
+/*
+ * It returns the number of run_on_message calls and the number of
+ * messages received by all vertices.
+ */
+static std::pair<size_t, size_t> count_msgs(FG_graph::ptr fg, bool combine)
+{
+	graph_index::ptr index = NUMA_graph_index<msg_vertex>::create(
+			fg->get_graph_header());
+	graph_engine::ptr graph = fg->create_engine(index);
+	if (combine)
+		graph->start_all(vertex_initializer::ptr(),
+				vertex_program_creater::ptr(new combiner_program_creater()));
+	else
+		graph->start_all();
+	graph->wait4complete();
+
+	std::pair<size_t, size_t> ret(0, 0);
+	for (size_t i = 0; i < graph->get_num_vertices(); i++) {
+		msg_vertex &v = (msg_vertex &) graph->get_vertex(i);
+		ret.first += v.num_calls;
+		ret.second += v.num_msgs;
+	}
+	return ret;
+}
+
+BOOST_AUTO_TEST_SUITE (msg_combiner_test)
+
+BOOST_AUTO_TEST_CASE (test_combine_multicast)
+{
+	char dir_buf[] = "/tmp/test-msg-combinerXXXXXX";
+	BOOST_REQUIRE(mkdtemp(dir_buf));
+	std::string dir = dir_buf;
+
+	std::string name = build_graph(dir);
+	config_map::ptr configs = config_map::create();
+	configs->add_options("threads=2 part_range_size_log=6");
+	FG_graph::ptr fg = FG_graph::create(name + ".adj", name + ".index",
+			configs);
+	std::pair<size_t, size_t> orig = count_msgs(fg, false);
+	std::pair<size_t, size_t> combined = count_msgs(fg, true);
+	BOOST_CHECK_EQUAL(orig.first, orig.second);
+	BOOST_CHECK_EQUAL(orig.second, combined.second);
+	BOOST_CHECK_LT(combined.first, orig.first);
+	printf("%ld run_on_message calls without a combiner, %ld with a combiner\n",
+			orig.first, combined.first);
+	graph_engine::destroy_flash_graph();
+
+	std::string cmd = "rm -rf " + dir;
+	BOOST_VERIFY(system(cmd.c_str()) == 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END( )
@@ -0,0 +1,70 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+
+#define BOOST_TEST_MODULE vertex_index
+#include <boost/test/included/unit_test.hpp>
+
+#include "exception.h"
+#include "vertex.h"
+#include "vertex_index.h"
+
+/*
+ * Build the index of a small undirected graph. Vertex i has i % 5 edges.
+ */
+static std::string build_index(const std::string &dir)
+{
+	const size_t num_vertices = 1000;
+	default_in_mem_vertex_index in_idx;
+	size_t num_edges = 0;
+	for (vertex_id_t id = 0; id < num_vertices; id++) {
+		in_mem_undirected_vertex<> v(id, false);
+		for (vertex_id_t i = 0; i < id % 5; i++)
+			v.add_edge(edge<>(id, i));
+		num_edges += v.get_num_edges(edge_type::OUT_EDGE);
+		in_idx.add_vertex(v);
+	}
+	graph_header header(graph_type::UNDIRECTED, num_vertices, num_edges, 0);
+	std::string index_file = dir + "/graph.index";
+	in_idx.dump(index_file, header, false);
+	return index_file;
+}
+
+BOOST_AUTO_TEST_SUITE (vertex_index_test)
+
+BOOST_AUTO_TEST_CASE (test_mmap_load)
+{
+	char dir_buf[] = "/tmp/test-vertex-indexXXXXXX";
+	BOOST_REQUIRE(mkdtemp(dir_buf));
+	std::string dir = dir_buf;
+	std::string index_file = build_index(dir);
+
+	vertex_index::ptr loaded = vertex_index::load(index_file);
+	vertex_index::ptr mapped = vertex_index::mmap_load(index_file, false,
+			false);
+	BOOST_CHECK(vertex_index::is_mapped(mapped));
+	BOOST_CHECK(!vertex_index::is_mapped(loaded));
+	BOOST_REQUIRE_EQUAL(mapped->get_num_vertices(),
+			loaded->get_num_vertices());
+	BOOST_REQUIRE_EQUAL(mapped->get_index_size(), loaded->get_index_size());
+	default_vertex_index::ptr loaded_idx = default_vertex_index::cast(loaded);
+	default_vertex_index::ptr mapped_idx = default_vertex_index::cast(mapped);
+	for (size_t i = 0; i <= loaded->get_num_vertices(); i++)
+		BOOST_CHECK_EQUAL(mapped_idx->get_vertex(i).get_off(),
+				loaded_idx->get_vertex(i).get_off());
+
+	// A truncated index is an input error.
+	BOOST_REQUIRE(truncate(index_file.c_str(),
+				loaded->get_index_size() - 1) == 0);
+	BOOST_CHECK_THROW(vertex_index::mmap_load(index_file, false, false),
+			io_exception);
+	BOOST_REQUIRE(truncate(index_file.c_str(), 10) == 0);
+	BOOST_CHECK_THROW(vertex_index::mmap_load(index_file, false, false),
+			io_exception);
+
+	unlink(index_file.c_str());
+	rmdir(dir.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
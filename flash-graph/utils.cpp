@@ -235,6 +235,7 @@ public:
 	virtual void push_back(const edge<edge_data_type> &e) = 0;
 	virtual void append(const std::vector<edge<edge_data_type> > &vec) = 0;
 	virtual void sort(bool out_edge) = 0;
+	virtual void relabel(const std::vector<vertex_id_t> &new_ids) = 0;
 	virtual edge_stream get_stream() const = 0;
 	virtual ptr clone() const = 0;
 	virtual size_t size() const = 0;
@@ -299,6 +300,15 @@ public:
 		}
 	}
 
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		typename stxxl::VECTOR_GENERATOR<edge<edge_data_type> >::result::iterator it;
+		for (it = data.begin(); it != data.end(); it++) {
+			edge<edge_data_type> e = *it;
+			e.relabel(new_ids);
+			*it = e;
+		}
+	}
+
 	virtual typename edge_vector<edge_data_type>::edge_stream get_stream() const {
 		typename edge_vector<edge_data_type>::bulk_iterator::ptr it(
 				new stxxl_iterator(data.begin(), data.end()));
@@ -397,6 +407,12 @@ public:
 		}
 	}
 
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+#pragma omp parallel for
+		for (size_t i = 0; i < data.size(); i++)
+			data[i].relabel(new_ids);
+	}
+
 	virtual typename edge_vector<edge_data_type>::edge_stream get_stream() const {
 		typename edge_vector<edge_data_type>::bulk_iterator::ptr it(
 				new std_iterator(data.begin(), data.end()));
@@ -1028,6 +1044,50 @@ public:
 	}
 };
 
+/*
+ * Construct the adjacency lists of all vertices from edge lists.
+ * The adjacency list of vertex `i' is stored in
+ * neighbors[offs[i]] ... neighbors[offs[i + 1] - 1].
+ * If `both_dirs' is true, an edge is added to the adjacency lists of
+ * both of its endpoints.
+ */
+template<class edge_data_type>
+void build_adjacency(
+		const std::vector<std::shared_ptr<edge_vector<edge_data_type> > > &edge_lists,
+		bool both_dirs, std::vector<size_t> &offs,
+		std::vector<vertex_id_t> &neighbors)
+{
+	std::vector<size_t> degrees;
+	for (size_t i = 0; i < edge_lists.size(); i++) {
+		typename edge_vector<edge_data_type>::edge_stream strm
+			= edge_lists[i]->get_stream();
+		for (; !strm.empty(); ++strm) {
+			vertex_id_t max_id = std::max(strm->get_from(), strm->get_to());
+			if (max_id >= degrees.size())
+				degrees.resize(max_id + 1);
+			degrees[strm->get_from()]++;
+			if (both_dirs)
+				degrees[strm->get_to()]++;
+		}
+	}
+
+	offs.resize(degrees.size() + 1);
+	offs[0] = 0;
+	for (size_t i = 0; i < degrees.size(); i++)
+		offs[i + 1] = offs[i] + degrees[i];
+	neighbors.resize(offs.back());
+	std::vector<size_t> locs(offs.begin(), offs.end() - 1);
+	for (size_t i = 0; i < edge_lists.size(); i++) {
+		typename edge_vector<edge_data_type>::edge_stream strm
+			= edge_lists[i]->get_stream();
+		for (; !strm.empty(); ++strm) {
+			neighbors[locs[strm->get_from()]++] = strm->get_to();
+			if (both_dirs)
+				neighbors[locs[strm->get_to()]++] = strm->get_from();
+		}
+	}
+}
+
 template<class edge_data_type = empty_data>
 class undirected_edge_graph: public edge_graph
 {
@@ -1061,7 +1121,8 @@ public:
 	 */
 	undirected_edge_graph(
 			std::vector<std::shared_ptr<edge_vector<edge_data_type> > > &edge_lists,
-			bool has_data): edge_graph(has_data) {
+			bool has_data): edge_graph(
+				has_data ? sizeof(edge_data_type) : 0) {
 		this->edge_lists = edge_lists;
 	}
 
@@ -1070,6 +1131,17 @@ public:
 			edge_lists[i]->sort(true);
 	}
 
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		for (size_t i = 0; i < edge_lists.size(); i++)
+			edge_lists[i]->relabel(new_ids);
+	}
+
+	void get_adjacency(std::vector<size_t> &offs,
+			std::vector<vertex_id_t> &neighbors) const {
+		// Each edge is stored in both directions in an undirected graph.
+		build_adjacency(edge_lists, false, offs, neighbors);
+	}
+
 	size_t get_num_edges() const {
 		size_t num_edges = 0;
 		for (size_t i = 0; i < edge_lists.size(); i++)
@@ -1125,7 +1197,8 @@ public:
 	 */
 	directed_edge_graph(
 			std::vector<std::shared_ptr<edge_vector<edge_data_type> > > &edge_lists,
-			bool has_data): edge_graph(has_data) {
+			bool has_data): edge_graph(
+				has_data ? sizeof(edge_data_type) : 0) {
 		this->in_edge_lists = edge_lists;
 		this->out_edge_lists.resize(edge_lists.size());
 		for (size_t i = 0; i < edge_lists.size(); i++)
@@ -1139,6 +1212,18 @@ public:
 		}
 	}
 
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		for (size_t i = 0; i < in_edge_lists.size(); i++) {
+			out_edge_lists[i]->relabel(new_ids);
+			in_edge_lists[i]->relabel(new_ids);
+		}
+	}
+
+	void get_adjacency(std::vector<size_t> &offs,
+			std::vector<vertex_id_t> &neighbors) const {
+		build_adjacency(out_edge_lists, true, offs, neighbors);
+	}
+
 	void check_vertices(
 			const std::vector<ext_mem_undirected_vertex *> &vertices,
 			bool in_part) const;
@@ -1521,6 +1606,101 @@ void disk_serial_graph::dump(const std::string &index_file,
 			"It takes %1% seconds to dump the index") % time_diff(start, end);
 }
 
+/*
+ * Read the next vertex in the original format from the adjacency list file.
+ */
+static const ext_mem_undirected_vertex *read_ext_vertex(FILE *f,
+		std::vector<char> &buf)
+{
+	size_t header_size = ext_mem_undirected_vertex::get_header_size();
+	if (buf.size() < header_size)
+		buf.resize(header_size);
+	BOOST_VERIFY(fread(buf.data(), header_size, 1, f) == 1);
+	size_t size = ((ext_mem_undirected_vertex *) buf.data())->get_size();
+	if (buf.size() < size)
+		buf.resize(size);
+	if (size > header_size)
+		BOOST_VERIFY(fread(buf.data() + header_size, size - header_size,
+					1, f) == 1);
+	return (const ext_mem_undirected_vertex *) buf.data();
+}
+
+void compress_adj_lists(const std::string &index_file,
+		const std::string &adj_file)
+{
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+
+	FILE *in_f = fopen(adj_file.c_str(), "r");
+	if (in_f == NULL)
+		ABORT_MSG(boost::format("fail to open %1%: %2%")
+				% adj_file % strerror(errno));
+	graph_header header;
+	BOOST_VERIFY(fread(&header, sizeof(header), 1, in_f) == 1);
+	header.verify();
+	if (header.is_edge_list_compressed())
+		ABORT_MSG("the adjacency lists have been compressed");
+	if (header.get_graph_type() != graph_type::DIRECTED
+			&& header.get_graph_type() != graph_type::UNDIRECTED)
+		ABORT_MSG("only directed and undirected graphs can be compressed");
+
+	std::string tmp_adj_file = adj_file + ".tmp";
+	FILE *out_f = fopen(tmp_adj_file.c_str(), "w");
+	if (out_f == NULL)
+		ABORT_MSG(boost::format("fail to open %1%: %2%")
+				% tmp_adj_file % strerror(errno));
+	header.set_edge_list_compressed(true);
+	BOOST_VERIFY(fwrite(&header, sizeof(header), 1, out_f) == 1);
+
+	// A directed graph stores the in-part of all vertices and then
+	// the out-part of all vertices.
+	size_t num_vertices = header.get_num_vertices();
+	size_t num_parts = header.is_directed_graph() ? 2 : 1;
+	std::vector<vsize_t> num_edges(num_vertices * num_parts);
+	std::vector<off_t> offs(num_vertices * num_parts + 1);
+	std::vector<char> in_buf;
+	std::vector<char> out_buf;
+	off_t off = sizeof(header);
+	for (size_t i = 0; i < num_vertices * num_parts; i++) {
+		const ext_mem_undirected_vertex *v = read_ext_vertex(in_f, in_buf);
+		TEST(v->get_id() == i % num_vertices);
+		num_edges[i] = v->get_num_edges();
+		offs[i] = off;
+
+		size_t max_size = ext_mem_compressed_vertex::get_max_size(
+				v->get_num_edges(), v->get_edge_data_size());
+		if (out_buf.size() < max_size)
+			out_buf.resize(max_size);
+		size_t size = ext_mem_compressed_vertex::compress(*v, out_buf.data(),
+				out_buf.size());
+		BOOST_VERIFY(fwrite(out_buf.data(), size, 1, out_f) == 1);
+		off += size;
+	}
+	offs.back() = off;
+	long orig_size = ftell(in_f);
+	fclose(in_f);
+	fclose(out_f);
+
+	std::string tmp_index_file = index_file + ".tmp";
+	if (header.is_directed_graph()) {
+		std::vector<directed_vertex_entry> entries(num_vertices + 1);
+		for (size_t i = 0; i <= num_vertices; i++)
+			entries[i] = directed_vertex_entry(offs[i], offs[num_vertices + i]);
+		directed_vertex_index::dump(tmp_index_file, header, entries, num_edges);
+	}
+	else {
+		std::vector<vertex_offset> entries(offs.begin(), offs.end());
+		default_vertex_index::dump(tmp_index_file, header, entries, num_edges);
+	}
+	BOOST_VERIFY(rename(tmp_adj_file.c_str(), adj_file.c_str()) == 0);
+	BOOST_VERIFY(rename(tmp_index_file.c_str(), index_file.c_str()) == 0);
+
+	gettimeofday(&end, NULL);
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"It takes %1% seconds to compress adjacency lists from %2% bytes to %3% bytes")
+		% time_diff(start, end) % orig_size % off;
+}
+
 template<class edge_data_type = empty_data>
 edge_graph::ptr par_load_edge_list_text(
 		const std::vector<std::string> &files, bool has_edge_data,
@@ -2326,9 +2506,12 @@ edge_graph::ptr par_load_edge_list_text(const std::vector<std::string> &files,
 			io = graph_file_io::ptr(new text_graph_file_io(file));
 		while (!io->eof()) {
 			size_t size = 0;
+			// The size is only known after the text is read, so we can't
+			// read the text in the argument list of the task.
+			std::unique_ptr<char[]> line_buf = io->read_edge_list_text(
+					EDGE_LIST_BLOCK_SIZE, size);
 			thread_task *task = new text_edge_task<edge_data_type>(
-					io->read_edge_list_text(EDGE_LIST_BLOCK_SIZE, size),
-					size, directed);
+					std::move(line_buf), size, directed);
 			threads[thread_no % num_threads]->add_task(task);
 			thread_no++;
 		}
@@ -2380,6 +2563,137 @@ edge_graph::ptr par_load_edge_list_text(const std::vector<std::string> &files,
 	return edge_g;
 }
 
+class comp_degree
+{
+	const std::vector<size_t> &offs;
+	bool ascend;
+public:
+	comp_degree(const std::vector<size_t> &_offs, bool ascend): offs(_offs) {
+		this->ascend = ascend;
+	}
+
+	size_t get_degree(vertex_id_t id) const {
+		return offs[id + 1] - offs[id];
+	}
+
+	bool operator()(vertex_id_t id1, vertex_id_t id2) const {
+		if (ascend)
+			return get_degree(id1) < get_degree(id2);
+		else
+			return get_degree(id1) > get_degree(id2);
+	}
+};
+
+/*
+ * Order vertices in descending order of their degree. Vertices with
+ * the same degree keep their original order.
+ */
+static void get_degree_order(const std::vector<size_t> &offs,
+		std::vector<vertex_id_t> &order)
+{
+	size_t num_vertices = offs.size() - 1;
+	order.resize(num_vertices);
+	for (size_t i = 0; i < num_vertices; i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), comp_degree(offs, false));
+}
+
+/*
+ * Reverse Cuthill-McKee ordering. We traverse each connected component
+ * in the BFS order, starting from the unvisited vertex with the smallest
+ * degree and visiting the neighbors of a vertex in ascending order of
+ * their degree. The final order is the reverse of the traversal order.
+ */
+static void get_rcm_order(const std::vector<size_t> &offs,
+		const std::vector<vertex_id_t> &neighbors,
+		std::vector<vertex_id_t> &order)
+{
+	size_t num_vertices = offs.size() - 1;
+	comp_degree comp(offs, true);
+	std::vector<vertex_id_t> start_vertices(num_vertices);
+	for (size_t i = 0; i < num_vertices; i++)
+		start_vertices[i] = i;
+	std::stable_sort(start_vertices.begin(), start_vertices.end(), comp);
+
+	std::vector<bool> visited(num_vertices);
+	std::vector<vertex_id_t> new_neighbors;
+	order.clear();
+	order.reserve(num_vertices);
+	for (size_t i = 0; i < num_vertices; i++) {
+		if (visited[start_vertices[i]])
+			continue;
+		// `order' is also used as the BFS queue.
+		size_t head = order.size();
+		order.push_back(start_vertices[i]);
+		visited[start_vertices[i]] = true;
+		for (; head < order.size(); head++) {
+			vertex_id_t id = order[head];
+			new_neighbors.clear();
+			for (size_t j = offs[id]; j < offs[id + 1]; j++) {
+				if (!visited[neighbors[j]]) {
+					visited[neighbors[j]] = true;
+					new_neighbors.push_back(neighbors[j]);
+				}
+			}
+			std::stable_sort(new_neighbors.begin(), new_neighbors.end(), comp);
+			order.insert(order.end(), new_neighbors.begin(),
+					new_neighbors.end());
+		}
+	}
+	assert(order.size() == num_vertices);
+	std::reverse(order.begin(), order.end());
+}
+
+std::vector<vertex_id_t> reorder_vertices(edge_graph &edge_g,
+		vertex_order order)
+{
+	std::vector<vertex_id_t> new_ids;
+	if (order == ORIG_ORDER)
+		return new_ids;
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	std::vector<size_t> offs;
+	std::vector<vertex_id_t> neighbors;
+	edge_g.get_adjacency(offs, neighbors);
+
+	std::vector<vertex_id_t> vorder;
+	if (order == DEGREE_ORDER)
+		get_degree_order(offs, vorder);
+	else
+		get_rcm_order(offs, neighbors, vorder);
+	// The adjacency lists can be very large. We don't need them any more.
+	std::vector<size_t>().swap(offs);
+	std::vector<vertex_id_t>().swap(neighbors);
+
+	new_ids.resize(vorder.size());
+	for (size_t i = 0; i < vorder.size(); i++)
+		new_ids[vorder[i]] = i;
+	edge_g.relabel(new_ids);
+	gettimeofday(&end, NULL);
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"It takes %1% seconds to reorder %2% vertices")
+		% time_diff(start, end) % new_ids.size();
+	return new_ids;
+}
+
+void dump_vertex_map(const std::string &file,
+		const std::vector<vertex_id_t> &new_ids)
+{
+	std::vector<vertex_id_t> orig_ids(new_ids.size());
+	for (size_t i = 0; i < new_ids.size(); i++)
+		orig_ids[new_ids[i]] = i;
+
+	FILE *f = fopen(file.c_str(), "w");
+	if (f == NULL)
+		ABORT_MSG(boost::format("fail to open %1%: %2%")
+				% file % strerror(errno));
+	if (!orig_ids.empty())
+		BOOST_VERIFY(fwrite(orig_ids.data(),
+					orig_ids.size() * sizeof(orig_ids[0]), 1, f));
+	fclose(f);
+}
+
 edge_graph::ptr parse_edge_lists(const std::vector<std::string> &edge_list_files,
 		int edge_attr_type, bool directed, int nthreads, bool in_mem)
 {
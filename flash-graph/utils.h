@@ -116,6 +116,18 @@ public:
 	}
 
 	virtual void sort_edges() = 0;
+	/*
+	 * Give all vertices new IDs. `new_ids' is indexed by the current IDs
+	 * of vertices.
+	 */
+	virtual void relabel(const std::vector<vertex_id_t> &new_ids) = 0;
+	/*
+	 * Get the adjacency lists of all vertices, ignoring the edge direction.
+	 * The neighbors of vertex `i' are stored in
+	 * neighbors[offs[i]] ... neighbors[offs[i + 1] - 1].
+	 */
+	virtual void get_adjacency(std::vector<size_t> &offs,
+			std::vector<vertex_id_t> &neighbors) const = 0;
 	virtual void check_vertices(
 			const std::vector<ext_mem_undirected_vertex *> &vertices,
 			bool in_part) const = 0;
@@ -148,8 +160,46 @@ public:
 	virtual void finalize_graph_file(const std::string &adj_file) = 0;
 };
 
+/*
+ * The order of vertices in the adjacency list file.
+ */
+enum vertex_order
+{
+	// Keep the vertex IDs in the edge lists.
+	ORIG_ORDER,
+	// Sort vertices in descending order of their degree, so the vertices
+	// accessed most often are stored together.
+	DEGREE_ORDER,
+	// Reverse Cuthill-McKee ordering, which gives neighbors close IDs.
+	RCM_ORDER,
+};
+
+/*
+ * Relabel the vertices of the edge graph in the specified order.
+ * It returns the new ID of each vertex, indexed by the original ID.
+ * Vertices without edges get the largest IDs, so they may not be
+ * stored in the constructed graph. The computation keeps the undirected
+ * adjacency lists of the whole graph in memory.
+ */
+std::vector<vertex_id_t> reorder_vertices(edge_graph &edge_g,
+		vertex_order order);
+/*
+ * Write the map from new vertex IDs to the original vertex IDs to a file,
+ * so results computed on the relabeled graph can be mapped back.
+ * The file is an array of vertex_id_t indexed by the new IDs.
+ */
+void dump_vertex_map(const std::string &file,
+		const std::vector<vertex_id_t> &new_ids);
+
 edge_graph::ptr parse_edge_lists(const std::vector<std::string> &edge_list_files,
 		int edge_attr_type, bool directed, int num_threads, bool in_mem);
+/*
+ * Convert the adjacency lists of a graph to the compressed format
+ * (see ext_mem_compressed_vertex) in place, and rewrite the vertex index
+ * for the compressed graph.
+ */
+void compress_adj_lists(const std::string &index_file,
+		const std::string &adj_file);
 serial_graph::ptr construct_graph(edge_graph::ptr edge_g,
 		const std::string &work_dir, int num_threads);
 serial_graph::ptr construct_graph(const std::vector<std::string> &edge_list_files,
@@ -44,3 +44,160 @@ size_t ext_mem_undirected_vertex::serialize(const in_mem_vertex &v, char *buf,
 
 	return mem_size;
 }
+
+static inline uint64_t zigzag_encode(int64_t v)
+{
+	return (((uint64_t) v) << 1) ^ (uint64_t) (v >> 63);
+}
+
+static inline int64_t zigzag_decode(uint64_t v)
+{
+	return (int64_t) (v >> 1) ^ -((int64_t) (v & 1));
+}
+
+size_t ext_mem_compressed_vertex::compress(const ext_mem_undirected_vertex &v,
+		char *buf, size_t size)
+{
+	assert(size >= get_max_size(v.get_num_edges(), v.get_edge_data_size()));
+	ext_mem_compressed_vertex *comp_v = (ext_mem_compressed_vertex *) buf;
+	comp_v->id = v.get_id();
+	comp_v->edge_data_size = v.get_edge_data_size();
+	comp_v->num_edges = v.get_num_edges();
+
+	unsigned char *p = comp_v->neighbors;
+	vertex_id_t prev = v.get_id();
+	for (size_t i = 0; i < v.get_num_edges(); i++) {
+		vertex_id_t neigh = v.get_neighbor(i);
+		uint64_t gap = zigzag_encode(((int64_t) neigh) - prev);
+		while (gap >= 0x80) {
+			*p++ = (unsigned char) (gap | 0x80);
+			gap >>= 7;
+		}
+		*p++ = (unsigned char) gap;
+		prev = neigh;
+	}
+	comp_v->neigh_bytes = p - comp_v->neighbors;
+
+	size_t edge_data_off = comp_v->get_edge_data_offset();
+	// Clear the padding so the output file is deterministic.
+	memset(p, 0, comp_v->get_size() - (p - (unsigned char *) buf));
+	if (v.has_edge_data())
+		memcpy(buf + edge_data_off, ((const char *) &v)
+				+ ext_mem_undirected_vertex::get_edge_data_offset(
+					v.get_num_edges(), v.get_edge_data_size()),
+				v.get_num_edges() * v.get_edge_data_size());
+	return comp_v->get_size();
+}
+
+namespace {
+
+/*
+ * This decodes the varint-encoded gaps of a neighbor list.
+ * The encoded bytes may be split in multiple pages, so the decoder keeps
+ * its state between the bytes.
+ */
+class neigh_decoder
+{
+	vertex_id_t *neighs;
+	vertex_id_t prev;
+	uint64_t val;
+	int shift;
+	size_t num;
+public:
+	neigh_decoder(vertex_id_t id, vertex_id_t *neighs) {
+		this->neighs = neighs;
+		this->prev = id;
+		this->val = 0;
+		this->shift = 0;
+		this->num = 0;
+	}
+
+	void add(unsigned char b) {
+		val |= ((uint64_t) (b & 0x7f)) << shift;
+		if (b & 0x80)
+			shift += 7;
+		else {
+			prev = (vertex_id_t) (((int64_t) prev) + zigzag_decode(val));
+			neighs[num++] = prev;
+			val = 0;
+			shift = 0;
+		}
+	}
+
+	size_t get_num_decoded() const {
+		return num;
+	}
+};
+
+}
+
+/*
+ * The allocator of the clones of decompressed byte arrays.
+ */
+class decompressed_array_allocator: public byte_array_allocator
+{
+public:
+	virtual page_byte_array *alloc() {
+		return new decompressed_byte_array(*this);
+	}
+
+	virtual void free(page_byte_array *arr) {
+		delete arr;
+	}
+};
+
+static decompressed_array_allocator decompressed_alloc;
+
+page_byte_array *decompressed_byte_array::clone()
+{
+	decompressed_byte_array *arr
+		= (decompressed_byte_array *) decompressed_alloc.alloc();
+	arr->buf.resize(size);
+	::memcpy(arr->buf.data(), buf.data(), size);
+	arr->size = size;
+	arr->compressed_size = compressed_size;
+	arr->off = off;
+	return arr;
+}
+
+void decompressed_byte_array::init(const page_byte_array &arr)
+{
+	BOOST_VERIFY(arr.get_size() >= ext_mem_compressed_vertex::get_header_size());
+	ext_mem_compressed_vertex comp_v = arr.get<ext_mem_compressed_vertex>(0);
+	compressed_size = comp_v.get_size();
+	assert(arr.get_size() >= compressed_size);
+	off = arr.get_offset();
+
+	size = ext_mem_undirected_vertex::num_edges2vsize(comp_v.get_num_edges(),
+			comp_v.get_edge_data_size());
+	buf.resize(size);
+	new (buf.data()) ext_mem_undirected_vertex(comp_v.get_id(),
+			comp_v.get_num_edges(), comp_v.get_edge_data_size());
+
+	neigh_decoder decoder(comp_v.get_id(), (vertex_id_t *) (buf.data()
+				+ ext_mem_undirected_vertex::get_header_size()));
+	off_t neigh_start = ext_mem_compressed_vertex::get_header_size();
+	off_t neigh_end = neigh_start + comp_v.get_neigh_bytes();
+	// Most vertices are inside a page, so we can decode them from
+	// the page directly.
+	if (arr.get_offset_in_first_page() + neigh_end <= PAGE_SIZE) {
+		const unsigned char *p = (const unsigned char *) arr.get_page(0)
+			+ arr.get_offset_in_first_page();
+		for (off_t i = neigh_start; i < neigh_end; i++)
+			decoder.add(p[i]);
+	}
+	else {
+		page_byte_array::seq_const_iterator<unsigned char> it
+			= arr.get_seq_iterator<unsigned char>(neigh_start, neigh_end);
+		PAGE_FOREACH(unsigned char, b, it) {
+			decoder.add(b);
+		} PAGE_FOREACH_END
+	}
+	BOOST_VERIFY(decoder.get_num_decoded() == comp_v.get_num_edges());
+
+	if (comp_v.has_edge_data())
+		arr.memcpy(comp_v.get_edge_data_offset(), buf.data()
+				+ ext_mem_undirected_vertex::get_edge_data_offset(
+					comp_v.get_num_edges(), comp_v.get_edge_data_size()),
+				comp_v.get_num_edges() * comp_v.get_edge_data_size());
+}
@@ -197,6 +197,15 @@ public:
 		from = to;
 		to = tmp;
 	}
+
+	/*
+	 * Give the endpoints of the edge new IDs.
+	 * `new_ids' is indexed by the current IDs of vertices.
+	 */
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		from = new_ids[from];
+		to = new_ids[to];
+	}
 };
 
 template<>
@@ -242,6 +251,15 @@ public:
 		from = to;
 		to = tmp;
 	}
+
+	/*
+	 * Give the endpoints of the edge new IDs.
+	 * `new_ids' is indexed by the current IDs of vertices.
+	 */
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		from = new_ids[from];
+		to = new_ids[to];
+	}
 };
 
 /**
@@ -322,6 +340,15 @@ public:
 		from = to;
 		to = tmp;
 	}
+
+	/*
+	 * Give the endpoints of the edge new IDs.
+	 * `new_ids' is indexed by the current IDs of vertices.
+	 */
+	void relabel(const std::vector<vertex_id_t> &new_ids) {
+		from = new_ids[from];
+		to = new_ids[to];
+	}
 };
 
 /**
@@ -548,6 +575,154 @@ inline bool ext_mem_vertex_info::has_edges() const
 	return size > ext_mem_undirected_vertex::get_header_size();
 }
 
+/*
+ * This vertex represents an undirected vertex (or one part of a directed
+ * vertex) whose adjacency list is compressed in the external memory.
+ * It has the same header as ext_mem_undirected_vertex, followed by
+ * the number of bytes of the encoded neighbor list. Each neighbor is stored
+ * as the gap from the previous neighbor (the first one is relative to
+ * the vertex itself). The gaps are zigzag-encoded and stored as varints,
+ * so a sorted adjacency list usually takes 1-2 bytes per edge. Edge data
+ * isn't compressed and is aligned in the same way as the original format.
+ */
+class ext_mem_compressed_vertex
+{
+	vertex_id_t id;
+	uint32_t edge_data_size;
+	vsize_t num_edges;
+	uint32_t neigh_bytes;
+	unsigned char neighbors[0];
+public:
+	static size_t get_header_size() {
+		return offsetof(ext_mem_compressed_vertex, neighbors);
+	}
+
+	/*
+	 * The maximal size of a compressed vertex. A varint of a gap between
+	 * two vertex Ids takes at most 5 bytes.
+	 */
+	static size_t get_max_size(vsize_t num_edges, uint32_t edge_data_size) {
+		return ROUNDUP(get_header_size() + num_edges * 5 + edge_data_size
+				+ num_edges * edge_data_size, sizeof(vertex_id_t));
+	}
+
+	/*
+	 * Compress a vertex in the original format to the buffer.
+	 * It returns the size of the compressed vertex.
+	 */
+	static size_t compress(const ext_mem_undirected_vertex &v, char *buf,
+			size_t size);
+
+	ext_mem_compressed_vertex() {
+		this->id = 0;
+		this->edge_data_size = 0;
+		this->num_edges = 0;
+		this->neigh_bytes = 0;
+	}
+
+	size_t get_edge_data_offset() const {
+		if (has_edge_data())
+			return ROUNDUP(get_header_size() + neigh_bytes, edge_data_size);
+		else
+			return get_header_size() + neigh_bytes;
+	}
+
+	size_t get_size() const {
+		return ROUNDUP(get_edge_data_offset() + num_edges * edge_data_size,
+				sizeof(vertex_id_t));
+	}
+
+	size_t get_neigh_bytes() const {
+		return neigh_bytes;
+	}
+
+	bool has_edge_data() const {
+		return edge_data_size > 0;
+	}
+
+	size_t get_edge_data_size() const {
+		return edge_data_size;
+	}
+
+	size_t get_num_edges() const {
+		return num_edges;
+	}
+
+	vertex_id_t get_id() const {
+		return id;
+	}
+};
+
+/*
+ * This byte array holds a vertex decompressed from ext_mem_compressed_vertex
+ * in the format of ext_mem_undirected_vertex, so page vertices can be
+ * constructed on it as if the vertex were read from an uncompressed graph.
+ */
+class decompressed_byte_array: public page_byte_array
+{
+	embedded_array<char, PAGE_SIZE> buf;
+	size_t size;
+	size_t compressed_size;
+	off_t off;
+public:
+	decompressed_byte_array() {
+		size = 0;
+		compressed_size = 0;
+		off = 0;
+	}
+
+	decompressed_byte_array(byte_array_allocator &alloc): page_byte_array(
+			alloc) {
+		size = 0;
+		compressed_size = 0;
+		off = 0;
+	}
+
+	/*
+	 * Decompress the vertex at the beginning of the byte array.
+	 */
+	void init(const page_byte_array &arr);
+
+	/*
+	 * The size of the compressed vertex in the original byte array.
+	 */
+	size_t get_compressed_size() const {
+		return compressed_size;
+	}
+
+	virtual void lock() {
+	}
+
+	virtual void unlock() {
+	}
+
+	virtual off_t get_offset() const {
+		return off;
+	}
+
+	virtual size_t get_size() const {
+		return size;
+	}
+
+	/*
+	 * The clone is allocated on the heap and is freed with
+	 * page_byte_array::destroy().
+	 */
+	virtual page_byte_array *clone();
+
+	virtual off_t get_offset_in_first_page() const {
+		return 0;
+	}
+
+	virtual const char *get_page(int idx) const {
+		return buf.data() + idx * PAGE_SIZE;
+	}
+
+	virtual const char *get_contiguous_data() const {
+		return buf.data();
+	}
+};
+
 /**
  * \brief Vertex representation when in the page cache.
  */
@@ -20,6 +20,35 @@
 #include "graph_engine.h"
 #include "worker_thread.h"
 #include "vertex_index_reader.h"
+#include "ts_index.h"
+
+/*
+ * The adjacency lists of a compressed graph are decompressed before we
+ * construct page vertices on them, so vertex programs always see vertices
+ * in the original format.
+ */
+static inline const page_byte_array &get_vertex_array(const graph_engine &graph,
+		const page_byte_array &arr, decompressed_byte_array &buf)
+{
+	if (graph.get_graph_header().is_edge_list_compressed()) {
+		buf.init(arr);
+		return buf;
+	}
+	else
+		return arr;
+}
+
+/*
+ * The size of a vertex in the byte array read from the disk.
+ */
+static inline size_t get_stored_size(const page_byte_array &vertex_arr,
+		const decompressed_byte_array &buf, size_t vertex_size)
+{
+	if (&vertex_arr == &buf)
+		return buf.get_compressed_size();
+	else
+		return vertex_size;
+}
 
 request_range vertex_compute::get_next_request()
 {
@@ -66,7 +95,8 @@ void vertex_compute::request_num_edges(vertex_id_t ids[], size_t num)
 void vertex_compute::run_on_vertex_size(vertex_id_t id, vsize_t size)
 {
 	start_run();
-	vsize_t num_edges = issue_thread->get_graph().cal_num_edges(size);
+	vsize_t num_edges = issue_thread->get_graph().cal_num_edges(id,
+			edge_type::IN_EDGE, size);
 	vertex_header header(id, num_edges);
 	issue_thread->get_vertex_program(v.is_part()).run_on_num_edges(*v, header);
 	num_edge_completed++;
@@ -94,25 +124,66 @@ void vertex_compute::run(page_byte_array &array)
 {
 	num_complete_fetched++;
 	start_run();
-	page_undirected_vertex pg_v(array);
+	decompressed_byte_array buf;
+	page_undirected_vertex pg_v(get_vertex_array(*graph, array, buf));
 	issue_thread->get_vertex_program(v.is_part()).run(*v, pg_v);
 	finish_run();
 }
 
-void directed_vertex_compute::run_on_page_vertex(page_directed_vertex &pg_v)
+void directed_vertex_compute::run_on_page_vertex(page_vertex &pg_v)
 {
 	start_run();
 	issue_thread->get_vertex_program(v.is_part()).run(*v, pg_v);
 	finish_run();
 }
 
+void directed_vertex_compute::run_on_ts_range(page_byte_array &array,
+		const ts_range_info &info)
+{
+	if (!info.combine) {
+		page_ts_range_vertex pg_v(info.id);
+		pg_v.set_part(info.type, array, info.edge_start);
+		run_on_page_vertex(pg_v);
+		return;
+	}
+
+	ts_combine_map_t::iterator it = ts_combine_map.find(info.id);
+	if (it == ts_combine_map.end()) {
+		page_byte_array *arr_copy = array.clone();
+		assert(arr_copy);
+		ts_combine_map.insert(ts_combine_map_t::value_type(info.id,
+					std::pair<page_byte_array *, ts_range_info>(arr_copy, info)));
+	}
+	else {
+		const ts_range_info &other = it->second.second;
+		assert(other.type != info.type);
+		page_ts_range_vertex pg_v(info.id);
+		pg_v.set_part(other.type, *it->second.first, other.edge_start);
+		pg_v.set_part(info.type, array, info.edge_start);
+		run_on_page_vertex(pg_v);
+		page_byte_array::destroy(it->second.first);
+		ts_combine_map.erase(it);
+	}
+}
+
 void directed_vertex_compute::run(page_byte_array &array)
 {
 	num_complete_fetched++;
+	if (!ts_ranges.empty()) {
+		ts_range_map_t::iterator it = ts_ranges.find(array.get_offset());
+		if (it != ts_ranges.end()) {
+			ts_range_info info = it->second;
+			ts_ranges.erase(it);
+			run_on_ts_range(array, info);
+			return;
+		}
+	}
+
 	// If the combine map is empty, we don't need to merge
 	// byte arrays.
 	if (combine_map.empty()) {
-		page_directed_vertex pg_v(array,
+		decompressed_byte_array buf;
+		page_directed_vertex pg_v(get_vertex_array(*graph, array, buf),
 				(size_t) array.get_offset() < graph->get_in_part_size());
 		run_on_page_vertex(pg_v);
 		return;
@@ -123,7 +194,8 @@ void directed_vertex_compute::run(page_byte_array &array)
 	// If the vertex isn't in the combine map, we don't need to
 	// merge byte arrays.
 	if (it == combine_map.end()) {
-		page_directed_vertex pg_v(array,
+		decompressed_byte_array buf;
+		page_directed_vertex pg_v(get_vertex_array(*graph, array, buf),
 				(size_t) array.get_offset() < graph->get_in_part_size());
 		run_on_page_vertex(pg_v);
 		return;
@@ -146,7 +218,10 @@ void directed_vertex_compute::run(page_byte_array &array)
 			in_arr = &array;
 			assert((size_t) array.get_offset() < get_graph().get_in_part_size());
 		}
-		page_directed_vertex pg_v(*in_arr, *out_arr);
+		decompressed_byte_array in_buf;
+		decompressed_byte_array out_buf;
+		page_directed_vertex pg_v(get_vertex_array(*graph, *in_arr, in_buf),
+				get_vertex_array(*graph, *out_arr, out_buf));
 		run_on_page_vertex(pg_v);
 		page_byte_array::destroy(it->second);
 		combine_map.erase(it);
@@ -173,12 +248,56 @@ void directed_vertex_compute::request_partial_vertices(
 	issue_thread->get_index_reader().request_vertices(reqs, num, *this);
 }
 
+void directed_vertex_compute::issue_ts_range(vertex_id_t id, edge_type type,
+		const ts_edge_range &range, bool combine)
+{
+	off_t off = range.get_neigh_off();
+	BOOST_VERIFY(ts_ranges.insert(ts_range_map_t::value_type(off,
+					ts_range_info(id, type, range.get_start(), combine))).second);
+	num_requested++;
+	issue_io_request(ext_mem_vertex_info(id, off,
+				range.get_num_edges() * sizeof(vertex_id_t)));
+}
+
+size_t directed_vertex_compute::request_ts_vertices(ts_range_request reqs[],
+		size_t num)
+{
+	ts_vertex_index::ptr index = graph->get_ts_index();
+	assert(index);
+	size_t num_vertices = 0;
+	for (size_t i = 0; i < num; i++) {
+		vertex_id_t id = reqs[i].get_id();
+		edge_type type = reqs[i].get_type();
+		time_t start = reqs[i].get_time_start();
+		time_t interval = reqs[i].get_time_interval();
+		assert(index->is_aligned(start, interval));
+
+		ts_edge_range in_range;
+		ts_edge_range out_range;
+		if (type == IN_EDGE || type == BOTH_EDGES)
+			in_range = index->get_edge_range(id, IN_EDGE, start, interval);
+		if (type == OUT_EDGE || type == BOTH_EDGES)
+			out_range = index->get_edge_range(id, OUT_EDGE, start, interval);
+		bool has_in = in_range.get_num_edges() > 0;
+		bool has_out = out_range.get_num_edges() > 0;
+		if (has_in)
+			issue_ts_range(id, IN_EDGE, in_range, has_out);
+		if (has_out)
+			issue_ts_range(id, OUT_EDGE, out_range, has_in);
+		if (has_in || has_out)
+			num_vertices++;
+	}
+	return num_vertices;
+}
+
 void directed_vertex_compute::run_on_vertex_size(vertex_id_t id,
 		size_t in_size, size_t out_size)
 {
 	start_run();
-	vsize_t num_in_edges = issue_thread->get_graph().cal_num_edges(in_size);
-	vsize_t num_out_edges = issue_thread->get_graph().cal_num_edges(out_size);
+	vsize_t num_in_edges = issue_thread->get_graph().cal_num_edges(id,
+			edge_type::IN_EDGE, in_size);
+	vsize_t num_out_edges = issue_thread->get_graph().cal_num_edges(id,
+			edge_type::OUT_EDGE, out_size);
 	directed_vertex_header header(id, num_in_edges, num_out_edges);
 	issue_thread->get_vertex_program(v.is_part()).run_on_num_edges(*v, header);
 	num_edge_completed++;
@@ -234,6 +353,25 @@ void merged_vertex_compute::finish_run(compute_vertex_pointer v)
 		issue_thread->complete_vertex(v);
 }
 
+/*
+ * Get the part of the adjacency list that the vertex should run on.
+ * In the streaming mode, it returns NONE if the vertex didn't ask for
+ * its adjacency list in this iteration.
+ */
+edge_type merged_vertex_compute::get_run_type(vertex_id_t id, edge_type type)
+{
+	if (stream)
+		return issue_thread->take_stream_vertex(id);
+	else
+		return type;
+}
+
+void merged_vertex_compute::complete_stream()
+{
+	if (stream)
+		issue_thread->complete_stream_chunk();
+}
+
 void merged_undirected_vertex_compute::run(page_byte_array &array)
 {
 	off_t off = 0;
@@ -243,16 +381,22 @@ void merged_undirected_vertex_compute::run(page_byte_array &array)
 	vertex_program &curr_vprog = t->get_vertex_program(false);
 	for (int i = 0; i < get_num_vertices(); i++, id++) {
 		sub_page_byte_array sub_arr(array, off);
-		page_undirected_vertex pg_v(sub_arr);
+		decompressed_byte_array buf;
+		const page_byte_array &vertex_arr = get_vertex_array(get_graph(),
+				sub_arr, buf);
+		page_undirected_vertex pg_v(vertex_arr);
 		assert(pg_v.get_id() == id);
-		compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
-		start_run(v);
-		curr_vprog.run(*v, pg_v);
-		finish_run(v);
-		off += pg_v.get_size();
+		if (get_run_type(id, IN_EDGE) != edge_type::NONE) {
+			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
+			start_run(v);
+			curr_vprog.run(*v, pg_v);
+			finish_run(v);
+		}
+		off += get_stored_size(vertex_arr, buf, pg_v.get_size());
 	}
 
 	complete = true;
+	complete_stream();
 }
 
 void merged_directed_vertex_compute::run_on_array(page_byte_array &array)
@@ -265,16 +409,23 @@ void merged_directed_vertex_compute::run_on_array(page_byte_array &array)
 	bool in_part = (size_t) array.get_offset() < get_graph().get_in_part_size();
 	for (int i = 0; i < get_num_vertices(); i++, id++) {
 		sub_page_byte_array sub_arr(array, off);
-		page_directed_vertex pg_v(sub_arr, in_part);
+		decompressed_byte_array buf;
+		const page_byte_array &vertex_arr = get_vertex_array(get_graph(),
+				sub_arr, buf);
+		page_directed_vertex pg_v(vertex_arr, in_part);
 		assert(pg_v.get_id() == id);
-		compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
-		start_run(v);
-		curr_vprog.run(*v, pg_v);
-		finish_run(v);
+		edge_type run_type = get_run_type(id, type);
+		if (run_type != edge_type::NONE) {
+			assert(run_type == type);
+			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
+			start_run(v);
+			curr_vprog.run(*v, pg_v);
+			finish_run(v);
+		}
 		if (in_part)
-			off += pg_v.get_in_size();
+			off += get_stored_size(vertex_arr, buf, pg_v.get_in_size());
 		else
-			off += pg_v.get_out_size();
+			off += get_stored_size(vertex_arr, buf, pg_v.get_out_size());
 	}
 }
 
@@ -290,14 +441,36 @@ void merged_directed_vertex_compute::run_on_arrays(page_byte_array &in_arr,
 	for (int i = 0; i < get_num_vertices(); i++, id++) {
 		sub_page_byte_array sub_in_arr(in_arr, in_off);
 		sub_page_byte_array sub_out_arr(out_arr, out_off);
-		page_directed_vertex pg_v(sub_in_arr, sub_out_arr);
+		decompressed_byte_array in_buf;
+		decompressed_byte_array out_buf;
+		const page_byte_array &in_vertex_arr = get_vertex_array(get_graph(),
+				sub_in_arr, in_buf);
+		const page_byte_array &out_vertex_arr = get_vertex_array(get_graph(),
+				sub_out_arr, out_buf);
+		page_directed_vertex pg_v(in_vertex_arr, out_vertex_arr);
 		assert(pg_v.get_id() == id);
-		compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
-		start_run(v);
-		curr_vprog.run(*v, pg_v);
-		finish_run(v);
-		in_off += pg_v.get_in_size();
-		out_off += pg_v.get_out_size();
+		// In the streaming mode, we read both parts for a range of
+		// vertices, but a vertex may only ask for one of them. A vertex
+		// that asks for the in-edges and the out-edges separately gets
+		// the other part in a separate run.
+		edge_type run_type = get_run_type(id, BOTH_EDGES);
+		if (run_type == BOTH_EDGES) {
+			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
+			start_run(v);
+			curr_vprog.run(*v, pg_v);
+			finish_run(v);
+		}
+		else if (run_type != edge_type::NONE) {
+			page_directed_vertex part_v(run_type == IN_EDGE ? in_vertex_arr
+					: out_vertex_arr, run_type == IN_EDGE);
+			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
+			start_run(v);
+			curr_vprog.run(*v, part_v);
+			finish_run(v);
+		}
+		in_off += get_stored_size(in_vertex_arr, in_buf, pg_v.get_in_size());
+		out_off += get_stored_size(out_vertex_arr, out_buf,
+				pg_v.get_out_size());
 	}
 }
 
@@ -322,6 +495,7 @@ void merged_directed_vertex_compute::run(page_byte_array &arr)
 
 		run_on_arrays(*in_arr, *out_arr);
 		page_byte_array::destroy(buffered_arr);
+		complete_stream();
 	}
 	else if (type == BOTH_EDGES) {
 		buffered_arr = arr.clone();
@@ -329,10 +503,12 @@ void merged_directed_vertex_compute::run(page_byte_array &arr)
 	else if (type == IN_EDGE) {
 		assert((size_t) arr.get_offset() < get_graph().get_in_part_size());
 		run_on_array(arr);
+		complete_stream();
 	}
 	else if (type == OUT_EDGE) {
 		assert((size_t) arr.get_offset() >= get_graph().get_in_part_size());
 		run_on_array(arr);
+		complete_stream();
 	}
 	else
 		ABORT_MSG("wrong type");
@@ -368,13 +544,16 @@ void sparse_undirected_vertex_compute::run(page_byte_array &arr)
 		off_t off = this->ranges[i].start_off - arr.get_offset();
 		for (int j = 0; j < num_vertices; j++, id++) {
 			sub_page_byte_array sub_arr(arr, off);
-			page_undirected_vertex pg_v(sub_arr);
+			decompressed_byte_array buf;
+			const page_byte_array &vertex_arr = get_vertex_array(get_graph(),
+					sub_arr, buf);
+			page_undirected_vertex pg_v(vertex_arr);
 			assert(pg_v.get_id() == id);
 			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
 			start_run(v);
 			curr_vprog.run(*v, pg_v);
 			finish_run(v);
-			off += pg_v.get_size();
+			off += get_stored_size(vertex_arr, buf, pg_v.get_size());
 		}
 	}
 	complete = true;
@@ -393,16 +572,19 @@ void sparse_directed_vertex_compute::run_on_array(page_byte_array &arr)
 		bool in_part = (size_t) arr.get_offset() < get_graph().get_in_part_size();
 		for (int j = 0; j < num_vertices; j++, id++) {
 			sub_page_byte_array sub_arr(arr, off);
-			page_directed_vertex pg_v(sub_arr, in_part);
+			decompressed_byte_array buf;
+			const page_byte_array &vertex_arr = get_vertex_array(get_graph(),
+					sub_arr, buf);
+			page_directed_vertex pg_v(vertex_arr, in_part);
 			assert(pg_v.get_id() == id);
 			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
 			start_run(v);
 			curr_vprog.run(*v, pg_v);
 			finish_run(v);
 			if (in_part)
-				off += pg_v.get_in_size();
+				off += get_stored_size(vertex_arr, buf, pg_v.get_in_size());
 			else
-				off += pg_v.get_out_size();
+				off += get_stored_size(vertex_arr, buf, pg_v.get_out_size());
 		}
 	}
 	complete = true;
@@ -428,14 +610,22 @@ void sparse_directed_vertex_compute::run_on_arrays(page_byte_array &in_arr,
 		for (int i = 0; i < num_vertices; i++, id++) {
 			sub_page_byte_array sub_in_arr(in_arr, in_off);
 			sub_page_byte_array sub_out_arr(out_arr, out_off);
-			page_directed_vertex pg_v(sub_in_arr, sub_out_arr);
+			decompressed_byte_array in_buf;
+			decompressed_byte_array out_buf;
+			const page_byte_array &in_vertex_arr = get_vertex_array(
+					get_graph(), sub_in_arr, in_buf);
+			const page_byte_array &out_vertex_arr = get_vertex_array(
+					get_graph(), sub_out_arr, out_buf);
+			page_directed_vertex pg_v(in_vertex_arr, out_vertex_arr);
 			assert(pg_v.get_id() == id);
 			compute_vertex_pointer v(&get_graph().get_vertex(pg_v.get_id()));
 			start_run(v);
 			curr_vprog.run(*v, pg_v);
 			finish_run(v);
-			in_off += pg_v.get_in_size();
-			out_off += pg_v.get_out_size();
+			in_off += get_stored_size(in_vertex_arr, in_buf,
+					pg_v.get_in_size());
+			out_off += get_stored_size(out_vertex_arr, out_buf,
+					pg_v.get_out_size());
 		}
 	}
 	complete = true;
@@ -35,6 +35,7 @@ class worker_thread;
 class graph_engine;
 class compute_vertex;
 class compute_directed_vertex;
+class ts_edge_range;
 
 /**
  * This data structure represents an active vertex that is being processed
@@ -210,7 +211,41 @@ class directed_vertex_compute: public vertex_compute
 	typedef std::unordered_map<vertex_id_t, page_byte_array *> combine_map_t;
 	combine_map_t combine_map;
 
-	void run_on_page_vertex(page_directed_vertex &);
+	/*
+	 * A range of edges of a vertex part requested with the timestamp index.
+	 */
+	struct ts_range_info
+	{
+		vertex_id_t id;
+		edge_type type;
+		// The location of the first edge in the edge list of the part.
+		size_t edge_start;
+		// Whether the range has to be combined with the range in
+		// the other part.
+		bool combine;
+
+		ts_range_info(vertex_id_t id, edge_type type, size_t edge_start,
+				bool combine) {
+			this->id = id;
+			this->type = type;
+			this->edge_start = edge_start;
+			this->combine = combine;
+		}
+	};
+	// The ranges being read, indexed by their locations in the graph file.
+	// A range never starts at the beginning of a vertex, so we can tell
+	// them from the vertices being read.
+	typedef std::unordered_map<off_t, ts_range_info> ts_range_map_t;
+	ts_range_map_t ts_ranges;
+	// The ranges that wait for the range in the other part.
+	typedef std::unordered_map<vertex_id_t,
+			std::pair<page_byte_array *, ts_range_info> > ts_combine_map_t;
+	ts_combine_map_t ts_combine_map;
+
+	void run_on_page_vertex(page_vertex &);
+	void run_on_ts_range(page_byte_array &, const ts_range_info &);
+	void issue_ts_range(vertex_id_t id, edge_type type,
+			const ts_edge_range &range, bool combine);
 public:
 	directed_vertex_compute(graph_engine *graph,
 			compute_allocator *alloc): vertex_compute(graph, alloc) {
@@ -233,6 +268,14 @@ public:
 	virtual void request_vertices(vertex_id_t ids[], size_t num);
 	void request_partial_vertices(directed_vertex_request reqs[], size_t num);
 
+	/*
+	 * This requests the edges of vertices in time intervals. The location
+	 * of the edges comes from the timestamp index, so the requests are
+	 * issued to SAFS directly. It returns the number of vertices that have
+	 * edges in the time intervals.
+	 */
+	size_t request_ts_vertices(ts_range_request reqs[], size_t num);
+
 	/*
 	 * This is a callback function. When the vertex index gets the vertex size,
 	 * it notifies the vertex_compute of this information.
@@ -259,17 +302,24 @@ class merged_vertex_compute: public user_compute
 	vertex_id_t start_id;
 	int num_vertices;
 	graph_engine *graph;
+	// In the streaming mode, the vertices in the range don't request
+	// their adjacency lists individually. We only run on the vertices
+	// that the worker thread has recorded for streaming.
+	bool stream;
 protected:
 	worker_thread *issue_thread;
 
 	void start_run(compute_vertex_pointer v);
 	void finish_run(compute_vertex_pointer v);
+	edge_type get_run_type(vertex_id_t id, edge_type type);
+	void complete_stream();
 public:
 	merged_vertex_compute(graph_engine *graph,
 			compute_allocator *alloc): user_compute(alloc) {
 		this->graph = graph;
 		start_id = INVALID_VERTEX_ID;
 		num_vertices = 0;
+		stream = false;
 		issue_thread = (worker_thread *) thread::get_curr_thread();
 	}
 
@@ -285,9 +335,11 @@ public:
 		return num_vertices;
 	}
 
-	virtual void init(vertex_id_t start_id, int num_vertices, edge_type type) {
+	virtual void init(vertex_id_t start_id, int num_vertices, edge_type type,
+			bool stream = false) {
 		this->start_id = start_id;
 		this->num_vertices = num_vertices;
+		this->stream = stream;
 	}
 
 	virtual int serialize(char *buf, int size) const {
@@ -351,8 +403,9 @@ public:
 		buffered_arr = NULL;
 	}
 
-	void init(vertex_id_t start_id, int num_vertices, edge_type type) {
-		merged_vertex_compute::init(start_id, num_vertices, type);
+	void init(vertex_id_t start_id, int num_vertices, edge_type type,
+			bool stream = false) {
+		merged_vertex_compute::init(start_id, num_vertices, type, stream);
 		this->type = type;
 		this->num_fetched_arrs = 0;
 		switch(type) {
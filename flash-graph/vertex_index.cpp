@@ -17,6 +17,11 @@
  * limitations under the License.
  */
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+
 #include <boost/format.hpp>
 
 #include "log.h"
@@ -30,6 +35,10 @@ const size_t compressed_vertex_entry::ENTRY_SIZE;
 static void verify_index(vertex_index::ptr idx)
 {
 	idx->get_graph_header().verify();
+	// The compressed vertex index infers the number of edges from the size
+	// of a vertex, which doesn't work on compressed adjacency lists.
+	TEST(!(idx->is_compressed()
+				&& idx->get_graph_header().is_edge_list_compressed()));
 	if (idx->get_graph_header().is_directed_graph()) {
 		if (idx->is_compressed())
 			cdirected_vertex_index::cast(idx)->verify();
@@ -89,6 +98,58 @@ vertex_index::ptr vertex_index::load(const std::string &index_file)
 	return idx;
 }
 
+vertex_index::ptr vertex_index::mmap_load(const std::string &index_file,
+		bool populate, bool huge_page)
+{
+	int fd = open(index_file.c_str(), O_RDONLY);
+	if (fd < 0)
+		throw io_exception(std::string("can't open ") + index_file);
+	struct stat stats;
+	if (fstat(fd, &stats) < 0) {
+		close(fd);
+		throw io_exception(std::string("can't get the size of ") + index_file);
+	}
+	size_t size = stats.st_size;
+	if (size < sizeof(vertex_index)) {
+		close(fd);
+		throw io_exception(index_file
+				+ " is smaller than the header of a vertex index");
+	}
+
+	int flags = MAP_PRIVATE;
+	if (populate)
+		flags |= MAP_POPULATE;
+	void *addr = mmap(NULL, size, PROT_READ, flags, fd, 0);
+	// The mapping stays valid after the file is closed.
+	close(fd);
+	if (addr == MAP_FAILED)
+		throw io_exception(std::string("can't map ") + index_file + ": "
+				+ strerror(errno));
+#ifdef MADV_HUGEPAGE
+	if (huge_page && madvise(addr, size, MADV_HUGEPAGE) < 0)
+		BOOST_LOG_TRIVIAL(warning)
+			<< boost::format("can't use huge pages for %1%: %2%")
+			% index_file % strerror(errno);
+#endif
+
+	vertex_index *index = (vertex_index *) addr;
+	index->get_graph_header().verify();
+	// A truncated index would make us read beyond the end of the mapping.
+	size_t index_size = index->get_index_size();
+	if (size < index_size) {
+		munmap(addr, size);
+		throw io_exception(boost::str(boost::format(
+						"%1% is truncated: file size: %2%, index size: %3%")
+					% index_file % size % index_size));
+	}
+	vertex_index::ptr idx(index, unmap_index(size));
+	verify_index(idx);
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("map vertex index: file size: %1%, index size: %2%")
+		% size % idx->get_index_size();
+	return idx;
+}
+
 vertex_index::ptr vertex_index::safs_load(const std::string &index_file)
 {
 	const int INDEX_HEADER_SIZE = PAGE_SIZE * 2;
@@ -524,12 +585,16 @@ public:
 	}
 
 	vsize_t get_num_in_edges(vertex_id_t id) const {
+		if (index->get_graph_header().is_edge_list_compressed())
+			return index->get_num_edges_arr()[id];
 		ext_mem_vertex_info info = index->get_vertex_info_in(id);
 		return ext_mem_undirected_vertex::vsize2num_edges(info.get_size(),
 				index->get_graph_header().get_edge_data_size());
 	}
 
 	vsize_t get_num_out_edges(vertex_id_t id) const {
+		if (index->get_graph_header().is_edge_list_compressed())
+			return index->get_num_edges_arr()[index->get_num_vertices() + id];
 		ext_mem_vertex_info info = index->get_vertex_info_out(id);
 		return ext_mem_undirected_vertex::vsize2num_edges(info.get_size(),
 				index->get_graph_header().get_edge_data_size());
@@ -566,6 +631,8 @@ public:
 	}
 
 	virtual vsize_t get_num_edges(vertex_id_t id, edge_type type) const {
+		if (index->get_graph_header().is_edge_list_compressed())
+			return index->get_num_edges_arr()[id];
 		ext_mem_vertex_info info = index->get_vertex_info(id);
 		return ext_mem_undirected_vertex::vsize2num_edges(info.get_size(),
 				index->get_graph_header().get_edge_data_size());
@@ -579,6 +646,14 @@ public:
 in_mem_query_vertex_index::ptr in_mem_query_vertex_index::create(
 		vertex_index::ptr index, bool compress)
 {
+	// The number of edges of vertices in a graph with compressed adjacency
+	// lists is stored in the original index, so we query on it directly.
+	if (index->get_graph_header().is_edge_list_compressed())
+		compress = false;
+	// Compressing a memory-mapped index would read all of it to the heap.
+	// We query on the mapped pages instead, so they are read on demand.
+	if (vertex_index::is_mapped(index))
+		compress = false;
 	if (index->is_compressed() || compress) {
 		if (index->get_graph_header().is_directed_graph())
 			return in_mem_cdirected_vertex_index::create(*index);
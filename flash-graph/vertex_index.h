@@ -21,6 +21,7 @@
  */
 
 #include <string.h>
+#include <sys/mman.h>
 
 #include <string>
 #include <unordered_map>
@@ -70,6 +71,19 @@ protected:
 		}
 	};
 
+	class unmap_index
+	{
+		size_t size;
+	public:
+		unmap_index(size_t size) {
+			this->size = size;
+		}
+
+		void operator()(vertex_index *index) {
+			munmap(index, size);
+		}
+	};
+
 public:
 	typedef std::shared_ptr<vertex_index> ptr;
 
@@ -81,6 +95,21 @@ public:
 	 * Load the vertex index from the Linux filesystem.
 	 */
 	static vertex_index::ptr load(const std::string &index_file);
+	/*
+	 * Map the vertex index in the Linux filesystem to memory.
+	 * The index is read-only and shares the pages in the Linux page cache
+	 * with other processes that use the same index file.
+	 * `populate' prefaults the whole index with MAP_POPULATE, and
+	 * `huge_page' asks the kernel to back the index with huge pages.
+	 */
+	static vertex_index::ptr mmap_load(const std::string &index_file,
+			bool populate, bool huge_page);
+	/*
+	 * Test if the vertex index is mapped to memory by mmap_load.
+	 */
+	static bool is_mapped(vertex_index::ptr index) {
+		return std::get_deleter<unmap_index>(index) != NULL;
+	}
 
 	static size_t get_header_size() {
 		return sizeof(vertex_index);
@@ -156,13 +185,18 @@ public:
 			= new (buf) vertex_index_temp<vertex_entry_type>(header);
 		index->h.data.num_entries = vertices.size();
 		assert(header.get_num_vertices() + 1 == vertices.size());
+		assert(!header.is_edge_list_compressed());
 		memcpy(buf + vertex_index::get_header_size(), vertices.data(),
 				vertices.size() * sizeof(vertices[0]));
 		return vertex_index::ptr(index);
 	}
 
+	/*
+	 * `num_edges' is only used by a graph with compressed adjacency lists.
+	 */
 	static void dump(const std::string &file, const graph_header &header,
-			const std::vector<vertex_entry_type> &vertices) {
+			const std::vector<vertex_entry_type> &vertices,
+			const std::vector<vsize_t> &num_edges = std::vector<vsize_t>()) {
 		vertex_index_temp<vertex_entry_type> index(header);
 		index.h.data.num_entries = vertices.size();
 		assert(header.get_num_vertices() + 1 == vertices.size());
@@ -174,6 +208,7 @@ public:
 		BOOST_VERIFY(fwrite(&index, vertex_index::get_header_size(), 1, f));
 		BOOST_VERIFY(fwrite(vertices.data(),
 					vertices.size() * sizeof(vertices[0]), 1, f));
+		index.dump_num_edges(f, num_edges);
 
 		fclose(f);
 	}
@@ -191,9 +226,38 @@ public:
 		return vertices;
 	}
 
+	/*
+	 * The number of edges of a vertex can't be inferred from the size of
+	 * the vertex if its adjacency list is compressed, so the index of such
+	 * a graph stores the number of edges of each vertex behind the vertex
+	 * entries. For a directed graph, the number of in-edges of all vertices
+	 * is followed by the number of out-edges.
+	 */
+	size_t get_num_edges_arr_len() const {
+		if (!get_graph_header().is_edge_list_compressed())
+			return 0;
+		else if (get_graph_header().is_directed_graph())
+			return get_num_vertices() * 2;
+		else
+			return get_num_vertices();
+	}
+
+	const vsize_t *get_num_edges_arr() const {
+		assert(get_graph_header().is_edge_list_compressed());
+		return (const vsize_t *) (vertices + h.data.num_entries);
+	}
+
+	void dump_num_edges(FILE *f, const std::vector<vsize_t> &num_edges) const {
+		assert(num_edges.size() == get_num_edges_arr_len());
+		if (!num_edges.empty())
+			BOOST_VERIFY(fwrite(num_edges.data(),
+						num_edges.size() * sizeof(num_edges[0]), 1, f));
+	}
+
 	size_t cal_index_size() const {
 		return sizeof(vertex_index)
-			+ h.data.num_entries * h.data.entry_size;
+			+ h.data.num_entries * h.data.entry_size
+			+ get_num_edges_arr_len() * sizeof(vsize_t);
 	}
 
 	void verify() const {
@@ -332,13 +396,15 @@ public:
 		index->h.data.num_entries = vertices.size();
 		index->h.data.out_part_loc = vertices.front().get_out_off();
 		assert(header.get_num_vertices() + 1 == vertices.size());
+		assert(!header.is_edge_list_compressed());
 		memcpy(buf + vertex_index::get_header_size(), vertices.data(),
 				vertices.size() * sizeof(vertices[0]));
 		return vertex_index::ptr(index);
 	}
 
 	static void dump(const std::string &file, const graph_header &header,
-			const std::vector<directed_vertex_entry> &vertices) {
+			const std::vector<directed_vertex_entry> &vertices,
+			const std::vector<vsize_t> &num_edges = std::vector<vsize_t>()) {
 		directed_vertex_index index(header);
 		index.h.data.num_entries = vertices.size();
 		index.h.data.out_part_loc = vertices.front().get_out_off();
@@ -351,6 +417,7 @@ public:
 		BOOST_VERIFY(fwrite(&index, vertex_index::get_header_size(), 1, f));
 		BOOST_VERIFY(fwrite(vertices.data(),
 					vertices.size() * sizeof(vertices[0]), 1, f));
+		index.dump_num_edges(f, num_edges);
 
 		fclose(f);
 	}
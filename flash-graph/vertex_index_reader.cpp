@@ -76,6 +76,9 @@ protected:
 	ext_mem_vindex_reader_impl(io_interface::ptr io) {
 		this->io = io;
 		req_vertex_store = vertex_KV_store::create(io);
+		// All adjacency list reads wait for the index reads, so the index
+		// reads should be served before the adjacency list reads.
+		req_vertex_store->set_io_class(IO_CLASS_CRITICAL);
 	}
 public:
 	static ptr create(io_interface::ptr io) {
@@ -435,7 +438,7 @@ bool dense_self_vertex_compute::run(vertex_id_t start_vid, index_iterator &it)
 
 	merged_vertex_compute *compute
 		= (merged_vertex_compute *) thread->get_merged_compute_allocator().alloc();
-	compute->init(start_vid, get_num_vertices(), type);
+	compute->init(start_vid, get_num_vertices(), type, stream);
 	// For undirected vertices, the edge type is always IN_EDGE.
 	// For directed vertices, if the edge type is BOTH_EDGES, we issue
 	// two requests with one vertex compute.
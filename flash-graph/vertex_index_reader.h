@@ -430,6 +430,8 @@ class dense_self_vertex_compute: public index_compute
 {
 	edge_type type;
 	worker_thread *thread;
+	// Whether the range is read by the streaming mode of the worker thread.
+	bool stream;
 
 	int get_num_vertices() const {
 		return get_last_vertex() - get_first_vertex() + 1;
@@ -438,12 +440,15 @@ public:
 	dense_self_vertex_compute(index_comp_allocator &alloc): index_compute(alloc) {
 		this->thread = NULL;
 		type = IN_EDGE;
+		stream = false;
 	}
 
-	void init(const id_range_t &range, worker_thread *t, edge_type type) {
+	void init(const id_range_t &range, worker_thread *t, edge_type type,
+			bool stream = false) {
 		index_compute::init(range);
 		this->thread = t;
 		this->type = type;
+		this->stream = stream;
 	}
 
 	virtual bool run(vertex_id_t start_vid, index_iterator &it);
@@ -1182,6 +1187,18 @@ public:
 		request_vertex(self_part_reqs[req.get_type()], req.get_id());
 	}
 
+	/*
+	 * Read the adjacency lists of all vertices in the range with one
+	 * request for each part. This is used by the streaming mode of
+	 * the worker thread, so the request isn't buffered.
+	 */
+	void request_stream(const id_range_t &range, edge_type type) {
+		dense_self_vertex_compute *compute
+			= (dense_self_vertex_compute *) dense_self_req_alloc->alloc();
+		compute->init(range, t, type, true);
+		index_reader->request_index(compute);
+	}
+
 	void request_num_edges(vertex_id_t ids[], int num, vertex_compute &compute) {
 		// TODO it should only work for undirected vertices.
 		ABORT_MSG("request_num_edges isn't supported currently");
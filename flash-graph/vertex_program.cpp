@@ -89,6 +89,7 @@ void vertex_program::multicast_msg(vertex_id_t ids[], int num,
 		sender.init(msg);
 		BOOST_VERIFY((size_t) sender.add_dests(vid_bufs[i].data(),
 					vid_bufs[i].size()) == vid_bufs[i].size());
+		num_sent_msgs += vid_bufs[i].size();
 		vid_bufs[i].clear();
 		sender.end_multicast();
 	}
@@ -120,6 +121,7 @@ void vertex_program::multicast_msg(edge_seq_iterator &it, vertex_message &msg)
 		sender.init(msg);
 		BOOST_VERIFY((size_t) sender.add_dests(vid_bufs[i].data(),
 					vid_bufs[i].size()) == vid_bufs[i].size());
+		num_sent_msgs += vid_bufs[i].size();
 		vid_bufs[i].clear();
 		sender.end_multicast();
 	}
@@ -143,12 +145,17 @@ void vertex_program::send_msg(vertex_id_t dest, vertex_message &msg)
 		get_msg_sender(part_id).flush();
 
 		simple_msg_sender &sender = get_flush_msg_sender(part_id);
-		sender.send_cached(msg);
+		num_sent_msgs += sender.send_cached(msg);
 		sender.flush();
 	}
 	else {
 		simple_msg_sender &sender = get_msg_sender(part_id);
-		sender.send_cached(msg);
+		// Combined messages aren't counted, so the sent messages match
+		// the ones the receivers process.
+		if (combiner)
+			num_sent_msgs += sender.send_combined(msg, *combiner);
+		else
+			num_sent_msgs += sender.send_cached(msg);
 	}
 }
 
@@ -33,6 +33,32 @@ class page_vertex;
 class vertex_message;
 class worker_thread;
 
+/**
+ * \brief A user-defined operation that merges the messages sent to the same
+ *        vertex before they are delivered, e.g., summing up PageRank deltas
+ *        or taking the minimal component Id. It reduces the memory used by
+ *        messages and the number of messages the destination vertex needs
+ *        to process.
+ */
+class message_combiner
+{
+public:
+	typedef std::shared_ptr<message_combiner> ptr; /** Pointer defining object access. */
+
+	virtual ~message_combiner() {
+	}
+
+	/**
+	 * \brief Merge a message into another message sent to the same vertex.
+	 *        The two messages have the same size.
+	 *  \param combined The message buffered for the vertex. It keeps the result.
+	 *  \param msg The message to merge. It may be a multicast message, so
+	 *         only the fields of the user's message should be accessed.
+	 */
+	virtual void combine(vertex_message &combined,
+			const vertex_message &msg) const = 0;
+};
+
 /**
  *  This class allows users to customize the default `vertex_program`.
  *  For instance extending this class can allow a user to easily create
@@ -47,6 +73,8 @@ class vertex_program
 	std::unique_ptr<std::vector<local_vid_t>[]> vid_bufs;
 	std::unique_ptr<vertex_loc_t[]> vertex_locs;
 	size_t vloc_size;
+	// The number of vertex messages sent by this vertex program.
+	size_t num_sent_msgs;
 
 	// The message senders to send messages to all other threads.
 	// There are n senders, n is the total number of threads used by
@@ -55,6 +83,7 @@ class vertex_program
 	std::vector<simple_msg_sender *> flush_msg_senders;
 	std::vector<multicast_msg_sender *> multicast_senders;
 	std::vector<multicast_msg_sender *> activate_senders;
+	message_combiner::ptr combiner;
     
 	multicast_msg_sender &get_activate_sender(int thread_id) const {
 		return *activate_senders[thread_id];
@@ -86,8 +115,31 @@ public:
 	void init(graph_engine *graph, worker_thread *t) {
 		this->t = t;
 		this->graph = graph;
+		this->num_sent_msgs = 0;
+	}
+
+	/* Internal */
+	size_t get_num_sent_msgs() const {
+		return num_sent_msgs;
 	}
     
+	/**
+	 * \brief Set the combiner that merges the messages sent to the same
+	 *        vertex. The point-to-point messages sent by this vertex
+	 *        program are combined in the send buffers. The thread that
+	 *        receives messages combines all messages, including
+	 *        multicast messages, by their destinations before it delivers
+	 *        them, so a vertex gets one message for the messages combined.
+	 *  \param combiner The combiner. NULL disables combining.
+	 */
+	void set_msg_combiner(message_combiner::ptr combiner) {
+		this->combiner = combiner;
+	}
+
+	const message_combiner::ptr &get_msg_combiner() const {
+		return combiner;
+	}
+
     /* Internal */
 	void init_messaging(const std::vector<worker_thread *> &threads,
 			std::shared_ptr<slab_allocator> msg_alloc,
@@ -69,6 +69,35 @@ public:
 	}
 };
 
+/**
+ * This requests the edges of a directed vertex whose timestamps are
+ * in [time_start, time_start + time_interval).
+ */
+class ts_range_request: public directed_vertex_request
+{
+	time_t time_start;
+	time_t time_interval;
+public:
+	ts_range_request() {
+		time_start = 0;
+		time_interval = 0;
+	}
+
+	ts_range_request(vertex_id_t id, edge_type type, time_t time_start,
+			time_t time_interval): directed_vertex_request(id, type) {
+		this->time_start = time_start;
+		this->time_interval = time_interval;
+	}
+
+	time_t get_time_start() const {
+		return time_start;
+	}
+
+	time_t get_time_interval() const {
+		return time_interval;
+	}
+};
+
 /**
  * This class contains the request of a time-series vertex
  * from the user application.
@@ -342,6 +342,11 @@ worker_thread::worker_thread(graph_engine *graph,
 	this->vpart_vprogram = std::move(vpart_prog);
 	vpart_vprogram->init(graph, this);
 	start_all = false;
+	stream_level = false;
+	stream_collecting = false;
+	stream_loc = 0;
+	num_stream_vertices = 0;
+	num_stream_chunks = 0;
 	this->worker_id = worker_id;
 	this->graph = graph;
 	this->io = NULL;
@@ -400,6 +405,8 @@ void worker_thread::init()
 			new active_vertex_set(num_local_vertices, get_node_id()));
 	notify_vertices = std::unique_ptr<bitmap>(new bitmap(num_local_vertices,
 				get_node_id()));
+	if (graph_conf.use_stream_all())
+		stream_types.resize(num_local_vertices, edge_type::NONE);
 	if (scheduler)
 		curr_activated_vertices = std::unique_ptr<active_vertex_queue>(
 				// TODO can we only use the default vertex program?
@@ -493,9 +500,12 @@ int worker_thread::process_activated_vertices(int max)
 		return 0;
 
 	process_vertex_buf.resize(max);
-	int num = curr_activated_vertices->fetch(process_vertex_buf.data(), max);
+	int num = balancer->fetch_activated_vertices(process_vertex_buf.data(), max);
 	if (num == 0) {
 		assert(curr_activated_vertices->is_empty());
+		// All vertices in the partition have run, so we know the adjacency
+		// lists that need to be streamed.
+		stream_collecting = false;
 		num = balancer->steal_activated_vertices(process_vertex_buf.data(),
 				max);
 	}
@@ -520,7 +530,119 @@ int worker_thread::process_activated_vertices(int max)
 	return num;
 }
 
-size_t worker_thread::enter_next_level()
+static inline edge_type merge_edge_types(edge_type t1, edge_type t2)
+{
+	if (t1 == edge_type::NONE || t1 == t2)
+		return t2;
+	else if (t2 == edge_type::NONE)
+		return t1;
+	else
+		return edge_type::BOTH_EDGES;
+}
+
+/*
+ * We stream the adjacency lists in an iteration if all vertices in
+ * the partition are active. The vertices are still scheduled as usual,
+ * but their requests to their own adjacency lists are recorded
+ * in stream_vertex().
+ */
+void worker_thread::start_stream()
+{
+	assert(num_stream_vertices == 0);
+	assert(num_stream_chunks == 0);
+	stream_level = graph_conf.use_stream_all() && scheduler == NULL
+		// The vertically partitioned vertices request their adjacency
+		// lists in a different way.
+		&& index.get_num_vpart_vertices(worker_id) == 0
+		&& get_num_local_vertices() > 0
+		&& curr_activated_vertices->get_num_vertices()
+		== get_num_local_vertices();
+	stream_collecting = stream_level;
+	stream_loc = 0;
+}
+
+bool worker_thread::stream_vertex(vertex_id_t id, edge_type type)
+{
+	if (!stream_collecting)
+		return false;
+
+	int part_id;
+	off_t off;
+	graph->get_partitioner()->map2loc(id, part_id, off);
+	// The vertex stolen from another thread requests its adjacency list
+	// as usual.
+	if (part_id != worker_id)
+		return false;
+	// A vertex runs once for each part of the adjacency list it requests.
+	// Only one request of a vertex is recorded for streaming, so
+	// the other parts are requested as usual.
+	if (stream_types[off] != edge_type::NONE)
+		return false;
+	num_stream_vertices++;
+	stream_types[off] = type;
+	return true;
+}
+
+edge_type worker_thread::take_stream_vertex(vertex_id_t id)
+{
+	int part_id;
+	off_t off;
+	graph->get_partitioner()->map2loc(id, part_id, off);
+	assert(part_id == worker_id);
+	edge_type type = (edge_type) stream_types[off];
+	if (type != edge_type::NONE) {
+		stream_types[off] = edge_type::NONE;
+		num_stream_vertices--;
+	}
+	return type;
+}
+
+/*
+ * Read the adjacency lists recorded for streaming. A chunk covers
+ * the vertices with contiguous IDs, so it's a single read for each part
+ * of the adjacency lists. The vertices in the chunk that don't ask for
+ * their adjacency lists are skipped when the data is ready.
+ */
+void worker_thread::issue_stream_chunks()
+{
+	const size_t range_size = 1UL << graph_conf.get_part_range_size_log();
+	while (stream_loc < stream_types.size()
+			&& num_stream_chunks < MAX_STREAM_CHUNKS) {
+		while (stream_loc < stream_types.size()
+				&& stream_types[stream_loc] == edge_type::NONE)
+			stream_loc++;
+		if (stream_loc == stream_types.size())
+			break;
+
+		size_t first_loc = stream_loc;
+		vertex_id_t first_id;
+		graph->get_partitioner()->loc2map(worker_id, first_loc, first_id);
+		size_t end_loc = min(first_loc + MAX_STREAM_CHUNK_SIZE,
+				stream_types.size());
+		size_t last_loc = first_loc;
+		edge_type type = edge_type::NONE;
+		for (; stream_loc < end_loc; stream_loc++) {
+			// The next range of the partition is usually not adjacent to
+			// this range in the adjacency list file.
+			if (stream_loc % range_size == 0 && stream_loc > first_loc) {
+				vertex_id_t id;
+				graph->get_partitioner()->loc2map(worker_id, stream_loc, id);
+				if (id != first_id + (stream_loc - first_loc))
+					break;
+			}
+			if (stream_types[stream_loc] != edge_type::NONE) {
+				type = merge_edge_types(type,
+						(edge_type) stream_types[stream_loc]);
+				last_loc = stream_loc;
+			}
+		}
+		index_reader->request_stream(id_range_t(first_id,
+					first_id + last_loc - first_loc + 1), type);
+		num_stream_chunks++;
+	}
+}
+
+void worker_thread::complete_level()
 {
 	// We have to make sure all messages sent by other threads are processed.
 	msg_processor->process_msgs();
@@ -541,7 +663,10 @@ size_t worker_thread::enter_next_level()
 			}
 		}
 	}
+}
 
+size_t worker_thread::enter_next_level()
+{
 	curr_activated_vertices->init(*this);
 	assert(next_activated_vertices->get_num_active_vertices() == 0);
 	balancer->reset();
@@ -549,27 +674,65 @@ size_t worker_thread::enter_next_level()
 	return curr_activated_vertices->get_num_vertices();
 }
 
+void worker_thread::start_level_stat()
+{
+	curr_stat = level_thread_stat();
+	curr_stat.num_active = curr_activated_vertices->get_num_vertices();
+	curr_stat.num_stolen = balancer->get_num_stolen();
+	curr_stat.num_sent_msgs = vprogram->get_num_sent_msgs()
+		+ vpart_vprogram->get_num_sent_msgs();
+	curr_stat.num_recv_msgs = msg_processor->get_num_recv_msgs();
+	curr_stat.num_cache_hits = io->get_cache_hits();
+}
+
+void worker_thread::finish_level_stat(double level_time)
+{
+	curr_stat.num_stolen = balancer->get_num_stolen() - curr_stat.num_stolen;
+	curr_stat.num_sent_msgs = vprogram->get_num_sent_msgs()
+		+ vpart_vprogram->get_num_sent_msgs() - curr_stat.num_sent_msgs;
+	curr_stat.num_recv_msgs = msg_processor->get_num_recv_msgs()
+		- curr_stat.num_recv_msgs;
+	curr_stat.num_cache_hits = io->get_cache_hits() - curr_stat.num_cache_hits;
+	curr_stat.compute_time = std::max(0.0,
+			level_time - curr_stat.io_wait_time - curr_stat.sync_time);
+	level_stats.push_back(curr_stat);
+}
+
 /**
  * This method is the main function of the graph engine.
  */
 void worker_thread::run()
 {
+	struct timeval level_start, start, end;
 	while (true) {
 		int num_visited = 0;
 		int num;
+		gettimeofday(&level_start, NULL);
+		start_level_stat();
+		start_stream();
 		do {
 			balancer->process_completed_stolen_vertices();
+			// The vertices waiting for the streamed adjacency lists
+			// don't hold any resources.
 			num = process_activated_vertices(
 					graph->get_max_processing_vertices()
-					- get_num_vertices_processing());
+					- (get_num_vertices_processing() - (int) num_stream_vertices));
 			num_visited += num;
 			msg_processor->process_msgs();
+			if (stream_level && !stream_collecting)
+				issue_stream_chunks();
 			index_reader->wait4complete(0);
+			curr_stat.num_io_reqs += adj_reqs.size();
+			for (size_t i = 0; i < adj_reqs.size(); i++)
+				curr_stat.num_io_bytes += adj_reqs[i].get_size();
 			io->access(adj_reqs.data(), adj_reqs.size());
 			adj_reqs.clear();
+			gettimeofday(&start, NULL);
 			if (io->num_pending_ios() == 0 && index_reader->get_num_pending_tasks() > 0)
 				index_reader->wait4complete(1);
 			io->wait4complete(min(io->num_pending_ios() / 10, 2));
+			gettimeofday(&end, NULL);
+			curr_stat.io_wait_time += time_diff(start, end);
 			// If there are vertices being processed, we need to call
 			// wait4complete to complete processing them.
 		} while (get_num_vertices_processing() > 0
@@ -581,6 +744,8 @@ void worker_thread::run()
 				|| graph->get_num_remaining_vertices() > 0);
 		assert(index_reader->get_num_pending_tasks() == 0);
 		assert(io->num_pending_ios() == 0);
+		assert(num_stream_vertices == 0);
+		assert(num_stream_chunks == 0);
 		assert(active_computes.size() == 0);
 		assert(curr_activated_vertices->is_empty());
 		assert(num_visited == num_activated_vertices_in_level.get());
@@ -601,7 +766,12 @@ void worker_thread::run()
 		// threads.
 		balancer->process_completed_stolen_vertices();
 		balancer->reset();
+		curr_stat.num_processed = num_visited;
+		gettimeofday(&start, NULL);
 		bool completed = graph->progress_next_level();
+		gettimeofday(&end, NULL);
+		curr_stat.sync_time = time_diff(start, end);
+		finish_level_stat(time_diff(level_start, end));
 		if (completed)
 			break;
 	}
@@ -628,6 +798,12 @@ int worker_thread::steal_activated_vertices(compute_vertex_pointer vertices[], i
 	return num;
 }
 
+void worker_thread::notify_stolen_vertices(compute_vertex_pointer vertices[],
+		int num)
+{
+	msg_processor->steal_vertices(vertices, num);
+}
+
 void worker_thread::return_vertices(vertex_id_t ids[], int num)
 {
 	msg_processor->return_vertices(ids, num);
@@ -28,8 +28,13 @@
 #include "graph_engine.h"
 #include "bitmap.h"
 #include "scan_pointer.h"
+#include "engine_stats.h"
 
 static const size_t MAX_ACTIVE_V = 1024;
+// The max number of vertices in a chunk streamed by a worker thread.
+static const size_t MAX_STREAM_CHUNK_SIZE = 16 * 1024;
+// The max number of chunks being streamed by a worker thread.
+static const int MAX_STREAM_CHUNKS = 4;
 
 class worker_thread;
 
@@ -70,6 +75,8 @@ public:
 
 	void activate_all() {
 		active_map.set_all();
+		// All vertices in the buffer are covered by the bitmap now.
+		active_v.clear();
 	}
 
 	void activate_vertex(local_vid_t id) {
@@ -340,11 +347,41 @@ class worker_thread: public thread
 	// The buffer for processing activated vertex.
 	embedded_array<compute_vertex_pointer> process_vertex_buf;
 
+	/*
+	 * In the streaming mode, the vertices in an iteration where all
+	 * vertices of the partition are active don't request their own
+	 * adjacency lists individually. We record the part of the adjacency
+	 * list that each vertex asks for, and after all vertices have run,
+	 * read the adjacency lists of the partition in large sequential chunks.
+	 */
+	bool stream_level;
+	// Whether we still record the requests to the vertices' own
+	// adjacency lists.
+	bool stream_collecting;
+	// The part of the adjacency list each local vertex asks for.
+	std::vector<unsigned char> stream_types;
+	// The local vertex where the next chunk starts.
+	size_t stream_loc;
+	// The number of vertices waiting for their adjacency lists to be streamed.
+	size_t num_stream_vertices;
+	// The number of chunks being read.
+	int num_stream_chunks;
+
 	// The number of activated vertices processed in the current level.
 	atomic_number<long> num_activated_vertices_in_level;
 	// The number of vertices completed in the current level.
 	atomic_number<long> num_completed_vertices_in_level;
 
+	// The statistics of the thread in each level.
+	std::vector<level_thread_stat> level_stats;
+	// The statistics of the current level. Some of the counters are
+	// cumulative at the beginning of a level and are turned into
+	// the values of the level in finish_level_stat().
+	level_thread_stat curr_stat;
+
+	void start_level_stat();
+	void finish_level_stat(double level_time);
+
 	/**
 	 * Get the number of vertices being processed in the current level.
 	 */
@@ -353,6 +390,8 @@ class worker_thread: public thread
 			- num_completed_vertices_in_level.get();
 	}
 	int process_activated_vertices(int max);
+	void start_stream();
+	void issue_stream_chunks();
 public:
 	worker_thread(graph_engine *graph, file_io_factory::shared_ptr graph_factory,
 			file_io_factory::shared_ptr index_factory, vertex_program::ptr prog,
@@ -376,8 +415,26 @@ public:
 	 */
 	void complete_vertex(const compute_vertex_pointer v);
 
+	/**
+	 * Process all pending messages and notify the vertices that request
+	 * the notification of the end of the current iteration.
+	 */
+	void complete_level();
 	size_t enter_next_level();
 
+	/**
+	 * The number of vertices activated for the next iteration so far.
+	 * The vertices activated multiple times may be counted multiple times
+	 * before the active vertex set is finalized.
+	 */
+	size_t get_num_next_activated() const {
+		return next_activated_vertices->get_num_active_vertices();
+	}
+
+	void activate_all_next_level() {
+		next_activated_vertices->activate_all();
+	}
+
 	void start_vertices(const std::vector<vertex_id_t> &vertices,
 			vertex_initializer::ptr initializer) {
 		this->vinitializer = initializer;
@@ -411,6 +468,23 @@ public:
 	void request_on_vertex(vertex_id_t id) {
 		req_on_vertex = true;
 	}
+
+	/**
+	 * A vertex requests its own adjacency list. In the streaming mode,
+	 * we record the request and return true; otherwise, the vertex should
+	 * request its adjacency list as usual. Only one request is recorded
+	 * for a vertex in an iteration.
+	 */
+	bool stream_vertex(vertex_id_t id, edge_type type);
+	/**
+	 * Get the part of the adjacency list that a vertex has asked for
+	 * in the streaming mode and clear the record.
+	 */
+	edge_type take_stream_vertex(vertex_id_t id);
+	void complete_stream_chunk() {
+		num_stream_chunks--;
+		assert(num_stream_chunks >= 0);
+	}
 	vertex_compute *get_vertex_compute(compute_vertex_pointer v);
 
 	/**
@@ -429,8 +503,16 @@ public:
 	}
 
 	int steal_activated_vertices(compute_vertex_pointer vertices[], int num);
+	/**
+	 * Other threads have stolen the vertices from the deque of this thread.
+	 */
+	void notify_stolen_vertices(compute_vertex_pointer vertices[], int num);
 	void return_vertices(vertex_id_t ids[], int num);
 
+	load_balancer &get_balancer() {
+		return *balancer;
+	}
+
 	size_t get_num_local_vertices() const {
 		return graph->get_partitioner()->get_part_size(worker_id,
 					graph->get_num_vertices());
@@ -460,6 +542,10 @@ public:
 		adj_reqs.push_back(req);
 	}
 
+	const std::vector<level_thread_stat> &get_level_stats() const {
+		return level_stats;
+	}
+
 	size_t get_activates() const {
 		return curr_activated_vertices->get_num_vertices();
 	}
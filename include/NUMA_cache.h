@@ -67,6 +67,11 @@ public:
 		return caches[idx]->search(pg_id);
 	}
 
+	virtual page *prefetch(const page_id_t &pg_id, page_id_t &old_id) {
+		int idx = cache_conf->page2cache(pg_id);
+		return caches[idx]->prefetch(pg_id, old_id);
+	}
+
 	virtual long size() {
 		return cache_conf->get_size();
 	}
@@ -112,6 +117,16 @@ public:
 		return tot;
 	}
 
+	virtual bool load_compressed_page(const page_id_t &pg_id, char *buf) {
+		int idx = cache_conf->page2cache(pg_id);
+		return caches[idx]->load_compressed_page(pg_id, buf);
+	}
+
+	virtual void get_cached_pages(std::vector<cached_page_info> &pages) const {
+		for (size_t i = 0; i < caches.size(); i++)
+			caches[i]->get_cached_pages(pages);
+	}
+
 	virtual void sanity_check() const {
 		for (size_t i = 0; i < caches.size(); i++) {
 			caches[i]->sanity_check();
@@ -49,6 +49,10 @@ class async_io: public io_interface
 
 	int num_iowait;
 	int num_completed_reqs;
+	// The number of requests that have been merged with others and
+	// the number of vectored requests they are merged into.
+	long num_merged_reqs;
+	long num_coalesced_reqs;
 
 	// file id <-> buffered io
 	std::tr1::unordered_map<int, buffered_io *> open_files;
@@ -57,6 +61,10 @@ class async_io: public io_interface
 	virt_data_impl *data;
 
 	struct iocb *construct_req(io_request &io_req, callback_t cb_func);
+	struct iocb *construct_merged_req(io_request *reqs[], int num,
+			callback_t cb_func);
+	buffered_io *get_file(int file_id) const;
+	bool can_merge(const io_request &req1, const io_request &req2) const;
 public:
 	/**
 	 * @aio_depth_per_file
@@ -71,6 +79,16 @@ public:
 		return IO_UNSUPPORTED;
 	}
 	virtual void access(io_request *requests, int num, io_status *status = NULL);
+	/**
+	 * Issue the requests and merge the adjacent ones into vectored
+	 * requests. The requests that should be merged have to be next to
+	 * each other in the array, i.e., the caller sorts the requests.
+	 * Every merged request still completes individually.
+	 * It issues at most `max_iocbs' (merged) requests to the kernel and
+	 * returns the number of requests in the array that have been issued.
+	 */
+	int access_coalesced(io_request *requests, int num,
+			int max_iocbs = INT_MAX);
 
 	bool set_callback(callback *cb) {
 		this->cb = cb;
@@ -117,6 +135,14 @@ public:
 		return num_completed_reqs;
 	}
 
+	long get_num_merged_reqs() const {
+		return num_merged_reqs;
+	}
+
+	long get_num_coalesced_reqs() const {
+		return num_coalesced_reqs;
+	}
+
 	virtual void flush_requests();
 
 	// These two interfaces allow users to open and close more files.
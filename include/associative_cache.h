@@ -33,6 +33,8 @@
 #include "shadow_cell.h"
 #include "exception.h"
 #include "compute_stat.h"
+#include "compressed_cache.h"
+#include "dirty_page_flusher.h"
 
 const int CACHE_LINE = 128;
 
@@ -163,6 +165,11 @@ public:
 			page_cell<thread_safe_page> &buf) {
 		// We don't need to do anything if a page is accessed for many policies.
 	}
+	// It's invoked after a page returned by evict_page() gets its new
+	// page Id.
+	void insert_page(thread_safe_page *pg,
+			page_cell<thread_safe_page> &buf) {
+	}
 };
 
 class LRU_eviction_policy: public eviction_policy
@@ -212,8 +219,73 @@ public:
 	thread_safe_page *evict_page(page_cell<thread_safe_page> &buf);
 };
 
+/**
+ * The S3-FIFO eviction policy. Pages in a cell are split into a small FIFO
+ * queue and a main queue. A new page enters the small queue and moves to
+ * the main queue only if it's accessed again before it reaches the head of
+ * the small queue, so pages touched once by a scan are evicted quickly
+ * without flushing the pages in the main queue. The main queue works like
+ * gclock. The pages evicted from the small queue are remembered in a ghost
+ * queue, and a page found in the ghost queue is inserted to the main queue
+ * directly.
+ *
+ * Both queues are implemented with clock hands over the pages in the cell,
+ * and the active bit of a page indicates that it's in the main queue.
+ */
+class S3FIFO_eviction_policy: public eviction_policy
+{
+	// The percentage of pages in a cell used by the small queue. A cell
+	// has few pages, so it's larger than the 10% used for a global cache.
+	static const int SMALL_QUEUE_PERCENT = 20;
+	// The maximal number of times a page in the main queue is skipped
+	// by the clock hand before it's evicted.
+	static const int MAX_FREQ = 3;
+
+	unsigned int small_head;
+	unsigned int main_head;
+	LRU_shadow_cell ghost;
+
+	bool in_small_queue(thread_safe_page *pg) const {
+		return !pg->active();
+	}
+	thread_safe_page *evict_small(page_cell<thread_safe_page> &buf,
+			unsigned int &num_small, unsigned int min_small, bool avoid_dirty);
+	thread_safe_page *evict_main(page_cell<thread_safe_page> &buf,
+			bool avoid_dirty);
+public:
+	S3FIFO_eviction_policy() {
+		small_head = 0;
+		main_head = 0;
+	}
+
+	thread_safe_page *evict_page(page_cell<thread_safe_page> &buf);
+	void insert_page(thread_safe_page *pg,
+			page_cell<thread_safe_page> &buf);
+	int predict_evicted_pages(page_cell<thread_safe_page> &buf,
+			int num_pages, int set_flags, int clear_flags,
+			std::map<off_t, thread_safe_page *> &pages);
+};
+
 class associative_cache;
 
+/*
+ * The eviction policy used by the cells of the SA-cache. It's selected
+ * in parameters.h.
+ */
+#ifdef USE_LRU
+typedef LRU_eviction_policy cell_eviction_policy;
+#elif defined USE_LFU
+typedef LFU_eviction_policy cell_eviction_policy;
+#elif defined USE_FIFO
+typedef FIFO_eviction_policy cell_eviction_policy;
+#elif defined USE_CLOCK
+typedef clock_eviction_policy cell_eviction_policy;
+#elif defined USE_GCLOCK
+typedef gclock_eviction_policy cell_eviction_policy;
+#elif defined USE_S3FIFO
+typedef S3FIFO_eviction_policy cell_eviction_policy;
+#endif
+
 class hash_cell
 {
 	enum {
@@ -227,17 +299,7 @@ class hash_cell
 	pthread_spinlock_t _lock;
 	page_cell<thread_safe_page> buf;
 	associative_cache *table;
-#ifdef USE_LRU
-	LRU_eviction_policy policy;
-#elif defined USE_LFU
-	LFU_eviction_policy policy;
-#elif defined USE_FIFO
-	FIFO_eviction_policy policy;
-#elif defined USE_CLOCK
-	clock_eviction_policy policy;
-#elif defined USE_GCLOCK
-	gclock_eviction_policy policy;
-#endif
+	cell_eviction_policy policy;
 #ifdef USE_SHADOW_PAGE
 	clock_shadow_cell shadow;
 #endif
@@ -286,7 +348,12 @@ public:
 
 	void rebalance(hash_cell *cell);
 
-	page *search(const page_id_t &pg_id, page_id_t &old_id);
+	/*
+	 * If `access' is false, the eviction policy doesn't count it as
+	 * an access to the page.
+	 */
+	page *search(const page_id_t &pg_id, page_id_t &old_id,
+			bool access = true);
 	page *search(const page_id_t &pg_id);
 
 	bool contain(thread_safe_page *pg) const {
@@ -348,6 +415,10 @@ public:
 	}
 
 	int num_pages(char set_flags, char clear_flags);
+	/**
+	 * Get the pages with valid data in the cell and their hits.
+	 */
+	void get_cached_pages(std::vector<cached_page_info> &pages);
 	int get_num_pages() const {
 		return buf.get_num_pages();
 	}
@@ -369,10 +440,13 @@ public:
 		return num_evictions;
 	}
 
+	const cell_eviction_policy &get_policy() const {
+		return policy;
+	}
+
 	void print_cell();
 };
 
-class dirty_page_flusher;
 class memory_manager;
 
 class associative_cache: public page_cache
@@ -410,6 +484,8 @@ class associative_cache: public page_cache
 
 	std::unique_ptr<dirty_page_flusher> _flusher;
 	pthread_mutex_t init_mutex;
+	// It keeps the evicted pages in the compressed form.
+	compressed_page_cache *comp_cache;
 
 	associative_cache(long cache_size, long max_cache_size, int node_id,
 			int offset_factor, int _max_num_pending_flush,
@@ -491,6 +567,13 @@ public:
 	 * this method.
 	 */
 	page *search(const page_id_t &pg_id);
+	/**
+	 * This method searches for the specified page and evicts a page if
+	 * the specified page doesn't exist, but it isn't counted as an access
+	 * to the page by the eviction policy. It's used for readahead, so
+	 * a page read ahead isn't treated as a hot page on its first access.
+	 */
+	page *prefetch(const page_id_t &pg_id, page_id_t &old_id);
 
 	/**
 	 * Expand the cache by `npages' pages, and return the actual number
@@ -558,6 +641,9 @@ public:
 
 	int get_num_dirty_pages() const;
 
+	virtual void get_cached_pages(std::vector<cached_page_info> &pages) const;
+	virtual bool load_compressed_page(const page_id_t &pg_id, char *buf);
+
 	virtual void init(std::shared_ptr<io_interface> underlying);
 
 	friend class hash_cell;
@@ -568,6 +654,10 @@ public:
 		printf("\tmax pending flushes: %ld, avg: %ld, remaining pending: %d\n",
 				recorded_max_num_pending.get(), (long) avg_num_pending.get(),
 				num_pending_flush.get());
+		if (_flusher)
+			_flusher->print_stat();
+		if (comp_cache)
+			comp_cache->print_stat();
 #ifdef DETAILED_STATISTICS
 		for (int i = 0; i < get_num_cells(); i++)
 			printf("cell %d: %ld accesses, %ld evictions\n", i,
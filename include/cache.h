@@ -30,6 +30,7 @@
 
 #include <memory>
 #include <map>
+#include <vector>
 
 #include "common.h"
 #include "concurrency.h"
@@ -276,6 +277,14 @@ public:
 		return node_id;
 	}
 
+	/*
+	 * Other threads may change the flags of the page without holding
+	 * the lock of the cell, so we have to set the bit atomically.
+	 */
+	bool set_active(bool active) {
+		return set_flags_bit(ACTIVE_BIT, active);
+	}
+
 	/* this is enough for x86 architecture */
 	bool data_ready() const { return get_flags_bit(DATA_READY_BIT); }
 	void wait_ready() {
@@ -391,6 +400,16 @@ public:
 			const thread_safe_page *returned_pages[]) = 0;
 };
 
+/**
+ * A page resident in the page cache and the score that the eviction policy
+ * gives it. A page with a higher score is less likely to be evicted.
+ */
+struct cached_page_info
+{
+	page_id_t pg_id;
+	int score;
+};
+
 class dirty_page_flusher;
 class io_interface;
 class page_filter;
@@ -406,6 +425,13 @@ public:
 	 * saved in `old_off'.
 	 */
 	virtual page *search(const page_id_t &pg_id, page_id_t &old_id) = 0;
+	/**
+	 * This method works like search(pg_id, old_id), but it doesn't count
+	 * as an access to the page, e.g., when the page is read ahead.
+	 */
+	virtual page *prefetch(const page_id_t &pg_id, page_id_t &old_id) {
+		return search(pg_id, old_id);
+	}
 	/**
 	 * This method searches for a page with the specified offset.
 	 * If the page doesn't exist, it returns NULL.
@@ -437,6 +463,18 @@ public:
 	virtual int get_node_id() const {
 		return -1;
 	}
+	/**
+	 * Get the pages that contain valid data in the cache.
+	 */
+	virtual void get_cached_pages(std::vector<cached_page_info> &pages) const {
+	}
+	/**
+	 * Read a page evicted from the cache to the buffer if the page is kept
+	 * in the compressed form.
+	 */
+	virtual bool load_compressed_page(const page_id_t &pg_id, char *buf) {
+		return false;
+	}
 
 	// For test
 	virtual void print_stat() const {
@@ -595,6 +633,18 @@ public:
 	virtual off_t get_offset_in_first_page() const = 0;
 	virtual const char *get_page(int idx) const = 0;
 
+	/**
+	 * This method gets the data of the byte array if all bytes are
+	 * stored contiguously in memory, e.g., the byte array references
+	 * a graph loaded in memory. The iterators access the data directly
+	 * instead of going through the pages.
+	 * \return the pointer to the first byte or NULL if the bytes
+	 * aren't contiguous.
+	 */
+	virtual const char *get_contiguous_data() const {
+		return NULL;
+	}
+
 	/**
 	 * This is a STL-compatile iterator. Users can redefine the type of
 	 * elements in the byte array and iterate the elements stored in
@@ -606,6 +656,8 @@ public:
 	class const_iterator: public std::iterator<std::random_access_iterator_tag, T>
 	{
 		const page_byte_array *arr;
+		// The beginning of the first page if the data is contiguous.
+		const char *base;
 
 		// The byte offset in the pages.
 		off_t off;
@@ -617,6 +669,8 @@ public:
 
 		const_iterator(const page_byte_array *arr, off_t byte_off, off_t byte_end) {
 			this->arr = arr;
+			const char *data = arr->get_contiguous_data();
+			base = data ? data - arr->get_offset_in_first_page() : NULL;
 			off = arr->get_offset_in_first_page() + byte_off;
 			end = arr->get_offset_in_first_page() + byte_end;
 			assert((size_t) byte_end <= arr->get_size());
@@ -632,6 +686,8 @@ public:
 		 * \return the current element.
 		 */
 		T operator*() const {
+			if (base)
+				return *(const T *) (base + off);
 			off_t pg_idx = off / PAGE_SIZE;
 			off_t off_in_pg = off % PAGE_SIZE;
 			const char *data = arr->get_page(pg_idx);
@@ -756,6 +812,9 @@ public:
 	{
 		const page_byte_array *arr;
 		seq_const_page_iterator<T> curr_page_it;
+		// The beginning of the first page if the data is contiguous.
+		// In this case, the entire range is iterated as a single page.
+		const char *base;
 
 		off_t start;
 		// The byte offset in the pages.
@@ -769,6 +828,8 @@ public:
 			assert((size_t) byte_end <= arr->get_size());
 			assert(byte_off <= byte_end);
 
+			const char *data = arr->get_contiguous_data();
+			base = data ? data - arr->get_offset_in_first_page() : NULL;
 			start = arr->get_offset_in_first_page() + byte_off;
 			off = arr->get_offset_in_first_page() + byte_off;
 			end = arr->get_offset_in_first_page() + byte_end;
@@ -776,6 +837,10 @@ public:
 			if (byte_off == byte_end) {
 				curr_page_it = seq_const_page_iterator<T>();
 			}
+			else if (base) {
+				curr_page_it = seq_const_page_iterator<T>(base, off, end);
+				return;
+			}
 			else {
 				off_t pg_end;
 				if (end - ROUND_PAGE(off) >= PAGE_SIZE)
@@ -800,6 +865,8 @@ public:
 		bool has_next() {
 			if (curr_page_it.has_next())
 				return true;
+			else if (base)
+				return false;
 			else {
 				off = ROUNDUP_PAGE(off + 1);
 				if (off < end) {
@@ -844,6 +911,11 @@ public:
 			if (off >= end)
 				return false;
 
+			if (base) {
+				curr_page_it = seq_const_page_iterator<T>(base, off, end);
+				return true;
+			}
+
 			off_t pg_end;
 			if (end - ROUND_PAGE(off) >= PAGE_SIZE)
 				pg_end = PAGE_SIZE;
@@ -1098,6 +1170,11 @@ public:
 		return orig.get_page((off
 					+ orig.get_offset_in_first_page()) / PAGE_SIZE + idx);
 	}
+
+	virtual const char *get_contiguous_data() const {
+		const char *data = orig.get_contiguous_data();
+		return data ? data + off : NULL;
+	}
 };
 
 #endif
@@ -0,0 +1,128 @@
+#ifndef __COMPRESSED_CACHE_H__
+#define __COMPRESSED_CACHE_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unordered_map>
+#include <vector>
+
+#include "concurrency.h"
+#include "cache.h"
+
+/**
+ * This is the second-level page cache behind the SA-cache. It keeps the
+ * clean pages evicted from the SA-cache in the compressed form, so a miss
+ * in the SA-cache can be served by decompressing a page instead of reading
+ * it from SSDs.
+ *
+ * The memory of the cache is allocated on a NUMA node and split into
+ * shards. Each shard is a circular log: compressed pages are appended
+ * to the head of the log, and the oldest pages are dropped from the tail
+ * when the log is full. A page is removed from the cache when it's read
+ * back to the SA-cache, so the two levels don't keep the same page.
+ */
+class compressed_page_cache
+{
+	/*
+	 * The header of a compressed page in the log.
+	 */
+	struct entry_header
+	{
+		long key;
+		// The number of bytes the entry takes in the log.
+		int size;
+		int comp_size;
+	};
+
+	class shard
+	{
+		spin_lock lock;
+		char *log;
+		size_t log_size;
+		// The location where the next page is written.
+		size_t head;
+		// The location of the oldest page.
+		size_t tail;
+		// The number of bytes used in the log.
+		size_t num_bytes;
+		std::unordered_map<long, size_t> index;
+
+		void drop_tail();
+		size_t alloc_entry(size_t size);
+	public:
+		shard(char *log, size_t log_size);
+
+		void add(long key, const char *data, int comp_size);
+		bool fetch(long key, char *buf);
+		size_t get_num_pages() const {
+			return index.size();
+		}
+	};
+
+	int node_id;
+	char *arena;
+	size_t arena_size;
+	std::vector<shard *> shards;
+
+	atomic_number<size_t> num_adds;
+	atomic_number<size_t> num_rejects;
+	atomic_number<size_t> num_hits;
+	atomic_number<size_t> num_misses;
+	atomic_number<size_t> tot_comp_bytes;
+
+	compressed_page_cache(size_t size, int node_id);
+
+	static long get_key(const page_id_t &pg_id) {
+		return (((long) pg_id.get_file_id()) << 40)
+			| (pg_id.get_offset() / PAGE_SIZE);
+	}
+
+	shard &get_shard(long key) {
+		return *shards[universal_hash(key, shards.size())];
+	}
+public:
+	/**
+	 * Create a compressed page cache of `size' bytes on the NUMA node.
+	 */
+	static compressed_page_cache *create(size_t size, int node_id) {
+		return new compressed_page_cache(size, node_id);
+	}
+
+	static void destroy(compressed_page_cache *cache) {
+		delete cache;
+	}
+
+	~compressed_page_cache();
+
+	/**
+	 * Compress a page and add it to the cache. The page is dropped
+	 * if it doesn't compress well.
+	 */
+	void add(const page_id_t &pg_id, const char *data);
+	/**
+	 * Decompress a page to `buf' and remove it from the cache.
+	 * \return false if the page isn't in the cache.
+	 */
+	bool fetch(const page_id_t &pg_id, char *buf);
+
+	void print_stat() const;
+};
+
+#endif
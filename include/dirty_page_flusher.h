@@ -40,6 +40,9 @@ public:
 			io_interface *io) = 0;
 
 	virtual int flush_dirty_pages(page_filter *filter, int max_num) = 0;
+
+	virtual void print_stat() const {
+	}
 };
 
 #endif
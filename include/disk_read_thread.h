@@ -23,6 +23,7 @@
 #include <unistd.h>
 
 #include <string>
+#include <deque>
 #include <tr1/unordered_map>
 
 #include "aio_private.h"
@@ -37,6 +38,67 @@ void *process_requests(void *arg);
 
 class async_io;
 
+/**
+ * This dispatches the requests of different priority classes to the disk.
+ * It implements weighted fair queueing. Each class has a virtual time that
+ * advances by the size of a dispatched request divided by the weight of
+ * the class, and we always dispatch a request from the backlogged class
+ * with the smallest virtual time. Requests in the same class are
+ * dispatched in the order of arrival.
+ */
+class io_class_scheduler
+{
+	fifo_queue<io_request> *queues[NUM_IO_CLASSES];
+	// The requests put back to the scheduler. They are dispatched before
+	// the ones in the queue of the same class.
+	std::deque<io_request> put_back_reqs[NUM_IO_CLASSES];
+	long vtimes[NUM_IO_CLASSES];
+	// The virtual time of the last dispatched request.
+	long curr_vtime;
+	int num_reqs;
+
+	long num_dispatched[NUM_IO_CLASSES];
+	long num_dispatched_bytes[NUM_IO_CLASSES];
+
+	bool is_class_empty(int io_class) {
+		return put_back_reqs[io_class].empty() && queues[io_class]->is_empty();
+	}
+	int get_next_class();
+	io_request pop_req(int io_class);
+public:
+	io_class_scheduler(int node_id);
+	~io_class_scheduler();
+
+	void add(io_request reqs[], int num);
+	/**
+	 * Fetch at most `max_reqs' requests in the order that they should be
+	 * dispatched to the disk.
+	 */
+	int fetch(io_request reqs[], int max_reqs);
+	/**
+	 * Fetch at most `max_reqs' requests of the class that should be
+	 * dispatched next, so the requests can be reordered without changing
+	 * the order between classes.
+	 */
+	int fetch_class(io_request reqs[], int max_reqs);
+	/**
+	 * Put back the requests fetched from the scheduler but not dispatched.
+	 * They are dispatched before the other requests in their classes, and
+	 * their classes aren't charged for them.
+	 */
+	void put_back(io_request reqs[], int num);
+
+	int get_num_reqs() const {
+		return num_reqs;
+	}
+
+	bool is_empty() const {
+		return num_reqs == 0;
+	}
+
+	void print_stat() const;
+};
+
 class disk_io_thread: public thread
 {
 	static const int LOCAL_BUF_SIZE = 16;
@@ -132,6 +194,9 @@ class disk_io_thread: public thread
 	const int disk_id;
 
 	msg_queue<io_request> queue;
+	// The high-prio requests fetched from the queue, but not dispatched
+	// to the disk yet.
+	io_class_scheduler scheduler;
 	msg_queue<io_request> low_prio_queue;
 	thread_safe_FIFO_queue<remote_comm *> comm_queue;
 	logical_file_partition partition;
@@ -170,9 +235,12 @@ class disk_io_thread: public thread
 	dirty_page_filter filter;
 
 	int process_low_prio_msg(message<io_request> &low_prio_msg);
+	int fetch_requests(message<io_request> msgs[], int num_msgs);
+	void dispatch_requests();
+	void count_dispatched(io_request reqs[], int num);
 
 	int get_num_high_prio_reqs() {
-		return queue.get_num_objs();
+		return queue.get_num_objs() + scheduler.get_num_reqs();
 	}
 
 	int get_num_low_prio_reqs() {
@@ -270,6 +338,10 @@ public:
 					min_flush_delay);
 		printf("\tremain %d high-prio requests, %d low-prio requests, %ld messages in total\n",
 				get_num_high_prio_reqs(), get_num_low_prio_reqs(), num_msgs);
+		if (aio->get_num_coalesced_reqs() > 0)
+			printf("\tmerge %ld reqs into %ld vectored reqs\n",
+					aio->get_num_merged_reqs(), aio->get_num_coalesced_reqs());
+		scheduler.print_stat();
 #endif
 	}
 
@@ -34,6 +34,100 @@ class global_cached_io;
 
 typedef std::pair<thread_safe_page *, original_io_request *> page_req_pair;
 
+/**
+ * This detects sequential streams of reads in files and decides which pages
+ * to read ahead for them. Reads don't need to be strictly sequential: a read
+ * continues a stream as long as it starts close enough to where the stream
+ * ends, because a graph scan in the order of vertex Ids skips the inactive
+ * vertices.
+ *
+ * The readahead window of a stream doubles every time the pages read ahead
+ * previously were all used, and halves when some of them are skipped.
+ */
+class readahead_detector
+{
+	struct seq_stream
+	{
+		file_id_t file_id;
+		// The end of the last read in the stream.
+		off_t last_end;
+		// The end of the pages that have been read ahead.
+		off_t ra_end;
+		// The number of pages to read ahead.
+		int window;
+		// The number of sequential reads in the stream.
+		int num_seq_reads;
+		// Whether any pages read ahead have been skipped by the stream
+		// since the last readahead.
+		bool wasted;
+		size_t last_access;
+	};
+
+	// The number of streams we track for a global_cached_io.
+	static const int MAX_STREAMS = 8;
+	static const int MIN_WINDOW = 4;
+	// The number of sequential reads before we start reading ahead.
+	static const int MIN_SEQ_READS = 2;
+
+	int max_window;
+	// The end of the pages we can read ahead.
+	off_t file_end;
+	std::vector<seq_stream> streams;
+	// The stream that the last readahead is for.
+	int ra_stream_idx;
+	size_t num_accesses;
+
+	size_t num_ra_pages;
+	size_t num_useful_pages;
+	size_t num_wasted_pages;
+
+	seq_stream *find_stream(file_id_t file_id, off_t begin);
+	seq_stream *new_stream(file_id_t file_id);
+public:
+	readahead_detector() {
+		max_window = 0;
+		file_end = 0;
+		ra_stream_idx = -1;
+		num_accesses = 0;
+		num_ra_pages = 0;
+		num_useful_pages = 0;
+		num_wasted_pages = 0;
+	}
+
+	void init(int max_window, off_t file_size) {
+		this->max_window = max_window;
+		this->file_end = ROUNDUP_PAGE(file_size);
+	}
+
+	bool is_enabled() const {
+		return max_window > 0;
+	}
+
+	/**
+	 * Record a read in a file.
+	 * It returns the number of pages to read ahead, starting at `ra_off'.
+	 */
+	int access(file_id_t file_id, off_t off, size_t size, off_t &ra_off);
+	/**
+	 * Record the readahead after access() returns pages to read ahead.
+	 * `ra_end' is where the readahead stopped, and `num_pages' is
+	 * the number of pages actually read from the disk.
+	 */
+	void end_readahead(off_t ra_end, int num_pages);
+
+	size_t get_num_ra_pages() const {
+		return num_ra_pages;
+	}
+
+	size_t get_num_useful_pages() const {
+		return num_useful_pages;
+	}
+
+	size_t get_num_wasted_pages() const {
+		return num_wasted_pages;
+	}
+};
+
 class global_cached_io: public io_interface
 {
 	/**
@@ -140,6 +234,10 @@ class global_cached_io: public io_interface
 	size_t cache_hits;
 	size_t num_fast_process;
 	size_t num_evicted_dirty_pages;
+	// The number of pages read from the compressed page cache.
+	size_t num_comp_hits;
+
+	readahead_detector ra_detector;
 
 	// Count the number of async requests.
 	// The number of async requests that have been completed.
@@ -165,6 +263,8 @@ class global_cached_io: public io_interface
 	int multibuf_completion(io_request *request);
 
 	void wait4req(original_io_request *req);
+	void read_ahead(const io_request &req);
+	void send_readahead(thread_safe_page *pages[], int num_pages);
 
 	int get_num_underlying_reqs() const {
 		return num_to_underlying.get() - num_from_underlying.get();
@@ -194,6 +294,16 @@ public:
 		return global_cache;
 	}
 
+	/**
+	 * Read ahead the pages of sequential streams in the file.
+	 * It only works when files are read-only, so we never need to write
+	 * back an evicted dirty page for readahead.
+	 */
+	void enable_readahead(int max_window, off_t file_size) {
+		if (!params.is_writable())
+			ra_detector.init(max_window, file_size);
+	}
+
 	int preload(off_t start, long size);
 	io_status access(char *buf, off_t offset, ssize_t size, int access_method);
 	/**
@@ -257,6 +367,12 @@ public:
 		// tasks. We have to make sure all requests are completed.
 		while (num_pending_ios() > 0 || !comp_io_sched->is_empty())
 			wait4complete(num_pending_ios());
+		// Readahead requests don't belong to any user requests.
+		while (get_num_underlying_reqs() > 0) {
+			process_all_requests();
+			if (get_num_underlying_reqs() > 0)
+				get_thread()->wait();
+		}
 		underlying->cleanup();
 		assert(num_processed_areqs.get() == num_completed_areqs.get());
 		assert(num_processed_areqs.get() == num_issued_areqs.get());
@@ -321,6 +437,12 @@ public:
 	size_t get_num_fast_process() const {
 		return num_fast_process;
 	}
+	size_t get_num_comp_hits() const {
+		return num_comp_hits;
+	}
+	const readahead_detector &get_readahead_stat() const {
+		return ra_detector;
+	}
 
 	virtual void print_state() {
 #ifdef STATISTICS
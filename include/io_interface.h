@@ -213,6 +213,15 @@ public:
 	virtual void print_state() {
 	}
 
+	/*
+	 * This method returns the number of page accesses served by the page
+	 * cache so far. It's only meaningful for the IO instances that access
+	 * data through the page cache.
+	 */
+	virtual size_t get_cache_hits() const {
+		return 0;
+	}
+
 	virtual io_interface *clone(thread *t) const {
 		return NULL;
 	}
@@ -473,4 +482,22 @@ void print_io_thread_stat();
  */
 void set_file_weight(const std::string &file_name, int weight);
 
+/**
+ * This function saves the IDs of the pages in the page cache to a file,
+ * along with the scores given by the eviction policy. It can be invoked
+ * at any time after SAFS is initialized with the page cache.
+ * \param file_name the file in the local filesystem.
+ * \return true if the pages are saved successfully.
+ */
+bool dump_page_cache(const std::string &file_name);
+
+/**
+ * This function reads the pages saved by dump_page_cache() to the page cache.
+ * The pages with higher scores are loaded first if they can't all fit in
+ * the cache. Adjacent pages are read with large requests.
+ * \param file_name the file in the local filesystem.
+ * \return the number of pages read to the page cache.
+ */
+size_t warm_page_cache(const std::string &file_name);
+
 #endif
@@ -458,6 +458,19 @@ public:
 	virtual void free(user_compute *compute) = 0;
 };
 
+/**
+ * The priority classes of I/O requests. An I/O thread dispatches requests
+ * of different classes in proportion to the weights of the classes, so
+ * small latency-critical requests (e.g., reads to the graph index) don't
+ * wait behind large bulk reads.
+ */
+enum {
+	IO_CLASS_CRITICAL,
+	IO_CLASS_NORMAL,
+	IO_CLASS_BACKGROUND,
+	NUM_IO_CLASSES,
+};
+
 /**
  * This class defines an I/O request from users.
  * There are three forms of I/O reuqests:
@@ -505,8 +518,10 @@ class io_request
 	unsigned int high_prio: 1;
 	unsigned int low_latency: 1;
 	unsigned int discarded: 1;
-	static const int MAX_NODE_ID = (1 << 8) - 1;
-	unsigned int node_id: 8;
+	// The priority class used by the I/O thread to schedule the request.
+	unsigned int io_class: 2;
+	static const int MAX_NODE_ID = (1 << 6) - 1;
+	unsigned int node_id: 6;
 	// Linux uses 48 bit for addresses.
 	// When the request is completed, the IO instance will be notified of
 	// the completion. The IO is usually the issuer IO, but it can be other
@@ -537,12 +552,14 @@ class io_request
 		high_prio = 1;
 		low_latency = 0;
 		discarded = 0;
+		io_class = IO_CLASS_NORMAL;
 	}
 
 	void copy_flags(const io_request &req) {
 		this->sync = req.sync;
 		this->high_prio = req.high_prio;
 		this->low_latency = req.low_latency;
+		this->io_class = req.io_class;
 	}
 
 	void set_int_buf_size(size_t size) {
@@ -667,6 +684,7 @@ public:
 		offset = 0;
 		high_prio = 0;
 		sync = 0;
+		io_class = IO_CLASS_NORMAL;
 		node_id = MAX_NODE_ID;
 		io_addr = 0;
 		access_method = 0;
@@ -766,6 +784,15 @@ public:
 		this->low_latency = low_latency;
 	}
 
+	int get_io_class() const {
+		return io_class;
+	}
+
+	void set_io_class(int io_class) {
+		assert(io_class >= 0 && io_class < NUM_IO_CLASSES);
+		this->io_class = io_class;
+	}
+
 	/*
 	 * The requested data is inside a page on the disk.
 	 */
@@ -911,6 +938,13 @@ public:
 
 	const int get_vec(struct iovec *vec, int num) const {
 		num = min(get_num_bufs(), num);
+		if (!is_extended_req()) {
+			if (num > 0) {
+				vec[0].iov_base = get_buf();
+				vec[0].iov_len = get_size();
+			}
+			return num;
+		}
 		for (int i = 0; i < num; i++) {
 			io_req_extension *ext = get_extension();
 			vec[i].iov_base = ext->get_buf(i).get_buf();
@@ -965,6 +999,7 @@ public:
 		data_loc_t loc(this->get_file_id(), req_off);
 		extracted.init(req_buf, loc, req_size, this->get_access_method(),
 				this->get_io(), this->get_node_id());
+		extracted.set_io_class(this->get_io_class());
 	}
 
 	/*
@@ -1082,6 +1117,20 @@ public:
 	}
 };
 
+/*
+ * Order the requests by their locations in the files.
+ */
+class comp_req_offset
+{
+public:
+	bool operator() (const io_request &req1, const io_request &req2) const {
+		if (req1.get_file_id() != req2.get_file_id())
+			return req1.get_file_id() < req2.get_file_id();
+		else
+			return req1.get_offset() < req2.get_offset();
+	}
+};
+
 typedef void (*req_process_func_t)(io_interface *io, io_request *reqs[], int num);
 /*
  * Perform the same function to the requests with the same IO instance.
@@ -38,6 +38,8 @@ class memory_manager: public slab_allocator
 	~memory_manager() {
 		// TODO
 	}
+protected:
+	virtual void add_chunk(char *buf, long size);
 public:
 	static memory_manager *create(long max_size, int node_id) {
 		assert(node_id >= 0);
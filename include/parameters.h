@@ -27,7 +27,9 @@
 #include <string>
 #include <memory>
 
-#define USE_GCLOCK
+// S3-FIFO keeps the pages accessed repeatedly in the SA-cache when
+// a scan accesses many pages only once.
+#define USE_S3FIFO
 
 #define PAGE_SIZE 4096
 #define LOG_PAGE_SIZE 12
@@ -43,6 +45,8 @@ class sys_parameters
 	long cache_size;
 	int RAID_mapping_option;
 	bool use_virt_aio;
+	bool use_io_uring;
+	bool buffered_io;
 	bool verify_content;
 	bool use_flusher;
 	bool cache_large_write;
@@ -54,6 +58,12 @@ class sys_parameters
 	bool writable;
 	int max_num_pending_ios;
 	bool huge_page_enabled;
+	int max_readahead;
+	std::string hot_page_file;
+	long comp_cache_size;
+	std::string ssd_model_file;
+	bool coalesce_reqs;
+	bool write_combining;
 public:
 	sys_parameters();
 
@@ -91,6 +101,19 @@ public:
 		return use_virt_aio;
 	}
 
+	bool is_use_io_uring() const {
+		return use_io_uring;
+	}
+
+	/**
+	 * Files are opened without O_DIRECT and I/O goes through the OS page
+	 * cache. It only makes sense with io_uring, which doesn't block on
+	 * buffered I/O.
+	 */
+	bool is_buffered_io() const {
+		return use_io_uring && buffered_io;
+	}
+
 	bool is_verify_content() const {
 		return verify_content;
 	}
@@ -134,6 +157,56 @@ public:
 	bool is_huge_page_enabled() const {
 		return huge_page_enabled;
 	}
+
+	/**
+	 * The maximal number of pages read ahead for a sequential stream
+	 * in the page cache. 0 disables readahead.
+	 */
+	int get_max_readahead() const {
+		return max_readahead;
+	}
+
+	/**
+	 * The file where the pages in the page cache are saved when SAFS
+	 * is destroyed. The pages are loaded to the page cache again when
+	 * SAFS is initialized next time.
+	 */
+	const std::string &get_hot_page_file() const {
+		return hot_page_file;
+	}
+
+	/**
+	 * The size of the compressed page cache behind the SA-cache in bytes.
+	 * 0 disables the compressed page cache.
+	 */
+	long get_comp_cache_size() const {
+		return comp_cache_size;
+	}
+
+	/**
+	 * The profile of the SSD performance model used by virtual AIO.
+	 * With a profile, virtual AIO reads and writes the data in the files,
+	 * and completes requests as the model says.
+	 */
+	const std::string &get_ssd_model_file() const {
+		return ssd_model_file;
+	}
+
+	/**
+	 * Whether the I/O threads merge the adjacent requests from
+	 * different threads into vectored requests.
+	 */
+	bool is_coalesce_reqs() const {
+		return coalesce_reqs;
+	}
+
+	/**
+	 * Whether the flusher writes back dirty pages of many cells together
+	 * and merges the contiguous ones into large writes.
+	 */
+	bool is_write_combining() const {
+		return write_combining;
+	}
 };
 
 extern sys_parameters params;
@@ -70,8 +70,6 @@ public:
 	}
 };
 
-#ifdef USE_SHADOW_PAGE
-
 class shadow_cell
 {
 public:
@@ -147,7 +145,7 @@ public:
 	void print_state() {
 		printf("start: %d, num: %d\n", start, num);
 		for (int i = 0; i < this->size(); i++)
-			printf("%ld\t", this->get(i));
+			printf("%ld\t", this->get(i).get_offset());
 		printf("\n");
 	}
 };
@@ -193,5 +191,3 @@ public:
 };
 
 #endif
-
-#endif
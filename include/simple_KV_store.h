@@ -177,8 +177,11 @@ class simple_KV_store
 
 	embedded_array<io_request> req_buf;
 	int num_reqs;
+	// The priority class of the I/O requests issued by the store.
+	int io_class;
 
 	void add_io_request(io_request &req) {
+		req.set_io_class(io_class);
 		if (req_buf.get_capacity() <= num_reqs)
 			req_buf.resize(req_buf.get_capacity() * 2);
 		req_buf[num_reqs] = req;
@@ -208,6 +211,7 @@ class simple_KV_store
 		num_reqs = 0;
 		assert(PAGE_SIZE % sizeof(ValueType) == 0);
 		num_pending_tasks = 0;
+		io_class = IO_CLASS_NORMAL;
 	}
 public:
 	typedef std::shared_ptr<simple_KV_store<ValueType, TaskType> > ptr;
@@ -216,6 +220,10 @@ public:
 		return ptr(new simple_KV_store<ValueType, TaskType>(io));
 	}
 
+	void set_io_class(int io_class) {
+		this->io_class = io_class;
+	}
+
 	void flush_requests() {
 		if (task_buf.empty())
 			return;
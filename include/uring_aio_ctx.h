@@ -0,0 +1,132 @@
+#ifndef __URING_AIO_CTX_H__
+#define __URING_AIO_CTX_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+
+#include <vector>
+
+#include "wpaio.h"
+
+/**
+ * Register a memory region that will be used as I/O buffers. The region
+ * is registered to all io_uring instances as fixed buffers, so reads into
+ * the region don't need to map the user pages in the kernel every time.
+ * The page cache registers its memory chunks here.
+ *
+ * Each io_uring instance pins the registered buffers against
+ * RLIMIT_MEMLOCK separately. If the limit is too small, we print a warning
+ * and read to the buffers that can't be registered as regular buffers.
+ */
+void register_io_buf(void *buf, size_t size);
+
+/**
+ * This is an AIO context implemented with io_uring. It accepts the same
+ * iocbs as aio_ctx_impl, so the rest of async_io doesn't need to know
+ * which kernel interface is used.
+ *
+ * We talk to the kernel with the raw system calls and map the submission
+ * and completion rings ourselves. All iocbs passed to a single
+ * submit_io_request() are written to the submission ring and submitted
+ * with one system call. Completions are reaped from the completion ring
+ * directly and we only enter the kernel when we need to wait.
+ *
+ * Unlike Linux AIO, io_uring doesn't block on buffered I/O, so files can
+ * be opened without O_DIRECT when this context is used.
+ */
+class uring_aio_ctx: public aio_ctx
+{
+	int ring_fd;
+	int max_aio;
+	int busy_aio;
+
+	void *sq_ring_ptr;
+	size_t sq_ring_size;
+	void *cq_ring_ptr;
+	size_t cq_ring_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	// The fields of the submission ring.
+	unsigned *sq_head;
+	unsigned *sq_tail;
+	unsigned *sq_mask;
+	unsigned *sq_array;
+	// The fields of the completion ring.
+	unsigned *cq_head;
+	unsigned *cq_tail;
+	unsigned *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	// The buffers registered to the kernel. The index of a buffer is
+	// its index in the kernel's buffer table.
+	std::vector<struct iovec> reg_bufs;
+	// The version of the buffer registry when we registered the buffers.
+	size_t reg_version;
+	// We don't try to register buffers again if it failed once.
+	bool reg_failed;
+	// Whether the ring has a sparse buffer table. If it does, new buffers
+	// are added to the table while requests are in flight. Otherwise, all
+	// buffers are registered again when the ring is idle.
+	bool sparse_table;
+
+	size_t num_reqs;
+	size_t num_fixed_reqs;
+	size_t num_submit_calls;
+	size_t num_wait_calls;
+
+	uring_aio_ctx(int node_id, int max_aio);
+
+	bool init_ring();
+	void init_buf_table();
+	int enter(unsigned to_submit, unsigned min_complete, unsigned flags);
+	void update_reg_bufs();
+	void report_reg_failure(const std::vector<struct iovec> &bufs, int err);
+	int get_reg_buf(const void *buf, size_t size) const;
+	void prep_sqe(struct io_uring_sqe *sqe, struct iocb *req);
+	int reap(struct iocb *iocbs[], long res[], int max);
+public:
+	/**
+	 * Create an io_uring AIO context. It returns NULL if the kernel
+	 * doesn't support io_uring.
+	 */
+	static uring_aio_ctx *create(int node_id, int max_aio);
+
+	~uring_aio_ctx();
+
+	virtual void submit_io_request(struct iocb* ioq[], int num);
+	virtual int io_wait(struct timespec* to, int num);
+	virtual int max_io_slot() {
+		return max_aio - busy_aio;
+	}
+	virtual void print_stat();
+
+	size_t get_num_reg_bufs() const {
+		return reg_bufs.size();
+	}
+
+	size_t get_num_fixed_reqs() const {
+		return num_fixed_reqs;
+	}
+};
+
+#endif
@@ -20,6 +20,9 @@
  * limitations under the License.
  */
 
+#include <string>
+#include <vector>
+
 #include "container.h"
 #include "wpaio.h"
 
@@ -38,11 +41,73 @@ public:
 	virtual bool verify_data(int fd, void *data, int size, off_t off) = 0;
 };
 
+/**
+ * This computes how long an SSD takes to serve a request.
+ * The current time and the returned delay are in microseconds.
+ */
 class ssd_perf_model
 {
 public:
-	virtual long get_read_delay(off_t off, size_t size) = 0;
-	virtual long get_write_delay(off_t off, size_t size) = 0;
+	virtual ~ssd_perf_model() {
+	}
+
+	virtual long get_read_delay(long curr_time, off_t off, size_t size) = 0;
+	virtual long get_write_delay(long curr_time, off_t off, size_t size) = 0;
+};
+
+/**
+ * The parameters of an SSD, which are usually fitted from a calibration
+ * run on real hardware. They are saved in a profile file with one
+ * `key=value' per line.
+ */
+struct ssd_profile
+{
+	// The number of flash channels that serve pages in parallel.
+	int num_channels;
+	// The time that a channel is occupied to read/write a page (in us).
+	long read_latency;
+	long write_latency;
+	// The bandwidth of the host interface (in bytes per second).
+	long read_bandwidth;
+	long write_bandwidth;
+
+	ssd_profile();
+
+	bool load(const std::string &file);
+	bool save(const std::string &file) const;
+};
+
+/**
+ * This model simulates the flash channels and the host interface of
+ * an SSD. Pages are striped across the channels. A page waits until its
+ * channel is free and occupies it for the read or write latency, so
+ * requests queue up inside the SSD and writes delay reads. The data of
+ * requests is also transferred through the host interface, which is
+ * capped by the bandwidth. There isn't randomness in the model, so the same
+ * sequence of requests always gets the same delays.
+ */
+class queued_ssd_perf_model: public ssd_perf_model
+{
+	ssd_profile profile;
+	// The time when each channel becomes free.
+	std::vector<long> channel_free_times;
+	// The time when the host interface becomes free.
+	long bus_free_time;
+
+	long get_delay(long curr_time, off_t off, size_t size, long latency,
+			long bandwidth);
+public:
+	queued_ssd_perf_model(const ssd_profile &profile);
+
+	virtual long get_read_delay(long curr_time, off_t off, size_t size) {
+		return get_delay(curr_time, off, size, profile.read_latency,
+				profile.read_bandwidth);
+	}
+
+	virtual long get_write_delay(long curr_time, off_t off, size_t size) {
+		return get_delay(curr_time, off, size, profile.write_latency,
+				profile.write_bandwidth);
+	}
 };
 
 /**
@@ -58,6 +123,8 @@ class virt_aio_ctx: public aio_ctx
 	fifo_queue<struct req_entry> pending_reqs;
 	virt_data *data;
 	ssd_perf_model *model;
+	// Whether we read and write the data in the files.
+	bool access_data;
 
 	long read_bytes;
 	long write_bytes;
@@ -66,6 +133,7 @@ class virt_aio_ctx: public aio_ctx
 	struct timeval prev_print_time;
 public:
 	virt_aio_ctx(virt_data *data, int node_id, int max_aio);
+	~virt_aio_ctx();
 
 	virtual void submit_io_request(struct iocb* ioq[], int num);
 	virtual int io_wait(struct timespec* to, int num);
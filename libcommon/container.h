@@ -28,6 +28,7 @@
 #include <limits.h>
 
 #include <string>
+#include <atomic>
 #include <boost/assert.hpp>
 
 #include "common.h"
@@ -389,6 +390,194 @@ public:
 	}
 };
 
+/**
+ * This is a bounded lock-free FIFO queue for multiple producers and
+ * a single consumer. It's based on the bounded MPMC queue by Dmitry Vyukov:
+ * each slot in the ring buffer has a sequence number, so producers only
+ * need an atomic operation to claim a slot and never block each other.
+ *
+ * Producers can't wait for the consumer when the ring buffer is full,
+ * because the consumer may be a producer that is waiting for another queue
+ * in turn. Instead, the entries that can't fit in the ring buffer go to
+ * an overflow queue protected by a spin lock. Once the overflow queue is
+ * used, all producers use it until the consumer has drained it, so that
+ * the entries from the same producer are always fetched in order.
+ *
+ * Only the consumer thread can fetch entries and check whether
+ * the queue is empty.
+ */
+template<class T>
+class lockfree_mpsc_queue
+{
+	struct cell
+	{
+		std::atomic_long seq;
+		T entry;
+	};
+
+	cell *cells;
+	long size_mask;
+
+	// Keep the producers' and the consumer's states in different
+	// cache lines.
+	char pad1[64];
+	// The next slot that producers add entries to.
+	std::atomic_long tail;
+	char pad2[64];
+	// The next slot that the consumer fetches entries from.
+	long head;
+	// The consumer fetches entries in the ring buffer up to this slot
+	// before it fetches the entries from the overflow queue.
+	long fetch_end;
+
+	pthread_spinlock_t overflow_lock;
+	fifo_queue<T> overflow;
+	std::atomic_bool overflowed;
+	std::atomic_int num_overflow;
+	// The entries taken from the overflow queue that haven't been fetched.
+	fifo_queue<T> pending;
+	std::string name;
+
+	bool add_ring(T &entry) {
+		long pos = tail.load(std::memory_order_relaxed);
+		cell *c;
+		while (true) {
+			c = &cells[pos & size_mask];
+			long seq = c->seq.load(std::memory_order_acquire);
+			long diff = seq - pos;
+			if (diff == 0) {
+				if (tail.compare_exchange_weak(pos, pos + 1,
+							std::memory_order_relaxed))
+					break;
+			}
+			// The ring buffer is full.
+			else if (diff < 0)
+				return false;
+			else
+				pos = tail.load(std::memory_order_relaxed);
+		}
+		c->entry = entry;
+		c->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	void add_overflow(T *entries, int num) {
+		pthread_spin_lock(&overflow_lock);
+		overflowed.store(true);
+		if (overflow.get_num_remaining() < num) {
+			int new_size = overflow.get_size();
+			while (new_size < overflow.get_num_entries() + num)
+				new_size *= 2;
+			overflow.expand_queue(new_size);
+		}
+		BOOST_VERIFY(overflow.add(entries, num) == num);
+		num_overflow.store(overflow.get_num_entries());
+		pthread_spin_unlock(&overflow_lock);
+	}
+
+	/*
+	 * Take the entries in the overflow queue, and fetch the entries
+	 * in the ring buffer added so far before them.
+	 */
+	void start_fetch_pass() {
+		pthread_spin_lock(&overflow_lock);
+		if (overflow.is_empty())
+			overflowed.store(false);
+		else {
+			// The consumer only takes the overflow queue when it has
+			// fetched all pending entries.
+			assert(pending.is_empty());
+			if (pending.get_size() < overflow.get_num_entries())
+				pending.expand_queue(overflow.get_size());
+			BOOST_VERIFY(pending.add(&overflow) > 0);
+			assert(overflow.is_empty());
+			num_overflow.store(0);
+		}
+		pthread_spin_unlock(&overflow_lock);
+		fetch_end = tail.load(std::memory_order_acquire);
+	}
+public:
+	lockfree_mpsc_queue(const std::string &name, int node_id,
+			int capacity): overflow(node_id, 16, true), pending(node_id,
+				16, true) {
+		assert(capacity > 0 && (capacity & (capacity - 1)) == 0);
+		this->name = name;
+		cells = new cell[capacity];
+		for (int i = 0; i < capacity; i++)
+			cells[i].seq.store(i, std::memory_order_relaxed);
+		size_mask = capacity - 1;
+		tail = 0;
+		head = 0;
+		fetch_end = 0;
+		pthread_spin_init(&overflow_lock, PTHREAD_PROCESS_PRIVATE);
+		overflowed = false;
+		num_overflow = 0;
+	}
+
+	virtual ~lockfree_mpsc_queue() {
+		pthread_spin_destroy(&overflow_lock);
+		delete [] cells;
+	}
+
+	/**
+	 * This can be invoked by any thread. It always adds all entries.
+	 */
+	int add(T *entries, int num) {
+		int i = 0;
+		if (!overflowed.load(std::memory_order_acquire)) {
+			for (; i < num; i++) {
+				if (!add_ring(entries[i]))
+					break;
+			}
+		}
+		if (i < num)
+			add_overflow(entries + i, num - i);
+		return num;
+	}
+
+	/**
+	 * The methods below can only be invoked by the consumer thread.
+	 */
+
+	int fetch(T *entries, int num) {
+		int num_fetches = 0;
+		while (num_fetches < num) {
+			if (head < fetch_end) {
+				cell *c = &cells[head & size_mask];
+				// A producer has claimed the slot, but may not have
+				// finished writing the entry.
+				while (c->seq.load(std::memory_order_acquire) != head + 1);
+				entries[num_fetches++] = c->entry;
+				c->seq.store(head + size_mask + 1, std::memory_order_release);
+				head++;
+			}
+			else if (!pending.is_empty())
+				num_fetches += pending.fetch(entries + num_fetches,
+						num - num_fetches);
+			else {
+				start_fetch_pass();
+				if (head == fetch_end && pending.is_empty())
+					break;
+			}
+		}
+		return num_fetches;
+	}
+
+	bool is_empty() {
+		return head == fetch_end && pending.is_empty()
+			&& head == tail.load(std::memory_order_acquire)
+			&& num_overflow.load() == 0;
+	}
+
+	int get_capacity() const {
+		return size_mask + 1;
+	}
+
+	const std::string &get_name() const {
+		return name;
+	}
+};
+
 /**
  * This FIFO queue can block the thread if
  * a thread wants to add more entries when the queue is full;
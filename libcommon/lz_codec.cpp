@@ -0,0 +1,188 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lz_codec.h"
+
+static const int MIN_MATCH = 4;
+// The last bytes of the input are always stored as literals.
+static const int LAST_LITERALS = 5;
+// A match can't start in the last bytes of the input.
+static const int MATCH_LIMIT = 12;
+static const int MAX_OFFSET = 65535;
+static const int HASH_LOG = 12;
+
+static inline uint32_t read32(const char *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline int hash32(uint32_t v)
+{
+	return (v * 2654435761U) >> (32 - HASH_LOG);
+}
+
+static inline int get_len_size(int len)
+{
+	return len >= 15 ? (len - 15) / 255 + 1 : 0;
+}
+
+static inline int write_len(char *dst, int len)
+{
+	int i = 0;
+	for (len -= 15; len >= 255; len -= 255)
+		dst[i++] = (char) 255;
+	dst[i++] = (char) len;
+	return i;
+}
+
+/*
+ * Write a sequence of literals followed by a match. The last sequence
+ * of the compressed data doesn't have a match (match_len is 0).
+ * It returns the location after the sequence or -1 if the sequence
+ * doesn't fit in the buffer.
+ */
+static int write_sequence(char *dst, int out, int capacity, const char *lits,
+		int num_lits, int offset, int match_len)
+{
+	int ml = match_len - MIN_MATCH;
+	int size = 1 + get_len_size(num_lits) + num_lits;
+	if (match_len > 0)
+		size += 2 + get_len_size(ml);
+	if (out + size > capacity)
+		return -1;
+
+	int token_loc = out++;
+	unsigned char token = (num_lits >= 15 ? 15 : num_lits) << 4;
+	if (num_lits >= 15)
+		out += write_len(dst + out, num_lits);
+	memcpy(dst + out, lits, num_lits);
+	out += num_lits;
+	if (match_len > 0) {
+		token |= ml >= 15 ? 15 : ml;
+		dst[out++] = (char) (offset & 0xff);
+		dst[out++] = (char) (offset >> 8);
+		if (ml >= 15)
+			out += write_len(dst + out, ml);
+	}
+	dst[token_loc] = (char) token;
+	return out;
+}
+
+int lz_compress(const char *src, int src_size, char *dst, int capacity)
+{
+	int table[1 << HASH_LOG];
+	memset(table, 0xff, sizeof(table));
+
+	int anchor = 0;
+	int out = 0;
+	int pos = 0;
+	while (pos < src_size - MATCH_LIMIT) {
+		uint32_t seq = read32(src + pos);
+		int h = hash32(seq);
+		int ref = table[h];
+		table[h] = pos;
+		if (ref < 0 || pos - ref > MAX_OFFSET || read32(src + ref) != seq) {
+			// We skip faster if we can't find matches for a while,
+			// so incompressible data doesn't cost much.
+			pos += 1 + ((pos - anchor) >> 6);
+			continue;
+		}
+
+		while (pos > anchor && ref > 0 && src[pos - 1] == src[ref - 1]) {
+			pos--;
+			ref--;
+		}
+		int len = MIN_MATCH;
+		while (pos + len < src_size - LAST_LITERALS
+				&& src[pos + len] == src[ref + len])
+			len++;
+		out = write_sequence(dst, out, capacity, src + anchor, pos - anchor,
+				pos - ref, len);
+		if (out < 0)
+			return 0;
+		pos += len;
+		anchor = pos;
+	}
+	out = write_sequence(dst, out, capacity, src + anchor, src_size - anchor,
+			0, 0);
+	return out < 0 ? 0 : out;
+}
+
+/*
+ * Read the extra bytes of a length. It returns -1 if the length
+ * is corrupted.
+ */
+static inline int read_len(const unsigned char *src, int src_size, int &ip)
+{
+	int len = 15;
+	unsigned char b;
+	do {
+		if (ip >= src_size)
+			return -1;
+		b = src[ip++];
+		len += b;
+	} while (b == 255);
+	return len;
+}
+
+int lz_decompress(const char *src, int src_size, char *dst, int capacity)
+{
+	const unsigned char *in = (const unsigned char *) src;
+	int ip = 0;
+	int op = 0;
+	while (ip < src_size) {
+		unsigned char token = in[ip++];
+		int num_lits = token >> 4;
+		if (num_lits == 15 && (num_lits = read_len(in, src_size, ip)) < 0)
+			return -1;
+		if (ip + num_lits > src_size || op + num_lits > capacity)
+			return -1;
+		memcpy(dst + op, src + ip, num_lits);
+		ip += num_lits;
+		op += num_lits;
+		// The last sequence only has literals.
+		if (ip == src_size)
+			break;
+
+		if (ip + 2 > src_size)
+			return -1;
+		int offset = in[ip] | (in[ip + 1] << 8);
+		ip += 2;
+		int match_len = token & 15;
+		if (match_len == 15 && (match_len = read_len(in, src_size, ip)) < 0)
+			return -1;
+		match_len += MIN_MATCH;
+		if (offset == 0 || offset > op || op + match_len > capacity)
+			return -1;
+		// The match may overlap with the data it generates.
+		const char *match = dst + op - offset;
+		if (offset >= match_len)
+			memcpy(dst + op, match, match_len);
+		else
+			for (int i = 0; i < match_len; i++)
+				dst[op + i] = match[i];
+		op += match_len;
+	}
+	return op;
+}
@@ -0,0 +1,51 @@
+#ifndef __LZ_CODEC_H__
+#define __LZ_CODEC_H__
+
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * This is a fast LZ77 codec that uses the block format of LZ4. It's
+ * designed for compressing pages in memory, so it trades compression
+ * ratio for speed and decompresses at the speed of memory copy.
+ */
+
+/**
+ * The maximal size of the compressed data of `size' bytes.
+ */
+static inline int lz_compress_bound(int size)
+{
+	return size + size / 255 + 16;
+}
+
+/**
+ * Compress `src_size' bytes in `src' to `dst'.
+ * \return the size of the compressed data or 0 if it doesn't fit
+ * in `capacity' bytes.
+ */
+int lz_compress(const char *src, int src_size, char *dst, int capacity);
+
+/**
+ * Decompress `src_size' bytes in `src' to `dst'.
+ * \return the size of the decompressed data or -1 if the compressed
+ * data is corrupted or the decompressed data doesn't fit in `capacity' bytes.
+ */
+int lz_decompress(const char *src, int src_size, char *dst, int capacity);
+
+#endif
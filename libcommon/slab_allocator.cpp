@@ -155,6 +155,7 @@ int slab_allocator::alloc(char **objs, int nobjs) {
 			list.add_list(&tmp_list);
 			if (thread_safe)
 				pthread_spin_unlock(&lock);
+			add_chunk(objs, increase_size);
 		}
 		else {
 			if (thread_safe)
@@ -165,6 +165,13 @@ private:
 #ifdef MEMCHECK
 	aligned_allocator allocator;
 #endif
+protected:
+	/**
+	 * This is invoked every time the allocator gets a new memory chunk
+	 * from the system.
+	 */
+	virtual void add_chunk(char *buf, long size) {
+	}
 public:
 	slab_allocator(const std::string &name, int _obj_size, long _increase_size,
 			// We allow pages to be pinned when allocated.
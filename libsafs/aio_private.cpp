@@ -23,10 +23,12 @@
 
 #include "aio_private.h"
 #include "messaging.h"
+#include "log.h"
 #include "read_private.h"
 #include "file_partition.h"
 #include "slab_allocator.h"
 #include "virt_aio_ctx.h"
+#include "uring_aio_ctx.h"
 
 template class blocking_FIFO_queue<thread_callback_s *>;
 
@@ -49,6 +51,9 @@ struct thread_callback_s
 	callback_allocator *cb_allocator;
 	io_request req;
 	struct iovec vec[MAX_MULTI_BUFS];
+	// The requests merged into the same vectored request are linked here.
+	// Only the first of them is submitted to the AIO context.
+	thread_callback_s *next;
 };
 
 class virt_data_impl: public virt_data
@@ -121,17 +126,28 @@ public:
 void aio_callback(io_context_t ctx, struct iocb* iocb[],
 		void *cbs[], long res[], long res2[], int num) {
 	async_io *aio = NULL;
-	thread_callback_s *tcbs[num];
+	// A completed vectored request may contain multiple requests
+	// if they were merged.
+	int num_tcbs = 0;
+	for (int i = 0; i < num; i++) {
+		for (thread_callback_s *tcb = (thread_callback_s *) cbs[i];
+				tcb; tcb = tcb->next)
+			num_tcbs++;
+	}
+	thread_callback_s *tcbs[num_tcbs];
+	num_tcbs = 0;
 	for (int i = 0; i < num; i++) {
 		assert(res2[i] == 0);
-		tcbs[i] = (thread_callback_s *) cbs[i];
+		thread_callback_s *tcb = (thread_callback_s *) cbs[i];
 		if (aio == NULL)
-			aio = tcbs[i]->aio;
+			aio = tcb->aio;
 		// This is true when disks are only accessed by disk access threads.
-		assert(aio == tcbs[i]->aio);
+		assert(aio == tcb->aio);
+		for (; tcb; tcb = tcb->next)
+			tcbs[num_tcbs++] = tcb;
 	}
 
-	aio->return_cb(tcbs, num);
+	aio->return_cb(tcbs, num_tcbs);
 }
 
 async_io::async_io(const logical_file_partition &partition,
@@ -144,9 +160,24 @@ async_io::async_io(const logical_file_partition &partition,
 	buf_idx = 0;
 
 	data = NULL;
+	open_flags = O_DIRECT | flags;
 	if (params.is_use_virt_aio()) {
 		data = new virt_data_impl();
 		ctx = new virt_aio_ctx(data, node_id, AIO_DEPTH);
+		// The SSD model decides the performance, so the data in the files
+		// should be served from the Linux page cache instead of the disks.
+		if (!params.get_ssd_model_file().empty())
+			open_flags = flags;
+	}
+	else if (params.is_use_io_uring()) {
+		ctx = uring_aio_ctx::create(node_id, AIO_DEPTH);
+		if (ctx == NULL) {
+			BOOST_LOG_TRIVIAL(warning)
+				<< "io_uring isn't available, use Linux AIO instead";
+			ctx = new aio_ctx_impl(node_id, AIO_DEPTH);
+		}
+		else if (params.is_buffered_io())
+			open_flags = flags;
 	}
 	else
 		ctx = new aio_ctx_impl(node_id, AIO_DEPTH);
@@ -154,10 +185,11 @@ async_io::async_io(const logical_file_partition &partition,
 	cb = NULL;
 	num_iowait = 0;
 	num_completed_reqs = 0;
-	open_flags = flags;
+	num_merged_reqs = 0;
+	num_coalesced_reqs = 0;
 	if (partition.is_active()) {
 		int file_id = partition.get_file_id();
-		buffered_io *io = new buffered_io(partition, t, O_DIRECT | flags);
+		buffered_io *io = new buffered_io(partition, t, open_flags);
 		default_io = io;
 		open_files.insert(std::pair<int, buffered_io *>(file_id, io));
 		if (data)
@@ -211,6 +243,7 @@ struct iocb *async_io::construct_req(io_request &io_req, callback_t cb_func)
 	tcb->req = io_req;
 	tcb->aio = this;
 	tcb->cb_allocator = cb_allocator;
+	tcb->next = NULL;
 
 	assert(tcb->req.get_size() >= MIN_BLOCK_SIZE);
 	assert(tcb->req.get_size() % MIN_BLOCK_SIZE == 0);
@@ -252,6 +285,138 @@ struct iocb *async_io::construct_req(io_request &io_req, callback_t cb_func)
 	}
 }
 
+buffered_io *async_io::get_file(int file_id) const
+{
+	std::tr1::unordered_map<int, buffered_io *>::const_iterator it
+		= open_files.find(file_id);
+	assert(it != open_files.end());
+	assert(it->second);
+	return it->second;
+}
+
+/*
+ * Two requests can be merged if the second one starts where the first one
+ * ends in the same physical file. Since the file is striped, the two
+ * requests also have to be in the same RAID block.
+ */
+bool async_io::can_merge(const io_request &req1, const io_request &req2) const
+{
+	if (req1.get_file_id() != req2.get_file_id()
+			|| req1.get_access_method() != req2.get_access_method()
+			|| req1.get_offset() + req1.get_size() != req2.get_offset()
+			|| req1.get_offset() % PAGE_SIZE != 0
+			|| req1.get_size() % PAGE_SIZE != 0)
+		return false;
+
+	buffered_io *io = get_file(req1.get_file_id());
+	block_identifier bid1, bid2;
+	io->get_partition().map(req1.get_offset() / PAGE_SIZE, bid1);
+	io->get_partition().map(req2.get_offset() / PAGE_SIZE, bid2);
+	return bid1.idx == bid2.idx
+		&& (bid1.off * PAGE_SIZE + req1.get_size()) == bid2.off * PAGE_SIZE;
+}
+
+/*
+ * Construct a vectored request that reads or writes the buffers of all
+ * requests. Each request still gets its own callback structure, so it is
+ * completed individually.
+ */
+struct iocb *async_io::construct_merged_req(io_request *reqs[], int num,
+		callback_t cb_func)
+{
+	assert(num > 0);
+	thread_callback_s *tcbs[num];
+	// The I/O vector is stored in the callback structure of the first request.
+	thread_callback_s *head = NULL;
+	int num_bufs = 0;
+	for (int i = 0; i < num; i++) {
+		thread_callback_s *tcb = cb_allocator->alloc_obj();
+		tcb->cb.func = cb_func;
+		tcb->req = *reqs[i];
+		tcb->aio = this;
+		tcb->cb_allocator = cb_allocator;
+		tcb->next = NULL;
+		if (i > 0)
+			tcbs[i - 1]->next = tcb;
+		else
+			head = tcb;
+		tcbs[i] = tcb;
+
+		assert(tcb->req.get_offset() % MIN_BLOCK_SIZE == 0);
+		for (int j = 0; j < tcb->req.get_num_bufs(); j++) {
+			assert((long) tcb->req.get_buf(j) % MIN_BLOCK_SIZE == 0);
+			assert(tcb->req.get_buf_size(j) % MIN_BLOCK_SIZE == 0);
+		}
+		num_bufs += tcb->req.get_num_bufs();
+	}
+	assert(num_bufs <= MAX_MULTI_BUFS);
+
+	int vec_idx = 0;
+	for (int i = 0; i < num; i++) {
+		int num_req_bufs = tcbs[i]->req.get_num_bufs();
+		BOOST_VERIFY(tcbs[i]->req.get_vec(head->vec + vec_idx,
+					num_req_bufs) == num_req_bufs);
+		vec_idx += num_req_bufs;
+	}
+
+	int io_type = head->req.get_access_method() == READ ? A_READ : A_WRITE;
+	buffered_io *io = get_file(head->req.get_file_id());
+	block_identifier bid;
+	io->get_partition().map(head->req.get_offset() / PAGE_SIZE, bid);
+	num_merged_reqs += num;
+	num_coalesced_reqs++;
+	return ctx->make_iovec_request(io->get_fd(head->req.get_offset()),
+			head->vec, num_bufs, bid.off * PAGE_SIZE, io_type,
+			(io_callback_s *) head);
+}
+
+int async_io::access_coalesced(io_request *requests, int num, int max_iocbs)
+{
+	ASSERT_EQ(get_thread(), thread::get_curr_thread());
+	int idx = 0;
+	while (idx < num && max_iocbs > 0) {
+		int slot = ctx->max_io_slot();
+		if (slot == 0) {
+			num_iowait++;
+			ctx->io_wait(NULL, 1);
+			continue;
+		}
+		slot = min(slot, max_iocbs);
+		struct iocb *reqs[slot];
+		int num_iocb = 0;
+		while (num_iocb < slot && idx < num) {
+			assert(requests[idx].get_io());
+			int end = idx + 1;
+			int num_bufs = requests[idx].get_num_bufs();
+			while (end < num && can_merge(requests[end - 1], requests[end])
+					&& num_bufs + requests[end].get_num_bufs() <= MAX_MULTI_BUFS) {
+				num_bufs += requests[end].get_num_bufs();
+				end++;
+			}
+
+			struct iocb *req;
+			if (end - idx == 1)
+				req = construct_req(requests[idx], aio_callback);
+			else {
+				io_request *merged[end - idx];
+				for (int i = idx; i < end; i++)
+					merged[i - idx] = &requests[i];
+				req = construct_merged_req(merged, end - idx, aio_callback);
+			}
+			idx = end;
+			if (req)
+				reqs[num_iocb++] = req;
+			else
+				// construct_req has submitted the request itself.
+				break;
+		}
+		if (num_iocb > 0)
+			ctx->submit_io_request(reqs, num_iocb);
+		max_iocbs -= num_iocb;
+	}
+	return idx;
+}
+
 void async_io::access(io_request *requests, int num, io_status *status)
 {
 	ASSERT_EQ(get_thread(), thread::get_curr_thread());
@@ -421,7 +586,7 @@ int async_io::open_file(const logical_file_partition &partition)
 	int file_id = partition.get_file_id();
 	if (open_files.find(file_id) == open_files.end()) {
 		buffered_io *io = new buffered_io(partition, get_thread(),
-				O_DIRECT | open_flags);
+				open_flags);
 		open_files.insert(std::pair<int, buffered_io *>(file_id, io));
 		if (data)
 			data->add_new_file(io);
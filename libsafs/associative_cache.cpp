@@ -19,6 +19,7 @@
 
 #include <errno.h>
 #include <limits.h>
+#include <unistd.h>
 
 #include <algorithm>
 
@@ -320,9 +321,13 @@ page *hash_cell::search(const page_id_t &pg_id)
  * search for a page with the offset.
  * If the page doesn't exist, return an empty page.
  */
-page *hash_cell::search(const page_id_t &pg_id, page_id_t &old_id)
+page *hash_cell::search(const page_id_t &pg_id, page_id_t &old_id,
+		bool access)
 {
 	thread_safe_page *ret = NULL;
+	// The data of the clean page evicted from the cell.
+	char evicted_data[PAGE_SIZE];
+	bool has_evicted_data = false;
 	pthread_spin_lock(&_lock);
 	num_accesses++;
 
@@ -340,6 +345,13 @@ page *hash_cell::search(const page_id_t &pg_id, page_id_t &old_id)
 			pthread_spin_unlock(&_lock);
 			return NULL;
 		}
+		// Once we unlock the cell, the page may be overwritten by a read,
+		// so we save its data for the compressed page cache.
+		if (table->comp_cache && ret->data_ready() && !ret->is_dirty()
+				&& !ret->is_old_dirty()) {
+			memcpy(evicted_data, ret->get_data(), PAGE_SIZE);
+			has_evicted_data = true;
+		}
 		// We need to clear flags here.
 		ret->set_data_ready(false);
 		assert(!ret->is_io_pending());
@@ -366,6 +378,7 @@ page *hash_cell::search(const page_id_t &pg_id, page_id_t &old_id)
 		 * it might not have data ready.
 		 */
 		ret->set_id(pg_id);
+		policy.insert_page(ret, buf);
 #ifdef USE_SHADOW_PAGE
 		shadow_page shadow_pg = shadow.search(off);
 		/*
@@ -376,18 +389,22 @@ page *hash_cell::search(const page_id_t &pg_id, page_id_t &old_id)
 			ret->set_hits(shadow_pg.get_hits());
 #endif
 	}
-	else
+	else if (access)
 		policy.access_page(ret, buf);
 	/* it's possible that the data in the page isn't ready */
 	ret->inc_ref();
-	if (ret->get_hits() == 0xff) {
-		buf.scale_down_hits();
+	if (access) {
+		if (ret->get_hits() == 0xff) {
+			buf.scale_down_hits();
 #ifdef USE_SHADOW_PAGE
-		shadow.scale_down_hits();
+			shadow.scale_down_hits();
 #endif
+		}
+		ret->hit();
 	}
-	ret->hit();
 	pthread_spin_unlock(&_lock);
+	if (has_evicted_data)
+		table->comp_cache->add(old_id, evicted_data);
 #ifdef DEBUG
 	if (enable_debug && ret->is_old_dirty())
 		print_cell();
@@ -409,7 +426,11 @@ void hash_cell::print_cell()
 	pthread_spin_unlock(&_lock);
 }
 
-/* this function has to be called with lock held */
+/*
+ * this function has to be called with lock held.
+ * The eviction policy doesn't clear the flags of the evicted page,
+ * so the invoker can still tell if the page contains valid data.
+ */
 thread_safe_page *hash_cell::get_empty_page()
 {
 	thread_safe_page *ret = policy.evict_page(buf);
@@ -448,7 +469,6 @@ thread_safe_page *LRU_eviction_policy::evict_page(
 	thread_safe_page *ret = buf.get_page(pos);
 	while (ret->get_ref()) {}
 	pos_vec.push_back(pos);
-	ret->set_data_ready(false);
 	return ret;
 }
 
@@ -507,7 +527,6 @@ thread_safe_page *LFU_eviction_policy::evict_page(
 		}
 		/* it happens when all pages in the cell is used currently. */
 	} while (ret == NULL);
-	ret->set_data_ready(false);
 	ret->reset_hits();
 	return ret;
 }
@@ -524,10 +543,160 @@ thread_safe_page *FIFO_eviction_policy::evict_page(
 	while (ret->get_ref()) {
 		ret = buf.get_empty_page();
 	}
-	ret->set_data_ready(false);
 	return ret;
 }
 
+/**
+ * Move the clock hand of the small queue to find a page to evict.
+ * A page accessed again is moved to the main queue. If `min_small' is
+ * positive, we stop looking once the small queue shrinks below it, so
+ * the main queue takes over. It returns NULL if no page in the small
+ * queue can be evicted.
+ */
+thread_safe_page *S3FIFO_eviction_policy::evict_small(
+		page_cell<thread_safe_page> &buf, unsigned int &num_small,
+		unsigned int min_small, bool avoid_dirty)
+{
+	const unsigned int num_pages = buf.get_num_pages();
+	// Each page in the small queue is visited at most once.
+	for (unsigned int i = 0; i < num_pages && num_small >= min_small; i++) {
+		thread_safe_page *pg = buf.get_page(small_head % num_pages);
+		small_head++;
+		if (!in_small_queue(pg) || pg->get_ref()
+				|| (avoid_dirty && pg->is_dirty()))
+			continue;
+
+		// The page has been accessed after it was added to the cell.
+		if (pg->get_hits() > 1) {
+			pg->set_active(true);
+			pg->reset_hits();
+			num_small--;
+			continue;
+		}
+		ghost.add(shadow_page(*pg));
+		pg->set_active(false);
+		pg->reset_hits();
+		return pg;
+	}
+	return NULL;
+}
+
+/**
+ * Move the clock hand of the main queue to find a page to evict.
+ * It returns NULL if no page in the main queue can be evicted.
+ */
+thread_safe_page *S3FIFO_eviction_policy::evict_main(
+		page_cell<thread_safe_page> &buf, bool avoid_dirty)
+{
+	const unsigned int num_pages = buf.get_num_pages();
+	/*
+	 * A page in the main queue is skipped at most MAX_FREQ times,
+	 * so we visit each page one more time than that.
+	 */
+	const unsigned int max_steps = num_pages * (MAX_FREQ + 1);
+	for (unsigned int i = 0; i < max_steps; i++) {
+		thread_safe_page *pg = buf.get_page(main_head % num_pages);
+		main_head++;
+		if (in_small_queue(pg) || pg->get_ref()
+				|| (avoid_dirty && pg->is_dirty()))
+			continue;
+
+		if (pg->get_hits() > 0) {
+			int hits = pg->get_hits();
+			pg->set_hits((hits > MAX_FREQ ? MAX_FREQ : hits) - 1);
+			continue;
+		}
+		pg->set_active(false);
+		pg->reset_hits();
+		return pg;
+	}
+	return NULL;
+}
+
+thread_safe_page *S3FIFO_eviction_policy::evict_page(
+		page_cell<thread_safe_page> &buf)
+{
+	const unsigned int num_pages = buf.get_num_pages();
+	unsigned int num_small = 0;
+	for (unsigned int i = 0; i < num_pages; i++) {
+		thread_safe_page *pg = buf.get_page(i);
+		// Empty pages are always evicted first.
+		if (!pg->is_valid() && pg->get_ref() == 0) {
+			pg->set_active(false);
+			pg->reset_hits();
+			return pg;
+		}
+		if (in_small_queue(pg))
+			num_small++;
+	}
+	unsigned int small_size = std::max(1U,
+			num_pages * SMALL_QUEUE_PERCENT / 100);
+
+	/*
+	 * We pick the queue by its size. The pages in the chosen queue can all
+	 * be referenced (e.g., new pages in the small queue wait for their
+	 * reads), so we fall back to the other queue. We try to avoid dirty
+	 * pages in the first round, and we return NULL only when all pages
+	 * in the cell are referenced.
+	 */
+	for (int round = 0; round < 2; round++) {
+		bool avoid_dirty = round == 0;
+		thread_safe_page *pg = NULL;
+		if (num_small >= small_size || num_small == num_pages) {
+			pg = evict_small(buf, num_small, small_size, avoid_dirty);
+			if (pg == NULL)
+				pg = evict_main(buf, avoid_dirty);
+		}
+		else
+			pg = evict_main(buf, avoid_dirty);
+		// The small queue may promote pages to the main queue, so we try
+		// the main queue again afterwards.
+		if (pg == NULL)
+			pg = evict_small(buf, num_small, 0, avoid_dirty);
+		if (pg == NULL)
+			pg = evict_main(buf, avoid_dirty);
+		if (pg)
+			return pg;
+	}
+	return NULL;
+}
+
+void S3FIFO_eviction_policy::insert_page(thread_safe_page *pg,
+		page_cell<thread_safe_page> &buf)
+{
+	shadow_page shadow_pg = ghost.search(pg->get_offset());
+	pg->set_active(shadow_pg.is_valid());
+}
+
+/**
+ * The pages that will be evicted first are the ones in the small queue
+ * that haven't been accessed again, followed by the ones in the main queue
+ * that haven't been accessed recently, each in the order of the clock hand.
+ */
+int S3FIFO_eviction_policy::predict_evicted_pages(
+		page_cell<thread_safe_page> &buf, int num_pages, int set_flags,
+		int clear_flags, std::map<off_t, thread_safe_page *> &pages)
+{
+	const int num_cell_pages = buf.get_num_pages();
+	for (int k = 0; k < 2; k++) {
+		bool small = k == 0;
+		unsigned int head = small ? small_head : main_head;
+		for (int i = 0; i < num_cell_pages; i++) {
+			thread_safe_page *p = buf.get_page((head + i) % num_cell_pages);
+			if (!p->is_valid() || in_small_queue(p) != small
+					|| p->get_hits() > (small ? 1 : 0))
+				continue;
+			if (p->test_flags(set_flags) && !p->test_flags(clear_flags)) {
+				pages.insert(std::pair<off_t, thread_safe_page *>(
+							p->get_offset(), p));
+				if ((int) pages.size() == num_pages)
+					return pages.size();
+			}
+		}
+	}
+	return pages.size();
+}
+
 struct page_score
 {
 	thread_safe_page *pg;
@@ -598,7 +767,6 @@ thread_safe_page *gclock_eviction_policy::evict_page(
 		}
 		pg->set_hits(pg->get_hits() - 1);
 	} while (ret == NULL);
-	ret->set_data_ready(false);
 #if 0
 	assign_flush_scores(buf);
 #endif
@@ -690,7 +858,6 @@ thread_safe_page *clock_eviction_policy::evict_page(
 		pg->reset_hits();
 		clock_head++;
 	} while (ret == NULL);
-	ret->set_data_ready(false);
 	ret->reset_hits();
 	return ret;
 }
@@ -702,6 +869,8 @@ associative_cache::~associative_cache()
 			hash_cell::destroy_array(cells_table[i], init_ncells);
 	manager->unregister_cache(this);
 	memory_manager::destroy(manager);
+	if (comp_cache)
+		compressed_page_cache::destroy(comp_cache);
 }
 
 bool associative_cache::shrink(int npages, char *pages[])
@@ -936,6 +1105,13 @@ page *associative_cache::search(const page_id_t &pg_id, page_id_t &old_id) {
 	} while (true);
 }
 
+page *associative_cache::prefetch(const page_id_t &pg_id, page_id_t &old_id)
+{
+	do {
+		return get_cell_offset(pg_id)->search(pg_id, old_id, false);
+	} while (true);
+}
+
 page *associative_cache::search(const page_id_t &pg_id)
 {
 	do {
@@ -957,6 +1133,29 @@ int associative_cache::get_num_used_pages() const
 	return npages;
 }
 
+void associative_cache::get_cached_pages(
+		std::vector<cached_page_info> &pages) const
+{
+	unsigned long count;
+	size_t orig_size = pages.size();
+	do {
+		// The table may be expanded while we go through the cells.
+		pages.resize(orig_size);
+		table_lock.read_lock(count);
+		int ncells = get_num_cells();
+		for (int i = 0; i < ncells; i++)
+			get_cell(i)->get_cached_pages(pages);
+	} while (!table_lock.read_unlock(count));
+}
+
+bool associative_cache::load_compressed_page(const page_id_t &pg_id,
+		char *buf)
+{
+	if (comp_cache == NULL)
+		return false;
+	return comp_cache->fetch(pg_id, buf);
+}
+
 void associative_cache::sanity_check() const
 {
 	unsigned long count;
@@ -988,6 +1187,15 @@ associative_cache::associative_cache(long cache_size, long max_cache_size,
 	this->expandable = expandable;
 	this->manager = memory_manager::create(max_cache_size, node_id);
 	manager->register_cache(this);
+	comp_cache = NULL;
+	// The cache gets the part of the compressed page cache in proportion
+	// to its size. The compressed pages aren't updated by writes, so it's
+	// only used for read-only data.
+	if (params.get_comp_cache_size() > 0 && !params.is_writable()) {
+		long comp_size = (double) params.get_comp_cache_size() * cache_size
+			/ params.get_cache_size();
+		comp_cache = compressed_page_cache::create(comp_size, node_id);
+	}
 	long init_cache_size = default_init_cache_size;
 	if (init_cache_size > cache_size
 			// If the cache isn't expandable, let's just use the maximal
@@ -1072,6 +1280,20 @@ public:
 
 class associative_flusher;
 
+/*
+ * In the write-combining mode, the flusher writes back the dirty pages
+ * of this many cells in a batch.
+ */
+const int COMBINE_FLUSH_CELLS = 64;
+/*
+ * In the write-combining mode, a writer is throttled when more than
+ * 1/THROTTLE_DIRTY_CELLS_RATIO of the cells are waiting to be flushed.
+ * A writer waits for at most MAX_THROTTLE_US each time it's throttled.
+ */
+const int THROTTLE_DIRTY_CELLS_RATIO = 4;
+const long THROTTLE_INTERVAL_US = 100;
+const long MAX_THROTTLE_US = 10000;
+
 class flush_io: public io_interface
 {
 	io_interface::ptr underlying;
@@ -1128,6 +1350,20 @@ class associative_flusher: public dirty_page_flusher
 
 	std::unique_ptr<flush_io> io;
 	std::unique_ptr<select_dirty_pages_policy> policy;
+
+	atomic_long num_flushed_pages;
+	atomic_long num_discarded_flushes;
+	atomic_long num_throttles;
+	atomic_long tot_throttle_time;	// in us
+	// The time when the first flush completes and the last flush completes.
+	atomic_long first_complete_time;	// in us
+	atomic_long last_complete_time;	// in us
+
+	int flush_cells(hash_cell *cells[], int num_cells, io_interface *io,
+			bool full[]);
+	void combine_dirty_pages(thread_safe_page *pages[], int num,
+			io_interface *io);
+	void throttle();
 public:
 	thread_safe_FIFO_queue<hash_cell *> dirty_cells;
 	associative_flusher(page_cache *cache, associative_cache *local_cache,
@@ -1153,6 +1389,18 @@ public:
 			io_interface *io);
 	int flush_dirty_pages(page_filter *filter, int max_num);
 	int flush_cell(hash_cell *cell, io_request *req_array, int req_array_size);
+
+	void complete_flushes(int num_pages, int num_discarded) {
+		long curr = get_curr_us();
+		first_complete_time.CAS(0, curr);
+		long last = last_complete_time.get();
+		if (curr > last)
+			last_complete_time.CAS(last, curr);
+		num_flushed_pages.inc(num_pages);
+		num_discarded_flushes.inc(num_discarded);
+	}
+
+	void print_stat() const;
 };
 
 void flush_io::notify_completion(io_request *reqs[], int num)
@@ -1160,6 +1408,8 @@ void flush_io::notify_completion(io_request *reqs[], int num)
 	hash_cell *dirty_cells[num];
 	int num_dirty_cells = 0;
 	int num_flushes = 0;
+	int num_flushed_pages = 0;
+	int num_discarded = 0;
 	for (int i = 0; i < num; i++) {
 		// If the request is discarded by the I/O thread, we need to
 		// check the page set where it is located.
@@ -1167,6 +1417,7 @@ void flush_io::notify_completion(io_request *reqs[], int num)
 		// we need to check if the page set contains pages that
 		// we should flush.
 		if (reqs[i]->is_discarded()) {
+			num_discarded++;
 			page_id_t pg_id(reqs[i]->get_file_id(), reqs[i]->get_offset());
 			hash_cell *cell = cache->get_cell_offset(pg_id);
 #ifdef DEBUG
@@ -1198,6 +1449,7 @@ void flush_io::notify_completion(io_request *reqs[], int num)
 		}
 
 		assert(reqs[i]->get_num_bufs());
+		num_flushed_pages += reqs[i]->get_num_bufs();
 		if (reqs[i]->get_num_bufs() == 1) {
 			thread_safe_page *p = (thread_safe_page *) reqs[i]->get_page(0);
 			p->lock();
@@ -1227,6 +1479,9 @@ void flush_io::notify_completion(io_request *reqs[], int num)
 
 		delete reqs[i]->get_extension();
 	}
+#ifdef STATISTICS
+	flusher->complete_flushes(num_flushed_pages, num_discarded);
+#endif
 	if (num_dirty_cells > 0)
 		flusher->dirty_cells.add(dirty_cells, num_dirty_cells);
 	if (num_flushes > 0)
@@ -1316,6 +1571,122 @@ int associative_flusher::flush_cell(hash_cell *cell,
 	return num_init_reqs;
 }
 
+/**
+ * This flushes the dirty pages in multiple cells with a single batch of
+ * requests. The requests are sorted by their locations in the files, so
+ * the flushes of contiguous pages, which are spread over many cells,
+ * arrive at the I/O threads next to each other and are merged into large
+ * writes there. `full' indicates whether we get as many dirty pages
+ * as we ask for from a cell, so the cell may have more dirty pages.
+ */
+int associative_flusher::flush_cells(hash_cell *cells[], int num_cells,
+		io_interface *io, bool full[])
+{
+	stack_array<io_request> req_array(num_cells * NUM_WRITEBACK_DIRTY_PAGES);
+	int num_reqs = 0;
+	for (int i = 0; i < num_cells; i++) {
+		int ret = flush_cell(cells[i], req_array.data() + num_reqs,
+				NUM_WRITEBACK_DIRTY_PAGES);
+		num_reqs += ret;
+		full[i] = ret == NUM_WRITEBACK_DIRTY_PAGES;
+	}
+	if (num_reqs > 0) {
+		std::sort(req_array.data(), req_array.data() + num_reqs,
+				comp_req_offset());
+		io->access(req_array.data(), num_reqs);
+	}
+	return num_reqs;
+}
+
+/**
+ * Writers are throttled if the flusher can't keep up with them.
+ * A writer waits until enough dirty cells have been flushed, but not
+ * forever, in case the I/O threads are busy with high-prio requests.
+ */
+void associative_flusher::throttle()
+{
+	int max_dirty_cells = local_cache->get_num_cells()
+		/ THROTTLE_DIRTY_CELLS_RATIO;
+	if (dirty_cells.get_num_entries() <= max_dirty_cells)
+		return;
+
+	long start = get_curr_us();
+	long waited = 0;
+	while (dirty_cells.get_num_entries() > max_dirty_cells
+			&& waited < MAX_THROTTLE_US) {
+		usleep(THROTTLE_INTERVAL_US);
+		waited = get_curr_us() - start;
+	}
+	num_throttles.inc(1);
+	tot_throttle_time.inc(waited);
+}
+
+/**
+ * In the write-combining mode, a writer puts the cells with dirty pages
+ * in the queue instead of flushing them right away, and flushes a batch of
+ * cells from the queue if there aren't many pending flushes.
+ */
+void associative_flusher::combine_dirty_pages(thread_safe_page *pages[],
+		int num, io_interface *io)
+{
+	hash_cell *cells[num];
+	int num_queued_cells = 0;
+	char dirty_flag = 0;
+	char skip_flags = 0;
+	page_set_flag(dirty_flag, DIRTY_BIT, true);
+	page_set_flag(skip_flags, IO_PENDING_BIT, true);
+	page_set_flag(skip_flags, PREPARE_WRITEBACK, true);
+	for (int i = 0; i < num; i++) {
+		page_id_t pg_id(pages[i]->get_file_id(), pages[i]->get_offset());
+		hash_cell *cell = local_cache->get_cell_offset(pg_id);
+		if (cell->num_pages(dirty_flag, skip_flags) > DIRTY_PAGES_THRESHOLD
+				&& !cell->set_in_queue(true))
+			cells[num_queued_cells++] = cell;
+	}
+	if (num_queued_cells > 0)
+		dirty_cells.add(cells, num_queued_cells);
+
+	// We wait until there are enough dirty cells to form a batch.
+	// The remaining dirty cells are flushed by the I/O threads when
+	// they are idle.
+	if (local_cache->num_pending_flush.get()
+			< local_cache->max_num_pending_flush
+			&& dirty_cells.get_num_entries() >= COMBINE_FLUSH_CELLS) {
+		hash_cell *batch[COMBINE_FLUSH_CELLS];
+		hash_cell *queue_cells[COMBINE_FLUSH_CELLS];
+		bool full[COMBINE_FLUSH_CELLS];
+		int num_fetches = dirty_cells.fetch(batch, COMBINE_FLUSH_CELLS);
+		int num_flushes = flush_cells(batch, num_fetches, io, full);
+		num_queued_cells = 0;
+		for (int i = 0; i < num_fetches; i++) {
+			if (full[i])
+				queue_cells[num_queued_cells++] = batch[i];
+			else
+				batch[i]->set_in_queue(false);
+		}
+		dirty_cells.add(queue_cells, num_queued_cells);
+		if (num_flushes > 0)
+			local_cache->num_pending_flush.inc(num_flushes);
+	}
+	throttle();
+}
+
+void associative_flusher::print_stat() const
+{
+#ifdef STATISTICS
+	long secs_us = last_complete_time.get() - first_complete_time.get();
+	printf("\tflush %ld pages, discard %ld flushes", num_flushed_pages.get(),
+			num_discarded_flushes.get());
+	if (secs_us > 0)
+		printf(", %.2f MB/s", ((double) num_flushed_pages.get()) * PAGE_SIZE
+				/ secs_us);
+	printf("\n");
+#endif
+	if (num_throttles.get() > 0)
+		printf("\tthrottle writers %ld times, %ldus in total\n",
+				num_throttles.get(), tot_throttle_time.get());
+}
+
 /**
  * This will run until we get enough pending flushes.
  */
@@ -1325,22 +1696,32 @@ void associative_flusher::run()
 	// We can't get more requests than the number of pages in a cell.
 	io_request req_array[NUM_WRITEBACK_DIRTY_PAGES];
 	int tot_flushes = 0;
+	bool combine = params.is_write_combining();
+	const int fetch_size = combine ? COMBINE_FLUSH_CELLS : FETCH_BUF_SIZE;
 	while (dirty_cells.get_num_entries() > 0) {
-		hash_cell *cells[FETCH_BUF_SIZE];
-		hash_cell *tmp[FETCH_BUF_SIZE];
+		hash_cell *cells[fetch_size];
+		hash_cell *tmp[fetch_size];
+		bool full[fetch_size];
 		int num_dirty_cells = 0;
-		int num_fetches = dirty_cells.fetch(cells, FETCH_BUF_SIZE);
+		int num_fetches = dirty_cells.fetch(cells, fetch_size);
 		int num_flushes = 0;
-		for (int i = 0; i < num_fetches; i++) {
-			int ret = flush_cell(cells[i], req_array,
-					NUM_WRITEBACK_DIRTY_PAGES);
-			if (ret > 0) {
-				io->access(req_array, ret);
-				num_flushes += ret;
+		if (combine)
+			num_flushes = flush_cells(cells, num_fetches, io.get(), full);
+		else {
+			for (int i = 0; i < num_fetches; i++) {
+				int ret = flush_cell(cells[i], req_array,
+						NUM_WRITEBACK_DIRTY_PAGES);
+				if (ret > 0) {
+					io->access(req_array, ret);
+					num_flushes += ret;
+				}
+				full[i] = ret == NUM_WRITEBACK_DIRTY_PAGES;
 			}
+		}
+		for (int i = 0; i < num_fetches; i++) {
 			// If we get what we ask for, maybe there are more dirty pages
 			// we can flush. Add the dirty cell back in the queue.
-			if (ret == NUM_WRITEBACK_DIRTY_PAGES)
+			if (full[i])
 				tmp[num_dirty_cells++] = cells[i];
 			else {
 				// We can clear the in_queue flag now.
@@ -1450,6 +1831,21 @@ int hash_cell::num_pages(char set_flags, char clear_flags)
 	return num;
 }
 
+void hash_cell::get_cached_pages(std::vector<cached_page_info> &pages)
+{
+	pthread_spin_lock(&_lock);
+	for (unsigned int i = 0; i < buf.get_num_pages(); i++) {
+		thread_safe_page *p = buf.get_page(i);
+		if (p->data_ready() && p->initialized()) {
+			cached_page_info info;
+			info.pg_id = page_id_t(p->get_file_id(), p->get_offset());
+			info.score = p->get_hits();
+			pages.push_back(info);
+		}
+	}
+	pthread_spin_unlock(&_lock);
+}
+
 void hash_cell::predict_evicted_pages(int num_pages, char set_flags,
 		char clear_flags, std::map<off_t, thread_safe_page *> &pages)
 {
@@ -1496,6 +1892,11 @@ void associative_flusher::flush_dirty_pages(thread_safe_page *pages[],
 		return;
 	}
 
+	if (params.is_write_combining()) {
+		combine_dirty_pages(pages, num, io);
+		return;
+	}
+
 	hash_cell *cells[num];
 	int num_queued_cells = 0;
 	int num_flushes = 0;
@@ -1569,12 +1970,21 @@ int associative_flusher::flush_dirty_pages(page_filter *filter, int max_num)
 		int num_fetched_cells = dirty_cells.fetch(cells, num_cells);
 		if (num_fetched_cells == 0)
 			return num_flushes;
-		io_request req_array[NUM_WRITEBACK_DIRTY_PAGES];
+		bool full[num_fetched_cells];
+		if (params.is_write_combining())
+			num_flushes += flush_cells(cells, num_fetched_cells, io.get(), full);
+		else {
+			io_request req_array[NUM_WRITEBACK_DIRTY_PAGES];
+			for (int i = 0; i < num_fetched_cells; i++) {
+				int ret = flush_cell(cells[i], req_array,
+						NUM_WRITEBACK_DIRTY_PAGES);
+				io->access(req_array, ret);
+				num_flushes += ret;
+				full[i] = ret == NUM_WRITEBACK_DIRTY_PAGES;
+			}
+		}
 		for (int i = 0; i < num_fetched_cells; i++) {
-			int ret = flush_cell(cells[i], req_array, NUM_WRITEBACK_DIRTY_PAGES);
-			io->access(req_array, ret);
-			num_flushes += ret;
-			if (ret == NUM_WRITEBACK_DIRTY_PAGES)
+			if (full[i])
 				queue_cells[num_queued_cells++] = cells[i];
 			else
 				cells[i]->set_in_queue(false);
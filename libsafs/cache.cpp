@@ -25,6 +25,13 @@ void page_byte_array::memcpy(off_t rel_off, char buf[], size_t size) const
 	if (size == 0)
 		return;
 
+	const char *data = get_contiguous_data();
+	if (data) {
+		assert(rel_off + size <= get_size());
+		::memcpy(buf, data + rel_off, size);
+		return;
+	}
+
 	// The offset relative to the beginning of the page array.
 	off_t off = get_offset_in_first_page() + rel_off;
 	off_t end = off + size;
@@ -0,0 +1,211 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <numa.h>
+
+#include <boost/format.hpp>
+
+#include "log.h"
+#include "lz_codec.h"
+#include "compressed_cache.h"
+
+/*
+ * We don't keep a page if its compressed size is larger than this.
+ * The memory is better used by the SA-cache.
+ */
+static const int MAX_COMP_PAGE_SIZE = PAGE_SIZE * 3 / 4;
+/*
+ * The minimal size of a shard. It should be able to hold many pages.
+ */
+static const size_t MIN_SHARD_SIZE = 1024 * 1024;
+static const int MAX_NUM_SHARDS = 64;
+
+compressed_page_cache::shard::shard(char *log, size_t log_size)
+{
+	this->log = log;
+	this->log_size = log_size;
+	head = 0;
+	tail = 0;
+	num_bytes = 0;
+}
+
+/*
+ * Drop the oldest entry in the log.
+ */
+void compressed_page_cache::shard::drop_tail()
+{
+	assert(num_bytes > 0);
+	// The end of the log is too small for an entry, so it's skipped.
+	if (log_size - tail < sizeof(entry_header)) {
+		num_bytes -= log_size - tail;
+		tail = 0;
+		return;
+	}
+
+	entry_header *header = (entry_header *) (log + tail);
+	std::unordered_map<long, size_t>::iterator it = index.find(header->key);
+	// The page may have been fetched or added to the log again.
+	if (it != index.end() && it->second == tail)
+		index.erase(it);
+	num_bytes -= header->size;
+	tail += header->size;
+	if (tail == log_size)
+		tail = 0;
+}
+
+/*
+ * Allocate space in the log for an entry. It drops the oldest entries
+ * if there isn't enough space.
+ */
+size_t compressed_page_cache::shard::alloc_entry(size_t size)
+{
+	assert(size <= log_size);
+	while (true) {
+		if (num_bytes == 0) {
+			head = 0;
+			tail = 0;
+		}
+		// The used space is [tail, head).
+		if (head > tail || num_bytes == 0) {
+			if (log_size - head >= size)
+				break;
+			// Skip the end of the log and write from the beginning.
+			if (log_size - head >= sizeof(entry_header)) {
+				entry_header *header = (entry_header *) (log + head);
+				header->key = -1;
+				header->size = log_size - head;
+				header->comp_size = 0;
+			}
+			num_bytes += log_size - head;
+			head = 0;
+		}
+		// The used space is [tail, log_size) and [0, head).
+		else if (tail - head >= size)
+			break;
+		else
+			drop_tail();
+	}
+	size_t loc = head;
+	head += size;
+	num_bytes += size;
+	return loc;
+}
+
+void compressed_page_cache::shard::add(long key, const char *data,
+		int comp_size)
+{
+	size_t size = ROUNDUP(sizeof(entry_header) + comp_size,
+			sizeof(entry_header));
+	lock.lock();
+	// The old version of the page is dropped.
+	index.erase(key);
+	size_t loc = alloc_entry(size);
+	entry_header *header = (entry_header *) (log + loc);
+	header->key = key;
+	header->size = size;
+	header->comp_size = comp_size;
+	memcpy(header + 1, data, comp_size);
+	index[key] = loc;
+	lock.unlock();
+}
+
+bool compressed_page_cache::shard::fetch(long key, char *buf)
+{
+	lock.lock();
+	std::unordered_map<long, size_t>::iterator it = index.find(key);
+	if (it == index.end()) {
+		lock.unlock();
+		return false;
+	}
+	entry_header *header = (entry_header *) (log + it->second);
+	assert(header->key == key);
+	// The page has to be decompressed in the lock because its space
+	// in the log may be reused once we unlock it.
+	BOOST_VERIFY(lz_decompress((char *) (header + 1), header->comp_size,
+				buf, PAGE_SIZE) == PAGE_SIZE);
+	index.erase(it);
+	lock.unlock();
+	return true;
+}
+
+compressed_page_cache::compressed_page_cache(size_t size, int node_id)
+{
+	this->node_id = node_id;
+	int num_shards = std::min<size_t>(MAX_NUM_SHARDS,
+			std::max<size_t>(1, size / MIN_SHARD_SIZE));
+	size_t shard_size = ROUND(size / num_shards, PAGE_SIZE);
+	assert(shard_size > 0);
+	arena_size = shard_size * num_shards;
+	arena = (char *) numa_alloc_onnode(arena_size, node_id);
+	if (arena == NULL)
+		throw std::bad_alloc();
+	shards.resize(num_shards);
+	for (int i = 0; i < num_shards; i++)
+		shards[i] = new shard(arena + shard_size * i, shard_size);
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"create a compressed page cache of %1% bytes with %2% shards on node %3%")
+		% arena_size % num_shards % node_id;
+}
+
+compressed_page_cache::~compressed_page_cache()
+{
+	for (size_t i = 0; i < shards.size(); i++)
+		delete shards[i];
+	numa_free(arena, arena_size);
+}
+
+void compressed_page_cache::add(const page_id_t &pg_id, const char *data)
+{
+	char buf[lz_compress_bound(PAGE_SIZE)];
+	int comp_size = lz_compress(data, PAGE_SIZE, buf, MAX_COMP_PAGE_SIZE);
+	if (comp_size == 0) {
+		num_rejects.inc(1);
+		return;
+	}
+	num_adds.inc(1);
+	tot_comp_bytes.inc(comp_size);
+	long key = get_key(pg_id);
+	get_shard(key).add(key, buf, comp_size);
+}
+
+bool compressed_page_cache::fetch(const page_id_t &pg_id, char *buf)
+{
+	long key = get_key(pg_id);
+	bool ret = get_shard(key).fetch(key, buf);
+	if (ret)
+		num_hits.inc(1);
+	else
+		num_misses.inc(1);
+	return ret;
+}
+
+void compressed_page_cache::print_stat() const
+{
+	size_t num_pages = 0;
+	for (size_t i = 0; i < shards.size(); i++)
+		num_pages += shards[i]->get_num_pages();
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"compressed cache on node %1%: %2% pages, %3% hits, %4% misses")
+		% node_id % num_pages % num_hits.get() % num_misses.get();
+	if (num_adds.get() > 0)
+		BOOST_LOG_TRIVIAL(info) << boost::format(
+				"\t%1% pages added (avg %2% bytes), %3% pages don't compress well")
+			% num_adds.get() % (tot_comp_bytes.get() / num_adds.get())
+			% num_rejects.get();
+}
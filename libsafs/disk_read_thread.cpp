@@ -17,6 +17,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+
 #include "cache.h"
 #include "disk_read_thread.h"
 #include "parameters.h"
@@ -26,6 +28,127 @@
 const int AIO_HIGH_PRIO_SLOTS = 7;
 const int NUM_DIRTY_PAGES_TO_FETCH = 16 * 18;
 
+/*
+ * The weights of the I/O classes. A class gets the disk bandwidth in
+ * proportion to its weight when all classes are backlogged.
+ */
+static const int io_class_weights[NUM_IO_CLASSES] = {16, 4, 1};
+static const char *io_class_names[NUM_IO_CLASSES] = {
+	"critical", "normal", "background"
+};
+
+io_class_scheduler::io_class_scheduler(int node_id)
+{
+	for (int i = 0; i < NUM_IO_CLASSES; i++) {
+		queues[i] = fifo_queue<io_request>::create(node_id, IO_MSG_SIZE, true);
+		vtimes[i] = 0;
+		num_dispatched[i] = 0;
+		num_dispatched_bytes[i] = 0;
+	}
+	curr_vtime = 0;
+	num_reqs = 0;
+}
+
+io_class_scheduler::~io_class_scheduler()
+{
+	for (int i = 0; i < NUM_IO_CLASSES; i++)
+		fifo_queue<io_request>::destroy(queues[i]);
+}
+
+void io_class_scheduler::add(io_request reqs[], int num)
+{
+	for (int i = 0; i < num; i++) {
+		int c = reqs[i].get_io_class();
+		fifo_queue<io_request> *q = queues[c];
+		// A class that becomes backlogged starts from the current virtual
+		// time, so it can't claim the bandwidth it didn't use while idle.
+		if (is_class_empty(c))
+			vtimes[c] = max(vtimes[c], curr_vtime);
+		if (q->is_full())
+			BOOST_VERIFY(q->expand_queue(q->get_size() * 2));
+		q->push_back(reqs[i]);
+	}
+	num_reqs += num;
+}
+
+/*
+ * The backlogged class with the smallest virtual time.
+ */
+int io_class_scheduler::get_next_class()
+{
+	int min_class = -1;
+	for (int i = 0; i < NUM_IO_CLASSES; i++) {
+		if (!is_class_empty(i)
+				&& (min_class < 0 || vtimes[i] < vtimes[min_class]))
+			min_class = i;
+	}
+	assert(min_class >= 0);
+	return min_class;
+}
+
+/*
+ * Remove the next request of the class and charge the class for it.
+ */
+io_request io_class_scheduler::pop_req(int io_class)
+{
+	io_request req;
+	if (!put_back_reqs[io_class].empty()) {
+		req = put_back_reqs[io_class].front();
+		put_back_reqs[io_class].pop_front();
+	}
+	else
+		req = queues[io_class]->pop_front();
+	curr_vtime = vtimes[io_class];
+	vtimes[io_class] += max(req.get_size()
+			/ io_class_weights[io_class], 1UL);
+	num_dispatched[io_class]++;
+	num_dispatched_bytes[io_class] += req.get_size();
+	num_reqs--;
+	return req;
+}
+
+int io_class_scheduler::fetch(io_request reqs[], int max_reqs)
+{
+	int num_fetched = 0;
+	while (num_fetched < max_reqs && num_reqs > 0)
+		reqs[num_fetched++] = pop_req(get_next_class());
+	return num_fetched;
+}
+
+int io_class_scheduler::fetch_class(io_request reqs[], int max_reqs)
+{
+	if (num_reqs == 0)
+		return 0;
+	int io_class = get_next_class();
+	int num_fetched = 0;
+	while (num_fetched < max_reqs && !is_class_empty(io_class))
+		reqs[num_fetched++] = pop_req(io_class);
+	return num_fetched;
+}
+
+void io_class_scheduler::put_back(io_request reqs[], int num)
+{
+	// We put back the requests in reverse order, so they keep their order
+	// when they are fetched again.
+	for (int i = num - 1; i >= 0; i--) {
+		int c = reqs[i].get_io_class();
+		vtimes[c] -= max(reqs[i].get_size() / io_class_weights[c], 1UL);
+		num_dispatched[c]--;
+		num_dispatched_bytes[c] -= reqs[i].get_size();
+		put_back_reqs[c].push_front(reqs[i]);
+	}
+	num_reqs += num;
+}
+
+void io_class_scheduler::print_stat() const
+{
+	for (int i = 0; i < NUM_IO_CLASSES; i++) {
+		if (num_dispatched[i] > 0)
+			printf("\t%s class: %ld reqs (%ld bytes)\n", io_class_names[i],
+					num_dispatched[i], num_dispatched_bytes[i]);
+	}
+}
+
 // The partition contains a file mapper but the file mapper doesn't point
 // to a file in the SAFS filesystem.
 disk_io_thread::disk_io_thread(const logical_file_partition &_partition,
@@ -34,6 +157,7 @@ disk_io_thread::disk_io_thread(const logical_file_partition &_partition,
 		disk_id(_disk_id),
 		queue(node_id, std::string("io-queue-") + itoa(node_id),
 			IO_QUEUE_SIZE, INT_MAX, false),
+		scheduler(node_id),
 		// TODO let's allow the low-priority queue to
 		// be infinitely large for now.
 		low_prio_queue(node_id, std::string("io-queue-low_prio-")
@@ -90,8 +214,22 @@ int disk_io_thread::process_low_prio_msg(message<io_request> &low_prio_msg)
 	io_request req;
 	stack_array<io_request> ignored_flushes(low_prio_msg.get_num_objs());
 	int num_ignored = 0;
+	/*
+	 * In the write-combining mode, we collect all flushes in the message
+	 * and write them together, so the flushes to contiguous pages can be
+	 * merged into large writes.
+	 * The flushes are only submitted after the loop, so the number of
+	 * available slots doesn't change in the loop. We collect at most as
+	 * many flushes as there are slots for low-prio requests, so the flushes
+	 * never take the slots reserved for high-prio requests.
+	 */
+	bool combine = params.is_write_combining();
+	stack_array<io_request> flushes(combine ? low_prio_msg.get_num_objs() : 0);
+	int num_flushes = 0;
+	int max_flushes = aio->num_available_IO_slots() - AIO_HIGH_PRIO_SLOTS;
 	while (low_prio_msg.has_next()
 			&& aio->num_available_IO_slots() > AIO_HIGH_PRIO_SLOTS
+			&& (!combine || num_flushes < max_flushes)
 			// We only submit requests to the disk when there aren't
 			// high-prio requests.
 			&& queue.is_empty()) {
@@ -175,9 +313,19 @@ int disk_io_thread::process_low_prio_msg(message<io_request> &low_prio_msg)
 		// Now the request owns the page, it's safe to point to
 		// the page directly.
 		req.set_priv(p);
-		// This should block the thread.
-		aio->access(&req, 1);
+		if (combine)
+			flushes[num_flushes++] = req;
+		else
+			// This should block the thread.
+			aio->access(&req, 1);
+	}
+	if (num_flushes > 1) {
+		std::sort(flushes.data(), flushes.data() + num_flushes,
+				comp_req_offset());
+		aio->access_coalesced(flushes.data(), num_flushes);
 	}
+	else if (num_flushes == 1)
+		aio->access(flushes.data(), 1);
 	if (low_prio_msg.is_empty())
 		low_prio_msg.clear();
 
@@ -201,6 +349,90 @@ void disk_io_thread::run_commands(
 	}
 }
 
+/**
+ * Move the requests in the messages to the scheduler.
+ */
+int disk_io_thread::fetch_requests(message<io_request> msgs[], int num_msgs)
+{
+	// We don't drain the queue while there are enough requests waiting
+	// in the scheduler, so the queue still throttles the senders.
+	if (scheduler.get_num_reqs() >= aio->get_max_num_pending_ios() * 2)
+		return 0;
+
+	int num = queue.fetch(msgs, num_msgs);
+	this->num_msgs += num;
+	for (int i = 0; i < num; i++) {
+		int num_reqs = msgs[i].get_num_objs();
+		stack_array<io_request> local_reqs(num_reqs);
+		msgs[i].get_next_objs(local_reqs.data(), num_reqs);
+		scheduler.add(local_reqs.data(), num_reqs);
+		msgs[i].clear();
+	}
+	return num;
+}
+
+void disk_io_thread::count_dispatched(io_request reqs[], int num)
+{
+	for (int i = 0; i < num; i++) {
+		if (reqs[i].get_access_method() == READ) {
+			num_reads++;
+			num_read_bytes += reqs[i].get_size();
+		}
+		else {
+			num_writes++;
+			num_write_bytes += reqs[i].get_size();
+		}
+	}
+}
+
+/**
+ * Dispatch the requests in the scheduler to fill the available AIO slots.
+ * If there aren't any slots, we wait for a request to complete instead,
+ * and go back to check new requests, which may have a higher priority
+ * than the ones in the scheduler.
+ */
+void disk_io_thread::dispatch_requests()
+{
+	int num_slots = aio->num_available_IO_slots();
+	if (num_slots == 0) {
+		aio->wait4complete(1);
+		return;
+	}
+
+	if (!params.is_coalesce_reqs()) {
+		stack_array<io_request> local_reqs(num_slots);
+		int num_reqs = scheduler.fetch(local_reqs.data(), num_slots);
+		count_dispatched(local_reqs.data(), num_reqs);
+		aio->access(local_reqs.data(), num_reqs);
+		return;
+	}
+
+	/*
+	 * When we coalesce requests, the requests of a class waiting in
+	 * the scheduler form a window, which is sorted by location so that
+	 * adjacent requests are merged. A saturated disk frees only one or two
+	 * slots at a time, so the window isn't limited by the free slots, but
+	 * the merged requests are. The requests that don't fit are put back to
+	 * the scheduler, so new requests of a higher priority can still get
+	 * ahead of them.
+	 */
+	int window_size = aio->get_max_num_pending_ios();
+	stack_array<io_request> window(window_size);
+	while (num_slots > 0 && !scheduler.is_empty()) {
+		int num_reqs = scheduler.fetch_class(window.data(), window_size);
+		std::sort(window.data(), window.data() + num_reqs, comp_req_offset());
+		int num_issued = aio->access_coalesced(window.data(), num_reqs,
+				num_slots);
+		count_dispatched(window.data(), num_issued);
+		if (num_issued < num_reqs) {
+			scheduler.put_back(window.data() + num_issued,
+					num_reqs - num_issued);
+			break;
+		}
+		num_slots = aio->num_available_IO_slots();
+	}
+}
+
 void disk_io_thread::run() {
 	// First, check if we need to flush requests.
 	int num_flushes = flush_counter.get();
@@ -214,20 +446,18 @@ void disk_io_thread::run() {
 	message<io_request> msg_buffer[LOCAL_BUF_SIZE];
 	message<io_request> low_prio_msg;
 
-	const int LOCAL_REQ_BUF_SIZE = IO_MSG_SIZE;
 	do {
 		// TODO I need to make sure that checking commands doesn't cause
 		// noticeable CPU consumption.
 		if (!comm_queue.is_empty())
 			run_commands(comm_queue);
-		int num = queue.fetch(msg_buffer, LOCAL_BUF_SIZE);
-		num_msgs += num;
+		fetch_requests(msg_buffer, LOCAL_BUF_SIZE);
 		if (is_debug_enabled())
 			printf("I/O thread %d: queue size: %d, low-prio queue size: %d\n",
 					get_node_id(), queue.get_num_entries(),
 					low_prio_queue.get_num_entries());
-		// The high-prio queue is empty.
-		while (num == 0) {
+		// There aren't high-prio requests.
+		while (scheduler.is_empty()) {
 			// we can process as many low-prio requests as possible,
 			// but they shouldn't block the thread.
 			if (!low_prio_queue.is_empty()
@@ -257,32 +487,15 @@ void disk_io_thread::run() {
 				break;
 
 			// Let's try to fetch requests again.
-			num = queue.fetch(msg_buffer, LOCAL_BUF_SIZE);
-			num_msgs += num;
+			fetch_requests(msg_buffer, LOCAL_BUF_SIZE);
 		}
 
-		stack_array<io_request> local_reqs(LOCAL_REQ_BUF_SIZE);
-		for (int i = 0; i < num; i++) {
-			int num_reqs = msg_buffer[i].get_num_objs();
-			assert(num_reqs <= LOCAL_REQ_BUF_SIZE);
-			msg_buffer[i].get_next_objs(local_reqs.data(), num_reqs);
-			for (int j = 0; j < num_reqs; j++) {
-				if (local_reqs[j].get_access_method() == READ) {
-					num_reads++;
-					num_read_bytes += local_reqs[j].get_size();
-				}
-				else {
-					num_writes++;
-					num_write_bytes += local_reqs[j].get_size();
-				}
-			}
-			aio->access(local_reqs.data(), num_reqs);
-			msg_buffer[i].clear();
-		}
+		if (!scheduler.is_empty())
+			dispatch_requests();
 
 		// We can't exit the loop if there are still pending AIO requests.
 		// This thread is responsible for processing completed AIO requests.
-	} while (aio->num_pending_ios() > 0);
+	} while (aio->num_pending_ios() > 0 || !scheduler.is_empty());
 }
 
 int disk_io_thread::dirty_page_filter::filter(const thread_safe_page *pages[],
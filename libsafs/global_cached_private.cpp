@@ -765,12 +765,24 @@ void queue_requests(std::vector<page_req_pair> &pending_reqs)
 	process_page_reqs_on_io(pending_reqs.data(), pending_reqs.size());
 }
 
+/*
+ * Readahead requests don't have original requests. We mark them with
+ * the private data, so we can release the pages when they complete.
+ */
+static char readahead_tag;
+
+static inline bool is_readahead_req(const io_request &req)
+{
+	return req.get_priv() == &readahead_tag;
+}
+
 int global_cached_io::multibuf_completion(io_request *request)
 {
 	/*
 	 * Right now the global cache only support normal access().
 	 */
 	std::vector<page_req_pair> pending_reqs;
+	bool readahead = is_readahead_req(*request);
 	// The pages that are set dirty for the first time.
 	off_t off = request->get_offset();
 	for (int i = 0; i < request->get_num_bufs(); i++) {
@@ -793,6 +805,9 @@ int global_cached_io::multibuf_completion(io_request *request)
 		p->unlock();
 		if (pending_req)
 			pending_reqs.push_back(page_req_pair(p, pending_req));
+		// The readahead request holds a reference to the page.
+		if (readahead)
+			p->dec_ref();
 		if (request->get_access_method() == WRITE) {
 			// The reference count of a dirty page is always 1 + # original
 			// requests, so we can decrease the extra reference here.
@@ -816,7 +831,7 @@ void global_cached_io::process_disk_completed_requests(io_request requests[],
 		io_request *request = &requests[i];
 		num_underlying_pages.dec(request->get_num_bufs());
 
-		if (request->get_num_bufs() > 1) {
+		if (request->get_num_bufs() > 1 || is_readahead_req(*request)) {
 			multibuf_completion(request);
 			continue;
 		}
@@ -927,6 +942,120 @@ int global_cached_io::process_completed_requests()
 	return num_completed;
 }
 
+readahead_detector::seq_stream *readahead_detector::find_stream(
+		file_id_t file_id, off_t begin)
+{
+	for (size_t i = 0; i < streams.size(); i++) {
+		seq_stream &s = streams[i];
+		if (s.file_id != file_id)
+			continue;
+		// A read may access the last page of the previous read again, and
+		// it may skip some pages after the pages read ahead.
+		off_t end = std::max(s.last_end, s.ra_end);
+		if (begin >= s.last_end - PAGE_SIZE
+				&& begin <= end + s.window * PAGE_SIZE)
+			return &s;
+	}
+	return NULL;
+}
+
+readahead_detector::seq_stream *readahead_detector::new_stream(
+		file_id_t file_id)
+{
+	seq_stream *s;
+	if (streams.size() < (size_t) MAX_STREAMS) {
+		streams.push_back(seq_stream());
+		s = &streams.back();
+	}
+	else {
+		// Replace the stream accessed least recently. The pages it has read
+		// ahead but hasn't reached are wasted.
+		s = &streams[0];
+		for (size_t i = 1; i < streams.size(); i++) {
+			if (streams[i].last_access < s->last_access)
+				s = &streams[i];
+		}
+		if (s->ra_end > s->last_end)
+			num_wasted_pages += (s->ra_end - s->last_end) / PAGE_SIZE;
+	}
+	s->file_id = file_id;
+	s->last_end = 0;
+	s->ra_end = 0;
+	s->window = std::min((int) MIN_WINDOW, max_window);
+	s->num_seq_reads = 0;
+	s->wasted = false;
+	s->last_access = 0;
+	return s;
+}
+
+int readahead_detector::access(file_id_t file_id, off_t off, size_t size,
+		off_t &ra_off)
+{
+	if (!is_enabled())
+		return 0;
+
+	num_accesses++;
+	off_t begin = ROUND_PAGE(off);
+	off_t end = ROUNDUP_PAGE(off + size);
+	seq_stream *s = find_stream(file_id, begin);
+	if (s == NULL) {
+		s = new_stream(file_id);
+		s->last_end = end;
+		s->ra_end = end;
+		s->last_access = num_accesses;
+		return 0;
+	}
+	s->last_access = num_accesses;
+
+	// The pages read ahead and skipped by the read are wasted.
+	if (begin > s->last_end && s->ra_end > s->last_end) {
+		num_wasted_pages += (std::min(begin, s->ra_end) - s->last_end)
+			/ PAGE_SIZE;
+		s->wasted = true;
+	}
+	off_t useful_begin = std::max(begin, s->last_end);
+	off_t useful_end = std::min(end, s->ra_end);
+	if (useful_end > useful_begin)
+		num_useful_pages += (useful_end - useful_begin) / PAGE_SIZE;
+	s->last_end = std::max(s->last_end, end);
+	s->ra_end = std::max(s->ra_end, s->last_end);
+
+	s->num_seq_reads++;
+	if (s->num_seq_reads < MIN_SEQ_READS)
+		return 0;
+	// We read ahead again when the stream has used half of the pages
+	// read ahead, so the next pages arrive before they are needed.
+	if (s->ra_end - s->last_end > s->window * PAGE_SIZE / 2)
+		return 0;
+
+	if (s->wasted)
+		s->window = std::max(s->window / 2, std::min((int) MIN_WINDOW,
+					max_window));
+	else
+		s->window = std::min(s->window * 2, max_window);
+	s->wasted = false;
+
+	off_t ra_end = std::min(s->last_end + s->window * PAGE_SIZE, file_end);
+	if (ra_end <= s->ra_end)
+		return 0;
+	ra_off = s->ra_end;
+	s->ra_end = ra_end;
+	ra_stream_idx = s - streams.data();
+	return (ra_end - ra_off) / PAGE_SIZE;
+}
+
+void readahead_detector::end_readahead(off_t ra_end, int num_pages)
+{
+	assert(ra_stream_idx >= 0);
+	seq_stream &s = streams[ra_stream_idx];
+	// If the readahead stops early, the stream reads ahead from there
+	// next time.
+	if (ra_end < s.ra_end)
+		s.ra_end = std::max(ra_end, s.last_end);
+	num_ra_pages += num_pages;
+	ra_stream_idx = -1;
+}
+
 global_cached_io::global_cached_io(thread *t, io_interface *underlying,
 		page_cache *cache, comp_io_scheduler *sched): io_interface(t),
 	pending_requests(
@@ -963,6 +1092,7 @@ global_cached_io::global_cached_io(thread *t, io_interface *underlying,
 	num_bytes = 0;
 	num_fast_process = 0;
 	num_evicted_dirty_pages = 0;
+	num_comp_hits = 0;
 
 	this->underlying = underlying;
 	this->cache_size = cache->size();
@@ -1119,6 +1249,8 @@ ssize_t global_cached_io::read(io_request &req, thread_safe_page *pages[],
 	io_req_extension *ext = ext_allocator->alloc_obj();
 	io_request multibuf_req(ext, INVALID_DATA_LOC, req.get_access_method(), this,
 			get_node_id());
+	// The reads to the disk have the same priority as the user request.
+	multibuf_req.set_io_class(req.get_io_class());
 
 	assert(npages > 0);
 	int file_id = pages[0]->get_file_id();
@@ -1131,6 +1263,15 @@ ssize_t global_cached_io::read(io_request &req, thread_safe_page *pages[],
 		thread_safe_page *p = pages[i];
 		BOOST_VERIFY(file_id == p->get_file_id());
 		p->lock();
+		// The page may be kept in the compressed page cache, which is
+		// much faster than reading it from the disks.
+		if (!p->data_ready() && !p->is_io_pending()
+				&& get_global_cache()->load_compressed_page(
+					page_id_t(p->get_file_id(), p->get_offset()),
+					(char *) p->get_data())) {
+			p->set_data_ready(true);
+			num_comp_hits++;
+		}
 		if (!p->data_ready() && !p->is_io_pending()) {
 			assert(p->get_io_req() == NULL);
 			p->add_req(orig);
@@ -1160,6 +1301,7 @@ ssize_t global_cached_io::read(io_request &req, thread_safe_page *pages[],
 				io_request tmp(ext, INVALID_DATA_LOC, req.get_access_method(),
 						this, get_node_id());
 				multibuf_req = tmp;
+				multibuf_req.set_io_class(req.get_io_class());
 			}
 		}
 		/* 
@@ -1179,6 +1321,7 @@ ssize_t global_cached_io::read(io_request &req, thread_safe_page *pages[],
 				io_request tmp(ext, INVALID_DATA_LOC, req.get_access_method(),
 						this, get_node_id());
 				multibuf_req = tmp;
+				multibuf_req.set_io_class(req.get_io_class());
 			}
 			io_request complete_partial;
 			orig->extract(p->get_offset(), PAGE_SIZE, complete_partial);
@@ -1627,6 +1770,8 @@ void global_cached_io::process_user_reqs(queue_interface<io_request> &queue)
 		processing_req.init(req);
 		num_bytes += req.get_size();
 		process_user_req(dirty_pages, NULL);
+		if (ra_detector.is_enabled() && req.get_access_method() == READ)
+			read_ahead(req);
 	}
 
 	get_global_cache()->mark_dirty_pages(dirty_pages.data(),
@@ -1694,6 +1839,9 @@ void global_cached_io::access(io_request *requests, int num, io_status *status)
 		if (status)
 			stat_p = &status[i];
 		process_user_req(dirty_pages, stat_p);
+		if (ra_detector.is_enabled()
+				&& requests[i].get_access_method() == READ)
+			read_ahead(requests[i]);
 		// We can't process all requests. Let's queue the remaining requests.
 		if (!processing_req.is_empty() && i < num - 1) {
 			user_requests.add(&requests[i + 1], num - i - 1);
@@ -1757,6 +1905,89 @@ int global_cached_io::preload(off_t start, long size) {
 	return 0;
 }
 
+/**
+ * Read ahead the pages after the read if it's part of a sequential stream.
+ * We skip the pages that are already in the cache or being read.
+ */
+void global_cached_io::read_ahead(const io_request &req)
+{
+	off_t ra_off = 0;
+	int num_ra_pages = ra_detector.access(req.get_file_id(), req.get_offset(),
+			req.get_size(), ra_off);
+	if (num_ra_pages == 0)
+		return;
+
+	thread_safe_page *pages[params.get_RAID_block_size()];
+	int num_pages = 0;
+	int num_read_pages = 0;
+	off_t ra_end = ra_off + num_ra_pages * PAGE_SIZE;
+	const off_t RAID_block_size = params.get_RAID_block_size() * PAGE_SIZE;
+	for (int i = 0; i < num_ra_pages; i++) {
+		off_t off = ra_off + i * PAGE_SIZE;
+		// A request to the underlying IO can't cross a RAID block.
+		if (off % RAID_block_size == 0) {
+			send_readahead(pages, num_pages);
+			num_pages = 0;
+		}
+		page_id_t pg_id(req.get_file_id(), off);
+		page_id_t old_id;
+		// The page isn't accessed by the application yet, so it shouldn't
+		// look hot to the eviction policy.
+		thread_safe_page *p = (thread_safe_page *) (get_global_cache()
+				->prefetch(pg_id, old_id));
+		// We don't wait for the cache to evict pages for readahead.
+		if (p == NULL) {
+			ra_end = off;
+			break;
+		}
+		p->lock();
+		if (!p->data_ready() && !p->is_io_pending()
+				&& get_global_cache()->load_compressed_page(pg_id,
+					(char *) p->get_data())) {
+			p->set_data_ready(true);
+			num_comp_hits++;
+		}
+		if (p->data_ready() || p->is_io_pending()) {
+			p->unlock();
+			p->dec_ref();
+			send_readahead(pages, num_pages);
+			num_pages = 0;
+			continue;
+		}
+		// Files are read-only when readahead is enabled.
+		assert(!p->is_old_dirty());
+		p->set_io_pending(true);
+		p->unlock();
+		pages[num_pages++] = p;
+		num_read_pages++;
+	}
+	send_readahead(pages, num_pages);
+	ra_detector.end_readahead(ra_end, num_read_pages);
+}
+
+void global_cached_io::send_readahead(thread_safe_page *pages[], int num_pages)
+{
+	if (num_pages == 0)
+		return;
+
+	io_req_extension *ext = ext_allocator->alloc_obj();
+	data_loc_t loc(pages[0]->get_file_id(), pages[0]->get_offset());
+	io_request req(ext, loc, READ, this, get_node_id());
+	for (int i = 0; i < num_pages; i++)
+		req.add_page(pages[i]);
+	req.set_priv(&readahead_tag);
+	// Read-ahead shouldn't delay the reads that applications wait for.
+	req.set_io_class(IO_CLASS_BACKGROUND);
+
+	io_status status;
+	num_to_underlying.inc(1);
+	num_underlying_pages.inc(num_pages);
+	underlying->access(&req, 1, &status);
+	if (status == IO_FAIL) {
+		abort();
+	}
+}
+
 void global_cached_io::process_all_requests()
 {
 	// We first process the completed requests from the disk.
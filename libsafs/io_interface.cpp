@@ -21,7 +21,11 @@
 #include <signal.h>
 #include <time.h>
 #include <pthread.h>
+#include <errno.h>
+#include <string.h>
 
+#include <algorithm>
+#include <map>
 #include <unordered_set>
 #include <unordered_map>
 #include <vector>
@@ -59,6 +63,8 @@ struct global_data_collection
 	pthread_mutex_t mutex;
 	cache_config *cache_conf;
 	page_cache *global_cache;
+	// The message allocator used by the flusher of the page cache.
+	std::shared_ptr<slab_allocator> flush_msg_allocator;
 #ifdef PART_IO
 	// For part_global_cached_io
 	part_io_process_table *table;
@@ -95,6 +101,24 @@ public:
 		lock.unlock();
 		return *mapper;
 	}
+
+	/**
+	 * Find the name of the file with the specified file Id.
+	 */
+	bool get_name(int file_id, std::string &name) {
+		bool found = false;
+		lock.lock();
+		std::unordered_map<std::string, file_mapper *>::const_iterator it;
+		for (it = map.begin(); it != map.end(); it++) {
+			if (it->second->get_file_id() == file_id) {
+				name = it->first;
+				found = true;
+				break;
+			}
+		}
+		lock.unlock();
+		return found;
+	}
 };
 static file_mapper_set file_mappers;
 
@@ -215,6 +239,7 @@ void init_io_system(config_map::ptr configs, bool with_cache)
 	 * it will be blocked by the mutex. When a thread is returned from
 	 * the function, they all can see the global data.
 	 */
+	bool new_cache = false;
 	pthread_mutex_lock(&global_data.mutex);
 	int flags = O_RDONLY;
 	if (params.is_writable())
@@ -248,6 +273,7 @@ void init_io_system(config_map::ptr configs, bool with_cache)
 		global_data.global_cache = global_data.cache_conf->create_cache(
 				MAX_NUM_FLUSHES_PER_FILE *
 				global_data.raid_conf->get_num_disks());
+		new_cache = true;
 		int num_files = global_data.read_threads.size();
 		for (int k = 0; k < num_files; k++) {
 			global_data.read_threads[k]->register_cache(
@@ -257,13 +283,25 @@ void init_io_system(config_map::ptr configs, bool with_cache)
 		// The remote IO will never be used. It's only used for creating
 		// more remote IOs for flushing dirty pages, so it doesn't matter
 		// what thread is used here.
-#if 0
-		thread *curr = thread::get_curr_thread();
-		assert(curr);
-		io_interface::ptr underlying = io_interface::ptr(new remote_io(
-					global_data.read_threads, mapper, curr));
-		global_data.global_cache->init(underlying);
-#endif
+		// TODO the flusher that writes back one cell at a time hasn't been
+		// used for a long time, so we only create a flusher for write
+		// combining.
+		if (params.is_use_flusher() && params.is_write_combining()) {
+			thread *curr = thread::get_curr_thread();
+			assert(curr);
+			global_data.flush_msg_allocator = std::shared_ptr<slab_allocator>(
+					new slab_allocator("flush_msg_allocator",
+						IO_MSG_SIZE * sizeof(io_request),
+						IO_MSG_SIZE * sizeof(io_request) * 1024, INT_MAX,
+						curr->get_node_id()));
+			io_interface::ptr underlying = io_interface::ptr(new remote_io(
+						global_data.read_threads,
+						*global_data.flush_msg_allocator, mapper, curr));
+			global_data.global_cache->init(underlying);
+		}
+		else if (params.is_write_combining() && !params.is_use_flusher())
+			BOOST_LOG_TRIVIAL(warning)
+				<< "write_combining has no effect without use_flusher";
 	}
 #ifdef PART_IO
 	if (global_data.table == NULL && with_cache) {
@@ -274,11 +312,20 @@ void init_io_system(config_map::ptr configs, bool with_cache)
 	}
 #endif
 	pthread_mutex_unlock(&global_data.mutex);
+
+	// Load the pages saved last time the I/O system was destroyed.
+	if (new_cache && !params.get_hot_page_file().empty()) {
+		native_file f(params.get_hot_page_file());
+		if (f.exist())
+			warm_page_cache(params.get_hot_page_file());
+	}
 }
 
 void destroy_io_system()
 {
 	BOOST_LOG_TRIVIAL(info) << "I/O system is destroyed";
+	if (global_data.global_cache && !params.get_hot_page_file().empty())
+		dump_page_cache(params.get_hot_page_file());
 	global_data.raid_conf.reset();
 	if (global_data.global_cache)
 		global_data.global_cache->sanity_check();
@@ -295,6 +342,7 @@ void destroy_io_system()
 		delete global_data.cache_conf;
 		global_data.cache_conf = NULL;
 	}
+	global_data.flush_msg_allocator.reset();
 	size_t num_reads = 0;
 	size_t num_writes = 0;
 	size_t num_read_bytes = 0;
@@ -417,6 +465,10 @@ class global_cached_io_factory: public remote_io_factory
 	std::atomic_ulong tot_pg_accesses;
 	std::atomic_ulong tot_hits;
 	std::atomic_ulong tot_fast_process;
+	std::atomic_ulong tot_ra_pages;
+	std::atomic_ulong tot_useful_ra_pages;
+	std::atomic_ulong tot_wasted_ra_pages;
+	std::atomic_ulong tot_comp_hits;
 
 	page_cache *global_cache;
 public:
@@ -428,6 +480,10 @@ public:
 		tot_pg_accesses = 0;
 		tot_hits = 0;
 		tot_fast_process = 0;
+		tot_ra_pages = 0;
+		tot_useful_ra_pages = 0;
+		tot_wasted_ra_pages = 0;
+		tot_comp_hits = 0;
 	}
 
 	virtual io_interface::ptr create_io(thread *t);
@@ -442,6 +498,11 @@ public:
 		tot_pg_accesses += gio.get_num_pg_accesses();
 		tot_hits += gio.get_cache_hits();
 		tot_fast_process += gio.get_num_fast_process();
+		const readahead_detector &ra = gio.get_readahead_stat();
+		tot_ra_pages += ra.get_num_ra_pages();
+		tot_useful_ra_pages += ra.get_num_useful_pages();
+		tot_wasted_ra_pages += ra.get_num_wasted_pages();
+		tot_comp_hits += gio.get_num_comp_hits();
 	}
 
 	virtual void print_statistics() const {
@@ -451,6 +512,15 @@ public:
 		BOOST_LOG_TRIVIAL(info)
 			<< boost::format("There are %1% pages accessed, %2% cache hits, %3% of them are in the fast process")
 			% tot_pg_accesses.load() % tot_hits.load() % tot_fast_process.load();
+		if (params.get_max_readahead() > 0)
+			BOOST_LOG_TRIVIAL(info)
+				<< boost::format("%1% pages are read ahead, %2% of them are used and %3% are wasted")
+				% tot_ra_pages.load() % tot_useful_ra_pages.load()
+				% tot_wasted_ra_pages.load();
+		if (params.get_comp_cache_size() > 0)
+			BOOST_LOG_TRIVIAL(info)
+				<< boost::format("%1% pages are read from the compressed page cache")
+				% tot_comp_hits.load();
 	}
 };
 
@@ -585,6 +655,8 @@ io_interface::ptr global_cached_io_factory::create_io(thread *t)
 		scheduler = get_sched_creater()->create(underlying->get_node_id());
 	global_cached_io *io = new global_cached_io(t, underlying,
 			global_cache, scheduler);
+	if (params.get_max_readahead() > 0)
+		io->enable_readahead(params.get_max_readahead(), get_file_size());
 	num_ios++;
 	return io_interface::ptr(io, io_deleter(*this));
 }
@@ -690,4 +762,260 @@ bool is_safs_init()
 	return global_data.raid_conf != NULL;
 }
 
+/*
+ * A file saved by dump_page_cache() starts with HOT_PAGE_MAGIC. For each
+ * SAFS file, there is a hot_file_header, the file name and the pages of
+ * the file in the page cache.
+ */
+static const long HOT_PAGE_MAGIC = 0x53414653484f5450L;
+
+struct hot_file_header
+{
+	int name_len;
+	long num_pages;
+};
+
+struct hot_page
+{
+	unsigned long pg_idx: 56;
+	unsigned long score: 8;
+};
+
+bool dump_page_cache(const std::string &file_name)
+{
+	if (global_data.global_cache == NULL) {
+		BOOST_LOG_TRIVIAL(error) << "SAFS isn't initialized with page cache";
+		return false;
+	}
+
+	std::vector<cached_page_info> pages;
+	global_data.global_cache->get_cached_pages(pages);
+	std::map<file_id_t, std::vector<hot_page> > file_pages;
+	BOOST_FOREACH(cached_page_info &info, pages) {
+		hot_page pg;
+		pg.pg_idx = info.pg_id.get_offset() / PAGE_SIZE;
+		pg.score = info.score;
+		file_pages[info.pg_id.get_file_id()].push_back(pg);
+	}
+
+	FILE *f = fopen(file_name.c_str(), "w");
+	if (f == NULL) {
+		BOOST_LOG_TRIVIAL(error) << boost::format("can't open %1%: %2%")
+			% file_name % strerror(errno);
+		return false;
+	}
+	bool ret = fwrite(&HOT_PAGE_MAGIC, sizeof(HOT_PAGE_MAGIC), 1, f) == 1;
+	size_t num_saved = 0;
+	std::map<file_id_t, std::vector<hot_page> >::const_iterator it;
+	for (it = file_pages.begin(); it != file_pages.end() && ret; it++) {
+		std::string name;
+		if (!file_mappers.get_name(it->first, name))
+			continue;
+
+		hot_file_header header;
+		header.name_len = name.length();
+		header.num_pages = it->second.size();
+		ret = fwrite(&header, sizeof(header), 1, f) == 1
+			&& fwrite(name.c_str(), name.length(), 1, f) == 1
+			&& fwrite(it->second.data(), sizeof(hot_page), it->second.size(),
+					f) == it->second.size();
+		num_saved += it->second.size();
+	}
+	if (fclose(f) != 0)
+		ret = false;
+	if (ret)
+		BOOST_LOG_TRIVIAL(info)
+			<< boost::format("save %1% pages of the page cache to %2%")
+			% num_saved % file_name;
+	else
+		BOOST_LOG_TRIVIAL(error)
+			<< boost::format("fail to save the page cache to %1%") % file_name;
+	return ret;
+}
+
+struct warm_page
+{
+	int file_idx;
+	off_t pg_idx;
+	int score;
+};
+
+struct comp_warm_score {
+	bool operator() (const warm_page &pg1, const warm_page &pg2) {
+		return pg1.score > pg2.score;
+	}
+} warm_score_comparator;
+
+struct comp_warm_loc {
+	bool operator() (const warm_page &pg1, const warm_page &pg2) {
+		if (pg1.file_idx != pg2.file_idx)
+			return pg1.file_idx < pg2.file_idx;
+		else
+			return pg1.pg_idx < pg2.pg_idx;
+	}
+} warm_loc_comparator;
+
+/*
+ * The callback returns the buffers of the completed requests, so they
+ * can be used by the next requests.
+ */
+class warm_callback: public callback
+{
+	std::vector<char *> &free_bufs;
+public:
+	warm_callback(std::vector<char *> &bufs): free_bufs(bufs) {
+	}
+
+	int invoke(io_request *reqs[], int num) {
+		for (int i = 0; i < num; i++)
+			free_bufs.push_back(reqs[i]->get_buf());
+		return 0;
+	}
+};
+
+/*
+ * The max size of a request for warming up the page cache.
+ */
+static const int MAX_WARM_REQ_PAGES = 256;
+/*
+ * The number of requests issued concurrently to warm up the page cache.
+ */
+static const int NUM_WARM_REQS = 16;
+/*
+ * We read the pages between two hot pages if the gap is small, so we
+ * can issue larger requests.
+ */
+static const int MAX_WARM_GAP = 8;
+
+/*
+ * Read the pages of a file to the page cache. The pages are sorted
+ * by their locations.
+ */
+static size_t warm_file(const std::string &name, const warm_page pages[],
+		size_t num)
+{
+	file_io_factory::shared_ptr factory;
+	try {
+		factory = create_io_factory(name, GLOBAL_CACHE_ACCESS);
+	} catch (io_exception &e) {
+		BOOST_LOG_TRIVIAL(warning) << boost::format(
+				"can't warm up the page cache for %1%: %2%") % name % e.what();
+		return 0;
+	}
+	off_t num_file_pages = factory->get_file_size() / PAGE_SIZE;
+	io_interface::ptr io = factory->create_io(thread::get_curr_thread());
+
+	std::vector<char *> bufs(NUM_WARM_REQS);
+	for (size_t i = 0; i < bufs.size(); i++)
+		bufs[i] = (char *) valloc(MAX_WARM_REQ_PAGES * PAGE_SIZE);
+	std::vector<char *> free_bufs = bufs;
+	io->set_callback(new warm_callback(free_bufs));
+
+	size_t num_read = 0;
+	size_t i = 0;
+	while (i < num && pages[i].pg_idx < num_file_pages) {
+		off_t start = pages[i].pg_idx;
+		off_t end = start + 1;
+		for (i++; i < num; i++) {
+			if (pages[i].pg_idx - end > MAX_WARM_GAP
+					|| pages[i].pg_idx + 1 - start > MAX_WARM_REQ_PAGES
+					|| pages[i].pg_idx >= num_file_pages)
+				break;
+			end = pages[i].pg_idx + 1;
+		}
+
+		while (free_bufs.empty())
+			io->wait4complete(1);
+		char *buf = free_bufs.back();
+		free_bufs.pop_back();
+		data_loc_t loc(io->get_file_id(), start * PAGE_SIZE);
+		io_request req(buf, loc, (end - start) * PAGE_SIZE, READ);
+		io->access(&req, 1);
+		num_read += end - start;
+	}
+	io->wait4complete(io->num_pending_ios());
+	io->cleanup();
+	delete io->get_callback();
+	for (size_t i = 0; i < bufs.size(); i++)
+		free(bufs[i]);
+	return num_read;
+}
+
+size_t warm_page_cache(const std::string &file_name)
+{
+	if (global_data.global_cache == NULL) {
+		BOOST_LOG_TRIVIAL(error) << "SAFS isn't initialized with page cache";
+		return 0;
+	}
+
+	FILE *f = fopen(file_name.c_str(), "r");
+	if (f == NULL) {
+		BOOST_LOG_TRIVIAL(error) << boost::format("can't open %1%: %2%")
+			% file_name % strerror(errno);
+		return 0;
+	}
+	long magic = 0;
+	if (fread(&magic, sizeof(magic), 1, f) != 1 || magic != HOT_PAGE_MAGIC) {
+		BOOST_LOG_TRIVIAL(error)
+			<< boost::format("%1% doesn't contain pages of the page cache")
+			% file_name;
+		fclose(f);
+		return 0;
+	}
+	std::vector<std::string> names;
+	std::vector<warm_page> pages;
+	hot_file_header header;
+	while (fread(&header, sizeof(header), 1, f) == 1) {
+		if (header.name_len <= 0 || header.num_pages < 0)
+			break;
+		std::string name(header.name_len, 0);
+		std::vector<hot_page> file_pages(header.num_pages);
+		if (fread(&name[0], header.name_len, 1, f) != 1
+				|| fread(file_pages.data(), sizeof(hot_page),
+					file_pages.size(), f) != file_pages.size()) {
+			BOOST_LOG_TRIVIAL(error)
+				<< boost::format("%1% is truncated") % file_name;
+			break;
+		}
+		safs_file file(get_sys_RAID_conf(), name);
+		if (!file.exist())
+			continue;
+
+		BOOST_FOREACH(hot_page &pg, file_pages) {
+			warm_page wpg;
+			wpg.file_idx = names.size();
+			wpg.pg_idx = pg.pg_idx;
+			wpg.score = pg.score;
+			pages.push_back(wpg);
+		}
+		names.push_back(name);
+	}
+	fclose(f);
+
+	// If the cache is smaller now, we load the hottest pages.
+	size_t max_num_pages = params.get_cache_size() / PAGE_SIZE;
+	if (pages.size() > max_num_pages) {
+		std::stable_sort(pages.begin(), pages.end(), warm_score_comparator);
+		pages.resize(max_num_pages);
+	}
+	std::sort(pages.begin(), pages.end(), warm_loc_comparator);
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	size_t num_read = 0;
+	size_t i = 0;
+	while (i < pages.size()) {
+		size_t j = i;
+		while (j < pages.size() && pages[j].file_idx == pages[i].file_idx)
+			j++;
+		num_read += warm_file(names[pages[i].file_idx], &pages[i], j - i);
+		i = j;
+	}
+	gettimeofday(&end, NULL);
+	BOOST_LOG_TRIVIAL(info)
+		<< boost::format("warm up the page cache with %1% pages from %2% in %3% seconds")
+		% num_read % file_name % time_diff(start, end);
+	return num_read;
+}
+
 atomic_integer io_interface::io_counter;
@@ -18,6 +18,7 @@
  */
 
 #include "memory_manager.h"
+#include "uring_aio_ctx.h"
 
 const long SHRINK_NPAGES = 1024;
 const long INCREASE_SIZE = 1024 * 1024 * 128;
@@ -30,6 +31,15 @@ memory_manager::memory_manager(
 			max_size, node_id, false, true) {
 }
 
+/**
+ * Pages in the page cache are used as I/O buffers, so we register
+ * the memory to io_uring.
+ */
+void memory_manager::add_chunk(char *buf, long size)
+{
+	register_io_buf(buf, size);
+}
+
 /**
  * get `npages' pages for `request_cache'.
  * In the case of shrinking caches, it makes no sense
@@ -52,6 +52,8 @@ sys_parameters::sys_parameters()
 	cache_size = 512 * 1024 * 1024;
 	RAID_mapping_option = RAID5;
 	use_virt_aio = false;
+	use_io_uring = false;
+	buffered_io = false;
 	verify_content = false;
 	use_flusher = false;
 	cache_large_write = false;
@@ -59,10 +61,14 @@ sys_parameters::sys_parameters()
 	numa_num_process_threads = 1;
 	num_nodes = 1;
 	merge_reqs = false;
+	coalesce_reqs = false;
+	write_combining = false;
 	max_obj_alloc_size = 100 * 1024 * 1024;
 	writable = false;
 	max_num_pending_ios = 1000;
 	huge_page_enabled = false;
+	max_readahead = 0;
+	comp_cache_size = 0;
 }
 
 void sys_parameters::init(const std::map<std::string, std::string> &configs)
@@ -116,6 +122,14 @@ void sys_parameters::init(const std::map<std::string, std::string> &configs)
 	if (it != configs.end())
 		use_virt_aio = true;
 
+	it = configs.find("io_uring");
+	if (it != configs.end())
+		use_io_uring = true;
+
+	it = configs.find("buffered_io");
+	if (it != configs.end())
+		buffered_io = true;
+
 	it = configs.find("verify_content");
 	if (it != configs.end()) {
 		verify_content = true;
@@ -170,6 +184,36 @@ void sys_parameters::init(const std::map<std::string, std::string> &configs)
 	if (it != configs.end()) {
 		huge_page_enabled = true;
 	}
+
+	it = configs.find("readahead");
+	if (it != configs.end()) {
+		max_readahead = atoi(it->second.c_str());
+	}
+
+	it = configs.find("hot_page_file");
+	if (it != configs.end()) {
+		hot_page_file = it->second;
+	}
+
+	it = configs.find("comp_cache_size");
+	if (it != configs.end()) {
+		comp_cache_size = str2size(it->second);
+	}
+
+	it = configs.find("ssd_model");
+	if (it != configs.end()) {
+		ssd_model_file = it->second;
+	}
+
+	it = configs.find("coalesce_reqs");
+	if (it != configs.end()) {
+		coalesce_reqs = true;
+	}
+
+	it = configs.find("write_combining");
+	if (it != configs.end()) {
+		write_combining = true;
+	}
 }
 
 void sys_parameters::print()
@@ -182,6 +226,8 @@ void sys_parameters::print()
 	BOOST_LOG_TRIVIAL(info) << "\tcache_size: " << cache_size;
 	BOOST_LOG_TRIVIAL(info) << "\tRAID_mapping: " << RAID_mapping_option;
 	BOOST_LOG_TRIVIAL(info) << "\tvirt_aio: " << use_virt_aio;
+	BOOST_LOG_TRIVIAL(info) << "\tio_uring: " << use_io_uring;
+	BOOST_LOG_TRIVIAL(info) << "\tbuffered_io: " << buffered_io;
 	BOOST_LOG_TRIVIAL(info) << "\tverify_content: " << verify_content;
 	BOOST_LOG_TRIVIAL(info) << "\tuse_flusher: " << use_flusher;
 	BOOST_LOG_TRIVIAL(info) << "\tcache_large_write: " << cache_large_write;
@@ -193,6 +239,12 @@ void sys_parameters::print()
 	BOOST_LOG_TRIVIAL(info) << "\twritable: " << writable;
 	BOOST_LOG_TRIVIAL(info) << "\tmax_num_pending_ios: " << max_num_pending_ios;
 	BOOST_LOG_TRIVIAL(info) << "\thuge_page_enabled: " << huge_page_enabled;
+	BOOST_LOG_TRIVIAL(info) << "\treadahead: " << max_readahead;
+	BOOST_LOG_TRIVIAL(info) << "\thot_page_file: " << hot_page_file;
+	BOOST_LOG_TRIVIAL(info) << "\tcomp_cache_size: " << comp_cache_size;
+	BOOST_LOG_TRIVIAL(info) << "\tssd_model: " << ssd_model_file;
+	BOOST_LOG_TRIVIAL(info) << "\tcoalesce_reqs: " << coalesce_reqs;
+	BOOST_LOG_TRIVIAL(info) << "\twrite_combining: " << write_combining;
 }
 
 void sys_parameters::print_help()
@@ -213,6 +265,10 @@ void sys_parameters::print_help()
 	RAID_option_map.print("\tRAID_mapping: ");
 	std::cout << "\tvirt_aio: enable virtual AIO for debugging and performance evaluation"
 		<< std::endl;
+	std::cout << "\tio_uring: use io_uring instead of Linux AIO to access files"
+		<< std::endl;
+	std::cout << "\tbuffered_io: access files through the OS page cache (requires io_uring)"
+		<< std::endl;
 	std::cout << "\tverify_content: verify data for testing" << std::endl;
 	std::cout << "\tuse_flusher: use flusher in the page cache" << std::endl;
 	std::cout << "\tcache_large_write: enable large write in the page cache."
@@ -232,4 +288,16 @@ void sys_parameters::print_help()
 		<< std::endl;
 	std::cout << "\thuge_page_enabled: determine whether we use huge page for large chunk of memory"
 		<< std::endl;
+	std::cout << "\treadahead: the max number of pages read ahead for a sequential stream in the page cache"
+		<< std::endl;
+	std::cout << "\thot_page_file: the file where the pages in the page cache are saved and loaded at restart"
+		<< std::endl;
+	std::cout << "\tcomp_cache_size: the size of the compressed page cache behind the page cache x(k, K, m, M, g, G)"
+		<< std::endl;
+	std::cout << "\tssd_model: the profile of the SSD performance model for virtual AIO"
+		<< std::endl;
+	std::cout << "\tcoalesce_reqs: whether or not merge adjacent requests in the I/O threads"
+		<< std::endl;
+	std::cout << "\twrite_combining: flush dirty pages in large sorted batches and merge them into large writes (requires use_flusher)"
+		<< std::endl;
 }
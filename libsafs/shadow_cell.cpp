@@ -19,8 +19,6 @@
 
 #include "shadow_cell.h"
 
-#ifdef USE_SHADOW_PAGE
-
 void clock_shadow_cell::add(shadow_page pg)
 {
 	if (!queue.is_full()) {
@@ -167,6 +165,3 @@ void embedded_queue<T, SIZE>::remove(int idx)
 }
 
 template class embedded_queue<shadow_page, NUM_SHADOW_PAGES>;
-
-#endif
-
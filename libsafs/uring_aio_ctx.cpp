@@ -0,0 +1,471 @@
+/**
+ * Copyright 2014 Open Connectome Project (http://openconnecto.me)
+ * Written by Da Zheng (zhengda1936@gmail.com)
+ *
+ * This file is part of SAFSlib.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+
+#include <boost/format.hpp>
+
+#include "log.h"
+#include "common.h"
+#include "uring_aio_ctx.h"
+
+/**
+ * The memory regions registered by register_io_buf().
+ */
+static std::vector<struct iovec> io_bufs;
+// It increases every time a new region is registered, so an io_uring
+// instance knows when it needs to register the buffers again.
+static volatile size_t io_bufs_version;
+static pthread_spinlock_t io_bufs_lock;
+
+class io_bufs_lock_initiator
+{
+public:
+	io_bufs_lock_initiator() {
+		pthread_spin_init(&io_bufs_lock, PTHREAD_PROCESS_PRIVATE);
+	}
+};
+static io_bufs_lock_initiator io_bufs_lock_init;
+
+// The maximal number of fixed buffers an io_uring instance can have.
+static const size_t MAX_REG_BUFS = 1 << 14;
+
+void register_io_buf(void *buf, size_t size)
+{
+	struct iovec iov;
+	iov.iov_base = buf;
+	iov.iov_len = size;
+	pthread_spin_lock(&io_bufs_lock);
+	io_bufs.push_back(iov);
+	io_bufs_version++;
+	pthread_spin_unlock(&io_bufs_lock);
+}
+
+static int sys_io_uring_setup(unsigned entries, struct io_uring_params *p)
+{
+	return syscall(__NR_io_uring_setup, entries, p);
+}
+
+static int sys_io_uring_enter(int fd, unsigned to_submit,
+		unsigned min_complete, unsigned flags)
+{
+	return syscall(__NR_io_uring_enter, fd, to_submit, min_complete,
+			flags, NULL, 0);
+}
+
+static int sys_io_uring_register(int fd, unsigned opcode, const void *arg,
+		unsigned nr_args)
+{
+	return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+uring_aio_ctx *uring_aio_ctx::create(int node_id, int max_aio)
+{
+	uring_aio_ctx *ctx = new uring_aio_ctx(node_id, max_aio);
+	if (!ctx->init_ring()) {
+		delete ctx;
+		return NULL;
+	}
+	return ctx;
+}
+
+uring_aio_ctx::uring_aio_ctx(int node_id, int max_aio): aio_ctx(node_id,
+		max_aio)
+{
+	this->max_aio = max_aio;
+	busy_aio = 0;
+	ring_fd = -1;
+	sq_ring_ptr = MAP_FAILED;
+	sq_ring_size = 0;
+	cq_ring_ptr = MAP_FAILED;
+	cq_ring_size = 0;
+	sqes = (struct io_uring_sqe *) MAP_FAILED;
+	sqes_size = 0;
+	sq_head = sq_tail = sq_mask = sq_array = NULL;
+	cq_head = cq_tail = cq_mask = NULL;
+	cqes = NULL;
+	reg_version = 0;
+	reg_failed = false;
+	sparse_table = false;
+	num_reqs = 0;
+	num_fixed_reqs = 0;
+	num_submit_calls = 0;
+	num_wait_calls = 0;
+}
+
+bool uring_aio_ctx::init_ring()
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	ring_fd = sys_io_uring_setup(max_aio, &p);
+	if (ring_fd < 0) {
+		BOOST_LOG_TRIVIAL(error) << boost::format("io_uring_setup: %1%")
+			% strerror(errno);
+		return false;
+	}
+	// We never have more than max_aio requests in flight, so neither ring
+	// can overflow.
+	assert(p.sq_entries >= (unsigned) max_aio);
+	assert(p.cq_entries >= (unsigned) max_aio);
+
+	sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+		cq_ring_size = sq_ring_size;
+	}
+	sq_ring_ptr = mmap(NULL, sq_ring_size, PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+	if (sq_ring_ptr == MAP_FAILED) {
+		perror("mmap SQ ring");
+		return false;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP)
+		cq_ring_ptr = sq_ring_ptr;
+	else {
+		cq_ring_ptr = mmap(NULL, cq_ring_size, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+		if (cq_ring_ptr == MAP_FAILED) {
+			perror("mmap CQ ring");
+			return false;
+		}
+	}
+	sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+	sqes = (struct io_uring_sqe *) mmap(NULL, sqes_size,
+			PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+			IORING_OFF_SQES);
+	if (sqes == MAP_FAILED) {
+		perror("mmap SQEs");
+		return false;
+	}
+
+	char *sq = (char *) sq_ring_ptr;
+	sq_head = (unsigned *) (sq + p.sq_off.head);
+	sq_tail = (unsigned *) (sq + p.sq_off.tail);
+	sq_mask = (unsigned *) (sq + p.sq_off.ring_mask);
+	sq_array = (unsigned *) (sq + p.sq_off.array);
+	char *cq = (char *) cq_ring_ptr;
+	cq_head = (unsigned *) (cq + p.cq_off.head);
+	cq_tail = (unsigned *) (cq + p.cq_off.tail);
+	cq_mask = (unsigned *) (cq + p.cq_off.ring_mask);
+	cqes = (struct io_uring_cqe *) (cq + p.cq_off.cqes);
+
+	init_buf_table();
+	return true;
+}
+
+/**
+ * Create the buffer table of the ring and register the buffers that
+ * already exist. Most of the page cache is allocated before we start
+ * to access files, so most buffers are registered here.
+ */
+void uring_aio_ctx::init_buf_table()
+{
+#ifdef IORING_RSRC_REGISTER_SPARSE
+	struct io_uring_rsrc_register reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.nr = MAX_REG_BUFS;
+	reg.flags = IORING_RSRC_REGISTER_SPARSE;
+	sparse_table = sys_io_uring_register(ring_fd, IORING_REGISTER_BUFFERS2,
+			&reg, sizeof(reg)) == 0;
+#endif
+	if (!sparse_table)
+		BOOST_LOG_TRIVIAL(info)
+			<< "io_uring can't create a sparse buffer table, new buffers are registered only when the ring is idle";
+	update_reg_bufs();
+}
+
+uring_aio_ctx::~uring_aio_ctx()
+{
+	if (sqes != MAP_FAILED)
+		munmap(sqes, sqes_size);
+	if (cq_ring_ptr != MAP_FAILED && cq_ring_ptr != sq_ring_ptr)
+		munmap(cq_ring_ptr, cq_ring_size);
+	if (sq_ring_ptr != MAP_FAILED)
+		munmap(sq_ring_ptr, sq_ring_size);
+	if (ring_fd >= 0)
+		close(ring_fd);
+}
+
+int uring_aio_ctx::enter(unsigned to_submit, unsigned min_complete,
+		unsigned flags)
+{
+	int ret;
+	do {
+		ret = sys_io_uring_enter(ring_fd, to_submit, min_complete, flags);
+	} while (ret < 0 && errno == EINTR);
+	return ret;
+}
+
+/**
+ * Register the new buffers in the registry to the kernel.
+ * With a sparse buffer table, the new buffers are added to the free slots
+ * of the table, which doesn't affect the requests in flight. Otherwise,
+ * registration replaces all fixed buffers, so it's only done when there
+ * aren't any requests in flight.
+ */
+void uring_aio_ctx::update_reg_bufs()
+{
+	if (reg_failed || reg_version == io_bufs_version)
+		return;
+	if (!sparse_table && busy_aio > 0)
+		return;
+
+	std::vector<struct iovec> bufs;
+	pthread_spin_lock(&io_bufs_lock);
+	bufs = io_bufs;
+	size_t version = io_bufs_version;
+	pthread_spin_unlock(&io_bufs_lock);
+	reg_version = version;
+
+	if (!sparse_table) {
+		if (!reg_bufs.empty())
+			sys_io_uring_register(ring_fd, IORING_UNREGISTER_BUFFERS, NULL, 0);
+		reg_bufs.clear();
+		if (sys_io_uring_register(ring_fd, IORING_REGISTER_BUFFERS,
+					bufs.data(), bufs.size()) < 0)
+			report_reg_failure(bufs, errno);
+		else
+			reg_bufs = bufs;
+		return;
+	}
+
+#ifdef IORING_RSRC_REGISTER_SPARSE
+	size_t num_bufs = std::min(bufs.size(), MAX_REG_BUFS);
+	while (reg_bufs.size() < num_bufs) {
+		struct io_uring_rsrc_update2 update;
+		memset(&update, 0, sizeof(update));
+		update.offset = reg_bufs.size();
+		update.data = (unsigned long) (bufs.data() + reg_bufs.size());
+		update.nr = num_bufs - reg_bufs.size();
+		// The kernel returns the number of buffers it has registered
+		// if it fails in the middle.
+		int ret = sys_io_uring_register(ring_fd,
+				IORING_REGISTER_BUFFERS_UPDATE, &update, sizeof(update));
+		if (ret <= 0) {
+			report_reg_failure(std::vector<struct iovec>(bufs.begin()
+						+ reg_bufs.size(), bufs.begin() + num_bufs), errno);
+			return;
+		}
+		reg_bufs.insert(reg_bufs.end(), bufs.begin() + reg_bufs.size(),
+				bufs.begin() + reg_bufs.size() + ret);
+	}
+	if (bufs.size() > MAX_REG_BUFS) {
+		BOOST_LOG_TRIVIAL(warning) << boost::format(
+				"io_uring supports at most %1% fixed buffers, %2% I/O buffers aren't registered")
+			% MAX_REG_BUFS % (bufs.size() - MAX_REG_BUFS);
+		reg_failed = true;
+	}
+#endif
+}
+
+/**
+ * Registration fails when the pinned buffers exceed RLIMIT_MEMLOCK in
+ * most cases. We stop registering buffers to the ring and access the
+ * buffers that aren't registered as regular buffers. The warning is only
+ * printed once because all rings fail in the same way.
+ */
+void uring_aio_ctx::report_reg_failure(const std::vector<struct iovec> &bufs,
+		int err)
+{
+	static volatile bool reported = false;
+
+	reg_failed = true;
+	if (!__sync_bool_compare_and_swap(&reported, false, true))
+		return;
+
+	size_t size = 0;
+	for (size_t i = 0; i < bufs.size(); i++)
+		size += bufs[i].iov_len;
+	struct rlimit limit;
+	std::string limit_str = "unknown";
+	if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0) {
+		if (limit.rlim_cur == RLIM_INFINITY)
+			limit_str = "unlimited";
+		else
+			limit_str = boost::str(boost::format("%1% bytes")
+					% limit.rlim_cur);
+	}
+	BOOST_LOG_TRIVIAL(warning) << boost::format(
+			"can't register %1% bytes of I/O buffers to io_uring: %2%. "
+			"Each io_uring instance pins its fixed buffers against "
+			"RLIMIT_MEMLOCK (%3%). Raise the limit to use fixed buffers. "
+			"Until then, the buffers that aren't registered are accessed "
+			"as regular buffers.")
+		% size % strerror(err) % limit_str;
+}
+
+/**
+ * Get the index of the registered buffer that contains the memory region.
+ * It returns -1 if the region isn't in a registered buffer.
+ */
+int uring_aio_ctx::get_reg_buf(const void *buf, size_t size) const
+{
+	const char *start = (const char *) buf;
+	for (size_t i = 0; i < reg_bufs.size(); i++) {
+		const char *reg_start = (const char *) reg_bufs[i].iov_base;
+		if (start >= reg_start && start + size
+				<= reg_start + reg_bufs[i].iov_len)
+			return i;
+	}
+	return -1;
+}
+
+void uring_aio_ctx::prep_sqe(struct io_uring_sqe *sqe, struct iocb *req)
+{
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->fd = req->aio_fildes;
+	sqe->user_data = (unsigned long) req;
+	switch (req->aio_lio_opcode) {
+		case IO_CMD_PREAD:
+		case IO_CMD_PWRITE:
+			{
+				bool is_read = req->aio_lio_opcode == IO_CMD_PREAD;
+				int buf_idx = get_reg_buf(req->u.c.buf, req->u.c.nbytes);
+				if (buf_idx >= 0) {
+					sqe->opcode = is_read ? IORING_OP_READ_FIXED
+						: IORING_OP_WRITE_FIXED;
+					sqe->buf_index = buf_idx;
+					num_fixed_reqs++;
+				}
+				else
+					sqe->opcode = is_read ? IORING_OP_READ : IORING_OP_WRITE;
+				sqe->addr = (unsigned long) req->u.c.buf;
+				sqe->len = req->u.c.nbytes;
+				sqe->off = req->u.c.offset;
+				break;
+			}
+		case IO_CMD_PREADV:
+		case IO_CMD_PWRITEV:
+			sqe->opcode = req->aio_lio_opcode == IO_CMD_PREADV
+				? IORING_OP_READV : IORING_OP_WRITEV;
+			sqe->addr = (unsigned long) req->u.v.vec;
+			sqe->len = req->u.v.nr;
+			sqe->off = req->u.v.offset;
+			break;
+		default:
+			ABORT_MSG(boost::str(boost::format("unsupported AIO opcode %1%")
+						% req->aio_lio_opcode));
+	}
+}
+
+void uring_aio_ctx::submit_io_request(struct iocb* ioq[], int num)
+{
+	assert(busy_aio + num <= max_aio);
+	update_reg_bufs();
+
+	// We are the only one that writes to the tail of the submission ring.
+	unsigned tail = *sq_tail;
+	unsigned mask = *sq_mask;
+	for (int i = 0; i < num; i++) {
+		unsigned idx = tail & mask;
+		prep_sqe(&sqes[idx], ioq[i]);
+		sq_array[idx] = idx;
+		tail++;
+	}
+	__atomic_store_n(sq_tail, tail, __ATOMIC_RELEASE);
+
+	int num_submitted = 0;
+	while (num_submitted < num) {
+		int ret = enter(num - num_submitted, 0, 0);
+		num_submit_calls++;
+		if (ret < 0) {
+			fprintf(stderr, "io_uring_enter: %s\n", strerror(errno));
+			exit(1);
+		}
+		num_submitted += ret;
+	}
+	busy_aio += num;
+	num_reqs += num;
+}
+
+/**
+ * Get the completed requests from the completion ring.
+ */
+int uring_aio_ctx::reap(struct iocb *iocbs[], long res[], int max)
+{
+	unsigned head = *cq_head;
+	unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+	unsigned mask = *cq_mask;
+	int n = 0;
+	while (head != tail && n < max) {
+		struct io_uring_cqe *cqe = &cqes[head & mask];
+		iocbs[n] = (struct iocb *) cqe->user_data;
+		res[n] = cqe->res;
+		n++;
+		head++;
+	}
+	__atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+	return n;
+}
+
+int uring_aio_ctx::io_wait(struct timespec* to, int num)
+{
+	struct iocb *iocbs[max_aio];
+	long res[max_aio];
+	int n = reap(iocbs, res, max_aio);
+	// We only enter the kernel if there aren't enough completed requests.
+	// Only a zero timeout is supported, which means we don't wait.
+	bool can_wait = to == NULL || to->tv_sec > 0 || to->tv_nsec > 0;
+	while (n < num && can_wait) {
+		int ret = enter(0, num - n, IORING_ENTER_GETEVENTS);
+		num_wait_calls++;
+		if (ret < 0) {
+			fprintf(stderr, "io_uring_enter: %s\n", strerror(errno));
+			break;
+		}
+		n += reap(iocbs + n, res + n, max_aio - n);
+	}
+	if (n == 0)
+		return 0;
+
+	long res2[n];
+	io_callback_s *cbs[n];
+	callback_t cb_func = NULL;
+	for (int i = 0; i < n; i++) {
+		cbs[i] = (io_callback_s *) iocbs[i]->data;
+		if (cb_func == NULL)
+			cb_func = cbs[i]->func;
+		assert(cb_func == cbs[i]->func);
+		res2[i] = 0;
+	}
+
+	cb_func(NULL, iocbs, (void **) cbs, res, res2, n);
+
+	busy_aio -= n;
+	destroy_io_requests(iocbs, n);
+	return n;
+}
+
+void uring_aio_ctx::print_stat()
+{
+	BOOST_LOG_TRIVIAL(info) << boost::format(
+			"io_uring: %1% reqs (%2% to fixed buffers), %3% submit calls, %4% wait calls, %5% fixed buffers%6%")
+		% num_reqs % num_fixed_reqs % num_submit_calls % num_wait_calls
+		% reg_bufs.size() % (reg_failed ? " (registration failed)" : "");
+}
@@ -17,9 +17,15 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <string.h>
+
 #include <algorithm>
 
+#include <boost/format.hpp>
+
 #include "virt_aio_ctx.h"
+#include "config_map.h"
 
 const int MIN_READ_DELAY = 100;
 const int MAX_RAND_READ_DELAY = 100;		// in microseconds
@@ -38,11 +44,12 @@ struct timeval add2timeval(const struct timeval time, long added_delay)
 class naive_ssd_perf_model: public ssd_perf_model
 {
 public:
-	virtual long get_read_delay(off_t off, size_t size);
-	virtual long get_write_delay(off_t off, size_t size);
+	virtual long get_read_delay(long curr_time, off_t off, size_t size);
+	virtual long get_write_delay(long curr_time, off_t off, size_t size);
 };
 
-long naive_ssd_perf_model::get_read_delay(off_t off, size_t size)
+long naive_ssd_perf_model::get_read_delay(long curr_time, off_t off,
+		size_t size)
 {
 	// We introduce some random delay in each request.
 	// The delay is in microseconds.
@@ -53,7 +60,8 @@ long naive_ssd_perf_model::get_read_delay(off_t off, size_t size)
 	return rand_delay + MIN_READ_DELAY * num_pages;
 }
 
-long naive_ssd_perf_model::get_write_delay(off_t off, size_t size)
+long naive_ssd_perf_model::get_write_delay(long curr_time, off_t off,
+		size_t size)
 {
 	int rand_delay = random() % MAX_RAND_WRITE_DELAY;
 	int num_pages = size / PAGE_SIZE;
@@ -62,12 +70,120 @@ long naive_ssd_perf_model::get_write_delay(off_t off, size_t size)
 	return rand_delay + MIN_WRITE_DELAY * num_pages;
 }
 
+ssd_profile::ssd_profile()
+{
+	num_channels = 8;
+	read_latency = MIN_READ_DELAY;
+	write_latency = MIN_WRITE_DELAY;
+	read_bandwidth = 500L * 1024 * 1024;
+	write_bandwidth = 400L * 1024 * 1024;
+}
+
+bool ssd_profile::load(const std::string &file)
+{
+	config_map::ptr configs = config_map::create(file);
+	if (configs == NULL)
+		return false;
+
+	std::string value;
+	configs->read_option_int("num_channels", num_channels);
+	if (configs->read_option("read_latency", value))
+		read_latency = atol(value.c_str());
+	if (configs->read_option("write_latency", value))
+		write_latency = atol(value.c_str());
+	if (configs->read_option("read_bandwidth", value))
+		read_bandwidth = str2size(value);
+	if (configs->read_option("write_bandwidth", value))
+		write_bandwidth = str2size(value);
+	return num_channels > 0 && read_latency >= 0 && write_latency >= 0
+		&& read_bandwidth > 0 && write_bandwidth > 0;
+}
+
+bool ssd_profile::save(const std::string &file) const
+{
+	FILE *f = fopen(file.c_str(), "w");
+	if (f == NULL) {
+		BOOST_LOG_TRIVIAL(error) << boost::format("can't open %1%: %2%")
+			% file % strerror(errno);
+		return false;
+	}
+	fprintf(f, "# The profile of an SSD for the performance model of virtual AIO.\n");
+	fprintf(f, "# Latencies are in microseconds and bandwidth is in bytes per second.\n");
+	fprintf(f, "num_channels=%d\n", num_channels);
+	fprintf(f, "read_latency=%ld\n", read_latency);
+	fprintf(f, "write_latency=%ld\n", write_latency);
+	fprintf(f, "read_bandwidth=%ld\n", read_bandwidth);
+	fprintf(f, "write_bandwidth=%ld\n", write_bandwidth);
+	fclose(f);
+	return true;
+}
+
+queued_ssd_perf_model::queued_ssd_perf_model(
+		const ssd_profile &profile): channel_free_times(profile.num_channels)
+{
+	this->profile = profile;
+	bus_free_time = 0;
+}
+
+long queued_ssd_perf_model::get_delay(long curr_time, off_t off, size_t size,
+		long latency, long bandwidth)
+{
+	off_t first_page = off / PAGE_SIZE;
+	off_t last_page = (off + std::max(size, 1UL) - 1) / PAGE_SIZE;
+	long flash_done = curr_time;
+	for (off_t pg = first_page; pg <= last_page; pg++) {
+		long &free_time = channel_free_times[pg % profile.num_channels];
+		free_time = std::max(free_time, curr_time) + latency;
+		flash_done = std::max(flash_done, free_time);
+	}
+	// The host interface transfers the data of requests in the order of
+	// arrival. The transfer overlaps with the flash accesses of
+	// the request, so it only matters when the bandwidth saturates.
+	bus_free_time = std::max(bus_free_time, curr_time)
+		+ size * 1000000 / bandwidth;
+	return std::max(flash_done, bus_free_time) - curr_time;
+}
+
+/**
+ * Read or write the data of a request in the file.
+ */
+static ssize_t access_file(struct iocb *req)
+{
+	int fd = req->aio_fildes;
+	off_t offset = req->u.c.offset;
+	switch (req->aio_lio_opcode) {
+		case IO_CMD_PREAD:
+			return pread(fd, req->u.c.buf, req->u.c.nbytes, offset);
+		case IO_CMD_PWRITE:
+			return pwrite(fd, req->u.c.buf, req->u.c.nbytes, offset);
+		case IO_CMD_PREADV:
+			return preadv(fd, (struct iovec *) req->u.c.buf, req->u.c.nbytes,
+					offset);
+		case IO_CMD_PWRITEV:
+			return pwritev(fd, (struct iovec *) req->u.c.buf, req->u.c.nbytes,
+					offset);
+		default:
+			errno = EINVAL;
+			return -1;
+	}
+}
+
 virt_aio_ctx::virt_aio_ctx(virt_data *data, int node_id,
 		int max_aio): aio_ctx(node_id, max_aio), pending_reqs(node_id, max_aio)
 {
 	this->max_aio = max_aio;
 	this->data = data;
-	this->model = new naive_ssd_perf_model();
+	const std::string &model_file = params.get_ssd_model_file();
+	access_data = !model_file.empty();
+	if (access_data) {
+		ssd_profile profile;
+		if (!profile.load(model_file))
+			ABORT_MSG(boost::format("can't load the SSD profile from %1%")
+					% model_file);
+		this->model = new queued_ssd_perf_model(profile);
+	}
+	else
+		this->model = new naive_ssd_perf_model();
 
 	read_bytes = 0;
 	write_bytes = 0;
@@ -76,6 +192,11 @@ virt_aio_ctx::virt_aio_ctx(virt_data *data, int node_id,
 	memset(&prev_print_time, 0, sizeof(prev_print_time));
 }
 
+virt_aio_ctx::~virt_aio_ctx()
+{
+	delete model;
+}
+
 struct comp_issued_request
 {
 	bool operator() (const struct req_entry &req1,
@@ -107,17 +228,18 @@ void virt_aio_ctx::submit_io_request(struct iocb* ioq[], int num)
 	struct timeval curr;
 
 	gettimeofday(&curr, NULL);
+	long curr_us = curr.tv_sec * 1000000L + curr.tv_usec;
 	for (int i = 0; i < num; i++) {
 		entries[i].req = ioq[i];
 
 		off_t off = ioq[i]->u.c.offset;
 		if (ioq[i]->aio_lio_opcode == IO_CMD_PREAD
 				|| ioq[i]->aio_lio_opcode == IO_CMD_PREADV) {
-			long delay = model->get_read_delay(off, get_size(ioq[i]));
+			long delay = model->get_read_delay(curr_us, off, get_size(ioq[i]));
 			entries[i].issue_time = add2timeval(curr, delay);
 		}
 		else {
-			long delay = model->get_write_delay(off, get_size(ioq[i]));
+			long delay = model->get_write_delay(curr_us, off, get_size(ioq[i]));
 			entries[i].issue_time = add2timeval(curr, delay);
 		}
 	}
@@ -185,6 +307,12 @@ int virt_aio_ctx::io_wait(struct timespec* to, int num)
 			cb_func = cbs[i]->func;
 		assert(cb_func == cbs[i]->func);
 		iocbs[i] = entries[i].req;
+		// The data in the files is accessed when the request completes,
+		// so the requests see the data in the order of completion.
+		if (access_data && !params.is_verify_content()
+				&& access_file(iocbs[i]) < 0)
+			ABORT_MSG(boost::format("virtual AIO fails to access fd %1%: %2%")
+					% iocbs[i]->aio_fildes % strerror(errno));
 		if (iocbs[i]->aio_lio_opcode == IO_CMD_PREADV) {
 			off_t offset = iocbs[i]->u.c.offset;
 			int num_vecs = iocbs[i]->u.c.nbytes;
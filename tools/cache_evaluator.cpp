@@ -1,23 +1,180 @@
 /**
  * This program is to evaluate the cache hit rate given a workload sequence.
+ * The "policies" cache type replays the workload on a simulated SA-cache
+ * with each eviction policy of associative_cache, so we can compare
+ * the policies on the same workload.
  */
 
 #include "workload.h"
+#include "io_interface.h"
 #include "cache.h"
 #include "associative_cache.h"
+#if 0
 #include "hash_index_cache.h"
 #include "LRU2Q.h"
+#endif
 #include "common.h"
 
 #include <string>
+#include <vector>
+#include <map>
 
 int nthreads = 1;
 
+/*
+ * The pages in the simulated cache never contain data, but a page
+ * needs a data buffer to be considered as a page in the cell.
+ */
+static char page_data[PAGE_SIZE];
+
+/**
+ * A hash cell that only runs the eviction policy.
+ * It follows what hash_cell::search does.
+ */
+template<class policy_t>
+class sim_cell
+{
+	page_cell<thread_safe_page> buf;
+	policy_t policy;
+public:
+	sim_cell(int num_pages) {
+		char *pages[CELL_SIZE];
+		for (int i = 0; i < num_pages; i++)
+			pages[i] = page_data;
+		buf.set_pages(pages, num_pages, 0);
+	}
+
+	bool access(off_t off) {
+		thread_safe_page *pg = NULL;
+		for (unsigned int i = 0; i < buf.get_num_pages(); i++) {
+			if (buf.get_page(i)->get_offset() == off) {
+				pg = buf.get_page(i);
+				break;
+			}
+		}
+		bool hit = pg != NULL;
+		if (hit)
+			policy.access_page(pg, buf);
+		else {
+			pg = policy.evict_page(buf);
+			assert(pg);
+			pg->set_id(page_id_t(0, off));
+			policy.insert_page(pg, buf);
+		}
+		if (pg->get_hits() == 0xff)
+			buf.scale_down_hits();
+		pg->hit();
+		return hit;
+	}
+};
+
+template<class policy_t>
+void evaluate(const std::string &name, const std::vector<off_t> &accesses,
+		long cache_size, int cell_size)
+{
+	long num_cells = cache_size / PAGE_SIZE / cell_size;
+	assert(num_cells > 0);
+	std::vector<sim_cell<policy_t> *> cells(num_cells);
+	for (long i = 0; i < num_cells; i++)
+		cells[i] = new sim_cell<policy_t>(cell_size);
+
+	long num_hits = 0;
+	long num_counted = 0;
+	for (size_t i = 0; i < accesses.size(); i++) {
+		off_t off = accesses[i];
+		bool hit = cells[(off / PAGE_SIZE) % num_cells]->access(off);
+		// We only count the cache hits for the second half of the workload.
+		if (i >= accesses.size() / 2) {
+			num_counted++;
+			if (hit)
+				num_hits++;
+		}
+	}
+	printf("%s: %ld hits in %ld page accesses (%.2f%%)\n", name.c_str(),
+			num_hits, num_counted, ((double) num_hits) / num_counted * 100);
+
+	for (long i = 0; i < num_cells; i++)
+		delete cells[i];
+}
+
+/**
+ * Load the workload from a file and split the requests into pages.
+ */
+static void load_accesses(const std::string &workload_file,
+		std::vector<off_t> &accesses)
+{
+	long length = 0;
+	workload_t *workloads = load_file_workload(workload_file, length);
+	printf("There are %ld requests\n", length);
+	for (long i = 0; i < length; i++) {
+		off_t off = ROUND_PAGE(workloads[i].off);
+		off_t end = workloads[i].off + workloads[i].size;
+		assert(off < end);
+		for (; off < end; off += PAGE_SIZE)
+			accesses.push_back(off);
+	}
+	free(workloads);
+}
+
+/**
+ * Generate a workload that mixes random accesses to a hot set with
+ * sequential scans of a large range, e.g., BFS queries between iterations
+ * of a full-graph algorithm.
+ */
+static void gen_scan_accesses(long num_hot_pages, long num_scan_pages,
+		int num_rounds, std::vector<off_t> &accesses)
+{
+	for (int i = 0; i < num_rounds; i++) {
+		for (long j = 0; j < num_hot_pages * 4; j++)
+			accesses.push_back((random() % num_hot_pages) * PAGE_SIZE);
+		for (long j = 0; j < num_scan_pages; j++)
+			accesses.push_back((num_hot_pages + j) * PAGE_SIZE);
+	}
+}
+
+/**
+ * Compare the eviction policies on simulated SA-cache cells.
+ */
+static int evaluate_policies(const std::string &workload, long cache_size,
+		int cell_size)
+{
+	if (cell_size <= 0 || cell_size > CELL_SIZE) {
+		fprintf(stderr, "wrong cell size: %d\n", cell_size);
+		return 1;
+	}
+
+	std::vector<off_t> accesses;
+	if (workload.find("scan:") == 0) {
+		long num_hot_pages = 0;
+		long num_scan_pages = 0;
+		if (sscanf(workload.c_str(), "scan:%ld:%ld", &num_hot_pages,
+					&num_scan_pages) != 2 || num_hot_pages <= 0) {
+			fprintf(stderr, "wrong synthetic workload: %s\n", workload.c_str());
+			return 1;
+		}
+		gen_scan_accesses(num_hot_pages, num_scan_pages, 10, accesses);
+	}
+	else
+		load_accesses(workload, accesses);
+	printf("There are %ld page accesses\n", accesses.size());
+
+	evaluate<LRU_eviction_policy>("LRU", accesses, cache_size, cell_size);
+	evaluate<LFU_eviction_policy>("LFU", accesses, cache_size, cell_size);
+	evaluate<FIFO_eviction_policy>("FIFO", accesses, cache_size, cell_size);
+	evaluate<clock_eviction_policy>("clock", accesses, cache_size, cell_size);
+	evaluate<gclock_eviction_policy>("gclock", accesses, cache_size, cell_size);
+	evaluate<S3FIFO_eviction_policy>("S3-FIFO", accesses, cache_size, cell_size);
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	if (argc < 4) {
 		fprintf(stderr, "cache_evaluator workload_file cache_type cache_size [cell_size]\n");
-		fprintf(stderr, "supported cache types: associative, hash-index, lru2q\n");
+		fprintf(stderr, "supported cache types: associative, hash-index, lru2q, policies\n");
+		fprintf(stderr, "policies compares the eviction policies of SA-cache. Its workload can also be\n");
+		fprintf(stderr, "scan:num_hot_pages:num_scan_pages, which generates random accesses to the hot pages\n");
+		fprintf(stderr, "mixed with scans\n");
 		return 1;
 	}
 	std::string workload_file = argv[1];
@@ -25,21 +182,33 @@ int main(int argc, char *argv[])
 	// Cache size in bytes.
 	long cache_size = str2size(argv[3]);
 	printf("The cache size is %ld bytes\n", cache_size);
-	int cell_size = atoi(argv[4]);
+	int cell_size = params.get_SA_min_cell_size();
+	if (argc > 4)
+		cell_size = atoi(argv[4]);
 	printf("The cell size of SA-cache is %d\n", cell_size);
-	params.init(1, cell_size, 0);
+	if (cache_type == "policies")
+		return evaluate_policies(workload_file, cache_size, cell_size);
+	std::map<std::string, std::string> configs;
+	configs["SA_cell_size"] = itoa(cell_size);
+	params.init(configs);
 
 	page_cache *global_cache;
-	if (cache_type == "lru2q") {
-		global_cache = new LRU2Q_cache(cache_size);
-	}
-	else if (cache_type == "associative") {
+	if (cache_type == "associative") {
 		global_cache = associative_cache::create(cache_size, MAX_CACHE_SIZE, 0, 1, -1);
 	}
+#if 0
+	else if (cache_type == "lru2q") {
+		global_cache = new LRU2Q_cache(cache_size);
+	}
 	else if (cache_type == "hash-index") {
 		global_cache = new hash_index_cache(cache_size, 0);
 	}
-	global_cache->init(NULL);
+#endif
+	else {
+		fprintf(stderr, "cache type %s isn't supported\n", cache_type.c_str());
+		return 1;
+	}
+	global_cache->init(io_interface::ptr());
 
 	int num_hits = 0;
 	int num_accesses_in_pages = 0;
@@ -58,12 +227,14 @@ int main(int argc, char *argv[])
 		num_accesses++;
 		assert(off < end);
 		while (off < end) {
-			off_t old_off = -1;
-			thread_safe_page *pg = (thread_safe_page *) global_cache->search(off, old_off);
+			page_id_t old_id;
+			thread_safe_page *pg = (thread_safe_page *) global_cache->search(
+					page_id_t(0, off), old_id);
+			assert(pg);
 			// We only count the cache hits for the second half of the workload.
 			if (num_accesses >= size / 2) {
 				num_accesses_in_pages++;
-				if (old_off == -1)
+				if (old_id.get_offset() == -1)
 					num_hits++;
 			}
 			pg->dec_ref();
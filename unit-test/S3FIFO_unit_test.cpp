@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include <typeinfo>
+
+#include "cache.h"
+#include "associative_cache.h"
+#include "io_interface.h"
+
+const int NUM_PAGES = 16;
+
+/*
+ * The pages in the cell never contain data, but a page needs a data buffer
+ * to be considered as a page in the cell.
+ */
+char page_data[PAGE_SIZE];
+
+/*
+ * Fill the cell with pages through the eviction policy, the same way
+ * as hash_cell::search does.
+ */
+void fill_cell(S3FIFO_eviction_policy &policy,
+		page_cell<thread_safe_page> &buf)
+{
+	char *pages[NUM_PAGES];
+	for (int i = 0; i < NUM_PAGES; i++)
+		pages[i] = page_data;
+	buf.set_pages(pages, NUM_PAGES, 0);
+	for (int i = 0; i < NUM_PAGES; i++) {
+		thread_safe_page *pg = policy.evict_page(buf);
+		assert(pg);
+		assert(!pg->is_valid());
+		pg->set_id(page_id_t(0, ((off_t) i) * PAGE_SIZE));
+		policy.insert_page(pg, buf);
+		pg->hit();
+	}
+}
+
+/*
+ * The new pages in the small queue are referenced while their reads are
+ * in flight. The policy should evict an idle page in the main queue
+ * instead of failing.
+ */
+void test_referenced_small_queue()
+{
+	S3FIFO_eviction_policy policy;
+	page_cell<thread_safe_page> buf;
+	fill_cell(policy, buf);
+
+	// The pages accessed again move to the main queue at the next eviction.
+	const int num_new = 3;
+	for (int i = 0; i < NUM_PAGES - num_new; i++)
+		buf.get_page(i)->hit();
+	for (int i = NUM_PAGES - num_new; i < NUM_PAGES; i++)
+		buf.get_page(i)->inc_ref();
+
+	for (int i = 0; i < NUM_PAGES - num_new; i++) {
+		thread_safe_page *pg = policy.evict_page(buf);
+		assert(pg);
+		assert(pg->get_ref() == 0);
+		// The evicted page stays in the cell as a referenced new page.
+		pg->set_id(page_id_t(0, ((off_t) NUM_PAGES + i) * PAGE_SIZE));
+		policy.insert_page(pg, buf);
+		pg->hit();
+		pg->inc_ref();
+	}
+	// All pages in the cell are referenced now.
+	assert(policy.evict_page(buf) == NULL);
+
+	buf.get_page(0)->dec_ref();
+	assert(policy.evict_page(buf) == buf.get_page(0));
+	printf("evicting pages with a referenced small queue passes the test\n");
+}
+
+/*
+ * The pages accessed only once are evicted before the pages accessed again.
+ */
+void test_scan_resistance()
+{
+	S3FIFO_eviction_policy policy;
+	page_cell<thread_safe_page> buf;
+	fill_cell(policy, buf);
+	const int num_hot = NUM_PAGES / 2;
+	for (int i = 0; i < num_hot; i++)
+		buf.get_page(i)->hit();
+
+	for (int i = 0; i < NUM_PAGES * 4; i++) {
+		thread_safe_page *pg = policy.evict_page(buf);
+		assert(pg);
+		assert(pg->get_offset() >= num_hot * PAGE_SIZE);
+		pg->set_id(page_id_t(0, ((off_t) NUM_PAGES + i) * PAGE_SIZE));
+		policy.insert_page(pg, buf);
+		pg->hit();
+	}
+	printf("scan resistance passes the test\n");
+}
+
+void access_page(associative_cache *cache, off_t idx)
+{
+	page_id_t old_id;
+	page *pg = cache->search(page_id_t(0, idx * PAGE_SIZE), old_id);
+	assert(pg);
+	pg->dec_ref();
+}
+
+/*
+ * The SA-cache uses S3-FIFO, so the hot pages stay in the cache when
+ * a scan reads many more pages than the cache size.
+ */
+void test_associative_cache()
+{
+	const long cache_size = 16 * 1024 * 1024;
+	const long cache_npages = cache_size / PAGE_SIZE;
+	const long num_hot = cache_npages / 10;
+	associative_cache *cache = associative_cache::create(cache_size,
+			cache_size, 0, 1, -1);
+	cache->init(io_interface::ptr());
+	assert(typeid(cache->get_cell(0)->get_policy())
+			== typeid(S3FIFO_eviction_policy));
+
+	// The hot pages are accessed twice, so they are moved to the main queue.
+	for (int i = 0; i < 2; i++)
+		for (long j = 0; j < num_hot; j++)
+			access_page(cache, j);
+	for (long j = num_hot; j < num_hot + cache_npages * 4; j++)
+		access_page(cache, j);
+
+	long num_cached = 0;
+	for (long j = 0; j < num_hot; j++) {
+		page *pg = cache->search(page_id_t(0, j * PAGE_SIZE));
+		if (pg) {
+			num_cached++;
+			pg->dec_ref();
+		}
+	}
+	assert(num_cached == num_hot);
+	associative_cache::destroy(cache);
+	printf("the SA-cache with S3-FIFO passes the test\n");
+}
+
+int main()
+{
+	test_referenced_small_queue();
+	test_scan_resistance();
+	test_associative_cache();
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "lz_codec.h"
+#include "compressed_cache.h"
+
+/*
+ * Generate the content of a page. Some pages compress well and some don't.
+ */
+void gen_page(off_t pg_idx, char *buf)
+{
+	long *words = (long *) buf;
+	for (int i = 0; i < PAGE_SIZE / 8; i++) {
+		if (pg_idx % 5 == 0)
+			words[i] = random();
+		else
+			words[i] = (pg_idx * PAGE_SIZE + i * 8) >> 6;
+	}
+}
+
+void test_codec()
+{
+	char src[PAGE_SIZE];
+	char comp[lz_compress_bound(PAGE_SIZE)];
+	char out[PAGE_SIZE];
+	for (int i = 0; i < 10000; i++) {
+		int size = 1 + random() % PAGE_SIZE;
+		gen_page(i, src);
+		// Add some repeated bytes.
+		memset(src + random() % size, 0, random() % 64);
+		int comp_size = lz_compress(src, size, comp, sizeof(comp));
+		assert(comp_size > 0);
+		assert(lz_decompress(comp, comp_size, out, PAGE_SIZE) == size);
+		assert(memcmp(src, out, size) == 0);
+		// The compressed data doesn't fit in the buffer.
+		assert(lz_compress(src, size, comp, comp_size - 1) == 0);
+	}
+	// Decompressing random data shouldn't overflow the output buffer.
+	for (int i = 0; i < 10000; i++) {
+		for (int j = 0; j < 64; j++)
+			comp[j] = random();
+		lz_decompress(comp, 64, out, PAGE_SIZE);
+	}
+	printf("the codec passes the test\n");
+}
+
+void test_cache()
+{
+	const int num_pages = 4096;
+	// The cache can only keep part of the pages.
+	compressed_page_cache *cache = compressed_page_cache::create(
+			1024 * 1024, 0);
+	char buf[PAGE_SIZE];
+	char expected[PAGE_SIZE];
+	for (int i = 0; i < num_pages; i++) {
+		gen_page(i, buf);
+		cache->add(page_id_t(0, i * PAGE_SIZE), buf);
+	}
+	int num_hits = 0;
+	for (int i = 0; i < num_pages; i++) {
+		if (!cache->fetch(page_id_t(0, i * PAGE_SIZE), buf))
+			continue;
+		num_hits++;
+		gen_page(i, expected);
+		assert(memcmp(buf, expected, PAGE_SIZE) == 0);
+		// The page is removed from the cache once it's fetched.
+		assert(!cache->fetch(page_id_t(0, i * PAGE_SIZE), buf));
+	}
+	// The most recent pages are in the cache, but the random pages are not.
+	assert(num_hits > 0);
+	for (int i = 0; i < num_pages; i += 5)
+		assert(!cache->fetch(page_id_t(0, i * PAGE_SIZE), buf));
+	printf("%d of %d pages are in the compressed cache\n", num_hits, num_pages);
+	cache->print_stat();
+	compressed_page_cache::destroy(cache);
+}
+
+int main()
+{
+	test_codec();
+	test_cache();
+}
@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <assert.h>
+
+#include "disk_read_thread.h"
+
+const int NUM_REQS = 64;
+const int SMALL_REQ_SIZE = PAGE_SIZE;
+const int LARGE_REQ_SIZE = PAGE_SIZE * 16;
+
+void add_reqs(io_class_scheduler &scheduler, int io_class, int file_id,
+		int size, int num)
+{
+	for (int i = 0; i < num; i++) {
+		data_loc_t loc(file_id, ((off_t) i) * size);
+		io_request req((char *) NULL, loc, size, READ);
+		req.set_io_class(io_class);
+		scheduler.add(&req, 1);
+	}
+}
+
+/*
+ * Small critical requests shouldn't wait behind large normal requests.
+ * The requests in the same class are dispatched in the order of arrival.
+ */
+void test_priority()
+{
+	io_class_scheduler scheduler(0);
+	add_reqs(scheduler, IO_CLASS_NORMAL, 1, LARGE_REQ_SIZE, NUM_REQS);
+	add_reqs(scheduler, IO_CLASS_CRITICAL, 0, SMALL_REQ_SIZE, NUM_REQS);
+	assert(scheduler.get_num_reqs() == NUM_REQS * 2);
+
+	io_request reqs[NUM_REQS * 2];
+	int num = scheduler.fetch(reqs, NUM_REQS / 2);
+	assert(num == NUM_REQS / 2);
+	int num_normal = 0;
+	for (int i = 0; i < num; i++) {
+		if (reqs[i].get_io_class() == IO_CLASS_NORMAL)
+			num_normal++;
+	}
+	assert(num_normal <= 1);
+
+	num += scheduler.fetch(reqs + num, NUM_REQS * 2);
+	assert(num == NUM_REQS * 2);
+	assert(scheduler.is_empty());
+	off_t next_offs[NUM_IO_CLASSES] = {0, 0, 0};
+	for (int i = 0; i < num; i++) {
+		int c = reqs[i].get_io_class();
+		assert(reqs[i].get_offset() == next_offs[c]);
+		next_offs[c] += reqs[i].get_size();
+	}
+	printf("test_priority passes\n");
+}
+
+/*
+ * All classes get disk bandwidth in proportion to their weights, and
+ * a class that has been idle can't starve the other classes when it
+ * becomes busy.
+ */
+void test_fairness()
+{
+	io_class_scheduler scheduler(0);
+	add_reqs(scheduler, IO_CLASS_BACKGROUND, 2, LARGE_REQ_SIZE, NUM_REQS);
+	io_request reqs[NUM_REQS * 2];
+	assert(scheduler.fetch(reqs, NUM_REQS / 2) == NUM_REQS / 2);
+
+	add_reqs(scheduler, IO_CLASS_NORMAL, 1, LARGE_REQ_SIZE, NUM_REQS);
+	int num = scheduler.fetch(reqs, NUM_REQS / 2);
+	assert(num == NUM_REQS / 2);
+	int num_background = 0;
+	for (int i = 0; i < num; i++) {
+		if (reqs[i].get_io_class() == IO_CLASS_BACKGROUND)
+			num_background++;
+	}
+	// The normal class has 4 times the weight of the background class.
+	assert(num_background > 0 && num_background < num / 2);
+	printf("test_fairness passes\n");
+}
+
+/*
+ * A window only contains the requests of one class. The requests put back
+ * are fetched again first, and their class isn't charged for them.
+ */
+void test_window()
+{
+	io_class_scheduler scheduler(0);
+	add_reqs(scheduler, IO_CLASS_NORMAL, 1, LARGE_REQ_SIZE, NUM_REQS);
+	add_reqs(scheduler, IO_CLASS_CRITICAL, 0, SMALL_REQ_SIZE, NUM_REQS);
+	io_request reqs[NUM_REQS * 2];
+	int num = scheduler.fetch_class(reqs, NUM_REQS * 2);
+	assert(num == NUM_REQS);
+	int io_class = reqs[0].get_io_class();
+	for (int i = 0; i < num; i++)
+		assert(reqs[i].get_io_class() == io_class);
+
+	// No request is dispatched, so we get the same window again.
+	scheduler.put_back(reqs, num);
+	assert(scheduler.get_num_reqs() == NUM_REQS * 2);
+	num = scheduler.fetch_class(reqs, NUM_REQS * 2);
+	assert(num == NUM_REQS);
+	for (int i = 0; i < num; i++) {
+		assert(reqs[i].get_io_class() == io_class);
+		assert(reqs[i].get_offset() == i * reqs[i].get_size());
+	}
+	// Only the first request is dispatched.
+	scheduler.put_back(reqs + 1, num - 1);
+	assert(scheduler.get_num_reqs() == NUM_REQS * 2 - 1);
+
+	// The classes still share the disk as if the requests weren't put back.
+	num = scheduler.fetch(reqs, NUM_REQS / 2);
+	int num_normal = 0;
+	for (int i = 0; i < num; i++) {
+		if (reqs[i].get_io_class() == IO_CLASS_NORMAL)
+			num_normal++;
+	}
+	assert(num_normal <= 2);
+	num += scheduler.fetch(reqs + num, NUM_REQS * 2);
+	assert(num == NUM_REQS * 2 - 1);
+	assert(scheduler.is_empty());
+	printf("test_window passes\n");
+}
+
+int main()
+{
+	test_priority();
+	test_fairness();
+	test_window();
+}
@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "virt_aio_ctx.h"
+
+ssd_profile get_test_profile()
+{
+	ssd_profile profile;
+	profile.num_channels = 4;
+	profile.read_latency = 100;
+	profile.write_latency = 400;
+	// It takes 1us to transfer a page.
+	profile.read_bandwidth = PAGE_SIZE * 1000000L;
+	profile.write_bandwidth = PAGE_SIZE * 1000000L;
+	return profile;
+}
+
+/*
+ * Requests on different channels are served in parallel, and requests
+ * on the same channel queue up.
+ */
+void test_channels()
+{
+	queued_ssd_perf_model model(get_test_profile());
+	long curr = 1000000;
+	for (int i = 0; i < 4; i++) {
+		long delay = model.get_read_delay(curr, i * PAGE_SIZE, PAGE_SIZE);
+		assert(delay == 100);
+	}
+	// The page is on the first channel.
+	assert(model.get_read_delay(curr, 4 * PAGE_SIZE, PAGE_SIZE) == 200);
+
+	// A write occupies its channel longer and delays the reads behind it.
+	curr += 10000;
+	assert(model.get_write_delay(curr, 0, PAGE_SIZE) == 400);
+	assert(model.get_read_delay(curr, 4 * PAGE_SIZE, PAGE_SIZE) == 500);
+	assert(model.get_read_delay(curr, PAGE_SIZE, PAGE_SIZE) == 100);
+
+	// A large request is striped across all channels.
+	curr += 10000;
+	assert(model.get_read_delay(curr, 0, PAGE_SIZE * 8) == 200);
+	printf("test_channels passes\n");
+}
+
+/*
+ * Requests wait for the host interface when the bandwidth saturates.
+ */
+void test_bandwidth()
+{
+	ssd_profile profile = get_test_profile();
+	// It takes 1ms to transfer a page.
+	profile.read_bandwidth = PAGE_SIZE * 1000L;
+	queued_ssd_perf_model model(profile);
+	long curr = 1000000;
+	for (int i = 0; i < 16; i++) {
+		long delay = model.get_read_delay(curr, i * PAGE_SIZE, PAGE_SIZE);
+		assert(delay == (i + 1) * 1000);
+	}
+	printf("test_bandwidth passes\n");
+}
+
+/*
+ * The same sequence of requests always gets the same delays.
+ */
+void test_deterministic()
+{
+	queued_ssd_perf_model model1(get_test_profile());
+	queued_ssd_perf_model model2(get_test_profile());
+	long curr = 0;
+	for (int i = 0; i < 10000; i++) {
+		curr += i % 7;
+		off_t off = ((i * 7919L) % 1024) * PAGE_SIZE;
+		size_t size = (i % 3 + 1) * PAGE_SIZE;
+		if (i % 5 == 0)
+			assert(model1.get_write_delay(curr, off, size)
+					== model2.get_write_delay(curr, off, size));
+		else
+			assert(model1.get_read_delay(curr, off, size)
+					== model2.get_read_delay(curr, off, size));
+	}
+	printf("test_deterministic passes\n");
+}
+
+void test_profile()
+{
+	ssd_profile profile = get_test_profile();
+	std::string file = "/tmp/ssd_perf_model_unit_test.prof";
+	assert(profile.save(file));
+	ssd_profile loaded;
+	assert(loaded.load(file));
+	assert(loaded.num_channels == profile.num_channels);
+	assert(loaded.read_latency == profile.read_latency);
+	assert(loaded.write_latency == profile.write_latency);
+	assert(loaded.read_bandwidth == profile.read_bandwidth);
+	assert(loaded.write_bandwidth == profile.write_bandwidth);
+	unlink(file.c_str());
+	printf("test_profile passes\n");
+}
+
+int main()
+{
+	test_channels();
+	test_bandwidth();
+	test_deterministic();
+	test_profile();
+}
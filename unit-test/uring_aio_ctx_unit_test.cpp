@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <linux/capability.h>
+
+#include "uring_aio_ctx.h"
+
+const int FILE_SIZE = 8 * 1024 * 1024;
+const int NUM_REQS = 16;
+const int REQ_SIZE = PAGE_SIZE * 4;
+
+int fd;
+int num_completed;
+
+/*
+ * Each 8-byte word in the file is its offset in the file.
+ */
+void create_file()
+{
+	char file_name[] = "/tmp/uring_unit_test.XXXXXX";
+	fd = mkstemp(file_name);
+	assert(fd >= 0);
+	unlink(file_name);
+	for (off_t off = 0; off < FILE_SIZE; off += PAGE_SIZE) {
+		off_t words[PAGE_SIZE / sizeof(off_t)];
+		for (size_t i = 0; i < PAGE_SIZE / sizeof(off_t); i++)
+			words[i] = off + i * sizeof(off_t);
+		BOOST_VERIFY(pwrite(fd, words, PAGE_SIZE, off) == PAGE_SIZE);
+	}
+}
+
+void check_data(const char *buf, off_t off, size_t size)
+{
+	const off_t *words = (const off_t *) buf;
+	for (size_t i = 0; i < size / sizeof(off_t); i++)
+		assert(words[i] == (off_t) (off + i * sizeof(off_t)));
+}
+
+void read_complete(io_context_t ctx, struct iocb *iocbs[], void *cbs[],
+		long res[], long res2[], int num)
+{
+	for (int i = 0; i < num; i++) {
+		assert(res[i] == REQ_SIZE);
+		check_data((const char *) iocbs[i]->u.c.buf, iocbs[i]->u.c.offset,
+				REQ_SIZE);
+	}
+	num_completed += num;
+}
+
+io_callback_s cb = {read_complete};
+
+char *alloc_buf(size_t size)
+{
+	char *buf = (char *) valloc(size);
+	assert(buf);
+	memset(buf, 0, size);
+	return buf;
+}
+
+/*
+ * Read NUM_REQS requests to the buffer and wait for them.
+ */
+void read_to(uring_aio_ctx *ctx, char *buf)
+{
+	struct iocb *reqs[NUM_REQS];
+	for (int i = 0; i < NUM_REQS; i++) {
+		off_t off = ((off_t) random() % (FILE_SIZE / REQ_SIZE)) * REQ_SIZE;
+		reqs[i] = ctx->make_io_request(fd, REQ_SIZE, off,
+				buf + i * REQ_SIZE, A_READ, &cb);
+	}
+	num_completed = 0;
+	ctx->submit_io_request(reqs, NUM_REQS);
+	while (num_completed < NUM_REQS)
+		ctx->io_wait(NULL, NUM_REQS - num_completed);
+}
+
+/*
+ * The buffers registered before the ring is created are registered
+ * at ring setup.
+ */
+void test_setup(char *buf)
+{
+	uring_aio_ctx *ctx = uring_aio_ctx::create(0, NUM_REQS * 2);
+	assert(ctx);
+	assert(ctx->get_num_reg_bufs() == 1);
+	read_to(ctx, buf);
+	assert(ctx->get_num_fixed_reqs() == NUM_REQS);
+	delete ctx;
+	printf("registering buffers at setup passes\n");
+}
+
+/*
+ * A buffer registered while requests are in flight is used as a fixed
+ * buffer without waiting for the ring to be idle.
+ */
+void test_register_in_flight(char *buf1)
+{
+	uring_aio_ctx *ctx = uring_aio_ctx::create(0, NUM_REQS * 2);
+	assert(ctx);
+	num_completed = 0;
+	struct iocb *req = ctx->make_io_request(fd, REQ_SIZE, 0, buf1, A_READ,
+			&cb);
+	ctx->submit_io_request(&req, 1);
+
+	size_t size = NUM_REQS * REQ_SIZE;
+	char *buf2 = alloc_buf(size);
+	register_io_buf(buf2, size);
+	struct iocb *reqs[NUM_REQS];
+	for (int i = 0; i < NUM_REQS; i++)
+		reqs[i] = ctx->make_io_request(fd, REQ_SIZE, i * REQ_SIZE,
+				buf2 + i * REQ_SIZE, A_READ, &cb);
+	ctx->submit_io_request(reqs, NUM_REQS);
+	assert(ctx->get_num_reg_bufs() == 2);
+	while (num_completed < NUM_REQS + 1)
+		ctx->io_wait(NULL, NUM_REQS + 1 - num_completed);
+	assert(ctx->get_num_fixed_reqs() == NUM_REQS + 1);
+	delete ctx;
+	printf("registering buffers with requests in flight passes\n");
+}
+
+/*
+ * Root isn't limited by RLIMIT_MEMLOCK, so we drop CAP_IPC_LOCK to
+ * test the limit.
+ */
+bool drop_ipc_lock()
+{
+	struct __user_cap_header_struct header;
+	struct __user_cap_data_struct data[2];
+	memset(&header, 0, sizeof(header));
+	header.version = _LINUX_CAPABILITY_VERSION_3;
+	if (syscall(SYS_capget, &header, data) < 0)
+		return false;
+	data[0].effective &= ~(1U << CAP_IPC_LOCK);
+	return syscall(SYS_capset, &header, data) == 0;
+}
+
+/*
+ * If RLIMIT_MEMLOCK is too small for a buffer, the buffer isn't registered
+ * and is accessed as a regular buffer.
+ */
+void test_memlock(char *buf1)
+{
+	const size_t limit = 1024 * 1024;
+	if (!drop_ipc_lock()) {
+		printf("can't drop CAP_IPC_LOCK, skip the memlock test\n");
+		return;
+	}
+	struct rlimit rlim;
+	BOOST_VERIFY(getrlimit(RLIMIT_MEMLOCK, &rlim) == 0);
+	rlim.rlim_cur = limit;
+	BOOST_VERIFY(setrlimit(RLIMIT_MEMLOCK, &rlim) == 0);
+
+	char *large_buf = alloc_buf(limit * 2);
+	register_io_buf(large_buf, limit * 2);
+	uring_aio_ctx *ctx = uring_aio_ctx::create(0, NUM_REQS * 2);
+	assert(ctx);
+	// Only the small buffers fit in the limit.
+	assert(ctx->get_num_reg_bufs() == 2);
+	read_to(ctx, large_buf);
+	assert(ctx->get_num_fixed_reqs() == 0);
+	read_to(ctx, buf1);
+	assert(ctx->get_num_fixed_reqs() == NUM_REQS);
+	delete ctx;
+	printf("falling back when RLIMIT_MEMLOCK is too small passes\n");
+}
+
+int main()
+{
+	uring_aio_ctx *ctx = uring_aio_ctx::create(0, 1);
+	if (ctx == NULL) {
+		printf("io_uring isn't supported, skip the test\n");
+		return 0;
+	}
+	delete ctx;
+
+	create_file();
+	size_t size = NUM_REQS * REQ_SIZE;
+	char *buf = alloc_buf(size);
+	register_io_buf(buf, size);
+	test_setup(buf);
+	test_register_in_flight(buf);
+	test_memlock(buf);
+	close(fd);
+}
@@ -19,9 +19,13 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <fcntl.h>
 
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <numeric>
 #include <boost/format.hpp>
 
 #include "io_interface.h"
@@ -29,6 +33,7 @@
 #include "safs_file.h"
 #include "file_mapper.h"
 #include "RAID_config.h"
+#include "virt_aio_ctx.h"
 
 const int BUF_SIZE = 1024 * 64 * PAGE_SIZE;
 
@@ -365,6 +370,461 @@ void comm_create_file(int argc, char *argv[])
 	io->cleanup();
 }
 
+/**
+ * The configuration of the benchmark.
+ */
+struct bench_config
+{
+	int access_option;
+	bool rand_access;
+	int access_method;
+	size_t req_size;
+	// The number of pending requests in each thread.
+	int depth;
+	int num_threads;
+	// The duration of the benchmark in seconds.
+	int duration;
+
+	bench_config() {
+		access_option = GLOBAL_CACHE_ACCESS;
+		rand_access = true;
+		access_method = READ;
+		req_size = PAGE_SIZE;
+		depth = 32;
+		num_threads = 1;
+		duration = 10;
+	}
+
+	bool set_option(const std::string &name, const std::string &value);
+};
+
+bool bench_config::set_option(const std::string &name,
+		const std::string &value)
+{
+	if (name == "mode") {
+		if (value == "direct")
+			access_option = DIRECT_ACCESS;
+		else if (value == "remote")
+			access_option = REMOTE_ACCESS;
+		else if (value == "cached")
+			access_option = GLOBAL_CACHE_ACCESS;
+		else
+			return false;
+	}
+	else if (name == "access") {
+		if (value != "rand" && value != "seq")
+			return false;
+		rand_access = value == "rand";
+	}
+	else if (name == "rw") {
+		if (value != "read" && value != "write")
+			return false;
+		access_method = value == "read" ? READ : WRITE;
+	}
+	else if (name == "size")
+		req_size = str2size(value);
+	else if (name == "depth")
+		depth = atoi(value.c_str());
+	else if (name == "threads")
+		num_threads = atoi(value.c_str());
+	else if (name == "time")
+		duration = atoi(value.c_str());
+	else
+		return false;
+	return true;
+}
+
+class bench_thread;
+
+class bench_callback: public callback
+{
+	bench_thread *t;
+public:
+	bench_callback(bench_thread *t) {
+		this->t = t;
+	}
+
+	int invoke(io_request *rqs[], int num);
+};
+
+/**
+ * A thread of the benchmark keeps `depth' requests in flight until
+ * the benchmark times out. Each request uses its own buffer, so we
+ * know when a request was issued from its buffer.
+ */
+class bench_thread: public thread
+{
+	const bench_config &conf;
+	file_io_factory::shared_ptr factory;
+	io_interface::ptr io;
+	int idx;
+
+	char *bufs;
+	std::vector<struct timeval> issue_times;
+	std::vector<int> free_slots;
+
+	long num_blocks;
+	// The next block accessed by a sequential workload.
+	long next_block;
+	unsigned int seed;
+
+	// The latency of each request in microseconds.
+	std::vector<int> latencies;
+	size_t num_bytes;
+	size_t num_cache_hits;
+
+	off_t get_next_off() {
+		long block;
+		if (conf.rand_access)
+			block = (((long) rand_r(&seed)) << 31 | rand_r(&seed)) % num_blocks;
+		else {
+			block = next_block;
+			next_block = (next_block + 1) % num_blocks;
+		}
+		return block * conf.req_size;
+	}
+
+	void run_sync(const struct timeval &end_time);
+	void run_async(const struct timeval &end_time);
+public:
+	bench_thread(const bench_config &_conf, file_io_factory::shared_ptr factory,
+			int node_id, int idx): thread(std::string("bench-thread")
+				+ itoa(idx), node_id), conf(_conf) {
+		this->factory = factory;
+		this->idx = idx;
+		bufs = NULL;
+		num_blocks = factory->get_file_size() / conf.req_size;
+		assert(num_blocks > 0);
+		// Each thread scans its own part of the file in a sequential workload.
+		next_block = num_blocks / conf.num_threads * idx;
+		seed = idx + 1;
+		num_bytes = 0;
+		num_cache_hits = 0;
+	}
+
+	~bench_thread() {
+		free(bufs);
+	}
+
+	void init();
+	void run();
+	void complete(io_request *req);
+
+	const std::vector<int> &get_latencies() const {
+		return latencies;
+	}
+
+	size_t get_num_bytes() const {
+		return num_bytes;
+	}
+
+	size_t get_num_cache_hits() const {
+		return num_cache_hits;
+	}
+};
+
+int bench_callback::invoke(io_request *rqs[], int num)
+{
+	for (int i = 0; i < num; i++)
+		t->complete(rqs[i]);
+	return 0;
+}
+
+void bench_thread::init()
+{
+	io = factory->create_io(this);
+	int depth = io->support_aio() ? conf.depth : 1;
+	bufs = (char *) valloc(conf.req_size * depth);
+	memset(bufs, 0, conf.req_size * depth);
+	issue_times.resize(depth);
+	for (int i = 0; i < depth; i++)
+		free_slots.push_back(i);
+	if (io->support_aio()) {
+		io->set_max_num_pending_ios(depth);
+		io->set_callback(new bench_callback(this));
+	}
+}
+
+void bench_thread::complete(io_request *req)
+{
+	struct timeval curr;
+	gettimeofday(&curr, NULL);
+	int slot = (req->get_buf() - bufs) / conf.req_size;
+	latencies.push_back(time_diff_us(issue_times[slot], curr));
+	num_bytes += req->get_size();
+	free_slots.push_back(slot);
+}
+
+/**
+ * The I/O instances that don't support async I/O serve one request
+ * at a time.
+ */
+void bench_thread::run_sync(const struct timeval &end_time)
+{
+	struct timeval curr;
+	do {
+		off_t off = get_next_off();
+		gettimeofday(&issue_times[0], NULL);
+		io_status status = io->access(bufs, off, conf.req_size,
+				conf.access_method);
+		if (status == IO_FAIL) {
+			perror("access");
+			::exit(1);
+		}
+		gettimeofday(&curr, NULL);
+		latencies.push_back(time_diff_us(issue_times[0], curr));
+		num_bytes += conf.req_size;
+	} while (time_diff_us(curr, end_time) > 0);
+}
+
+void bench_thread::run_async(const struct timeval &end_time)
+{
+	struct timeval curr;
+	do {
+		// Cached requests may complete inside access(), so we issue
+		// requests one at a time.
+		while (!free_slots.empty()) {
+			int slot = free_slots.back();
+			free_slots.pop_back();
+			data_loc_t loc(io->get_file_id(), get_next_off());
+			io_request req(bufs + slot * conf.req_size, loc, conf.req_size,
+					conf.access_method);
+			gettimeofday(&issue_times[slot], NULL);
+			io->access(&req, 1);
+		}
+		io->wait4complete(1);
+		gettimeofday(&curr, NULL);
+	} while (time_diff_us(curr, end_time) > 0);
+	// Wait for all requests to complete.
+	while (io->num_pending_ios() > 0)
+		io->wait4complete(io->num_pending_ios());
+}
+
+void bench_thread::run()
+{
+	struct timeval end_time;
+	gettimeofday(&end_time, NULL);
+	end_time.tv_sec += conf.duration;
+	if (io->support_aio())
+		run_async(end_time);
+	else
+		run_sync(end_time);
+	num_cache_hits = io->get_cache_hits();
+
+	io->cleanup();
+	delete io->get_callback();
+	// Release the I/O instance, so its statistics are collected by
+	// the factory.
+	io.reset();
+	stop();
+}
+
+/**
+ * The result of a benchmark run.
+ */
+struct bench_result
+{
+	float secs;
+	size_t num_bytes;
+	size_t num_cache_hits;
+	// The latencies of all requests in microseconds in ascending order.
+	std::vector<int> latencies;
+
+	double get_iops() const {
+		return latencies.size() / secs;
+	}
+
+	// In bytes per second.
+	double get_bandwidth() const {
+		return num_bytes / secs;
+	}
+
+	int get_latency(int permille) const {
+		return latencies[latencies.size() * permille / 1000];
+	}
+
+	double get_avg_latency() const {
+		return ((double) std::accumulate(latencies.begin(), latencies.end(),
+					0L)) / latencies.size();
+	}
+};
+
+static void run_bench(const bench_config &conf,
+		file_io_factory::shared_ptr factory, bench_result &res)
+{
+	std::set<int> node_set = get_sys_RAID_conf().get_node_ids();
+	std::vector<int> node_ids(node_set.begin(), node_set.end());
+	std::vector<bench_thread *> threads(conf.num_threads);
+	for (int i = 0; i < conf.num_threads; i++)
+		threads[i] = new bench_thread(conf, factory,
+				node_ids[i % node_ids.size()], i);
+
+	struct timeval start, end;
+	gettimeofday(&start, NULL);
+	for (int i = 0; i < conf.num_threads; i++)
+		threads[i]->start();
+	for (int i = 0; i < conf.num_threads; i++)
+		threads[i]->join();
+	gettimeofday(&end, NULL);
+
+	res.secs = time_diff(start, end);
+	res.num_bytes = 0;
+	res.num_cache_hits = 0;
+	res.latencies.clear();
+	for (int i = 0; i < conf.num_threads; i++) {
+		const std::vector<int> &lats = threads[i]->get_latencies();
+		res.latencies.insert(res.latencies.end(), lats.begin(), lats.end());
+		res.num_bytes += threads[i]->get_num_bytes();
+		res.num_cache_hits += threads[i]->get_num_cache_hits();
+		delete threads[i];
+	}
+	if (res.latencies.empty()) {
+		fprintf(stderr, "no request is completed\n");
+		exit(-1);
+	}
+	std::sort(res.latencies.begin(), res.latencies.end());
+}
+
+void comm_bench(int argc, char *argv[])
+{
+	if (argc < 1) {
+		fprintf(stderr, "bench file_name [options]\n");
+		fprintf(stderr, "file_name is the file name in the SA-FS file system\n");
+		fprintf(stderr, "options:\n");
+		fprintf(stderr, "mode=direct|remote|cached: the I/O mode (default: cached)\n");
+		fprintf(stderr, "access=rand|seq: the access pattern (default: rand)\n");
+		fprintf(stderr, "rw=read|write: writes overwrite the data in the file (default: read)\n");
+		fprintf(stderr, "size=n: the request size (default: 4K)\n");
+		fprintf(stderr, "depth=n: the number of pending requests per thread (default: 32)\n");
+		fprintf(stderr, "threads=n: the number of threads (default: 1)\n");
+		fprintf(stderr, "time=n: the duration of the benchmark in seconds (default: 10)\n");
+		exit(-1);
+	}
+
+	std::string file_name = argv[0];
+	bench_config conf;
+	for (int i = 1; i < argc; i++) {
+		std::string opt = argv[i];
+		size_t pos = opt.find('=');
+		if (pos == std::string::npos
+				|| !conf.set_option(opt.substr(0, pos), opt.substr(pos + 1))) {
+			fprintf(stderr, "wrong option: %s\n", opt.c_str());
+			exit(-1);
+		}
+	}
+	if (conf.req_size == 0 || conf.req_size % MIN_BLOCK_SIZE > 0
+			|| conf.depth <= 0 || conf.num_threads <= 0 || conf.duration <= 0) {
+		fprintf(stderr, "wrong benchmark configuration\n");
+		exit(-1);
+	}
+
+	if (conf.access_method == WRITE)
+		configs->add_options("writable=1");
+	init_io_system(configs, conf.access_option == GLOBAL_CACHE_ACCESS);
+	file_io_factory::shared_ptr factory = create_io_factory(file_name,
+			conf.access_option);
+	assert(factory);
+
+	bench_result res;
+	run_bench(conf, factory, res);
+	printf("%ld requests of %ld bytes in %.3f seconds\n", res.latencies.size(),
+			conf.req_size, res.secs);
+	printf("IOPS: %.0f, bandwidth: %.3f MB/s\n", res.get_iops(),
+			res.get_bandwidth() / 1024 / 1024);
+	printf("latency (us): avg: %.1f, 50%%: %d, 90%%: %d, 99%%: %d, 99.9%%: %d, max: %d\n",
+			res.get_avg_latency(), res.get_latency(500), res.get_latency(900),
+			res.get_latency(990), res.get_latency(999), res.latencies.back());
+#ifdef STATISTICS
+	// The page cache only counts cache hits with statistics enabled.
+	if (conf.access_option == GLOBAL_CACHE_ACCESS) {
+		size_t num_pages = res.num_bytes / PAGE_SIZE;
+		printf("cache hits: %ld in %ld page accesses (%.2f%%)\n",
+				res.num_cache_hits, num_pages, num_pages > 0
+				? ((double) res.num_cache_hits) / num_pages * 100 : 0);
+	}
+#endif
+	factory->print_statistics();
+	print_io_thread_stat();
+}
+
+/**
+ * Fit the profile of the SSD performance model from a few benchmark runs
+ * on the real SSDs. Requests go through the I/O threads directly, so the
+ * page cache doesn't hide the SSDs.
+ */
+void comm_calibrate(int argc, char *argv[])
+{
+	if (argc < 2) {
+		fprintf(stderr, "calibrate file_name profile [write]\n");
+		fprintf(stderr, "file_name is the file name in the SA-FS file system\n");
+		fprintf(stderr, "profile is the file where the SSD profile is saved\n");
+		fprintf(stderr, "write: also calibrate writes, which overwrite the data in the file\n");
+		exit(-1);
+	}
+
+	std::string file_name = argv[0];
+	std::string profile_file = argv[1];
+	bool calibrate_write = argc >= 3 && std::string(argv[2]) == "write";
+
+	if (calibrate_write)
+		configs->add_options("writable=1");
+	init_io_system(configs, false);
+	file_io_factory::shared_ptr factory = create_io_factory(file_name,
+			REMOTE_ACCESS);
+	assert(factory);
+	int num_disks = get_sys_RAID_conf().get_num_disks();
+
+	ssd_profile profile;
+	bench_config conf;
+	conf.access_option = REMOTE_ACCESS;
+	conf.duration = 3;
+	bench_result res;
+	for (int i = 0; i < (calibrate_write ? 2 : 1); i++) {
+		conf.access_method = i == 0 ? READ : WRITE;
+		// The latency of a page when the SSDs are idle.
+		conf.rand_access = true;
+		conf.req_size = PAGE_SIZE;
+		conf.depth = 1;
+		conf.num_threads = 1;
+		run_bench(conf, factory, res);
+		long latency = res.get_latency(500);
+
+		// The SSDs serve as many pages in parallel as they have channels.
+		conf.depth = 64;
+		conf.num_threads = num_disks;
+		run_bench(conf, factory, res);
+		int num_channels = max<int>(1,
+				res.get_iops() / num_disks * latency / 1000000);
+
+		// The bandwidth of an SSD is measured with large sequential requests.
+		conf.rand_access = false;
+		conf.req_size = params.get_RAID_block_size() * PAGE_SIZE;
+		conf.depth = 16;
+		run_bench(conf, factory, res);
+		long bandwidth = res.get_bandwidth() / num_disks;
+
+		printf("%s: latency: %ldus, channels: %d, bandwidth: %.3fMB/s\n",
+				i == 0 ? "read" : "write", latency, num_channels,
+				((double) bandwidth) / 1024 / 1024);
+		if (i == 0) {
+			profile.num_channels = num_channels;
+			profile.read_latency = latency;
+			profile.read_bandwidth = bandwidth;
+			// Without calibrating writes, we assume writes are as fast
+			// as reads.
+			profile.write_latency = latency;
+			profile.write_bandwidth = bandwidth;
+		}
+		else {
+			profile.write_latency = latency;
+			profile.write_bandwidth = bandwidth;
+		}
+	}
+	if (!profile.save(profile_file))
+		exit(-1);
+	printf("save the SSD profile to %s\n", profile_file.c_str());
+}
+
 void print_help();
 
 void comm_help(int argc, char *argv[])
@@ -428,6 +888,10 @@ struct command
 };
 
 struct command commands[] = {
+	{"bench", comm_bench,
+		"bench file_name [options]: benchmark the I/O performance on the file"},
+	{"calibrate", comm_calibrate,
+		"calibrate file_name profile [write]: fit the SSD model for virtual AIO"},
 	{"create", comm_create_file,
 		"create file_name size: create a file with the specified size"},
 	{"delete", comm_delete_file,